@@ -132,11 +132,10 @@ glusterfs_ctx_defaults_init(glusterfs_ctx_t *ctx)
     if (!ctx->logbuf_pool)
         goto err;
 
-    INIT_LIST_HEAD(&pool->all_frames);
+    call_pool_init(pool);
     INIT_LIST_HEAD(&ctx->cmd_args.xlator_options);
     INIT_LIST_HEAD(&ctx->cmd_args.volfile_servers);
 
-    LOCK_INIT(&pool->lock);
     ctx->pool = pool;
 
     ret = 0;
@@ -1183,7 +1182,7 @@ glusterfs_ctx_destroy(glusterfs_ctx_t *ctx)
             mem_pool_destroy(pool->frame_mem_pool);
         if (pool->stack_mem_pool)
             mem_pool_destroy(pool->stack_mem_pool);
-        LOCK_DESTROY(&pool->lock);
+        call_pool_fini(pool);
         GF_FREE(pool);
     }
 
@@ -1266,12 +1265,12 @@ pub_glfs_fini(struct glfs *fs)
         pthread_mutex_lock(&fs->mutex);
         {
             /* Do we need to increase countdown? */
-            if ((!call_pool->cnt) && (!fs->pin_refcnt)) {
+            if ((!call_pool_inflight(call_pool)) && (!fs->pin_refcnt)) {
                 gf_msg_trace("glfs", 0,
                              "call_pool_cnt - %" PRId64
                              ","
                              "pin_refcnt - %d",
-                             call_pool->cnt, fs->pin_refcnt);
+                             call_pool_inflight(call_pool), fs->pin_refcnt);
 
                 ctx->cleanup_started = 1;
                 pthread_mutex_unlock(&fs->mutex);
@@ -1286,7 +1285,7 @@ pub_glfs_fini(struct glfs *fs)
 
     /*We deem glfs_fini as successful if there are no pending frames in the call
      *pool*/
-    ret = (call_pool->cnt == 0) ? 0 : -1;
+    ret = (call_pool_inflight(call_pool) == 0) ? 0 : -1;
 
     pthread_mutex_lock(&fs->mutex);
     {
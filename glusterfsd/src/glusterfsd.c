@@ -1595,8 +1595,7 @@ glusterfs_ctx_defaults_init(glusterfs_ctx_t *ctx)
         goto out;
     }
 
-    INIT_LIST_HEAD(&ctx->pool->all_frames);
-    LOCK_INIT(&ctx->pool->lock);
+    call_pool_init(ctx->pool);
 
     /* frame_mem_pool size 112 * 4k */
     ctx->pool->frame_mem_pool = mem_pool_new(call_frame_t, 4096);
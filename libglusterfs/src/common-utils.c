@@ -38,7 +38,7 @@
 #ifndef GF_LINUX_HOST_OS
 #include <sys/resource.h>
 #endif
-#ifdef HAVE_SYNCFS_SYS
+#if defined(HAVE_SYNCFS_SYS) || defined(GF_LINUX_HOST_OS)
 #include <sys/syscall.h>
 #endif
 
@@ -636,6 +636,7 @@ gf_print_trace(int32_t signum, glusterfs_ctx_t *ctx)
         0,
     };
     call_stack_t *stack = NULL;
+    int i = 0;
 
     /* Now every gf_log call will just write to a buffer and when the
      * buffer becomes full, its written to the log-file. Suppose the process
@@ -651,16 +652,20 @@ gf_print_trace(int32_t signum, glusterfs_ctx_t *ctx)
     /* Pending frames, (if any), list them in order */
     gf_msg_plain_nomem(GF_LOG_ALERT, "pending frames:");
     {
-        /* FIXME: traversing stacks outside pool->lock */
-        list_for_each_entry(stack, &ctx->pool->all_frames, all_frames)
-        {
-            if (stack->type == GF_OP_TYPE_FOP)
-                sprintf(msg, "frame : type(%d) op(%s)", stack->type,
-                        gf_fop_list[stack->op]);
-            else
-                sprintf(msg, "frame : type(%d) op(%d)", stack->type, stack->op);
-
-            gf_msg_plain_nomem(GF_LOG_ALERT, msg);
+        /* FIXME: traversing stacks outside the locks of the lists */
+        for (i = 0; i < GF_CALL_POOL_LISTS; i++) {
+            list_for_each_entry(stack, &ctx->pool->lists[i].all_frames,
+                                all_frames)
+            {
+                if (stack->type == GF_OP_TYPE_FOP)
+                    sprintf(msg, "frame : type(%d) op(%s)", stack->type,
+                            gf_fop_list[stack->op]);
+                else
+                    sprintf(msg, "frame : type(%d) op(%d)", stack->type,
+                            stack->op);
+
+                gf_msg_plain_nomem(GF_LOG_ALERT, msg);
+            }
         }
     }
 
@@ -3353,6 +3358,207 @@ gf_thread_create_detached(pthread_t *thread, void *(*start_routine)(void *),
     return ret;
 }
 
+#ifdef GF_LINUX_HOST_OS
+
+#define GF_NUMA_MAX_NODES 64
+
+static int gf_numa_cpu_node[CPU_SETSIZE];
+static int gf_numa_nodes = -1;
+static cpu_set_t gf_numa_startup_cpus; /* restored by gf_numa_bind_thread(-1) */
+static pthread_once_t gf_numa_once = PTHREAD_ONCE_INIT;
+
+/* Parses a sysfs cpu list like "0-7,16-23" and maps its cpus to node. */
+static void
+gf_numa_parse_cpulist(char *list, int node)
+{
+    char *saveptr = NULL;
+    char *tok = NULL;
+    int first = 0;
+    int last = 0;
+    int cpu = 0;
+
+    for (tok = strtok_r(list, ",\n", &saveptr); tok;
+         tok = strtok_r(NULL, ",\n", &saveptr)) {
+        switch (sscanf(tok, "%d-%d", &first, &last)) {
+            case 1:
+                last = first;
+                break;
+            case 2:
+                break;
+            default:
+                continue;
+        }
+
+        for (cpu = max(first, 0); (cpu <= last) && (cpu < CPU_SETSIZE); cpu++)
+            gf_numa_cpu_node[cpu] = node;
+    }
+}
+
+static void
+gf_numa_init(void)
+{
+    char path[PATH_MAX];
+    char list[4096];
+    ssize_t len = 0;
+    int node = 0;
+    int cpu = 0;
+    int fd = -1;
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        gf_numa_cpu_node[cpu] = -1;
+
+    /* Runs before any thread is bound, so this is the affinity the process
+     * was started with. */
+    if (sched_getaffinity(0, sizeof(gf_numa_startup_cpus),
+                          &gf_numa_startup_cpus) != 0) {
+        for (cpu = 0; cpu < CPU_SETSIZE; cpu++)
+            CPU_SET(cpu, &gf_numa_startup_cpus);
+    }
+
+    for (node = 0; node < GF_NUMA_MAX_NODES; node++) {
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+                 node);
+        fd = sys_open(path, O_RDONLY, 0);
+        if (fd < 0)
+            continue;
+
+        len = sys_read(fd, list, sizeof(list) - 1);
+        sys_close(fd);
+        if (len <= 0)
+            continue;
+
+        list[len] = '\0';
+        gf_numa_parse_cpulist(list, node);
+        gf_numa_nodes = node + 1;
+    }
+}
+
+int
+gf_numa_node_count(void)
+{
+    pthread_once(&gf_numa_once, gf_numa_init);
+
+    return gf_numa_nodes;
+}
+
+int
+gf_numa_node_of_cpu(int cpu)
+{
+    pthread_once(&gf_numa_once, gf_numa_init);
+
+    if ((cpu < 0) || (cpu >= CPU_SETSIZE))
+        return -1;
+
+    return gf_numa_cpu_node[cpu];
+}
+
+int
+gf_numa_current_node(void)
+{
+    return gf_numa_node_of_cpu(sched_getcpu());
+}
+
+int
+gf_numa_node_cpus(int node, cpu_set_t *cpus)
+{
+    int cpu = 0;
+    int ret = -1;
+
+    pthread_once(&gf_numa_once, gf_numa_init);
+
+    CPU_ZERO(cpus);
+    if (node < 0)
+        return -1;
+
+    for (cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (gf_numa_cpu_node[cpu] == node) {
+            CPU_SET(cpu, cpus);
+            ret = 0;
+        }
+    }
+
+    return ret;
+}
+
+int
+gf_numa_bind_thread(int node)
+{
+    cpu_set_t cpus;
+
+    if (node < 0) {
+        pthread_once(&gf_numa_once, gf_numa_init);
+        cpus = gf_numa_startup_cpus;
+    } else if (gf_numa_node_cpus(node, &cpus) != 0) {
+        return -EINVAL;
+    }
+
+    return -pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
+int
+gf_numa_bind_memory(void *addr, size_t len, int node)
+{
+    unsigned long mask[GF_NUMA_MAX_NODES / (8 * sizeof(unsigned long))];
+
+    if ((node < 0) || (node >= GF_NUMA_MAX_NODES))
+        return -EINVAL;
+
+    memset(mask, 0, sizeof(mask));
+    mask[node / (8 * sizeof(unsigned long))] |=
+        1UL << (node % (8 * sizeof(unsigned long)));
+
+    /* The kernel ignores the last bit of the mask it is given. */
+    if (syscall(SYS_mbind, addr, len, MPOL_PREFERRED, mask,
+                GF_NUMA_MAX_NODES + 1, 0) != 0)
+        return -errno;
+
+    return 0;
+}
+
+#else /* !GF_LINUX_HOST_OS */
+
+int
+gf_numa_node_count(void)
+{
+    return -1;
+}
+
+int
+gf_numa_node_of_cpu(int cpu)
+{
+    return -1;
+}
+
+int
+gf_numa_current_node(void)
+{
+    return -1;
+}
+
+int
+gf_numa_node_cpus(int node, void *cpus)
+{
+    return -1;
+}
+
+int
+gf_numa_bind_thread(int node)
+{
+    return -ENOSYS;
+}
+
+int
+gf_numa_bind_memory(void *addr, size_t len, int node)
+{
+    return -ENOSYS;
+}
+
+#endif /* GF_LINUX_HOST_OS */
+
 /* Below function is use to check at runtime if pid is running */
 
 static gf_boolean_t
@@ -11,6 +11,8 @@
 #include <pthread.h>
 
 #include "glusterfs/globals.h"
+#include "glusterfs/gf-event.h"
+#include "glusterfs/iobuf.h"
 #include "timer-wheel.h"
 
 glusterfs_ctx_t *global_ctx = NULL;
@@ -111,3 +113,20 @@ glusterfs_ctx_tw_put(glusterfs_ctx_t *ctx)
 {
     GF_REF_PUT(ctx->tw);
 }
+
+/* In NUMA mode the event threads are bound to the nodes of the host and
+ * share the connections out between them, and the iobufs come from arenas
+ * of the node of the thread asking for them. The xlators running threads
+ * of their own look at ctx->numa too. */
+void
+glusterfs_ctx_set_numa(glusterfs_ctx_t *ctx, gf_boolean_t numa)
+{
+    if (ctx->numa == numa)
+        return;
+
+    ctx->numa = numa;
+    if (ctx->event_pool)
+        gf_event_pool_set_numa(ctx->event_pool, numa);
+    if (ctx->iobuf_pool)
+        iobuf_pool_set_numa(ctx->iobuf_pool, numa);
+}
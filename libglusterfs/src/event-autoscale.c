@@ -0,0 +1,413 @@
+/*
+  Copyright (c) 2024 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Event thread autoscaling.
+ *
+ * Every EVENT_AUTOSCALE_INTERVAL seconds the controller sums the time the
+ * event threads spent in handlers and the events they dispatched, asks the
+ * registered sources (the rpc services) how many requests wait for their
+ * handler thread, and moves the thread count within [min, max]. Threads
+ * are added as soon as they are saturated, and removed one at a time only
+ * after the load stayed low for a while, so that the count does not flap
+ * with short bursts. The rpcsvc request handler threads follow,
+ * as each of them serves the requests of one event thread.
+ */
+
+#include <pthread.h>
+#include <time.h>
+
+#include "glusterfs/gf-event.h"
+#include "glusterfs/timespec.h"
+#include "glusterfs/statedump.h"
+#include "glusterfs/libglusterfs-messages.h"
+
+void
+gf_event_autoscale_init(struct event_autoscale *as)
+{
+    pthread_mutex_init(&as->mutex, NULL);
+    pthread_cond_init(&as->cond, NULL);
+    timespec_now(&as->sampled);
+}
+
+static uint64_t
+event_autoscale_backlog(struct event_autoscale *as)
+{
+    uint64_t backlog = 0;
+    int i;
+
+    for (i = 0; i < EVENT_AUTOSCALE_SOURCES; i++) {
+        if (as->sources[i].fn)
+            backlog += as->sources[i].fn(as->sources[i].data);
+    }
+
+    return backlog;
+}
+
+static void
+event_autoscale_totals(struct event_pool *event_pool, uint64_t *busy_ns,
+                       uint64_t *wakeups)
+{
+    int i;
+
+    *busy_ns = 0;
+    *wakeups = 0;
+
+    if (!event_pool->load)
+        return;
+
+    for (i = 0; i < EVENT_MAX_THREADS; i++) {
+        *busy_ns += GF_ATOMIC_GET(event_pool->load[i].busy_ns);
+        *wakeups += GF_ATOMIC_GET(event_pool->load[i].wakeups);
+    }
+}
+
+/* Returns the number of threads to run for the load of an interval.
+ * Keeps no state but the idle streak, so that load steps can be replayed
+ * through it. Called with as->mutex held. */
+int
+gf_event_autoscale_decide(struct event_autoscale *as, struct event_load *load)
+{
+    struct event_autoscale_decision *decision = NULL;
+    uint64_t capacity = 0;
+    int threads = load->threads;
+    int target = threads;
+    int busy = 0;
+    int rest = 0;
+
+    if (threads <= 0)
+        threads = 1;
+
+    capacity = load->interval_ns * threads;
+    if (capacity)
+        busy = min(load->busy_ns * 100 / capacity, 100);
+
+    if (((busy >= EVENT_AUTOSCALE_HIGH) && (load->wakeups >= threads)) ||
+        (load->backlog >= (uint64_t)threads * EVENT_AUTOSCALE_BACKLOG)) {
+        /* saturated: add a quarter more threads, at least one */
+        as->idle_samples = 0;
+        target = threads + max(threads / 4, 1);
+    } else {
+        if (threads > 1) {
+            rest = load->busy_ns * 100 /
+                   max(load->interval_ns * (threads - 1), 1);
+        }
+
+        if ((threads > 1) && (rest < EVENT_AUTOSCALE_LOW) &&
+            (load->backlog == 0))
+            as->idle_samples++;
+        else
+            as->idle_samples = 0;
+
+        if (as->idle_samples >= EVENT_AUTOSCALE_IDLE_SAMPLES) {
+            as->idle_samples = 0;
+            target = threads - 1;
+        }
+    }
+
+    target = max(min(target, as->max), as->min);
+    if (target == load->threads)
+        return target;
+
+    if (target > load->threads)
+        as->scale_ups++;
+    else
+        as->scale_downs++;
+
+    decision = &as->history[as->decisions++ % EVENT_AUTOSCALE_HISTORY];
+    decision->time = gf_time();
+    decision->from = load->threads;
+    decision->to = target;
+    decision->busy = busy;
+    decision->wakeups = load->wakeups;
+    decision->backlog = load->backlog;
+
+    return target;
+}
+
+static void
+event_autoscale_sample(struct event_pool *event_pool)
+{
+    struct event_autoscale *as = &event_pool->autoscale;
+    struct event_load *load = &as->last;
+    struct timespec now = {
+        0,
+    };
+    struct timespec elapsed = {
+        0,
+    };
+    uint64_t busy_ns = 0;
+    uint64_t wakeups = 0;
+    int target = 0;
+
+    timespec_now(&now);
+    timespec_sub(&as->sampled, &now, &elapsed);
+    event_autoscale_totals(event_pool, &busy_ns, &wakeups);
+
+    load->interval_ns = elapsed.tv_sec * 1000000000ULL + elapsed.tv_nsec;
+    load->busy_ns = busy_ns - as->busy_ns;
+    load->wakeups = wakeups - as->wakeups;
+    load->backlog = event_autoscale_backlog(as);
+    load->threads = event_pool->eventthreadcount;
+
+    as->sampled = now;
+    as->busy_ns = busy_ns;
+    as->wakeups = wakeups;
+
+    target = gf_event_autoscale_decide(as, load);
+    if (target < event_pool->numa_nodes)
+        target = event_pool->numa_nodes; /* see event_set_numa_epoll() */
+    if (target == load->threads)
+        return;
+
+    gf_msg_debug("epoll", 0,
+                 "autoscaling event threads from %d to %d (busy: %" PRIu64
+                 "ns in %" PRIu64 "ns, events: %" PRIu64 ", backlog: %" PRIu64
+                 ")",
+                 load->threads, target, load->busy_ns, load->interval_ns,
+                 load->wakeups, load->backlog);
+
+    (void)gf_event_reconfigure_threads(event_pool, target);
+}
+
+static void *
+event_autoscale_worker(void *data)
+{
+    struct event_pool *event_pool = data;
+    struct event_autoscale *as = &event_pool->autoscale;
+    struct timespec deadline = {
+        0,
+    };
+
+    pthread_mutex_lock(&as->mutex);
+    {
+        while (as->running) {
+            timespec_now_realtime(&deadline);
+            deadline.tv_sec += EVENT_AUTOSCALE_INTERVAL;
+            pthread_cond_timedwait(&as->cond, &as->mutex, &deadline);
+            if (!as->running)
+                break;
+
+            event_autoscale_sample(event_pool);
+        }
+    }
+    pthread_mutex_unlock(&as->mutex);
+
+    return NULL;
+}
+
+/* Runs between min and max event threads, or exactly min when max is not
+ * above it. The current count is kept when it is within the new bounds. */
+int
+gf_event_autoscale_set(struct event_pool *event_pool, int min_threads,
+                       int max_threads)
+{
+    struct event_autoscale *as = NULL;
+    gf_boolean_t stop = _gf_false;
+    pthread_t thread;
+    int target = 0;
+    int ret = 0;
+
+    GF_VALIDATE_OR_GOTO("event", event_pool, out);
+
+    as = &event_pool->autoscale;
+    max_threads = max(max_threads, min_threads);
+
+    pthread_mutex_lock(&as->mutex);
+    {
+        as->min = min_threads;
+        as->max = max_threads;
+        as->idle_samples = 0;
+
+        target = max(min(event_pool->eventthreadcount, max_threads),
+                     min_threads);
+        if (target != event_pool->eventthreadcount)
+            ret = gf_event_reconfigure_threads(event_pool, target);
+
+        if ((max_threads > min_threads) && !as->running) {
+            /* start from a fresh interval */
+            timespec_now(&as->sampled);
+            event_autoscale_totals(event_pool, &as->busy_ns, &as->wakeups);
+
+            as->running = _gf_true;
+            if (gf_thread_create(&as->thread, NULL, event_autoscale_worker,
+                                 event_pool, "epollscl") != 0) {
+                gf_msg("epoll", GF_LOG_WARNING, 0, LG_MSG_THREAD_CREATE_FAILED,
+                       "failed to start the event thread autoscaler");
+                as->running = _gf_false;
+            }
+        } else if ((max_threads == min_threads) && as->running) {
+            as->running = _gf_false;
+            pthread_cond_signal(&as->cond);
+            thread = as->thread;
+            stop = _gf_true;
+        }
+    }
+    pthread_mutex_unlock(&as->mutex);
+
+    if (stop)
+        pthread_join(thread, NULL);
+out:
+    return ret;
+}
+
+/* Moves the bounds, and the current count, by incr threads. Used as bricks
+ * attach to and detach from a multiplexed brick process. */
+int
+gf_event_autoscale_shift(struct event_pool *event_pool, int incr)
+{
+    struct event_autoscale *as = NULL;
+    int ret = -1;
+
+    GF_VALIDATE_OR_GOTO("event", event_pool, out);
+
+    as = &event_pool->autoscale;
+    pthread_mutex_lock(&as->mutex);
+    {
+        if (as->running) {
+            as->min += incr;
+            as->max += incr;
+        }
+
+        ret = gf_event_reconfigure_threads(event_pool,
+                                           event_pool->eventthreadcount + incr);
+    }
+    pthread_mutex_unlock(&as->mutex);
+out:
+    return ret;
+}
+
+void
+gf_event_autoscale_stop(struct event_pool *event_pool)
+{
+    struct event_autoscale *as = &event_pool->autoscale;
+    gf_boolean_t stop = _gf_false;
+
+    pthread_mutex_lock(&as->mutex);
+    {
+        if (as->running) {
+            as->running = _gf_false;
+            pthread_cond_signal(&as->cond);
+            stop = _gf_true;
+        }
+        as->max = as->min;
+    }
+    pthread_mutex_unlock(&as->mutex);
+
+    if (stop)
+        pthread_join(as->thread, NULL);
+}
+
+/* Adds a source of requests waiting to be handled to the load sampled. */
+int
+gf_event_autoscale_add_source(struct event_pool *event_pool,
+                              event_backlog_fn_t fn, void *data)
+{
+    struct event_autoscale *as = NULL;
+    int ret = -1;
+    int i;
+
+    GF_VALIDATE_OR_GOTO("event", event_pool, out);
+
+    as = &event_pool->autoscale;
+    pthread_mutex_lock(&as->mutex);
+    {
+        for (i = 0; i < EVENT_AUTOSCALE_SOURCES; i++) {
+            if (!as->sources[i].fn) {
+                as->sources[i].fn = fn;
+                as->sources[i].data = data;
+                ret = 0;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&as->mutex);
+out:
+    return ret;
+}
+
+void
+gf_event_autoscale_del_source(struct event_pool *event_pool,
+                              event_backlog_fn_t fn, void *data)
+{
+    struct event_autoscale *as = NULL;
+    int i;
+
+    GF_VALIDATE_OR_GOTO("event", event_pool, out);
+
+    as = &event_pool->autoscale;
+    pthread_mutex_lock(&as->mutex);
+    {
+        for (i = 0; i < EVENT_AUTOSCALE_SOURCES; i++) {
+            if ((as->sources[i].fn == fn) && (as->sources[i].data == data)) {
+                as->sources[i].fn = NULL;
+                as->sources[i].data = NULL;
+            }
+        }
+    }
+    pthread_mutex_unlock(&as->mutex);
+out:
+    return;
+}
+
+void
+gf_event_pool_dump(struct event_pool *event_pool)
+{
+    struct event_autoscale *as = &event_pool->autoscale;
+    struct event_autoscale_decision *decision = NULL;
+    char key[GF_DUMP_MAX_BUF_LEN];
+    uint64_t busy_ns = 0;
+    uint64_t wakeups = 0;
+    uint64_t i;
+
+    gf_proc_dump_add_section("event-pool");
+    gf_proc_dump_write("threads", "%d", event_pool->eventthreadcount);
+    gf_proc_dump_write("active-threads", "%d", event_pool->activethreadcount);
+    gf_proc_dump_write("auto-threads", "%d", event_pool->auto_thread_count);
+    gf_proc_dump_write("numa", "%d", event_pool->numa);
+    gf_proc_dump_write("numa-nodes", "%d", event_pool->numa_nodes);
+
+    event_autoscale_totals(event_pool, &busy_ns, &wakeups);
+    gf_proc_dump_write("events", "%" PRIu64, wakeups);
+
+    if (pthread_mutex_trylock(&as->mutex) != 0)
+        return;
+
+    gf_proc_dump_write("autoscale", "%d", as->running);
+    if (as->running) {
+        /* the event threads only time their work for the autoscaler */
+        gf_proc_dump_write("busy-ns", "%" PRIu64, busy_ns);
+        gf_proc_dump_write("autoscale.min-threads", "%d", as->min);
+        gf_proc_dump_write("autoscale.max-threads", "%d", as->max);
+        gf_proc_dump_write("autoscale.last-sample",
+                           "threads=%d, busy-ns=%" PRIu64
+                           ", interval-ns=%" PRIu64 ", events=%" PRIu64
+                           ", backlog=%" PRIu64,
+                           as->last.threads, as->last.busy_ns,
+                           as->last.interval_ns, as->last.wakeups,
+                           as->last.backlog);
+    }
+    gf_proc_dump_write("autoscale.scale-ups", "%" PRIu64, as->scale_ups);
+    gf_proc_dump_write("autoscale.scale-downs", "%" PRIu64, as->scale_downs);
+
+    i = (as->decisions > EVENT_AUTOSCALE_HISTORY)
+            ? as->decisions - EVENT_AUTOSCALE_HISTORY
+            : 0;
+    for (; i < as->decisions; i++) {
+        decision = &as->history[i % EVENT_AUTOSCALE_HISTORY];
+        gf_proc_dump_build_key(key, "autoscale", "decision[%" PRIu64 "]", i);
+        gf_proc_dump_write(key,
+                           "time=%ld, from=%d, to=%d, busy=%d%%, "
+                           "events=%" PRIu64 ", backlog=%" PRIu64,
+                           (long)decision->time, decision->from, decision->to,
+                           decision->busy, decision->wakeups,
+                           decision->backlog);
+    }
+    pthread_mutex_unlock(&as->mutex);
+}
@@ -14,15 +14,19 @@
 
 #include "glusterfs/gf-event.h"
 #include "glusterfs/common-utils.h"
+#include "glusterfs/timespec.h"
 #include "glusterfs/syscall.h"
 #include "glusterfs/libglusterfs-messages.h"
 
 #ifdef HAVE_SYS_EPOLL_H
 #include <sys/epoll.h>
+#include <urcu/arch.h>
+#include <urcu/system.h>
 
 struct event_slot_epoll {
     int slots_used;
     int fd;
+    int epfd; /* of the pool, or of a node in NUMA mode */
     int events;
     int gen;
     int idx;
@@ -277,6 +281,11 @@ event_pool_new_epoll(int count, int eventthreadcount)
         goto err;
     }
 
+    event_pool->load = GF_CALLOC(EVENT_MAX_THREADS, sizeof(*event_pool->load),
+                                 gf_common_mt_event_pool);
+    if (!event_pool->load)
+        goto err;
+
     if (__event_newtable(event_pool, 0) == NULL) {
         goto err;
     }
@@ -294,11 +303,57 @@ out:
 
 err:
     gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_CREATE_FAILED, NULL);
+    GF_FREE(event_pool->load);
     GF_FREE(event_pool->reg);
     GF_FREE(event_pool);
     return NULL;
 }
 
+/* The epoll fd a new fd is registered with: the fds go round the nodes in
+ * NUMA mode, so that their events are handled by the threads of each node
+ * in turn. */
+static int
+__event_numa_fd(struct event_pool *event_pool)
+{
+    if (!event_pool->numa)
+        return event_pool->fd;
+
+    event_pool->numa_next = (event_pool->numa_next + 1) %
+                            event_pool->numa_nodes;
+
+    return event_pool->numa_fds[event_pool->numa_next];
+}
+
+/* The epoll fd the event thread of index (from 0) polls. In NUMA mode the
+ * thread is also bound to the node of that fd, and unbound when NUMA mode
+ * is turned off; *node tracks what the thread is bound to. */
+static int
+event_numa_poll_fd(struct event_pool *event_pool, int index, int *node)
+{
+    int nodes = CMM_LOAD_SHARED(event_pool->numa_nodes);
+    int want = -1;
+    int ret = 0;
+
+    if (nodes == 0)
+        return event_pool->fd;
+
+    cmm_smp_rmb();
+
+    if (CMM_LOAD_SHARED(event_pool->numa))
+        want = index % nodes;
+
+    if (want != *node) {
+        ret = gf_numa_bind_thread(want);
+        if (ret != 0)
+            gf_log("epoll", GF_LOG_WARNING,
+                   "failed to bind event thread %d to NUMA node %d (%s)",
+                   index, want, strerror(-ret));
+        *node = want;
+    }
+
+    return event_pool->numa_fds[index % nodes];
+}
+
 static void
 __slot_update_events(struct event_slot_epoll *slot, int poll_in, int poll_out)
 {
@@ -369,6 +424,8 @@ event_register_epoll(struct event_pool *event_pool, int fd,
         }
 
         idx = __event_slot_alloc(event_pool, fd, notify_poller_death, &slot);
+        if (idx >= 0)
+            slot->epfd = __event_numa_fd(event_pool);
     }
     pthread_mutex_unlock(&event_pool->mutex);
 
@@ -401,7 +458,7 @@ event_register_epoll(struct event_pool *event_pool, int fd,
         ev_data->idx = idx;
         ev_data->gen = slot->gen;
 
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_ADD, fd, &epoll_event);
+        ret = epoll_ctl(slot->epfd, EPOLL_CTL_ADD, fd, &epoll_event);
         /* check ret after UNLOCK() to avoid deadlock in
            event_slot_unref()
         */
@@ -410,7 +467,7 @@ event_register_epoll(struct event_pool *event_pool, int fd,
 
     if (ret == -1) {
         gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_ADD_FAILED,
-                "fd=%d", fd, "epoll_fd=%d", event_pool->fd, NULL);
+                "fd=%d", fd, "epoll_fd=%d", slot->epfd, NULL);
         event_slot_unref(event_pool, slot, idx);
         idx = -1;
     }
@@ -448,11 +505,11 @@ event_unregister_epoll_common(struct event_pool *event_pool, int fd, int idx,
 
     LOCK(&slot->lock);
     {
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_DEL, fd, NULL);
+        ret = epoll_ctl(slot->epfd, EPOLL_CTL_DEL, fd, NULL);
 
         if (ret == -1) {
             gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_DEL_FAILED,
-                    "fd=%d", fd, "epoll_fd=%d", event_pool->fd, NULL);
+                    "fd=%d", fd, "epoll_fd=%d", slot->epfd, NULL);
             goto unlock;
         }
 
@@ -526,7 +583,7 @@ event_select_on_epoll(struct event_pool *event_pool, int fd, int idx,
              */
             goto unlock;
 
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_MOD, fd, &epoll_event);
+        ret = epoll_ctl(slot->epfd, EPOLL_CTL_MOD, fd, &epoll_event);
         if (ret == -1) {
             gf_smsg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_MODIFY_FAILED,
                     "fd=%d", fd, "events=%d", epoll_event.events, NULL);
@@ -634,6 +691,10 @@ event_dispatch_epoll_worker(void *data)
     int timetodie = 0, gen = 0;
     struct list_head poller_death_notify;
     struct event_slot_epoll *slot = NULL, *tmp = NULL;
+    struct event_thread_load *load = NULL;
+    struct timespec begin, end, elapsed;
+    int node = -1;
+    int epfd = -1;
 
     GF_VALIDATE_OR_GOTO("event", ev_data, out);
 
@@ -642,6 +703,8 @@ event_dispatch_epoll_worker(void *data)
 
     GF_VALIDATE_OR_GOTO("event", event_pool, out);
 
+    load = &event_pool->load[myindex - 1];
+
     gf_smsg("epoll", GF_LOG_INFO, 0, LG_MSG_STARTED_EPOLL_THREAD, "index=%d",
             myindex - 1, NULL);
 
@@ -714,7 +777,13 @@ event_dispatch_epoll_worker(void *data)
             }
         }
 
-        ret = epoll_wait(event_pool->fd, &event, 1, -1);
+        /* While bound to a node, wake up now and then so that turning NUMA
+         * mode off moves us back to the fd of the pool. When it is turned
+         * on, the fd of the pool stays the one of node 0 and keeps the
+         * connections made so far, so the next event there moves us. */
+        epfd = event_numa_poll_fd(event_pool, myindex - 1, &node);
+        ret = epoll_wait(epfd, &event, 1,
+                         (node >= 0) ? EVENT_NUMA_POLL_MS : -1);
 
         if (ret == 0)
             /* timeout */
@@ -724,7 +793,18 @@ event_dispatch_epoll_worker(void *data)
             /* sys call */
             continue;
 
-        ret = event_dispatch_epoll_handler(event_pool, &event);
+        /* timed for the autoscaler only, see event-autoscale.c */
+        if (CMM_LOAD_SHARED(event_pool->autoscale.running)) {
+            timespec_now(&begin);
+            ret = event_dispatch_epoll_handler(event_pool, &event);
+            timespec_now(&end);
+            timespec_sub(&begin, &end, &elapsed);
+            GF_ATOMIC_ADD(load->busy_ns,
+                          elapsed.tv_sec * 1000000000ULL + elapsed.tv_nsec);
+        } else {
+            ret = event_dispatch_epoll_handler(event_pool, &event);
+        }
+        GF_ATOMIC_INC(load->wakeups);
         if (ret) {
             gf_smsg("epoll", GF_LOG_ERROR, 0, LG_MSG_DISPATCH_HANDLER_FAILED,
                     NULL);
@@ -760,6 +840,10 @@ event_dispatch_epoll(struct event_pool *event_pool)
         if (pollercount <= 0)
             pollercount = 1;
 
+        /* Every node needs a thread polling its fd */
+        if (pollercount < event_pool->numa_nodes)
+            pollercount = event_pool->numa_nodes;
+
         event_pool->activethreadcount++;
 
         for (i = 0; i < pollercount; i++) {
@@ -856,6 +940,10 @@ event_reconfigure_threads_epoll(struct event_pool *event_pool, int value)
             /* Default pollers to 1 in case this is set incorrectly */
             if (value <= 0)
                 value = 1;
+
+            /* Every node needs a thread polling its fd */
+            if (value < event_pool->numa_nodes)
+                value = event_pool->numa_nodes;
         }
 
         oldthreadcount = event_pool->eventthreadcount;
@@ -905,6 +993,52 @@ event_reconfigure_threads_epoll(struct event_pool *event_pool, int value)
     return 0;
 }
 
+static int
+event_set_numa_epoll(struct event_pool *event_pool, gf_boolean_t numa)
+{
+    int nodes = gf_numa_node_count();
+    int threads = 0;
+    int ret = 0;
+    int i;
+
+    if (nodes > EVENT_NUMA_NODES)
+        nodes = EVENT_NUMA_NODES;
+
+    pthread_mutex_lock(&event_pool->mutex);
+    {
+        if (numa && (nodes > 1) && (event_pool->numa_nodes == 0)) {
+            event_pool->numa_fds[0] = event_pool->fd;
+            for (i = 1; i < nodes; i++) {
+                event_pool->numa_fds[i] = epoll_create(event_pool->count);
+                if (event_pool->numa_fds[i] < 0) {
+                    gf_smsg("epoll", GF_LOG_ERROR, errno,
+                            LG_MSG_EPOLL_FD_CREATE_FAILED, NULL);
+                    while (--i > 0)
+                        sys_close(event_pool->numa_fds[i]);
+                    ret = -1;
+                    goto unlock;
+                }
+            }
+
+            /* the event threads read the fds once they see the count */
+            cmm_smp_wmb();
+            CMM_STORE_SHARED(event_pool->numa_nodes, nodes);
+        }
+
+        CMM_STORE_SHARED(event_pool->numa,
+                         numa && (event_pool->numa_nodes > 1));
+        threads = event_pool->eventthreadcount;
+    }
+unlock:
+    pthread_mutex_unlock(&event_pool->mutex);
+
+    if ((ret == 0) && (threads < event_pool->numa_nodes))
+        ret = event_reconfigure_threads_epoll(event_pool,
+                                              event_pool->numa_nodes);
+
+    return ret;
+}
+
 /* This function is the destructor for the event_pool data structure
  * Should be called only after poller_threads_destroy() is called,
  * else will lead to crashes.
@@ -916,6 +1050,8 @@ event_pool_destroy_epoll(struct event_pool *event_pool)
     struct event_slot_epoll *table = NULL;
 
     ret = sys_close(event_pool->fd);
+    for (i = 1; i < event_pool->numa_nodes; i++)
+        sys_close(event_pool->numa_fds[i]);
 
     for (i = 0; i < EVENT_EPOLL_TABLES; i++) {
         if (event_pool->ereg[i]) {
@@ -934,6 +1070,7 @@ event_pool_destroy_epoll(struct event_pool *event_pool)
 
     GF_FREE(event_pool->evcache);
     GF_FREE(event_pool->reg);
+    GF_FREE(event_pool->load);
     GF_FREE(event_pool);
 
     return ret;
@@ -983,7 +1120,7 @@ event_handled_epoll(struct event_pool *event_pool, int fd, int idx, int gen)
             ev_data->idx = idx;
             ev_data->gen = gen;
 
-            ret = epoll_ctl(event_pool->fd, EPOLL_CTL_MOD, fd, &epoll_event);
+            ret = epoll_ctl(slot->epfd, EPOLL_CTL_MOD, fd, &epoll_event);
         }
     }
 unlock:
@@ -1004,6 +1141,7 @@ struct event_ops event_ops_epoll = {
     .event_reconfigure_threads = event_reconfigure_threads_epoll,
     .event_pool_destroy = event_pool_destroy_epoll,
     .event_handled = event_handled_epoll,
+    .event_set_numa = event_set_numa_epoll,
 };
 
 #endif
@@ -47,6 +47,9 @@ gf_event_pool_new(int count, int eventthreadcount)
             event_pool->ops = &event_ops_poll;
     }
 
+    if (event_pool)
+        gf_event_autoscale_init(&event_pool->autoscale);
+
     return event_pool;
 }
 
@@ -153,6 +156,10 @@ gf_event_pool_destroy(struct event_pool *event_pool)
         goto out;
     }
 
+    gf_event_autoscale_stop(event_pool);
+    pthread_mutex_destroy(&event_pool->autoscale.mutex);
+    pthread_cond_destroy(&event_pool->autoscale.cond);
+
     ret = event_pool->ops->event_pool_destroy(event_pool);
 out:
     return ret;
@@ -215,6 +222,9 @@ gf_event_dispatch_destroy(struct event_pool *event_pool)
     data.pool = event_pool;
     data.readfd = fd[1];
 
+    /* The autoscaler must not start threads behind our back. */
+    gf_event_autoscale_stop(event_pool);
+
     /* From the main thread register an event on the pipe fd[0],
      */
     idx = gf_event_register(event_pool, fd[0], poller_destroy_handler, &data, 1,
@@ -288,3 +298,20 @@ gf_event_handled(struct event_pool *event_pool, int fd, int idx, int gen)
 
     return ret;
 }
+
+/* Turns NUMA mode on or off. It is only supported by the epoll based pool,
+ * and does nothing on hosts with a single node. */
+int
+gf_event_pool_set_numa(struct event_pool *event_pool, gf_boolean_t numa)
+{
+    int ret = -1;
+
+    GF_VALIDATE_OR_GOTO("event", event_pool, out);
+
+    ret = 0;
+    if (event_pool->ops->event_set_numa)
+        ret = event_pool->ops->event_set_numa(event_pool, numa);
+
+out:
+    return ret;
+}
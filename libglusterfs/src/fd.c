@@ -11,83 +11,148 @@
 #include "glusterfs/fd.h"
 #include <errno.h>     // for EINVAL, errno, ENOMEM
 #include <inttypes.h>  // for PRIu64
+#include <sched.h>     // for sched_yield
 #include <stdint.h>    // for UINT32_MAX
 #include <string.h>    // for NULL, memcpy, memset, size_t
+#include <urcu/arch.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
 #include "glusterfs/statedump.h"
 
-static int
-gf_fd_fdtable_expand(fdtable_t *fdtable, uint32_t nr);
+/* Lookups of fd numbers, on every fop, take no lock: the segments of the
+ * table are published once and only freed with the table, and the free
+ * entries are kept in a lock-free stack. Only growing the table, which
+ * happens log2(fds) times, is serialized.
+ */
+
+#define GF_FDTABLE_HEAD(gen, idx) (((uint64_t)(gen) << 32) | (uint32_t)(idx))
+#define GF_FDTABLE_HEAD_IDX(head) ((int32_t)((head)&0xffffffff))
+#define GF_FDTABLE_HEAD_GEN(head) ((uint32_t)((head) >> 32))
 
 fd_t *
 __fd_ref(fd_t *fd);
 
-static int
-gf_fd_chain_fd_entries(fdentry_t *entries, uint32_t startidx, uint32_t endcount)
+static void
+gf_fd_segment_locate(int32_t fd, int *segment, uint32_t *offset)
 {
-    uint32_t i = 0;
+    uint32_t q = (uint32_t)fd / GF_FDTABLE_SEGMENT_SIZE + 1;
+    int k = 31 - __builtin_clz(q);
 
-    if (!entries) {
-        gf_msg_callingfn("fd", GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
-                         "!entries");
-        return -1;
-    }
+    *segment = k;
+    *offset = fd - GF_FDTABLE_SEGMENT_SIZE * ((1U << k) - 1);
+}
 
-    /* Chain only till the second to last entry because we want to
-     * ensure that the last entry has GF_FDTABLE_END.
-     */
-    for (i = startidx; i < (endcount - 1); i++)
-        entries[i].next_free = i + 1;
+static struct fd_table_slot *
+gf_fd_slot(fdtable_t *fdtable, int64_t fd)
+{
+    struct fd_table_slot *slots = NULL;
+    uint32_t offset = 0;
+    int segment = 0;
 
-    /* i has already been incremented up to the last entry. */
-    entries[i].next_free = GF_FDTABLE_END;
+    if ((fd < 0) || (fd >= CMM_LOAD_SHARED(fdtable->max_fds)))
+        return NULL;
 
-    return 0;
+    gf_fd_segment_locate(fd, &segment, &offset);
+    slots = CMM_LOAD_SHARED(fdtable->segments[segment]);
+    /* Pairs with the barrier publishing the segment. */
+    cmm_smp_read_barrier_depends();
+    if (!slots)
+        return NULL;
+
+    return &slots[offset];
 }
 
-static int
-gf_fd_fdtable_expand(fdtable_t *fdtable, uint32_t nr)
+/* Pushes the entries first..last, already chained, on the free stack. */
+static void
+gf_fd_free_push(fdtable_t *fdtable, int32_t first, struct fd_table_slot *last)
 {
-    fdentry_t *oldfds = NULL;
-    uint32_t oldmax_fds = -1;
-    int ret = -1;
+    uint64_t head = 0;
+    uint64_t old = 0;
+
+    head = uatomic_read(&fdtable->free_head);
+    for (;;) {
+        CMM_STORE_SHARED(last->next_free, GF_FDTABLE_HEAD_IDX(head));
+        old = uatomic_cmpxchg(&fdtable->free_head, head,
+                              GF_FDTABLE_HEAD(GF_FDTABLE_HEAD_GEN(head) + 1,
+                                              first));
+        if (old == head)
+            break;
+        head = old;
+    }
+}
 
-    if (fdtable == NULL || nr > UINT32_MAX) {
-        gf_msg_callingfn("fd", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
-                         "invalid argument");
-        ret = EINVAL;
-        goto out;
+/* Pops a free entry, GF_FDTABLE_END when there is none left. The next
+ * entry read from a popped entry may be stale, but then the generation of
+ * the head changed and the swap fails. */
+static int32_t
+gf_fd_free_pop(fdtable_t *fdtable)
+{
+    struct fd_table_slot *slot = NULL;
+    uint64_t head = 0;
+    uint64_t old = 0;
+    int32_t idx = 0;
+
+    head = uatomic_read(&fdtable->free_head);
+    for (;;) {
+        idx = GF_FDTABLE_HEAD_IDX(head);
+        if (idx == GF_FDTABLE_END)
+            return GF_FDTABLE_END;
+
+        slot = gf_fd_slot(fdtable, idx);
+        old = uatomic_cmpxchg(
+            &fdtable->free_head, head,
+            GF_FDTABLE_HEAD(GF_FDTABLE_HEAD_GEN(head) + 1,
+                            CMM_LOAD_SHARED(slot->next_free)));
+        if (old == head)
+            return idx;
+        head = old;
     }
+}
 
-    nr /= (1024 / sizeof(fdentry_t));
-    nr = gf_roundup_next_power_of_two(nr + 1);
-    nr *= (1024 / sizeof(fdentry_t));
+static int
+gf_fd_fdtable_expand(fdtable_t *fdtable)
+{
+    struct fd_table_slot *slots = NULL;
+    uint32_t size = 0;
+    uint32_t base = 0;
+    uint32_t i = 0;
+    int ret = 0;
 
-    oldfds = fdtable->fdentries;
-    oldmax_fds = fdtable->max_fds;
+    pthread_mutex_lock(&fdtable->lock);
+    {
+        /* another thread may have grown the table meanwhile */
+        if (GF_FDTABLE_HEAD_IDX(uatomic_read(&fdtable->free_head)) !=
+            GF_FDTABLE_END)
+            goto unlock;
+
+        if (fdtable->nr_segments == GF_FDTABLE_SEGMENTS) {
+            ret = EMFILE;
+            goto unlock;
+        }
 
-    fdtable->fdentries = GF_CALLOC(nr, sizeof(fdentry_t),
-                                   gf_common_mt_fdentry_t);
-    if (!fdtable->fdentries) {
-        ret = ENOMEM;
-        goto out;
-    }
-    fdtable->max_fds = nr;
+        size = GF_FDTABLE_SEGMENT_SIZE << fdtable->nr_segments;
+        base = fdtable->max_fds;
+        slots = GF_CALLOC(size, sizeof(*slots), gf_common_mt_fdentry_t);
+        if (!slots) {
+            ret = ENOMEM;
+            goto unlock;
+        }
 
-    if (oldfds) {
-        uint32_t cpy = oldmax_fds * sizeof(fdentry_t);
-        memcpy(fdtable->fdentries, oldfds, cpy);
-    }
+        for (i = 0; i < size - 1; i++)
+            slots[i].next_free = base + i + 1;
 
-    gf_fd_chain_fd_entries(fdtable->fdentries, oldmax_fds, fdtable->max_fds);
+        /* the entries must be visible before the segment */
+        cmm_smp_wmb();
+        CMM_STORE_SHARED(fdtable->segments[fdtable->nr_segments], slots);
+        fdtable->nr_segments++;
+        cmm_smp_wmb();
+        CMM_STORE_SHARED(fdtable->max_fds, base + size);
+
+        gf_fd_free_push(fdtable, base, &slots[size - 1]);
+    }
+unlock:
+    pthread_mutex_unlock(&fdtable->lock);
 
-    /* Now that expansion is done, we must update the fd list
-     * head pointer so that the fd allocation functions can continue
-     * using the expanded table.
-     */
-    fdtable->first_free = oldmax_fds;
-    GF_FREE(oldfds);
-    ret = 0;
-out:
     return ret;
 }
 
@@ -100,59 +165,67 @@ gf_fd_fdtable_alloc(void)
     if (!fdtable)
         return NULL;
 
-    pthread_rwlock_init(&fdtable->lock, NULL);
-
-    pthread_rwlock_wrlock(&fdtable->lock);
-    {
-        gf_fd_fdtable_expand(fdtable, 0);
-    }
-    pthread_rwlock_unlock(&fdtable->lock);
+    pthread_mutex_init(&fdtable->lock, NULL);
+    fdtable->free_head = GF_FDTABLE_HEAD(0, GF_FDTABLE_END);
+    gf_fd_fdtable_expand(fdtable);
 
     return fdtable;
 }
 
-static fdentry_t *
-__gf_fd_fdtable_get_all_fds(fdtable_t *fdtable, uint32_t *count)
+/* Takes the fd of an entry and waits for the lookups that may still be
+ * referencing it, after which the table's reference can be dropped. A
+ * lookup only holds 'readers' for the few instructions of its fd_ref(). */
+static fd_t *
+gf_fd_slot_take(struct fd_table_slot *slot, fd_t *expected)
 {
-    fdentry_t *fdentries = NULL;
+    fd_t *fdptr = NULL;
 
-    if (count == NULL) {
-        gf_msg_callingfn("fd", GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
-                         "!count");
-        goto out;
-    }
+    if (expected)
+        fdptr = uatomic_cmpxchg(&slot->fd, expected, NULL);
+    else
+        fdptr = uatomic_xchg(&slot->fd, NULL);
 
-    fdentries = fdtable->fdentries;
-    fdtable->fdentries = GF_CALLOC(fdtable->max_fds, sizeof(fdentry_t),
-                                   gf_common_mt_fdentry_t);
-    gf_fd_chain_fd_entries(fdtable->fdentries, 0, fdtable->max_fds);
-    *count = fdtable->max_fds;
+    if (!fdptr || (expected && (fdptr != expected)))
+        return NULL;
 
-out:
-    return fdentries;
+    while (uatomic_read(&slot->readers) != 0)
+        sched_yield();
+
+    return fdptr;
 }
 
-fdentry_t *
-gf_fd_fdtable_get_all_fds(fdtable_t *fdtable, uint32_t *count)
+static fd_t *
+gf_fd_slot_get(struct fd_table_slot *slot)
 {
-    fdentry_t *entries = NULL;
+    fd_t *fdptr = NULL;
 
-    if (fdtable) {
-        pthread_rwlock_wrlock(&fdtable->lock);
-        {
-            entries = __gf_fd_fdtable_get_all_fds(fdtable, count);
-        }
-        pthread_rwlock_unlock(&fdtable->lock);
-    }
+    uatomic_inc(&slot->readers);
+    /* Pairs with the exchange in gf_fd_slot_take(): either it sees us
+     * reading, or we see the entry cleared. */
+    cmm_smp_mb();
+    fdptr = CMM_LOAD_SHARED(slot->fd);
+    if (fdptr)
+        fd_ref(fdptr);
+    cmm_smp_mb();
+    uatomic_dec(&slot->readers);
 
-    return entries;
+    return fdptr;
+}
+
+static void
+gf_fd_slot_release(fdtable_t *fdtable, int32_t idx,
+                   struct fd_table_slot *slot)
+{
+    gf_fd_free_push(fdtable, idx, slot);
 }
 
 static fdentry_t *
-__gf_fd_fdtable_copy_all_fds(fdtable_t *fdtable, uint32_t *count)
+gf_fd_fdtable_collect(fdtable_t *fdtable, uint32_t *count, gf_boolean_t take)
 {
+    struct fd_table_slot *slot = NULL;
     fdentry_t *fdentries = NULL;
-    int i = 0;
+    uint32_t max_fds = 0;
+    uint32_t i = 0;
 
     if (count == NULL) {
         gf_msg_callingfn("fd", GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
@@ -160,36 +233,49 @@ __gf_fd_fdtable_copy_all_fds(fdtable_t *fdtable, uint32_t *count)
         goto out;
     }
 
-    fdentries = GF_CALLOC(fdtable->max_fds, sizeof(fdentry_t),
-                          gf_common_mt_fdentry_t);
+    max_fds = CMM_LOAD_SHARED(fdtable->max_fds);
+    fdentries = GF_CALLOC(max_fds, sizeof(fdentry_t), gf_common_mt_fdentry_t);
     if (fdentries == NULL) {
         goto out;
     }
 
-    *count = fdtable->max_fds;
+    *count = max_fds;
 
-    for (i = 0; i < fdtable->max_fds; i++) {
-        if (fdtable->fdentries[i].fd != NULL) {
-            fdentries[i].fd = fd_ref(fdtable->fdentries[i].fd);
+    for (i = 0; i < max_fds; i++) {
+        slot = gf_fd_slot(fdtable, i);
+        if (!take) {
+            fdentries[i].fd = gf_fd_slot_get(slot);
+            continue;
         }
+
+        fdentries[i].fd = gf_fd_slot_take(slot, NULL);
+        if (fdentries[i].fd)
+            gf_fd_slot_release(fdtable, i, slot);
     }
 
 out:
     return fdentries;
 }
 
+/* Empties the table, the caller owns the references of the returned fds. */
+fdentry_t *
+gf_fd_fdtable_get_all_fds(fdtable_t *fdtable, uint32_t *count)
+{
+    fdentry_t *entries = NULL;
+
+    if (fdtable)
+        entries = gf_fd_fdtable_collect(fdtable, count, _gf_true);
+
+    return entries;
+}
+
 fdentry_t *
 gf_fd_fdtable_copy_all_fds(fdtable_t *fdtable, uint32_t *count)
 {
     fdentry_t *entries = NULL;
 
-    if (fdtable) {
-        pthread_rwlock_rdlock(&fdtable->lock);
-        {
-            entries = __gf_fd_fdtable_copy_all_fds(fdtable, count);
-        }
-        pthread_rwlock_unlock(&fdtable->lock);
-    }
+    if (fdtable)
+        entries = gf_fd_fdtable_collect(fdtable, count, _gf_false);
 
     return entries;
 }
@@ -197,29 +283,18 @@ gf_fd_fdtable_copy_all_fds(fdtable_t *fdtable, uint32_t *count)
 void
 gf_fd_fdtable_destroy(fdtable_t *fdtable)
 {
-    struct list_head list = {
-        0,
-    };
     fd_t *fd = NULL;
     fdentry_t *fdentries = NULL;
     uint32_t fd_count = 0;
     int32_t i = 0;
 
-    INIT_LIST_HEAD(&list);
-
     if (!fdtable) {
         gf_msg_callingfn("fd", GF_LOG_WARNING, EINVAL, LG_MSG_INVALID_ARG,
                          "!fdtable");
         return;
     }
 
-    pthread_rwlock_wrlock(&fdtable->lock);
-    {
-        fdentries = __gf_fd_fdtable_get_all_fds(fdtable, &fd_count);
-        GF_FREE(fdtable->fdentries);
-    }
-    pthread_rwlock_unlock(&fdtable->lock);
-
+    fdentries = gf_fd_fdtable_collect(fdtable, &fd_count, _gf_true);
     if (fdentries != NULL) {
         for (i = 0; i < fd_count; i++) {
             fd = fdentries[i].fd;
@@ -229,18 +304,21 @@ gf_fd_fdtable_destroy(fdtable_t *fdtable)
         }
 
         GF_FREE(fdentries);
-        pthread_rwlock_destroy(&fdtable->lock);
-        GF_FREE(fdtable);
     }
+
+    for (i = 0; i < fdtable->nr_segments; i++)
+        GF_FREE(fdtable->segments[i]);
+
+    pthread_mutex_destroy(&fdtable->lock);
+    GF_FREE(fdtable);
 }
 
 int
 gf_fd_unused_get(fdtable_t *fdtable, fd_t *fdptr)
 {
+    struct fd_table_slot *slot = NULL;
     int32_t fd = -1;
-    fdentry_t *fde = NULL;
     int error;
-    int alloc_attempts = 0;
 
     if (fdtable == NULL || fdptr == NULL) {
         gf_msg_callingfn("fd", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
@@ -248,43 +326,20 @@ gf_fd_unused_get(fdtable_t *fdtable, fd_t *fdptr)
         return EINVAL;
     }
 
-    pthread_rwlock_wrlock(&fdtable->lock);
-    {
-    fd_alloc_try_again:
-        if (fdtable->first_free != GF_FDTABLE_END) {
-            fde = &fdtable->fdentries[fdtable->first_free];
-            fd = fdtable->first_free;
-            fdtable->first_free = fde->next_free;
-            fde->next_free = GF_FDENTRY_ALLOCATED;
-            fde->fd = fdptr;
-        } else {
-            /* If this is true, there is something
-             * seriously wrong with our data structures.
-             */
-            if (alloc_attempts >= 2) {
-                gf_msg("fd", GF_LOG_ERROR, 0, LG_MSG_EXPAND_FD_TABLE_FAILED,
-                       "multiple attempts to expand fd table"
-                       " have failed.");
-                goto out;
-            }
-            error = gf_fd_fdtable_expand(fdtable, fdtable->max_fds + 1);
-            if (error) {
-                gf_msg("fd", GF_LOG_ERROR, error, LG_MSG_EXPAND_FD_TABLE_FAILED,
-                       "Cannot expand fdtable");
-                goto out;
-            }
-            ++alloc_attempts;
-            /* At this point, the table stands expanded
-             * with the first_free referring to the first
-             * free entry in the new set of fdentries that
-             * have just been allocated. That means, the
-             * above logic should just work.
-             */
-            goto fd_alloc_try_again;
+    while ((fd = gf_fd_free_pop(fdtable)) == GF_FDTABLE_END) {
+        error = gf_fd_fdtable_expand(fdtable);
+        if (error) {
+            gf_msg("fd", GF_LOG_ERROR, error, LG_MSG_EXPAND_FD_TABLE_FAILED,
+                   "Cannot expand fdtable");
+            return -1;
         }
     }
-out:
-    pthread_rwlock_unlock(&fdtable->lock);
+
+    slot = gf_fd_slot(fdtable, fd);
+    CMM_STORE_SHARED(slot->next_free, GF_FDENTRY_ALLOCATED);
+    /* the fd is set up before it can be looked up */
+    cmm_smp_wmb();
+    CMM_STORE_SHARED(slot->fd, fdptr);
 
     return fd;
 }
@@ -292,8 +347,8 @@ out:
 void
 gf_fd_put(fdtable_t *fdtable, int32_t fd)
 {
+    struct fd_table_slot *slot = NULL;
     fd_t *fdptr = NULL;
-    fdentry_t *fde = NULL;
 
     if (fd == GF_ANON_FD_NO)
         return;
@@ -304,41 +359,34 @@ gf_fd_put(fdtable_t *fdtable, int32_t fd)
         return;
     }
 
-    if (!(fd < fdtable->max_fds)) {
+    slot = gf_fd_slot(fdtable, fd);
+    if (!slot) {
         gf_msg_callingfn("fd", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
                          "invalid argument");
         return;
     }
 
-    pthread_rwlock_wrlock(&fdtable->lock);
-    {
-        fde = &fdtable->fdentries[fd];
-        /* If the entry is not allocated, put operation must return
-         * without doing anything.
-         * This has the potential of masking out any bugs in a user of
-         * fd that ends up calling gf_fd_put twice for the same fd or
-         * for an unallocated fd, but it is a price we have to pay for
-         * ensuring sanity of our fd-table.
-         */
-        if (fde->next_free != GF_FDENTRY_ALLOCATED)
-            goto unlock_out;
-        fdptr = fde->fd;
-        fde->fd = NULL;
-        fde->next_free = fdtable->first_free;
-        fdtable->first_free = fd;
-    }
-unlock_out:
-    pthread_rwlock_unlock(&fdtable->lock);
+    /* If the entry is not allocated, put operation must return
+     * without doing anything.
+     * This has the potential of masking out any bugs in a user of
+     * fd that ends up calling gf_fd_put twice for the same fd or
+     * for an unallocated fd, but it is a price we have to pay for
+     * ensuring sanity of our fd-table.
+     */
+    fdptr = gf_fd_slot_take(slot, NULL);
+    if (!fdptr)
+        return;
 
-    if (fdptr) {
-        fd_unref(fdptr);
-    }
+    gf_fd_slot_release(fdtable, fd, slot);
+    fd_unref(fdptr);
 }
 
 void
 gf_fdptr_put(fdtable_t *fdtable, fd_t *fd)
 {
-    fdentry_t *fde = NULL;
+    struct fd_table_slot *slot = NULL;
+    fd_t *fdptr = NULL;
+    uint32_t max_fds = 0;
     int32_t i = 0;
 
     if ((fdtable == NULL) || (fd == NULL)) {
@@ -347,47 +395,33 @@ gf_fdptr_put(fdtable_t *fdtable, fd_t *fd)
         return;
     }
 
-    pthread_rwlock_wrlock(&fdtable->lock);
-    {
-        for (i = 0; i < fdtable->max_fds; i++) {
-            if (fdtable->fdentries[i].fd == fd) {
-                fde = &fdtable->fdentries[i];
-                break;
-            }
-        }
-
-        if (fde == NULL) {
-            gf_msg_callingfn("fd", GF_LOG_WARNING, 0,
-                             LG_MSG_FD_NOT_FOUND_IN_FDTABLE,
-                             "fd (%p) is not present in fdtable", fd);
-            goto unlock_out;
-        }
-
-        /* If the entry is not allocated, put operation must return
-         * without doing anything.
-         * This has the potential of masking out any bugs in a user of
-         * fd that ends up calling gf_fd_put twice for the same fd or
-         * for an unallocated fd, but it is a price we have to pay for
-         * ensuring sanity of our fd-table.
-         */
-        if (fde->next_free != GF_FDENTRY_ALLOCATED)
-            goto unlock_out;
-        fde->fd = NULL;
-        fde->next_free = fdtable->first_free;
-        fdtable->first_free = i;
+    max_fds = CMM_LOAD_SHARED(fdtable->max_fds);
+    for (i = 0; i < max_fds; i++) {
+        slot = gf_fd_slot(fdtable, i);
+        if (CMM_LOAD_SHARED(slot->fd) == fd)
+            break;
     }
-unlock_out:
-    pthread_rwlock_unlock(&fdtable->lock);
 
-    if ((fd != NULL) && (fde != NULL)) {
-        fd_unref(fd);
+    if (i == max_fds) {
+        gf_msg_callingfn("fd", GF_LOG_WARNING, 0,
+                         LG_MSG_FD_NOT_FOUND_IN_FDTABLE,
+                         "fd (%p) is not present in fdtable", fd);
+        return;
     }
+
+    /* already put if somebody else cleared it meanwhile */
+    fdptr = gf_fd_slot_take(slot, fd);
+    if (!fdptr)
+        return;
+
+    gf_fd_slot_release(fdtable, i, slot);
+    fd_unref(fdptr);
 }
 
 fd_t *
 gf_fd_fdptr_get(fdtable_t *fdtable, int64_t fd)
 {
-    fd_t *fdptr = NULL;
+    struct fd_table_slot *slot = NULL;
 
     if (fdtable == NULL || fd < 0) {
         gf_msg_callingfn("fd", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
@@ -396,23 +430,15 @@ gf_fd_fdptr_get(fdtable_t *fdtable, int64_t fd)
         return NULL;
     }
 
-    if (!(fd < fdtable->max_fds)) {
+    slot = gf_fd_slot(fdtable, fd);
+    if (!slot) {
         gf_msg_callingfn("fd", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
                          "invalid argument");
         errno = EINVAL;
         return NULL;
     }
 
-    pthread_rwlock_rdlock(&fdtable->lock);
-    {
-        fdptr = fdtable->fdentries[fd].fd;
-        if (fdptr) {
-            fd_ref(fdptr);
-        }
-    }
-    pthread_rwlock_unlock(&fdtable->lock);
-
-    return fdptr;
+    return gf_fd_slot_get(slot);
 }
 
 fd_t *
@@ -1037,38 +1063,35 @@ void
 fdtable_dump(fdtable_t *fdtable, char *prefix)
 {
     char key[GF_DUMP_MAX_BUF_LEN];
+    fdentry_t fdentry = {
+        .next_free = GF_FDENTRY_ALLOCATED,
+    };
+    uint32_t max_fds = 0;
     int i = 0;
-    int ret = -1;
 
     if (!fdtable)
         return;
 
-    ret = pthread_rwlock_tryrdlock(&fdtable->lock);
-    if (ret)
-        goto out;
+    max_fds = CMM_LOAD_SHARED(fdtable->max_fds);
 
     gf_proc_dump_build_key(key, prefix, "refcount");
     gf_proc_dump_write(key, "%d", fdtable->refcount);
     gf_proc_dump_build_key(key, prefix, "maxfds");
-    gf_proc_dump_write(key, "%d", fdtable->max_fds);
+    gf_proc_dump_write(key, "%u", max_fds);
     gf_proc_dump_build_key(key, prefix, "first_free");
-    gf_proc_dump_write(key, "%d", fdtable->first_free);
+    gf_proc_dump_write(
+        key, "%d", GF_FDTABLE_HEAD_IDX(uatomic_read(&fdtable->free_head)));
 
-    for (i = 0; i < fdtable->max_fds; i++) {
-        if (GF_FDENTRY_ALLOCATED == fdtable->fdentries[i].next_free) {
-            gf_proc_dump_build_key(key, prefix, "fdentry[%d]", i);
-            gf_proc_dump_add_section("%s", key);
-            fdentry_dump(&fdtable->fdentries[i], key);
-        }
-    }
-
-    pthread_rwlock_unlock(&fdtable->lock);
+    for (i = 0; i < max_fds; i++) {
+        fdentry.fd = gf_fd_slot_get(gf_fd_slot(fdtable, i));
+        if (!fdentry.fd)
+            continue;
 
-out:
-    if (ret != 0)
-        gf_proc_dump_write("Unable to dump the fdtable",
-                           "(Lock acquistion failed) %p", fdtable);
-    return;
+        gf_proc_dump_build_key(key, prefix, "fdentry[%d]", i);
+        gf_proc_dump_add_section("%s", key);
+        fdentry_dump(&fdentry, key);
+        fd_unref(fdentry.fd);
+    }
 }
 
 void
@@ -1161,6 +1184,10 @@ fdtable_dump_to_dict(fdtable_t *fdtable, char *prefix, dict_t *dict)
     char key[GF_DUMP_MAX_BUF_LEN] = {
         0,
     };
+    fdentry_t fdentry = {
+        .next_free = GF_FDENTRY_ALLOCATED,
+    };
+    uint32_t max_fds = 0;
     int i = 0;
     int openfds = 0;
     int ret = -1;
@@ -1170,38 +1197,34 @@ fdtable_dump_to_dict(fdtable_t *fdtable, char *prefix, dict_t *dict)
     if (!dict)
         return;
 
-    ret = pthread_rwlock_tryrdlock(&fdtable->lock);
-    if (ret)
-        return;
+    max_fds = CMM_LOAD_SHARED(fdtable->max_fds);
 
     snprintf(key, sizeof(key), "%s.fdtable.refcount", prefix);
     ret = dict_set_int32(dict, key, fdtable->refcount);
     if (ret)
-        goto out;
+        return;
 
     snprintf(key, sizeof(key), "%s.fdtable.maxfds", prefix);
-    ret = dict_set_uint32(dict, key, fdtable->max_fds);
+    ret = dict_set_uint32(dict, key, max_fds);
     if (ret)
-        goto out;
+        return;
 
     snprintf(key, sizeof(key), "%s.fdtable.firstfree", prefix);
-    ret = dict_set_int32(dict, key, fdtable->first_free);
+    ret = dict_set_int32(
+        dict, key, GF_FDTABLE_HEAD_IDX(uatomic_read(&fdtable->free_head)));
     if (ret)
-        goto out;
+        return;
 
-    for (i = 0; i < fdtable->max_fds; i++) {
-        if (GF_FDENTRY_ALLOCATED == fdtable->fdentries[i].next_free) {
-            snprintf(key, sizeof(key), "%s.fdtable.fdentry%d", prefix, i);
-            fdentry_dump_to_dict(&fdtable->fdentries[i], key, dict, &openfds);
-        }
+    for (i = 0; i < max_fds; i++) {
+        fdentry.fd = gf_fd_slot_get(gf_fd_slot(fdtable, i));
+        if (!fdentry.fd)
+            continue;
+
+        snprintf(key, sizeof(key), "%s.fdtable.fdentry%d", prefix, i);
+        fdentry_dump_to_dict(&fdentry, key, dict, &openfds);
+        fd_unref(fdentry.fd);
     }
 
     snprintf(key, sizeof(key), "%s.fdtable.openfds", prefix);
     ret = dict_set_int32(dict, key, openfds);
-    if (ret)
-        goto out;
-
-out:
-    pthread_rwlock_unlock(&fdtable->lock);
-    return;
 }
@@ -16,6 +16,7 @@
 #include <string.h>
 #include <assert.h>
 #include <pthread.h>
+#include <sched.h>
 #include <dirent.h>
 #include <unistd.h>
 #ifndef GF_BSD_HOST_OS
@@ -1094,6 +1095,37 @@ void
 gf_thread_set_name(pthread_t thread, const char *name, ...)
     __attribute__((__format__(__printf__, 2, 3)));
 
+/* NUMA topology, as exposed by sysfs. Nodes are numbered as in
+ * /sys/devices/system/node. All of these return -1 when the topology is
+ * not known (non-Linux hosts, sysfs not mounted, ...). */
+int
+gf_numa_node_count(void);
+
+int
+gf_numa_node_of_cpu(int cpu);
+
+int
+gf_numa_current_node(void);
+
+/* Restricts the calling thread to the cpus of node, or gives it back the
+ * affinity the process started with when node is -1. Returns 0 or -errno. */
+int
+gf_numa_bind_thread(int node);
+
+/* Asks the kernel to back the pages of [addr, addr + len) with memory of
+ * node, falling back to other nodes when it is full. Returns 0 or -errno. */
+int
+gf_numa_bind_memory(void *addr, size_t len, int node);
+
+/* Fills cpus with the cpus of node. Returns 0, or -1 when node has none. */
+#ifdef GF_LINUX_HOST_OS
+int
+gf_numa_node_cpus(int node, cpu_set_t *cpus);
+#else
+int
+gf_numa_node_cpus(int node, void *cpus);
+#endif
+
 gf_boolean_t
 gf_is_service_running(char *pidfile, int *pid);
 
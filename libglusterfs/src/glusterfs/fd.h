@@ -58,12 +58,32 @@ struct fd_table_entry {
 };
 typedef struct fd_table_entry fdentry_t;
 
+/* An entry of the table. fd is published once the entry is allocated and
+ * cleared when it is put; readers announce themselves in 'readers' while
+ * they take their reference, so that the table's reference is only dropped
+ * once no lookup can still be using the pointer they read. */
+struct fd_table_slot {
+    fd_t *fd;
+    int32_t next_free;
+    int32_t readers;
+};
+
+/* The table grows by segments that never move once published, so that
+ * lookups need no lock: segment k holds GF_FDTABLE_SEGMENT_SIZE << k entries,
+ * the first 64 fds being in segment 0, the next 128 in segment 1... */
+#define GF_FDTABLE_SEGMENT_SIZE 64
+#define GF_FDTABLE_SEGMENTS 25
+
 struct _fdtable {
     int refcount;
-    uint32_t max_fds;
-    pthread_rwlock_t lock;
-    fdentry_t *fdentries;
-    int first_free;
+    uint32_t max_fds;     /* entries in the published segments */
+    pthread_mutex_t lock; /* serializes the growth of the table */
+    struct fd_table_slot *segments[GF_FDTABLE_SEGMENTS];
+    int nr_segments;
+    /* index of the first free entry in the low 32 bits, tagged in the
+     * high ones with a generation bumped at every change so that a stale
+     * head cannot be swapped back in (ABA) */
+    uint64_t free_head;
 };
 typedef struct _fdtable fdtable_t;
 
@@ -31,10 +31,83 @@ typedef void (*event_handler_t)(int fd, int idx, int gen, void *data,
 #define EVENT_EPOLL_TABLES 1024
 #define EVENT_EPOLL_SLOTS 1024
 #define EVENT_MAX_THREADS 1024
+#define EVENT_NUMA_NODES 64
+/* How often, in ms, the event threads bound to a NUMA node look up the
+ * epoll fd they should be polling. */
+#define EVENT_NUMA_POLL_MS 1000
 
 /* See rpcsvc.h to check why. */
 GF_STATIC_ASSERT(EVENT_MAX_THREADS % __BITS_PER_LONG == 0);
 
+/* Work done by an event thread, padded so that the threads do not share
+ * the cache lines they update at every event. */
+struct event_thread_load {
+    gf_atomic_t busy_ns; /* time spent in event handlers */
+    gf_atomic_t wakeups; /* events dispatched */
+} __attribute__((aligned(64)));
+
+/* Load of the event threads over one sampling interval. */
+struct event_load {
+    uint64_t interval_ns;
+    uint64_t busy_ns;
+    uint64_t wakeups;
+    uint64_t backlog; /* requests waiting for their handler thread */
+    int threads;
+};
+
+/* Returns the number of requests waiting to be handled, see
+ * gf_event_autoscale_add_source(). */
+typedef uint64_t (*event_backlog_fn_t)(void *data);
+
+#define EVENT_AUTOSCALE_INTERVAL 1 /* seconds between two samples */
+/* A thread is added when the threads are busier than this (%), or when
+ * more requests than EVENT_AUTOSCALE_BACKLOG per thread are waiting. */
+#define EVENT_AUTOSCALE_HIGH 75
+#define EVENT_AUTOSCALE_BACKLOG 8
+/* A thread is removed when, for EVENT_AUTOSCALE_IDLE_SAMPLES samples in a
+ * row, the others would have been less busy than this (%) doing its work. */
+#define EVENT_AUTOSCALE_LOW 40
+#define EVENT_AUTOSCALE_IDLE_SAMPLES 10
+#define EVENT_AUTOSCALE_SOURCES 8
+#define EVENT_AUTOSCALE_HISTORY 16
+
+struct event_autoscale_decision {
+    time_t time;
+    int from;
+    int to;
+    int busy; /* % */
+    uint64_t wakeups;
+    uint64_t backlog;
+};
+
+/* Controller adjusting the number of event threads between min and max to
+ * the measured load. It is disabled while max is not above min. */
+struct event_autoscale {
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_t thread;
+    gf_boolean_t running;
+    int min;
+    int max;
+    int idle_samples; /* samples in a row allowing one thread less */
+
+    struct {
+        event_backlog_fn_t fn;
+        void *data;
+    } sources[EVENT_AUTOSCALE_SOURCES];
+
+    /* totals of the threads at the previous sample */
+    struct timespec sampled;
+    uint64_t busy_ns;
+    uint64_t wakeups;
+
+    struct event_load last;
+    uint64_t scale_ups;
+    uint64_t scale_downs;
+    uint64_t decisions; /* index of the next one in history */
+    struct event_autoscale_decision history[EVENT_AUTOSCALE_HISTORY];
+};
+
 struct event_pool {
     struct event_ops *ops;
 
@@ -79,6 +152,18 @@ struct event_pool {
      */
     int auto_thread_count;
 
+    struct event_thread_load *load; /* one per poller */
+    struct event_autoscale autoscale;
+
+    /* NUMA mode, see gf_event_pool_set_numa(). Each node gets an epoll fd
+     * of its own, polled by the event threads bound to the node, and the
+     * fds registered afterwards are spread over the nodes. The fds stay
+     * until the pool is destroyed, numa_fds[0] being fd. */
+    gf_boolean_t numa;
+    int numa_nodes; /* fds in numa_fds, 0 until NUMA mode is first set */
+    int numa_next;  /* node of the next fd registered */
+    int numa_fds[EVENT_NUMA_NODES];
+
     struct event_slot_epoll *ereg[EVENT_EPOLL_TABLES];
     pthread_t pollers[EVENT_MAX_THREADS]; /* poller thread_id store, and live
                                              status */
@@ -111,6 +196,7 @@ struct event_ops {
     int (*event_pool_destroy)(struct event_pool *event_pool);
     int (*event_handled)(struct event_pool *event_pool, int fd, int idx,
                          int gen);
+    int (*event_set_numa)(struct event_pool *event_pool, gf_boolean_t numa);
 };
 
 struct event_pool *
@@ -136,5 +222,27 @@ int
 gf_event_dispatch_destroy(struct event_pool *event_pool);
 int
 gf_event_handled(struct event_pool *event_pool, int fd, int idx, int gen);
+int
+gf_event_pool_set_numa(struct event_pool *event_pool, gf_boolean_t numa);
+
+void
+gf_event_autoscale_init(struct event_autoscale *as);
+int
+gf_event_autoscale_set(struct event_pool *event_pool, int min_threads,
+                       int max_threads);
+int
+gf_event_autoscale_shift(struct event_pool *event_pool, int incr);
+void
+gf_event_autoscale_stop(struct event_pool *event_pool);
+int
+gf_event_autoscale_add_source(struct event_pool *event_pool,
+                              event_backlog_fn_t fn, void *data);
+void
+gf_event_autoscale_del_source(struct event_pool *event_pool,
+                              event_backlog_fn_t fn, void *data);
+int
+gf_event_autoscale_decide(struct event_autoscale *as, struct event_load *load);
+void
+gf_event_pool_dump(struct event_pool *event_pool);
 
 #endif /* _GF_EVENT_H_ */
@@ -174,6 +174,8 @@ struct tvec_base *
 glusterfs_ctx_tw_get(glusterfs_ctx_t *ctx);
 void
 glusterfs_ctx_tw_put(glusterfs_ctx_t *ctx);
+void
+glusterfs_ctx_set_numa(glusterfs_ctx_t *ctx, gf_boolean_t numa);
 
 extern const char *gf_fop_list[];
 extern const char *gf_upcall_list[];
@@ -755,6 +755,9 @@ struct _glusterfs_ctx {
     gf_boolean_t destroy_ctx;
     char *hostname;
     char volume_id[GF_UUID_BUF_SIZE]; /* Used only in protocol/client */
+
+    /* NUMA mode, see glusterfs_ctx_set_numa() */
+    gf_boolean_t numa;
 };
 typedef struct _glusterfs_ctx glusterfs_ctx_t;
 
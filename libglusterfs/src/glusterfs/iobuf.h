@@ -17,8 +17,10 @@
 #include <sys/uio.h>            // for struct iovec
 #include "glusterfs/locking.h"  // for gf_lock_t
 #include "glusterfs/list.h"
+#include "glusterfs/glusterfs.h"  // for gf_boolean_t
 
 #define GF_VARIABLE_IOBUF_COUNT 32
+#define GF_IOBUF_NUMA_NODES 64
 
 /* Lets try to define the new anonymous mapping
  * flag, in case the system is still using the
@@ -110,12 +112,21 @@ struct iobuf_pool {
     uint64_t request_misses; /* mostly the requests for higher
                                value of iobufs */
     int arena_cnt;
+
+    /* In NUMA mode the arenas are taken from the pool of the node of the
+     * calling thread instead, created on first use and whose memory is
+     * placed on its node. */
+    gf_boolean_t numa;
+    int node; /* of the memory of the arenas, -1 for the main pool */
+    struct iobuf_pool *nodes[GF_IOBUF_NUMA_NODES];
 };
 
 struct iobuf_pool *
 iobuf_pool_new(void);
 void
 iobuf_pool_destroy(struct iobuf_pool *iobuf_pool);
+void
+iobuf_pool_set_numa(struct iobuf_pool *iobuf_pool, gf_boolean_t numa);
 struct iobuf *
 iobuf_get(struct iobuf_pool *iobuf_pool);
 void
@@ -119,6 +119,7 @@ typedef struct gf_log_handle_ {
     uint32_t timeout;
     uint8_t logrotate;
     uint8_t cmd_history_logrotate;
+    uint8_t async; /* see gf_log_set_async() */
 } gf_log_handle_t;
 
 typedef struct log_buf_ {
@@ -306,6 +307,9 @@ gf_log_set_logger(gf_log_logger_t logger);
 void
 gf_log_set_logformat(gf_log_format_t format);
 
+void
+gf_log_set_async(int on);
+
 void
 gf_log_set_log_buf_size(uint32_t buf_size);
 
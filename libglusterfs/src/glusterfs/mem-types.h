@@ -119,6 +119,8 @@ enum gf_common_mem_types_ {
     gf_common_mt_mgmt_v3_lock_timer_t, /* used only in one location */
     gf_common_mt_server_cmdline_t,     /* used only in one location */
     gf_common_mt_latency_t,
+    gf_common_mt_metric_t,
+    gf_common_mt_crawl_dir,
     gf_common_mt_end,
 };
 #endif
@@ -13,9 +13,138 @@
 
 #include "glusterfs/glusterfs.h"
 
+#include <urcu/uatomic.h>
+#ifdef GF_LINUX_HOST_OS
+#include <sched.h>
+#endif
+
 #define GLUSTER_METRICS_DIR "/var/run/gluster/metrics"
 
 char *
 gf_monitor_metrics(glusterfs_ctx_t *ctx);
 
+/*
+ * Live metrics registry.
+ *
+ * Metrics are registered once (typically from an xlator's init) and then
+ * updated from the fop path without taking any lock: every metric keeps
+ * GF_METRIC_SLOTS cache-line sized slots, and an update only touches the
+ * slot of the CPU the caller is running on. The slots are summed when the
+ * metrics are read, which is done by a thread serving the Prometheus text
+ * format on a unix socket (see gf_metrics_server_start()).
+ *
+ * A metric may instead be backed by a read function, which is called when
+ * the metrics are served. This is meant for values an xlator already keeps
+ * in its own counters, so that they do not have to be maintained twice.
+ * Read functions are called without any xlator lock held and must not
+ * block.
+ */
+
+#define GF_METRIC_SLOTS 16 /* must be a power of 2 */
+
+/* Histogram bucket i counts observations <= 2^i microseconds; the last
+ * bucket is +Inf. */
+#define GF_METRIC_HIST_BUCKETS 24
+
+typedef enum {
+    GF_METRIC_COUNTER,
+    GF_METRIC_GAUGE,
+    GF_METRIC_HISTOGRAM,
+} gf_metric_type_t;
+
+typedef struct gf_metric_slot {
+    int64_t value;
+} __attribute__((aligned(64))) gf_metric_slot_t;
+
+typedef struct gf_metric_hist_slot {
+    uint64_t bucket[GF_METRIC_HIST_BUCKETS];
+    uint64_t sum;
+    uint64_t count;
+} __attribute__((aligned(64))) gf_metric_hist_slot_t;
+
+typedef int64_t (*gf_metric_read_fn_t)(void *data);
+
+typedef struct gf_metric {
+    struct list_head list;
+    char *name;
+    char *labels; /* 'key="value",...' without braces, or NULL */
+    char *help;
+    gf_metric_type_t type;
+    gf_metric_read_fn_t read;
+    void *data;
+    union {
+        gf_metric_slot_t *slots;
+        gf_metric_hist_slot_t *hist;
+    } u;
+    void *data_mem; /* allocation backing 'u' */
+} gf_metric_t;
+
+static inline int
+gf_metric_slot(void)
+{
+#ifdef GF_LINUX_HOST_OS
+    int cpu = sched_getcpu();
+
+    if (cpu >= 0)
+        return cpu & (GF_METRIC_SLOTS - 1);
+#endif
+    return 0;
+}
+
+static inline void
+gf_metric_add(gf_metric_t *metric, int64_t value)
+{
+    uatomic_add(&metric->u.slots[gf_metric_slot()].value, value);
+}
+
+static inline void
+gf_metric_inc(gf_metric_t *metric)
+{
+    gf_metric_add(metric, 1);
+}
+
+static inline void
+gf_metric_dec(gf_metric_t *metric)
+{
+    gf_metric_add(metric, -1);
+}
+
+static inline void
+gf_metric_observe(gf_metric_t *metric, uint64_t usec)
+{
+    gf_metric_hist_slot_t *slot = &metric->u.hist[gf_metric_slot()];
+    int bucket = 0;
+
+    while ((bucket < GF_METRIC_HIST_BUCKETS - 1) && (usec > (1ULL << bucket)))
+        bucket++;
+
+    uatomic_inc(&slot->bucket[bucket]);
+    uatomic_add(&slot->sum, usec);
+    uatomic_inc(&slot->count);
+}
+
+gf_metric_t *
+gf_metric_register(const char *name, const char *labels, const char *help,
+                   gf_metric_type_t type);
+
+gf_metric_t *
+gf_metric_register_fn(const char *name, const char *labels, const char *help,
+                      gf_metric_type_t type, gf_metric_read_fn_t read,
+                      void *data);
+
+void
+gf_metric_unregister(gf_metric_t *metric);
+
+int64_t
+gf_metric_read_atomic(void *data);
+
+char *
+gf_metric_label_escape(char *buf, size_t size, const char *value);
+
+int
+gf_metrics_server_start(glusterfs_ctx_t *ctx);
+
+void
+gf_metrics_server_stop(void);
+
 #endif /* __MONITORING_H__ */
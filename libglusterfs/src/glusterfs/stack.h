@@ -46,17 +46,25 @@ typedef int32_t (*ret_fn_t)(call_frame_t *frame, call_frame_t *prev_frame,
 void
 gf_frame_latency_update(call_frame_t *frame);
 
-struct call_pool {
-    union {
-        struct list_head all_frames;
-        struct {
-            call_stack_t *next_call;
-            call_stack_t *prev_call;
-        } all_stacks;
-    };
-    int64_t cnt;
-    gf_atomic_t total_count;
+/* Stacks in flight are linked on one of GF_CALL_POOL_LISTS lists, the one
+ * of the thread that created them, so that threads winding fops do not
+ * contend on a single lock. Statedump and friends walk all the lists.
+ * The pool comes from GF_CALLOC, which does not align it to a cache line,
+ * so each list ends with a full line of padding: the lock and counters of
+ * two neighbours can never share a line. */
+#define GF_CALL_POOL_LISTS 64
+
+struct call_pool_list {
+    struct list_head all_frames;
+    int64_t cnt;    /* stacks in flight */
+    uint64_t total; /* stacks ever created */
+    uint64_t unique;
     gf_lock_t lock;
+    char _pad[64];
+};
+
+struct call_pool {
+    struct call_pool_list lists[GF_CALL_POOL_LISTS];
     struct mem_pool *frame_mem_pool;
     struct mem_pool *stack_mem_pool;
 };
@@ -99,6 +107,7 @@ struct _call_stack {
         };
     };
     call_pool_t *pool;
+    struct call_pool_list *list; /* the list of pool the stack is on */
     gf_lock_t stack_lock;
     client_t *client;
     uint64_t unique;
@@ -129,6 +138,10 @@ struct _call_stack {
                               creation of stack. */
 
     ns_info_t ns_info;
+
+    const char *qos_class; /* class features/qos scheduled the request in,
+                              NULL if it was not classified */
+    uint64_t qos_delay;    /* nanoseconds it was held back by features/qos */
 };
 
 /* call_stack flags field users */
@@ -178,12 +191,12 @@ STACK_DESTROY(call_stack_t *stack)
     call_frame_t *tmp = NULL;
     gf_boolean_t measure_latency;
 
-    LOCK(&stack->pool->lock);
+    LOCK(&stack->list->lock);
     {
         list_del_init(&stack->all_frames);
-        stack->pool->cnt--;
+        stack->list->cnt--;
     }
-    UNLOCK(&stack->pool->lock);
+    UNLOCK(&stack->list->lock);
 
     LOCK_DESTROY(&stack->stack_lock);
 
@@ -209,18 +222,18 @@ STACK_RESET(call_stack_t *stack)
 
     INIT_LIST_HEAD(&toreset);
 
-    /* We acquire call_pool->lock only to remove the frames from this stack
-     * to preserve atomicity. This synchronizes across concurrent requests
-     * like statedump, STACK_DESTROY etc. */
+    /* We acquire the lock of the stack's list only to remove the frames
+     * from this stack to preserve atomicity. This synchronizes across
+     * concurrent requests like statedump, STACK_DESTROY etc. */
 
-    LOCK(&stack->pool->lock);
+    LOCK(&stack->list->lock);
     {
         last = list_last_entry(&stack->myframes, call_frame_t, frames);
         list_del_init(&last->frames);
         list_splice_init(&stack->myframes, &toreset);
         list_add(&last->frames, &stack->myframes);
     }
-    UNLOCK(&stack->pool->lock);
+    UNLOCK(&stack->list->lock);
 
     measure_latency = stack->ctx->measure_latency;
     list_for_each_entry_safe(frame, tmp, &toreset, frames)
@@ -272,6 +285,19 @@ get_the_pt_fop(void *base_fop, int fop_idx)
     return (void *)*(unsigned long *)target_addr;
 }
 
+/* The xlator which really runs fop 'op' when wound to 'xl', skipping the
+ * ones which would only forward it to their first child. */
+#define FOP_TARGET(xl, op)                                                     \
+    ((xl)->fop_target[op] ? (xl)->fop_target[op] : (xl))
+
+/* The function of 'next_xl' for fop 'op', the pass-through one if it is in
+ * pass-through mode. */
+#define FOP_TARGET_FN(next_xl, op)                                             \
+    get_the_pt_fop((next_xl)->pass_through                                     \
+                       ? &(next_xl)->pass_through_fops->stat                   \
+                       : &(next_xl)->fops->stat,                               \
+                   op)
+
 /* make a call without switching frames */
 #define STACK_WIND_TAIL(frame, obj, fn, params...)                             \
     do {                                                                       \
@@ -280,6 +306,7 @@ get_the_pt_fop(void *base_fop, int fop_idx)
         typeof(fn) next_xl_fn = fn;                                            \
         int opn = get_fop_index_from_fn((next_xl), (fn));                      \
                                                                                \
+        next_xl = FOP_TARGET(next_xl, opn);                                    \
         frame->this = next_xl;                                                 \
         frame->wind_to = #fn;                                                  \
         old_THIS = THIS;                                                       \
@@ -294,10 +321,8 @@ get_the_pt_fop(void *base_fop, int fop_idx)
             GF_ATOMIC_INC(next_xl->stats[opn].interval_fop);                   \
         }                                                                      \
                                                                                \
-        if (next_xl->pass_through) {                                           \
-            next_xl_fn = get_the_pt_fop(&next_xl->pass_through_fops->stat,     \
-                                        opn);                                  \
-        }                                                                      \
+        if (next_xl->pass_through || (next_xl != (obj)))                       \
+            next_xl_fn = FOP_TARGET_FN(next_xl, opn);                          \
         next_xl_fn(frame, next_xl, params);                                    \
         THIS = old_THIS;                                                       \
     } while (0)
@@ -319,6 +344,7 @@ get_the_pt_fop(void *base_fop, int fop_idx)
     do {                                                                       \
         call_frame_t *_new = NULL;                                             \
         xlator_t *old_THIS = NULL;                                             \
+        xlator_t *next_xl = NULL;                                              \
         typeof(fn) next_xl_fn = fn;                                            \
                                                                                \
         _new = mem_get0(frame->root->pool->frame_mem_pool);                    \
@@ -326,8 +352,10 @@ get_the_pt_fop(void *base_fop, int fop_idx)
             break;                                                             \
         }                                                                      \
         typeof(fn##_cbk) tmp_cbk = rfn;                                        \
+        _new->op = get_fop_index_from_fn((obj), (fn));                         \
+        next_xl = FOP_TARGET(obj, _new->op);                                   \
         _new->root = frame->root;                                              \
-        _new->this = obj;                                                      \
+        _new->this = next_xl;                                                  \
         _new->ret = (ret_fn_t)tmp_cbk;                                         \
         _new->parent = frame;                                                  \
         /* (void *) is required for avoiding gcc warning */                    \
@@ -343,23 +371,30 @@ get_the_pt_fop(void *base_fop, int fop_idx)
         UNLOCK(&frame->root->stack_lock);                                      \
         fn##_cbk = rfn;                                                        \
         old_THIS = THIS;                                                       \
-        THIS = obj;                                                            \
+        THIS = next_xl;                                                        \
         gf_msg_trace("stack-trace", 0,                                         \
                      "stack-address: %p, "                                     \
                      "winding from %s to %s",                                  \
                      frame->root, old_THIS->name, THIS->name);                 \
         if (obj->ctx->measure_latency)                                         \
             timespec_now(&_new->begin);                                        \
-        _new->op = get_fop_index_from_fn((_new->this), (fn));                  \
         if (!obj->pass_through) {                                              \
             GF_ATOMIC_INC(obj->stats[_new->op].total_fop);                     \
             GF_ATOMIC_INC(obj->stats[_new->op].interval_fop);                  \
-        } else {                                                               \
+        }                                                                      \
+        if (next_xl != (obj)) {                                                \
+            /* the leaf counts fops forwarded to it, as in STACK_WIND_TAIL */  \
+            if (!next_xl->pass_through && !next_xl->children) {                \
+                GF_ATOMIC_INC(next_xl->stats[_new->op].total_fop);             \
+                GF_ATOMIC_INC(next_xl->stats[_new->op].interval_fop);          \
+            }                                                                  \
+            next_xl_fn = FOP_TARGET_FN(next_xl, _new->op);                     \
+        } else if (obj->pass_through) {                                        \
             /* we want to get to the actual fop to call */                     \
             next_xl_fn = get_the_pt_fop(&obj->pass_through_fops->stat,         \
                                         _new->op);                             \
         }                                                                      \
-        next_xl_fn(_new, obj, params);                                         \
+        next_xl_fn(_new, next_xl, params);                                     \
         THIS = old_THIS;                                                       \
     } while (0)
 
@@ -458,6 +493,9 @@ call_frames_count(call_stack_t *call_stack)
     return count;
 }
 
+void
+call_stack_link(call_stack_t *stack);
+
 static inline call_frame_t *
 copy_frame(call_frame_t *frame)
 {
@@ -513,7 +551,6 @@ copy_frame(call_frame_t *frame)
     }
     newstack->ngrps = oldstack->ngrps;
     memcpy(newstack->groups, oldstack->groups, sizeof(gid_t) * oldstack->ngrps);
-    newstack->unique = oldstack->unique;
     newstack->pool = oldstack->pool;
     lk_owner_copy(&newstack->lk_owner, &oldstack->lk_owner);
     newstack->ctx = oldstack->ctx;
@@ -526,13 +563,8 @@ copy_frame(call_frame_t *frame)
     LOCK_INIT(&newframe->lock);
     LOCK_INIT(&newstack->stack_lock);
 
-    LOCK(&oldstack->pool->lock);
-    {
-        list_add(&newstack->all_frames, &oldstack->all_frames);
-        newstack->pool->cnt++;
-    }
-    UNLOCK(&oldstack->pool->lock);
-    GF_ATOMIC_INC(newstack->pool->total_count);
+    call_stack_link(newstack);
+    newstack->unique = oldstack->unique;
 
     return newframe;
 }
@@ -545,6 +577,14 @@ void
 gf_proc_dump_pending_frames_to_dict(call_pool_t *call_pool, dict_t *dict);
 call_frame_t *
 create_frame(xlator_t *xl, call_pool_t *pool);
+void
+call_pool_init(call_pool_t *pool);
+void
+call_pool_fini(call_pool_t *pool);
+int64_t
+call_pool_inflight(call_pool_t *pool);
+uint64_t
+call_pool_total(call_pool_t *pool);
 gf_boolean_t
 __is_fuse_call(call_frame_t *frame);
 #endif /* _STACK_H */
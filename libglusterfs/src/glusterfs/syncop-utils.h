@@ -23,6 +23,14 @@ syncop_mt_dir_scan(call_frame_t *frame, xlator_t *subvol, loc_t *loc, int pid,
                    void *data, syncop_dir_scan_fn_t fn, dict_t *xdata,
                    uint32_t max_jobs, uint32_t max_qlen);
 
+/* Synctasks all the syncop_mt_ftw() crawls of a process run at once */
+#define SYNCOP_CRAWL_BUDGET 64
+
+int
+syncop_mt_ftw(call_frame_t *frame, xlator_t *subvol, loc_t *loc, int pid,
+              void *data, syncop_dir_scan_fn_t fn, uint32_t max_jobs,
+              uint32_t max_qlen);
+
 int
 syncop_dir_scan(xlator_t *subvol, loc_t *loc, int pid, void *data,
                 int (*fn)(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
@@ -801,6 +801,11 @@ struct _xlator {
     gf_boolean_t pass_through;
     struct xlator_fops *pass_through_fops;
 
+    /* For each fop, the xlator down the graph that really implements it,
+     * skipping the ones which would only pass it to their first child.
+     * NULL when not resolved, see xlator_resolve_fop_targets(). */
+    struct _xlator *fop_target[GF_FOP_MAXVALUE];
+
     struct {
         gf_atomic_t total_fop;
         gf_atomic_t interval_fop;
@@ -943,6 +948,8 @@ int
 xlator_notify(xlator_t *this, int32_t event, void *data, ...);
 int
 xlator_init(xlator_t *this);
+void
+xlator_resolve_fop_targets(xlator_t *xl);
 int
 xlator_destroy(xlator_t *xl);
 
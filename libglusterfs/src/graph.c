@@ -452,6 +452,25 @@ gluster_graph_set_params(xlator_t *xl, uint32_t level, uint32_t id)
     return xl->child_count + 1;
 }
 
+static void
+xlator_tree_resolve_fop_targets(xlator_t *xl)
+{
+    xlator_list_t *trav = NULL;
+
+    xlator_resolve_fop_targets(xl);
+    for (trav = xl->children; trav; trav = trav->next)
+        xlator_tree_resolve_fop_targets(trav->xlator);
+}
+
+/* Walks the tree rather than graph->first, which misses the bricks attached
+ * to a multiplexed server. */
+static void
+glusterfs_graph_resolve_fop_targets(glusterfs_graph_t *graph)
+{
+    if (graph->top)
+        xlator_tree_resolve_fop_targets(graph->top);
+}
+
 int
 glusterfs_graph_init(glusterfs_graph_t *graph)
 {
@@ -480,6 +499,9 @@ glusterfs_graph_init(glusterfs_graph_t *graph)
         trav = trav->next;
     }
 
+    /* all the xlators are in their pass-through mode now */
+    glusterfs_graph_resolve_fop_targets(graph);
+
     return 0;
 }
 
@@ -1138,6 +1160,7 @@ glusterfs_graph_reconfigure(glusterfs_graph_t *oldgraph,
     xlator_t *old_xl = NULL;
     xlator_t *new_xl = NULL;
     xlator_list_t *trav;
+    int ret = -1;
 
     GF_ASSERT(oldgraph);
     GF_ASSERT(newgraph);
@@ -1153,7 +1176,10 @@ glusterfs_graph_reconfigure(glusterfs_graph_t *oldgraph,
     }
 
     if (strcmp(old_xl->type, "protocol/server") != 0) {
-        return xlator_tree_reconfigure(old_xl, new_xl);
+        ret = xlator_tree_reconfigure(old_xl, new_xl);
+        /* xlators may have switched their pass-through mode */
+        glusterfs_graph_resolve_fop_targets(oldgraph);
+        return ret;
     }
 
     /* Some options still need to be handled by the server translator. */
@@ -1167,7 +1193,9 @@ glusterfs_graph_reconfigure(glusterfs_graph_t *oldgraph,
     for (trav = old_xl->children; trav; trav = trav->next) {
         if (!trav->xlator->cleanup_starting &&
             !strcmp(trav->xlator->name, new_xl->name)) {
-            return xlator_tree_reconfigure(trav->xlator, new_xl);
+            ret = xlator_tree_reconfigure(trav->xlator, new_xl);
+            glusterfs_graph_resolve_fop_targets(oldgraph);
+            return ret;
         }
     }
 
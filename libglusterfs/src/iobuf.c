@@ -8,6 +8,9 @@
   cases as published by the Free Software Foundation.
 */
 
+#include <urcu/arch.h>
+#include <urcu/system.h>
+
 #include "glusterfs/iobuf.h"
 #include "glusterfs/statedump.h"
 #include "glusterfs/libglusterfs-messages.h"
@@ -162,6 +165,13 @@ __iobuf_arena_alloc(struct iobuf_pool *iobuf_pool, size_t page_size,
         goto err;
     }
 
+    /* nothing has touched the pages yet, they all follow the policy */
+    if ((iobuf_pool->node >= 0) &&
+        (gf_numa_bind_memory(iobuf_arena->mem_base, iobuf_arena->arena_size,
+                             iobuf_pool->node) != 0))
+        gf_msg_debug("iobuf", 0, "arena %p could not be bound to node %d",
+                     iobuf_arena, iobuf_pool->node);
+
     __iobuf_arena_init_iobufs(iobuf_arena);
     if (!iobuf_arena->iobufs) {
         gf_smsg(THIS->name, GF_LOG_ERROR, 0, LG_MSG_INIT_IOBUF_FAILED, NULL);
@@ -228,6 +238,11 @@ iobuf_pool_destroy(struct iobuf_pool *iobuf_pool)
 
     GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
 
+    for (i = 0; i < GF_IOBUF_NUMA_NODES; i++) {
+        if (iobuf_pool->nodes[i])
+            iobuf_pool_destroy(iobuf_pool->nodes[i]);
+    }
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
         for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
@@ -300,8 +315,8 @@ err:
     return;
 }
 
-struct iobuf_pool *
-iobuf_pool_new(void)
+static struct iobuf_pool *
+iobuf_pool_new_node(int node)
 {
     struct iobuf_pool *iobuf_pool = NULL;
     int i = 0;
@@ -314,6 +329,7 @@ iobuf_pool_new(void)
         goto out;
 
     pthread_mutex_init(&iobuf_pool->mutex, NULL);
+    iobuf_pool->node = node;
     for (i = 0; i <= IOBUF_ARENA_MAX_INDEX; i++) {
         INIT_LIST_HEAD(&iobuf_pool->arenas[i]);
         INIT_LIST_HEAD(&iobuf_pool->filled[i]);
@@ -342,6 +358,56 @@ out:
     return iobuf_pool;
 }
 
+struct iobuf_pool *
+iobuf_pool_new(void)
+{
+    return iobuf_pool_new_node(-1);
+}
+
+/* NUMA mode only makes a difference on hosts with several nodes, and only
+ * to the iobufs served from the arenas. */
+void
+iobuf_pool_set_numa(struct iobuf_pool *iobuf_pool, gf_boolean_t numa)
+{
+    GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
+
+    CMM_STORE_SHARED(iobuf_pool->numa, numa && (gf_numa_node_count() > 1));
+out:
+    return;
+}
+
+/* The pool of the node of the calling thread, or iobuf_pool itself when
+ * that node is not known or its pool cannot be created. */
+static struct iobuf_pool *
+iobuf_pool_node(struct iobuf_pool *iobuf_pool)
+{
+    struct iobuf_pool *node_pool = NULL;
+    int node = gf_numa_current_node();
+
+    if ((node < 0) || (node >= GF_IOBUF_NUMA_NODES))
+        return iobuf_pool;
+
+    node_pool = CMM_LOAD_SHARED(iobuf_pool->nodes[node]);
+    if (node_pool)
+        return node_pool;
+
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    {
+        node_pool = iobuf_pool->nodes[node];
+        if (!node_pool) {
+            node_pool = iobuf_pool_new_node(node);
+            if (node_pool) {
+                node_pool->default_page_size = iobuf_pool->default_page_size;
+                cmm_smp_wmb();
+                CMM_STORE_SHARED(iobuf_pool->nodes[node], node_pool);
+            }
+        }
+    }
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+
+    return node_pool ? node_pool : iobuf_pool;
+}
+
 static void
 __iobuf_arena_prune(struct iobuf_pool *iobuf_pool,
                     struct iobuf_arena *iobuf_arena, const int index)
@@ -582,6 +648,9 @@ iobuf_get2(struct iobuf_pool *iobuf_pool, size_t page_size)
         return NULL;
     }
 
+    if (CMM_LOAD_SHARED(iobuf_pool->numa))
+        iobuf_pool = iobuf_pool_node(iobuf_pool);
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
         iobuf = __iobuf_get(iobuf_pool, rounded_size, index);
@@ -1057,6 +1126,13 @@ iobuf_stats_dump(struct iobuf_pool *iobuf_pool)
     gf_proc_dump_write("iobuf_pool.arena_cnt", "%d", iobuf_pool->arena_cnt);
     gf_proc_dump_write("iobuf_pool.request_misses", "%" PRId64,
                        iobuf_pool->request_misses);
+    gf_proc_dump_write("iobuf_pool.numa", "%d", iobuf_pool->numa);
+    for (j = 0; j < GF_IOBUF_NUMA_NODES; j++) {
+        if (!iobuf_pool->nodes[j])
+            continue;
+        snprintf(msg, sizeof(msg), "iobuf_pool.node%d.arena_cnt", j);
+        gf_proc_dump_write(msg, "%d", iobuf_pool->nodes[j]->arena_cnt);
+    }
 
     for (j = 0; j < IOBUF_ARENA_MAX_INDEX; j++) {
         list_for_each_entry(trav, &iobuf_pool->arenas[j], list)
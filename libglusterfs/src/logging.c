@@ -26,6 +26,7 @@
 #endif
 
 #include <sys/stat.h>
+#include <urcu/uatomic.h>
 
 #include "glusterfs/syscall.h"
 
@@ -93,6 +94,9 @@ log_buf_init(log_buf_t *buf, const char *domain, const char *file,
 static void
 gf_log_rotate(glusterfs_ctx_t *ctx);
 
+static int
+gf_log_async_drain(void);
+
 static char gf_level_strings[] = {
     ' ', /* NONE */
     'M', /* EMERGENCY */
@@ -424,6 +428,12 @@ gf_log_fini(void *data)
 
     gf_log_disable_suppression_before_exit(ctx);
 
+    /* write out what is still queued for the log file */
+    if (ctx->log.async) {
+        ctx->log.async = 0;
+        (void)gf_log_async_drain();
+    }
+
     pthread_mutex_lock(&ctx->log.logfile_mutex);
     {
         if (ctx->log.logfile) {
@@ -1284,10 +1294,11 @@ gf_log_syslog(glusterfs_ctx_t *ctx, const char *domain, const char *file,
 }
 
 static int
-gf_log_glusterlog(glusterfs_ctx_t *ctx, const char *domain, const char *file,
-                  const char *function, int32_t line, gf_loglevel_t level,
-                  int errnum, uint64_t msgid, char **appmsgstr, char *callstr,
-                  struct timeval tv, int graph_id, gf_log_format_t fmt)
+__gf_log_glusterlog(glusterfs_ctx_t *ctx, const char *domain, const char *file,
+                    const char *function, int32_t line, gf_loglevel_t level,
+                    int errnum, uint64_t msgid, char **appmsgstr,
+                    char *callstr, struct timeval tv, int graph_id,
+                    gf_log_format_t fmt, gf_boolean_t flush)
 {
     char timestr[GF_TIMESTR_SIZE] = {
         0,
@@ -1357,7 +1368,8 @@ gf_log_glusterlog(glusterfs_ctx_t *ctx, const char *domain, const char *file,
     {
         if (ctx->log.logfile) {
             fprintf(ctx->log.logfile, "%s%s", header, footer);
-            fflush(ctx->log.logfile);
+            if (flush)
+                fflush(ctx->log.logfile);
         } else if (ctx->log.loglevel >= level) {
             fprintf(stderr, "%s%s", header, footer);
             fflush(stderr);
@@ -1386,6 +1398,567 @@ err:
     return ret;
 }
 
+/*
+ * Asynchronous logging, see gf_log_set_async().
+ *
+ * Each thread that logs gets a ring of its own, written only by that thread
+ * and read only by the log writer thread, so queueing a message takes no
+ * lock and no syscall. The message is queued in binary form (timestamp,
+ * level, msgid, location and the application string); the header is
+ * formatted and the line written by the writer. gf_msg() formats the message
+ * straight into the ring, other callers have it copied there. When the ring
+ * of a thread is full the message is dropped and counted rather than waiting
+ * for the writer; the count is reported in the log once the writer catches
+ * up.
+ *
+ * The messages of one thread are written in the order they were logged, but
+ * there is no order between the messages of different threads. CRITICAL and
+ * more severe messages are not queued: the rings are drained and the message
+ * is written synchronously, so that it is in the log should the process die
+ * right after. Repeated messages flushed from the LRU are written
+ * synchronously as well.
+ */
+
+#define GF_LOG_RING_SIZE (64 * 1024)
+#define GF_LOG_REC_MAX (GF_LOG_RING_SIZE / 4)
+#define GF_LOG_WRITER_IDLE_MS 50
+
+typedef struct gf_log_rec_ {
+    uint32_t size; /* of the whole record, multiple of 8 */
+    uint32_t skip; /* filler up to the end of the ring */
+    glusterfs_ctx_t *ctx;
+    struct timeval tv;
+    uint64_t msgid;
+    int32_t line;
+    int32_t errnum;
+    int32_t graph_id;
+    uint16_t domain_len;
+    uint16_t file_len;
+    uint16_t function_len;
+    uint16_t callstr_len;
+    uint32_t msg_len;
+    uint8_t level;
+    uint8_t fmt;
+    char _pad[2];
+    char data[]; /* msg, domain, file, function, callstr: NUL terminated */
+} gf_log_rec_t;
+
+typedef struct gf_log_ring_ {
+    struct list_head list;
+    uint32_t head; /* written by the owning thread only */
+    uint32_t tail; /* written by the writer thread only */
+    int orphan;    /* owning thread has exited */
+    char buf[GF_LOG_RING_SIZE];
+} gf_log_ring_t;
+
+static struct {
+    pthread_once_t once;
+    pthread_key_t key;
+    pthread_mutex_t mutex;      /* single reader of the rings */
+    pthread_mutex_t rings_lock; /* rings list, never held while writing */
+    pthread_cond_t cond;
+    struct list_head rings;
+    pthread_t writer;
+    int writer_idle;
+    unsigned long dropped;
+    unsigned long reported;
+    int running;
+} gf_log_async = {
+    .once = PTHREAD_ONCE_INIT,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .rings_lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .rings = {&gf_log_async.rings, &gf_log_async.rings},
+};
+
+static __thread gf_log_ring_t *gf_log_thread_ring;
+static __thread int gf_log_is_writer;
+static __thread int gf_log_thread_exiting;
+
+/* Message formatted into the ring by gf_log_async_format(), not published
+ * yet. */
+static __thread struct {
+    gf_log_rec_t *rec;
+    uint32_t skip;
+    uint32_t room;
+} gf_log_pending;
+
+/* The writer frees the ring once it is orphaned and drained, so the thread
+ * lets go of it first. Whatever the thread logs from then on, from other
+ * destructors, is written synchronously. */
+static void
+gf_log_ring_orphan(void *data)
+{
+    gf_log_ring_t *ring = data;
+
+    gf_log_thread_ring = NULL;
+    gf_log_thread_exiting = 1;
+    uatomic_set(&ring->orphan, 1);
+}
+
+static void
+gf_log_async_init_once(void)
+{
+    if (pthread_key_create(&gf_log_async.key, gf_log_ring_orphan) != 0)
+        return;
+    gf_log_async.running = 1;
+}
+
+static gf_log_ring_t *
+gf_log_ring_get(void)
+{
+    gf_log_ring_t *ring = gf_log_thread_ring;
+
+    if (ring)
+        return ring;
+
+    if (gf_log_thread_exiting)
+        return NULL;
+
+    /* Not GF_MALLOC: the ring outlives its thread, and memory accounting
+     * may log. */
+    ring = calloc(1, sizeof(*ring));
+    if (!ring)
+        return NULL;
+    INIT_LIST_HEAD(&ring->list);
+
+    if (pthread_setspecific(gf_log_async.key, ring) != 0) {
+        free(ring);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&gf_log_async.rings_lock);
+    {
+        list_add_tail(&ring->list, &gf_log_async.rings);
+    }
+    pthread_mutex_unlock(&gf_log_async.rings_lock);
+
+    gf_log_thread_ring = ring;
+
+    return ring;
+}
+
+/* Contiguous room at the head of the ring for a record of at least @want
+ * bytes, 0 if the ring is full. @skip is set to the filler needed when the
+ * record has to go to the start of the ring. */
+static uint32_t
+gf_log_ring_room(gf_log_ring_t *ring, uint32_t want, uint32_t *skip)
+{
+    uint32_t avail = GF_LOG_RING_SIZE - (ring->head - uatomic_read(&ring->tail));
+    uint32_t end = GF_LOG_RING_SIZE - (ring->head & (GF_LOG_RING_SIZE - 1));
+
+    *skip = 0;
+    if (end >= want)
+        return (avail >= want) ? min(end, avail) : 0;
+
+    *skip = end;
+    return (avail >= end + want) ? avail - end : 0;
+}
+
+static gf_log_rec_t *
+gf_log_ring_rec(gf_log_ring_t *ring, uint32_t skip)
+{
+    if (skip)
+        return (gf_log_rec_t *)ring->buf;
+
+    return (gf_log_rec_t *)(ring->buf + (ring->head & (GF_LOG_RING_SIZE - 1)));
+}
+
+static void
+gf_log_ring_publish(gf_log_ring_t *ring, uint32_t skip, uint32_t size)
+{
+    gf_log_rec_t *filler = NULL;
+
+    if (skip) {
+        filler = (gf_log_rec_t *)(ring->buf +
+                                  (ring->head & (GF_LOG_RING_SIZE - 1)));
+        filler->size = 0;
+        filler->skip = skip;
+    }
+
+    /* publish the record before the new head */
+    cmm_smp_wmb();
+    uatomic_set(&ring->head, ring->head + skip + size);
+
+    if (uatomic_read(&gf_log_async.writer_idle))
+        pthread_cond_signal(&gf_log_async.cond);
+}
+
+/* Formats the message of gf_msg() into the ring of the thread, keeping room
+ * for the rest of the record, which gf_log_async_enqueue() fills in unless
+ * the message turns out to be a repetition. Returns the message, or NULL if
+ * the caller has to format it itself. */
+static char *
+gf_log_async_format(glusterfs_ctx_t *ctx, gf_loglevel_t level,
+                    const char *domain, const char *file, const char *function,
+                    const char *callstr, const char *fmt, va_list ap)
+{
+    gf_log_ring_t *ring = NULL;
+    gf_log_rec_t *rec = NULL;
+    size_t fixed = 0;
+    uint32_t room = 0;
+    uint32_t skip = 0;
+    int len = 0;
+
+    if (!ctx->log.async || ctx->log.logger != gf_logger_glusterlog ||
+        level <= GF_LOG_CRITICAL || gf_log_is_writer ||
+        !gf_log_async.running || gf_log_pending.rec)
+        return NULL;
+
+    /* the file name logged is its basename, never longer */
+    fixed = sizeof(*rec) + strlen(domain) + strlen(file) + strlen(function) +
+            (callstr ? strlen(callstr) : 0) + 5;
+    if (fixed + 1 > GF_LOG_REC_MAX)
+        return NULL;
+
+    ring = gf_log_ring_get();
+    if (!ring)
+        return NULL;
+
+    room = gf_log_ring_room(ring, (fixed + 1 + 7) & ~7, &skip);
+    if (!room)
+        return NULL;
+    room = min(room, GF_LOG_REC_MAX);
+
+    rec = gf_log_ring_rec(ring, skip);
+    len = vsnprintf(rec->data, room - fixed + 1, fmt, ap);
+    if (len < 0)
+        return NULL;
+
+    /* longer than what is left before the end of the ring, let it wrap */
+    if ((size_t)len > room - fixed) {
+        if (room < GF_LOG_REC_MAX)
+            return NULL;
+        len = room - fixed;
+    }
+
+    rec->msg_len = len;
+    gf_log_pending.rec = rec;
+    gf_log_pending.skip = skip;
+    gf_log_pending.room = room;
+
+    return rec->data;
+}
+
+/* Returns 0 if the message was queued or dropped, -1 if it has to be
+ * logged synchronously by the caller. */
+static int
+gf_log_async_enqueue(glusterfs_ctx_t *ctx, const char *domain,
+                     const char *file, const char *function, int32_t line,
+                     gf_loglevel_t level, int errnum, uint64_t msgid,
+                     const char *appmsgstr, const char *callstr,
+                     struct timeval tv, int graph_id, gf_log_format_t fmt)
+{
+    gf_log_ring_t *ring = NULL;
+    gf_log_rec_t *rec = NULL;
+    size_t domain_len = strlen(domain);
+    size_t file_len = strlen(file);
+    size_t function_len = strlen(function);
+    size_t callstr_len = callstr ? strlen(callstr) : 0;
+    size_t msg_len = 0;
+    size_t fixed = 0;
+    uint32_t size = 0;
+    uint32_t skip = 0;
+    char *p = NULL;
+
+    if (gf_log_is_writer || !gf_log_async.running)
+        return -1;
+
+    fixed = sizeof(*rec) + domain_len + file_len + function_len +
+            callstr_len + 5;
+    if (fixed + 1 > GF_LOG_REC_MAX || domain_len > UINT16_MAX ||
+        function_len > UINT16_MAX || file_len > UINT16_MAX ||
+        callstr_len > UINT16_MAX)
+        return -1;
+
+    ring = gf_log_thread_ring;
+    if (gf_log_pending.rec) {
+        /* the reserved room is at the head of the ring, anything else
+         * logged meanwhile (the flush of an LRU message) is written now */
+        if (appmsgstr != gf_log_pending.rec->data)
+            return -1;
+
+        rec = gf_log_pending.rec;
+        msg_len = rec->msg_len;
+        skip = gf_log_pending.skip;
+        size = (fixed + msg_len + 7) & ~7;
+        if (size > gf_log_pending.room)
+            return -1;
+        gf_log_pending.rec = NULL;
+    } else {
+        /* very long messages are cut rather than written out of order */
+        msg_len = strlen(appmsgstr);
+        if (fixed + msg_len > GF_LOG_REC_MAX)
+            msg_len = GF_LOG_REC_MAX - fixed;
+        size = (fixed + msg_len + 7) & ~7;
+
+        ring = gf_log_ring_get();
+        if (!ring)
+            return -1;
+
+        if (!gf_log_ring_room(ring, size, &skip)) {
+            uatomic_inc(&gf_log_async.dropped);
+            return 0;
+        }
+
+        rec = gf_log_ring_rec(ring, skip);
+        memcpy(rec->data, appmsgstr, msg_len);
+        rec->data[msg_len] = '\0';
+    }
+
+    rec->size = size;
+    rec->skip = 0;
+    rec->ctx = ctx;
+    rec->tv = tv;
+    rec->msgid = msgid;
+    rec->line = line;
+    rec->errnum = errnum;
+    rec->graph_id = graph_id;
+    rec->level = level;
+    rec->fmt = fmt;
+    rec->domain_len = domain_len;
+    rec->file_len = file_len;
+    rec->function_len = function_len;
+    rec->callstr_len = callstr_len;
+    rec->msg_len = msg_len;
+
+    p = rec->data + msg_len + 1;
+    memcpy(p, domain, domain_len + 1);
+    p += domain_len + 1;
+    memcpy(p, file, file_len + 1);
+    p += file_len + 1;
+    memcpy(p, function, function_len + 1);
+    p += function_len + 1;
+    if (callstr)
+        memcpy(p, callstr, callstr_len);
+    p[callstr_len] = '\0';
+
+    gf_log_ring_publish(ring, skip, size);
+
+    return 0;
+}
+
+static void
+gf_log_ctx_flush(glusterfs_ctx_t *ctx)
+{
+    pthread_mutex_lock(&ctx->log.logfile_mutex);
+    {
+        if (ctx->log.logfile)
+            fflush(ctx->log.logfile);
+    }
+    pthread_mutex_unlock(&ctx->log.logfile_mutex);
+}
+
+static void
+gf_log_rec_write(gf_log_rec_t *rec)
+{
+    char *msg = rec->data;
+    char *domain = msg + rec->msg_len + 1;
+    char *file = domain + rec->domain_len + 1;
+    char *function = file + rec->file_len + 1;
+    char *callstr = function + rec->function_len + 1;
+
+    (void)__gf_log_glusterlog(rec->ctx, domain, file, function, rec->line,
+                              rec->level, rec->errnum, rec->msgid, &msg,
+                              rec->callstr_len ? callstr : NULL, rec->tv,
+                              rec->graph_id, rec->fmt, _gf_false);
+}
+
+/* Called with gf_log_async.mutex held. Returns the number of messages
+ * written. */
+static int
+__gf_log_ring_drain(gf_log_ring_t *ring, glusterfs_ctx_t **last_ctx)
+{
+    gf_log_rec_t *rec = NULL;
+    uint32_t head = 0;
+    uint32_t tail = ring->tail;
+    uint32_t off = 0;
+    int count = 0;
+
+    head = uatomic_read(&ring->head);
+    /* read the records only after the head that published them */
+    cmm_smp_rmb();
+
+    while (tail != head) {
+        off = tail & (GF_LOG_RING_SIZE - 1);
+        rec = (gf_log_rec_t *)(ring->buf + off);
+        if (rec->skip) {
+            tail += rec->skip;
+            continue;
+        }
+
+        if (*last_ctx && *last_ctx != rec->ctx)
+            gf_log_ctx_flush(*last_ctx);
+        gf_log_rec_write(rec);
+        *last_ctx = rec->ctx;
+        tail += rec->size;
+        count++;
+    }
+
+    /* done with the records before handing the space back */
+    cmm_smp_mb();
+    uatomic_set(&ring->tail, tail);
+
+    return count;
+}
+
+/* The rings are taken off the list while they are drained, so that a
+ * thread registering its ring does not wait behind the writes. */
+static int
+gf_log_async_drain(void)
+{
+    gf_log_ring_t *ring = NULL;
+    gf_log_ring_t *tmp = NULL;
+    glusterfs_ctx_t *ctx = NULL;
+    unsigned long dropped = 0;
+    char *msg = NULL;
+    struct timeval tv = {
+        0,
+    };
+    struct list_head rings;
+    int count = 0;
+
+    INIT_LIST_HEAD(&rings);
+
+    pthread_mutex_lock(&gf_log_async.mutex);
+    {
+        pthread_mutex_lock(&gf_log_async.rings_lock);
+        {
+            list_splice_init(&gf_log_async.rings, &rings);
+        }
+        pthread_mutex_unlock(&gf_log_async.rings_lock);
+
+        list_for_each_entry_safe(ring, tmp, &rings, list)
+        {
+            count += __gf_log_ring_drain(ring, &ctx);
+
+            if (uatomic_read(&ring->orphan) &&
+                uatomic_read(&ring->head) == ring->tail) {
+                list_del_init(&ring->list);
+                free(ring);
+            }
+        }
+
+        /* ahead of the rings registered meanwhile */
+        pthread_mutex_lock(&gf_log_async.rings_lock);
+        {
+            list_splice(&rings, &gf_log_async.rings);
+        }
+        pthread_mutex_unlock(&gf_log_async.rings_lock);
+
+        dropped = uatomic_read(&gf_log_async.dropped);
+        if (ctx && dropped != gf_log_async.reported &&
+            gf_asprintf(&msg, "%lu log messages dropped, logging too fast",
+                        dropped - gf_log_async.reported) != -1) {
+            gettimeofday(&tv, NULL);
+            (void)__gf_log_glusterlog(ctx, "logging-infra", "logging.c",
+                                      __FUNCTION__, __LINE__, GF_LOG_WARNING,
+                                      0, 0, &msg, NULL, tv, 0,
+                                      gf_logformat_traditional, _gf_false);
+            GF_FREE(msg);
+            gf_log_async.reported = dropped;
+        }
+
+        if (ctx)
+            gf_log_ctx_flush(ctx);
+    }
+    pthread_mutex_unlock(&gf_log_async.mutex);
+
+    return count;
+}
+
+static void *
+gf_log_async_writer(void *data)
+{
+    struct timespec ts = {
+        0,
+    };
+
+    gf_log_is_writer = 1;
+
+    for (;;) {
+        if (gf_log_async_drain() > 0)
+            continue;
+
+        timespec_now_realtime(&ts);
+        ts.tv_nsec += GF_LOG_WRITER_IDLE_MS * 1000000;
+        if (ts.tv_nsec >= 1000000000) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000;
+        }
+
+        pthread_mutex_lock(&gf_log_async.mutex);
+        {
+            uatomic_set(&gf_log_async.writer_idle, 1);
+            pthread_cond_timedwait(&gf_log_async.cond, &gf_log_async.mutex,
+                                   &ts);
+            uatomic_set(&gf_log_async.writer_idle, 0);
+        }
+        pthread_mutex_unlock(&gf_log_async.mutex);
+    }
+
+    return NULL;
+}
+
+/* gf_log_set_async - queue log messages of this process to a writer thread
+ *                    instead of writing them from the logging thread.
+ *
+ * Messages are written asynchronously to the gluster log only, syslog and
+ * the deprecated gf_log() API stay synchronous. Messages still queued when
+ * the process is killed are lost.
+ */
+void
+gf_log_set_async(int on)
+{
+    glusterfs_ctx_t *ctx = THIS->ctx;
+    int ret = 0;
+
+    if (on) {
+        (void)pthread_once(&gf_log_async.once, gf_log_async_init_once);
+        if (!gf_log_async.running)
+            return;
+
+        pthread_mutex_lock(&gf_log_async.mutex);
+        {
+            if (!gf_log_async.writer) {
+                ret = gf_thread_create_detached(&gf_log_async.writer,
+                                                gf_log_async_writer, NULL,
+                                                "logwr");
+                if (ret)
+                    gf_log_async.writer = 0;
+            }
+        }
+        pthread_mutex_unlock(&gf_log_async.mutex);
+
+        if (ret)
+            return;
+    }
+
+    ctx->log.async = on;
+}
+
+static int
+gf_log_glusterlog(glusterfs_ctx_t *ctx, const char *domain, const char *file,
+                  const char *function, int32_t line, gf_loglevel_t level,
+                  int errnum, uint64_t msgid, char **appmsgstr, char *callstr,
+                  struct timeval tv, int graph_id, gf_log_format_t fmt)
+{
+    if (ctx->log.async && level <= GF_LOG_CRITICAL) {
+        /* what was queued before it goes first */
+        if (!gf_log_is_writer && gf_log_async.running)
+            (void)gf_log_async_drain();
+    } else if (ctx->log.async &&
+               gf_log_async_enqueue(ctx, domain, file, function, line, level,
+                                    errnum, msgid, *appmsgstr, callstr, tv,
+                                    graph_id, fmt) == 0) {
+        return 0;
+    }
+
+    return __gf_log_glusterlog(ctx, domain, file, function, line, level,
+                               errnum, msgid, appmsgstr, callstr, tv, graph_id,
+                               fmt, _gf_true);
+}
+
 static int
 gf_syslog_log_repetitions(const char *domain, const char *file,
                           const char *function, int32_t line,
@@ -1930,6 +2503,7 @@ _gf_msg(const char *domain, const char *file, const char *function,
     xlator_t *this = THIS;
     glusterfs_ctx_t *ctx = NULL;
     char *callstr = NULL;
+    char *inring = NULL;
     int log_inited = 0;
 
     if (this == NULL)
@@ -1952,34 +2526,45 @@ _gf_msg(const char *domain, const char *file, const char *function,
         return -1;
     }
 
-    /* form the message */
-    va_start(ap, fmt);
-    ret = vasprintf(&msgstr, fmt, ap);
-    va_end(ap);
-
-    /* log */
-    if (ret != -1) {
-        if (trace) {
-            callstr = GF_MALLOC(GF_LOG_BACKTRACE_SIZE, gf_common_mt_char);
-            if (callstr == NULL)
-                return -1;
+    if (trace) {
+        callstr = GF_MALLOC(GF_LOG_BACKTRACE_SIZE, gf_common_mt_char);
+        if (callstr == NULL)
+            return -1;
 
-            ret = _gf_msg_backtrace(GF_LOG_BACKTRACE_DEPTH, callstr,
-                                    GF_LOG_BACKTRACE_SIZE);
-            if (ret < 0) {
-                GF_FREE(callstr);
-                callstr = NULL;
-            }
+        ret = _gf_msg_backtrace(GF_LOG_BACKTRACE_DEPTH, callstr,
+                                GF_LOG_BACKTRACE_SIZE);
+        if (ret < 0) {
+            GF_FREE(callstr);
+            callstr = NULL;
         }
+    }
 
-        pthread_mutex_lock(&ctx->log.logfile_mutex);
-        {
-            if (ctx->log.logfile) {
-                log_inited = 1;
-            }
+    pthread_mutex_lock(&ctx->log.logfile_mutex);
+    {
+        if (ctx->log.logfile) {
+            log_inited = 1;
         }
-        pthread_mutex_unlock(&ctx->log.logfile_mutex);
+    }
+    pthread_mutex_unlock(&ctx->log.logfile_mutex);
 
+    /* form the message, in the log ring if it is queued */
+    if (log_inited) {
+        va_start(ap, fmt);
+        inring = gf_log_async_format(ctx, level, domain, file, function,
+                                     callstr, fmt, ap);
+        va_end(ap);
+    }
+    if (inring) {
+        msgstr = inring;
+        ret = 0;
+    } else {
+        va_start(ap, fmt);
+        ret = vasprintf(&msgstr, fmt, ap);
+        va_end(ap);
+    }
+
+    /* log */
+    if (ret != -1) {
         if (!log_inited && ctx->log.gf_log_syslog) {
             ret = gf_log_syslog(
                 ctx, domain, file, function, line, level, errnum, msgid,
@@ -1997,7 +2582,10 @@ _gf_msg(const char *domain, const char *file, const char *function,
     }
     if (callstr)
         GF_FREE(callstr);
-    FREE(msgstr);
+    if (!inring)
+        FREE(msgstr);
+    else if (gf_log_pending.rec && gf_log_pending.rec->data == inring)
+        gf_log_pending.rec = NULL; /* a repetition, not queued */
 
 out:
     return ret;
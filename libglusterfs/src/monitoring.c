@@ -11,8 +11,12 @@
 #include "glusterfs/monitoring.h"
 #include "glusterfs/xlator.h"
 #include "glusterfs/syscall.h"
+#include "glusterfs/libglusterfs-messages.h"
 
 #include <stdlib.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 static void
 dump_mem_acct_details(xlator_t *xl, int fd)
@@ -103,9 +107,9 @@ dump_latency_and_count(xlator_t *xl, int fd)
 static inline void
 dump_call_stack_details(glusterfs_ctx_t *ctx, int fd)
 {
-    dprintf(fd, "total.stack.count %" PRIu64 "\n",
-            GF_ATOMIC_GET(ctx->pool->total_count));
-    dprintf(fd, "total.stack.in-flight %" PRIu64 "\n", ctx->pool->cnt);
+    dprintf(fd, "total.stack.count %" PRIu64 "\n", call_pool_total(ctx->pool));
+    dprintf(fd, "total.stack.in-flight %" PRId64 "\n",
+            call_pool_inflight(ctx->pool));
 }
 
 static inline void
@@ -242,3 +246,477 @@ gf_monitor_metrics(glusterfs_ctx_t *ctx)
     /* Figure this out, not happy with returning this string */
     return filepath;
 }
+
+/* Registry of live metrics and the unix socket they are served on. 'lock'
+ * protects the list and is never taken by metric updates, 'server_lock'
+ * serializes starting and stopping the server. */
+static struct {
+    pthread_mutex_t lock;
+    struct list_head metrics;
+    pthread_mutex_t server_lock;
+    glusterfs_ctx_t *ctx;
+    pthread_t thread;
+    char *path;
+    int sock;
+    int refs;
+    int stop;
+} gf_metrics = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .server_lock = PTHREAD_MUTEX_INITIALIZER,
+    .metrics = {&gf_metrics.metrics, &gf_metrics.metrics},
+    .sock = -1,
+};
+
+#define GF_METRIC_ALIGN(ptr)                                                   \
+    ((void *)(((uintptr_t)(ptr) + 63) & ~(uintptr_t)63))
+
+static void
+gf_metric_free(gf_metric_t *metric)
+{
+    GF_FREE(metric->name);
+    GF_FREE(metric->labels);
+    GF_FREE(metric->help);
+    GF_FREE(metric->data_mem);
+    GF_FREE(metric);
+}
+
+static gf_metric_t *
+gf_metric_new(const char *name, const char *labels, const char *help,
+              gf_metric_type_t type, gf_metric_read_fn_t read, void *data)
+{
+    gf_metric_t *metric = NULL;
+    gf_metric_t *tmp = NULL;
+    struct list_head *pos = NULL;
+    size_t size = 0;
+
+    GF_VALIDATE_OR_GOTO("monitoring", name, out);
+    GF_VALIDATE_OR_GOTO("monitoring", help, out);
+
+    metric = GF_CALLOC(1, sizeof(*metric), gf_common_mt_metric_t);
+    if (!metric)
+        goto out;
+
+    INIT_LIST_HEAD(&metric->list);
+    metric->type = type;
+    metric->read = read;
+    metric->data = data;
+    metric->name = gf_strdup(name);
+    metric->help = gf_strdup(help);
+    if (labels && labels[0])
+        metric->labels = gf_strdup(labels);
+    if (!metric->name || !metric->help ||
+        (labels && labels[0] && !metric->labels))
+        goto err;
+
+    if (!read) {
+        if (type == GF_METRIC_HISTOGRAM)
+            size = GF_METRIC_SLOTS * sizeof(gf_metric_hist_slot_t);
+        else
+            size = GF_METRIC_SLOTS * sizeof(gf_metric_slot_t);
+
+        /* the slots are aligned by hand so that no two CPUs ever share a
+         * cache line */
+        metric->data_mem = GF_CALLOC(1, size + 63, gf_common_mt_metric_t);
+        if (!metric->data_mem)
+            goto err;
+        metric->u.slots = GF_METRIC_ALIGN(metric->data_mem);
+    }
+
+    /* Metrics sharing a name are kept next to each other, the text format
+     * wants them grouped under a single HELP and TYPE line. */
+    pthread_mutex_lock(&gf_metrics.lock);
+    {
+        pos = gf_metrics.metrics.prev;
+        list_for_each_entry(tmp, &gf_metrics.metrics, list)
+        {
+            if (strcmp(tmp->name, name))
+                continue;
+            if (tmp->type != type) {
+                pthread_mutex_unlock(&gf_metrics.lock);
+                gf_msg("monitoring", GF_LOG_ERROR, EINVAL,
+                       LG_MSG_INVALID_ARG,
+                       "metric %s already registered with another type",
+                       name);
+                goto err;
+            }
+            pos = &tmp->list;
+        }
+        list_add(&metric->list, pos);
+    }
+    pthread_mutex_unlock(&gf_metrics.lock);
+
+    return metric;
+err:
+    gf_metric_free(metric);
+    metric = NULL;
+out:
+    return metric;
+}
+
+/* Registers a metric updated with gf_metric_add() or gf_metric_observe().
+ * 'labels' is copied, it is the label list without the braces, e.g.
+ * 'xlator="patchy-io-stats",fop="WRITE"'. */
+gf_metric_t *
+gf_metric_register(const char *name, const char *labels, const char *help,
+                   gf_metric_type_t type)
+{
+    return gf_metric_new(name, labels, help, type, NULL, NULL);
+}
+
+/* Registers a counter or gauge whose value is returned by 'read' */
+gf_metric_t *
+gf_metric_register_fn(const char *name, const char *labels, const char *help,
+                      gf_metric_type_t type, gf_metric_read_fn_t read,
+                      void *data)
+{
+    if (!read || (type == GF_METRIC_HISTOGRAM)) {
+        gf_msg("monitoring", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
+               "metric %s can not be backed by a read function", name);
+        return NULL;
+    }
+
+    return gf_metric_new(name, labels, help, type, read, data);
+}
+
+/* Copies 'value' into 'buf' as a label value, with backslash, double quote
+ * and newline escaped as the text format wants. Cut to fit in 'size'. */
+char *
+gf_metric_label_escape(char *buf, size_t size, const char *value)
+{
+    size_t len = 0;
+
+    for (; *value && (len + 2 < size); value++) {
+        if ((*value == '\\') || (*value == '"')) {
+            buf[len++] = '\\';
+            buf[len++] = *value;
+        } else if (*value == '\n') {
+            buf[len++] = '\\';
+            buf[len++] = 'n';
+        } else {
+            buf[len++] = *value;
+        }
+    }
+    buf[len] = '\0';
+
+    return buf;
+}
+
+/* Read function for a metric backed by a gf_atomic_t */
+int64_t
+gf_metric_read_atomic(void *data)
+{
+    return GF_ATOMIC_GET(*(gf_atomic_t *)data);
+}
+
+/* Once this returns the metric is no longer read by the server. It is up to
+ * the caller to make sure nobody updates it anymore. */
+void
+gf_metric_unregister(gf_metric_t *metric)
+{
+    if (!metric)
+        return;
+
+    pthread_mutex_lock(&gf_metrics.lock);
+    {
+        list_del_init(&metric->list);
+    }
+    pthread_mutex_unlock(&gf_metrics.lock);
+
+    gf_metric_free(metric);
+}
+
+static void
+gf_metric_print_header(FILE *fp, const char *name, const char *help,
+                       gf_metric_type_t type)
+{
+    static const char *types[] = {
+        [GF_METRIC_COUNTER] = "counter",
+        [GF_METRIC_GAUGE] = "gauge",
+        [GF_METRIC_HISTOGRAM] = "histogram",
+    };
+
+    fprintf(fp, "# HELP %s %s\n# TYPE %s %s\n", name, help, name,
+            types[type]);
+}
+
+static void
+gf_metric_print(FILE *fp, gf_metric_t *metric)
+{
+    const char *labels = metric->labels ? metric->labels : "";
+    const char *sep = metric->labels ? "," : "";
+    uint64_t bucket[GF_METRIC_HIST_BUCKETS] = {
+        0,
+    };
+    uint64_t sum = 0;
+    uint64_t count = 0;
+    int64_t value = 0;
+    int i = 0;
+    int j = 0;
+
+    if (metric->type != GF_METRIC_HISTOGRAM) {
+        if (metric->read) {
+            value = metric->read(metric->data);
+        } else {
+            for (i = 0; i < GF_METRIC_SLOTS; i++)
+                value += uatomic_read(&metric->u.slots[i].value);
+        }
+        fprintf(fp, "%s%s%s%s %" PRId64 "\n", metric->name,
+                metric->labels ? "{" : "", labels, metric->labels ? "}" : "",
+                value);
+        return;
+    }
+
+    for (i = 0; i < GF_METRIC_SLOTS; i++) {
+        for (j = 0; j < GF_METRIC_HIST_BUCKETS; j++)
+            bucket[j] += uatomic_read(&metric->u.hist[i].bucket[j]);
+        sum += uatomic_read(&metric->u.hist[i].sum);
+        count += uatomic_read(&metric->u.hist[i].count);
+    }
+
+    /* buckets are cumulative in the text format */
+    for (j = 0; j < GF_METRIC_HIST_BUCKETS; j++) {
+        if (j)
+            bucket[j] += bucket[j - 1];
+        if (j < GF_METRIC_HIST_BUCKETS - 1)
+            fprintf(fp, "%s_bucket{%s%sle=\"%llu\"} %" PRIu64 "\n",
+                    metric->name, labels, sep, 1ULL << j, bucket[j]);
+        else
+            fprintf(fp, "%s_bucket{%s%sle=\"+Inf\"} %" PRIu64 "\n",
+                    metric->name, labels, sep, bucket[j]);
+    }
+    fprintf(fp, "%s_sum%s%s%s %" PRIu64 "\n", metric->name,
+            metric->labels ? "{" : "", labels, metric->labels ? "}" : "", sum);
+    fprintf(fp, "%s_count%s%s%s %" PRIu64 "\n", metric->name,
+            metric->labels ? "{" : "", labels, metric->labels ? "}" : "",
+            count);
+}
+
+/* Fop counters every xlator keeps anyway, read straight from the atomics.
+ * Like gf_monitor_metrics() only the active graph is looked at. It is
+ * walked under the cleanup lock, which a graph is destroyed or detached
+ * under. */
+static void
+gf_metrics_print_xlators(FILE *fp, glusterfs_ctx_t *ctx)
+{
+    xlator_t *xl = NULL;
+    char name[512];
+    uint64_t count = 0;
+    int i = 0;
+
+    gf_metric_print_header(fp, "gluster_call_stacks_in_flight",
+                           "Call stacks currently in flight", GF_METRIC_GAUGE);
+    fprintf(fp, "gluster_call_stacks_in_flight %" PRIu64 "\n",
+            (uint64_t)call_pool_inflight(ctx->pool));
+
+    pthread_mutex_lock(&ctx->cleanup_lock);
+    {
+        if (!ctx->active)
+            goto unlock;
+
+        gf_metric_print_header(fp, "gluster_xlator_fops_total",
+                               "Fops wound to the translator",
+                               GF_METRIC_COUNTER);
+        for (xl = ctx->active->top; xl; xl = xl->next) {
+            gf_metric_label_escape(name, sizeof(name), xl->name);
+            for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+                count = GF_ATOMIC_GET(xl->stats[i].total_fop);
+                if (count)
+                    fprintf(fp,
+                            "gluster_xlator_fops_total{xlator=\"%s\","
+                            "fop=\"%s\"} %" PRIu64 "\n",
+                            name, gf_fop_list[i], count);
+            }
+        }
+
+        gf_metric_print_header(fp, "gluster_xlator_fop_failures_total",
+                               "Fops unwound by the translator with an error",
+                               GF_METRIC_COUNTER);
+        for (xl = ctx->active->top; xl; xl = xl->next) {
+            gf_metric_label_escape(name, sizeof(name), xl->name);
+            for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+                count = GF_ATOMIC_GET(xl->stats[i].total_fop_cbk);
+                if (count)
+                    fprintf(fp,
+                            "gluster_xlator_fop_failures_total{xlator=\"%s\","
+                            "fop=\"%s\"} %" PRIu64 "\n",
+                            name, gf_fop_list[i], count);
+            }
+        }
+    }
+unlock:
+    pthread_mutex_unlock(&ctx->cleanup_lock);
+}
+
+static void
+gf_metrics_send(int client)
+{
+    struct timeval tv = {
+        .tv_sec = 1,
+    };
+    gf_metric_t *metric = NULL;
+    const char *name = NULL;
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *fp = NULL;
+
+    fp = open_memstream(&buf, &len);
+    if (!fp)
+        return;
+
+    gf_metrics_print_xlators(fp, gf_metrics.ctx);
+
+    pthread_mutex_lock(&gf_metrics.lock);
+    {
+        list_for_each_entry(metric, &gf_metrics.metrics, list)
+        {
+            if (!name || strcmp(name, metric->name))
+                gf_metric_print_header(fp, metric->name, metric->help,
+                                       metric->type);
+            name = metric->name;
+            gf_metric_print(fp, metric);
+        }
+    }
+    pthread_mutex_unlock(&gf_metrics.lock);
+
+    if (fclose(fp) == 0) {
+        /* a client that does not read must not hold up the next one */
+        setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        gf_nwrite(client, buf, len);
+    }
+    free(buf);
+}
+
+static void *
+gf_metrics_serve(void *data)
+{
+    struct pollfd pfd = {
+        .fd = (intptr_t)data,
+        .events = POLLIN,
+    };
+    int client = -1;
+
+    while (!uatomic_read(&gf_metrics.stop)) {
+        if (poll(&pfd, 1, 500) <= 0)
+            continue;
+
+        client = sys_accept(pfd.fd, NULL, NULL, O_CLOEXEC);
+        if (client < 0)
+            continue;
+
+        gf_metrics_send(client);
+        sys_close(client);
+    }
+
+    return NULL;
+}
+
+/* Starts serving the registered metrics on
+ * <metrics-dir>/gmetrics.<pid>.sock. A connection gets the current values
+ * in the Prometheus text format, after which it is closed. Calls nest, the
+ * server runs until gf_metrics_server_stop() was called as many times. */
+int
+gf_metrics_server_start(glusterfs_ctx_t *ctx)
+{
+    struct sockaddr_un addr = {
+        .sun_family = AF_UNIX,
+    };
+    char *dumppath = NULL;
+    char *path = NULL;
+    int sock = -1;
+    int ret = -1;
+
+    pthread_mutex_lock(&gf_metrics.server_lock);
+
+    if (gf_metrics.refs > 0) {
+        gf_metrics.refs++;
+        ret = 0;
+        goto unlock;
+    }
+
+    dumppath = ctx->config.metrics_dumppath;
+    if (dumppath == NULL)
+        dumppath = GLUSTER_METRICS_DIR;
+
+    if (mkdir_p(dumppath, 0755, true)) {
+        gf_msg("monitoring", GF_LOG_ERROR, errno, LG_MSG_CREATE_FAILED,
+               "failed to create metrics dir %s", dumppath);
+        goto unlock;
+    }
+
+    if (gf_asprintf(&path, "%s/gmetrics.%d.sock", dumppath, getpid()) < 0)
+        goto unlock;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        gf_msg("monitoring", GF_LOG_ERROR, ENAMETOOLONG, LG_MSG_BINDING_FAILED,
+               "metrics socket path %s is too long", path);
+        goto unlock;
+    }
+    strcpy(addr.sun_path, path);
+
+    sock = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (sock < 0)
+        goto err;
+
+    /* a previous process with the same pid may have left it behind */
+    sys_unlink(path);
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) ||
+        listen(sock, 16))
+        goto err;
+
+    gf_metrics.ctx = ctx;
+    gf_metrics.stop = 0;
+    ret = gf_thread_create(&gf_metrics.thread, NULL, gf_metrics_serve,
+                           (void *)(intptr_t)sock, "metrics");
+    if (ret) {
+        sys_unlink(path);
+        goto err;
+    }
+
+    gf_metrics.sock = sock;
+    gf_metrics.path = path;
+    gf_metrics.refs = 1;
+    pthread_mutex_unlock(&gf_metrics.server_lock);
+
+    gf_log("monitoring", GF_LOG_INFO, "serving metrics on %s", path);
+    return 0;
+
+err:
+    gf_msg("monitoring", GF_LOG_ERROR, errno, LG_MSG_BINDING_FAILED,
+           "failed to serve metrics on %s", path);
+    if (sock >= 0)
+        sys_close(sock);
+    ret = -1;
+unlock:
+    pthread_mutex_unlock(&gf_metrics.server_lock);
+    GF_FREE(path);
+    return ret;
+}
+
+void
+gf_metrics_server_stop(void)
+{
+    pthread_t thread;
+    char *path = NULL;
+    int sock = -1;
+
+    pthread_mutex_lock(&gf_metrics.server_lock);
+    {
+        if ((gf_metrics.refs == 0) || (--gf_metrics.refs > 0)) {
+            pthread_mutex_unlock(&gf_metrics.server_lock);
+            return;
+        }
+
+        thread = gf_metrics.thread;
+        sock = gf_metrics.sock;
+        path = gf_metrics.path;
+        gf_metrics.sock = -1;
+        gf_metrics.path = NULL;
+        uatomic_set(&gf_metrics.stop, 1);
+
+        pthread_join(thread, NULL);
+        sys_unlink(path);
+        sys_close(sock);
+    }
+    pthread_mutex_unlock(&gf_metrics.server_lock);
+
+    GF_FREE(path);
+}
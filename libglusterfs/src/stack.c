@@ -12,12 +12,84 @@
 #include "glusterfs/stack.h"
 #include "glusterfs/libglusterfs-messages.h"
 
+/* The list of the pools a thread links its stacks on; threads are spread
+ * over the lists in the order they first create a stack. */
+static __thread int call_pool_list_idx = -1;
+static gf_atomic_t call_pool_threads;
+
+void
+call_pool_init(call_pool_t *pool)
+{
+    int i;
+
+    for (i = 0; i < GF_CALL_POOL_LISTS; i++) {
+        INIT_LIST_HEAD(&pool->lists[i].all_frames);
+        LOCK_INIT(&pool->lists[i].lock);
+    }
+}
+
+void
+call_pool_fini(call_pool_t *pool)
+{
+    int i;
+
+    for (i = 0; i < GF_CALL_POOL_LISTS; i++)
+        LOCK_DESTROY(&pool->lists[i].lock);
+}
+
+int64_t
+call_pool_inflight(call_pool_t *pool)
+{
+    int64_t cnt = 0;
+    int i;
+
+    for (i = 0; i < GF_CALL_POOL_LISTS; i++)
+        cnt += __atomic_load_n(&pool->lists[i].cnt, __ATOMIC_RELAXED);
+
+    return cnt;
+}
+
+uint64_t
+call_pool_total(call_pool_t *pool)
+{
+    uint64_t total = 0;
+    int i;
+
+    for (i = 0; i < GF_CALL_POOL_LISTS; i++)
+        total += __atomic_load_n(&pool->lists[i].total, __ATOMIC_RELAXED);
+
+    return total;
+}
+
+void
+call_stack_link(call_stack_t *stack)
+{
+    struct call_pool_list *list = NULL;
+
+    if (call_pool_list_idx < 0)
+        call_pool_list_idx = (GF_ATOMIC_INC(call_pool_threads) - 1) %
+                             GF_CALL_POOL_LISTS;
+
+    list = &stack->pool->lists[call_pool_list_idx];
+    stack->list = list;
+
+    LOCK(&list->lock);
+    {
+        list_add(&stack->all_frames, &list->all_frames);
+        list->cnt++;
+        list->total++;
+        /* unique across the lists, the low bits being the list */
+        stack->unique = (list->unique++ * GF_CALL_POOL_LISTS) +
+                        call_pool_list_idx;
+    }
+    UNLOCK(&list->lock);
+}
+
 call_frame_t *
 create_frame(xlator_t *xl, call_pool_t *pool)
 {
     call_stack_t *stack = NULL;
     call_frame_t *frame = NULL;
-    static uint64_t unique = 0;
 
     if (!xl || !pool) {
         return NULL;
@@ -49,14 +121,7 @@ create_frame(xlator_t *xl, call_pool_t *pool)
         memcpy(&frame->begin, &stack->tv, sizeof(stack->tv));
     }
 
-    LOCK(&pool->lock);
-    {
-        list_add(&stack->all_frames, &pool->all_frames);
-        pool->cnt++;
-        stack->unique = unique++;
-    }
-    UNLOCK(&pool->lock);
-    GF_ATOMIC_INC(pool->total_count);
+    call_stack_link(stack);
 
     LOCK_INIT(&stack->stack_lock);
 
@@ -206,40 +271,39 @@ gf_proc_dump_call_stack(call_stack_t *call_stack, const char *key_buf, ...)
 void
 gf_proc_dump_pending_frames(call_pool_t *call_pool)
 {
+    struct call_pool_list *list = NULL;
     call_stack_t *trav = NULL;
     int i = 1;
-    int ret = -1;
-    gf_boolean_t section_added = _gf_false;
+    int l = 0;
 
     if (!call_pool)
         return;
 
-    ret = TRY_LOCK(&(call_pool->lock));
-    if (ret)
-        goto out;
-
     gf_proc_dump_add_section("global.callpool");
-    section_added = _gf_true;
     gf_proc_dump_write("callpool_address", "%p", call_pool);
-    gf_proc_dump_write("callpool.cnt", "%" PRId64, call_pool->cnt);
-
-    list_for_each_entry(trav, &call_pool->all_frames, all_frames)
-    {
-        gf_proc_dump_add_section("global.callpool.stack.%d", i);
-        gf_proc_dump_call_stack(trav, "global.callpool.stack.%d", i);
-        i++;
+    gf_proc_dump_write("callpool.cnt", "%" PRId64,
+                       call_pool_inflight(call_pool));
+
+    for (l = 0; l < GF_CALL_POOL_LISTS; l++) {
+        list = &call_pool->lists[l];
+        if (list_empty(&list->all_frames))
+            continue;
+
+        if (TRY_LOCK(&list->lock)) {
+            gf_proc_dump_write("Unable to dump the callpool",
+                               "(Lock acquisition failed) %p list %d",
+                               call_pool, l);
+            continue;
+        }
+
+        list_for_each_entry(trav, &list->all_frames, all_frames)
+        {
+            gf_proc_dump_add_section("global.callpool.stack.%d", i);
+            gf_proc_dump_call_stack(trav, "global.callpool.stack.%d", i);
+            i++;
+        }
+        UNLOCK(&list->lock);
     }
-    UNLOCK(&(call_pool->lock));
-
-    ret = 0;
-out:
-    if (ret) {
-        if (_gf_false == section_added)
-            gf_proc_dump_add_section("global.callpool");
-        gf_proc_dump_write("Unable to dump the callpool",
-                           "(Lock acquisition failed) %p", call_pool);
-    }
-    return;
 }
 
 void
@@ -394,39 +458,43 @@ gf_proc_dump_call_stack_to_dict(call_stack_t *call_stack, char *prefix,
 void
 gf_proc_dump_pending_frames_to_dict(call_pool_t *call_pool, dict_t *dict)
 {
-    int ret = -1;
+    struct call_pool_list *list = NULL;
     call_stack_t *trav = NULL;
     char key[GF_DUMP_MAX_BUF_LEN] = {
         0,
     };
+    int ret = 0;
     int i = 0;
+    int l = 0;
 
     if (!call_pool || !dict)
         return;
 
-    ret = TRY_LOCK(&call_pool->lock);
-    if (ret) {
-        gf_msg(THIS->name, GF_LOG_WARNING, errno, LG_MSG_LOCK_FAILURE,
-               "Unable to dump call "
-               "pool to dict.");
-        return;
+    for (l = 0; l < GF_CALL_POOL_LISTS; l++) {
+        list = &call_pool->lists[l];
+        if (list_empty(&list->all_frames))
+            continue;
+
+        if (TRY_LOCK(&list->lock)) {
+            gf_msg(THIS->name, GF_LOG_WARNING, errno, LG_MSG_LOCK_FAILURE,
+                   "Unable to dump call "
+                   "pool to dict.");
+            continue;
+        }
+
+        list_for_each_entry(trav, &list->all_frames, all_frames)
+        {
+            snprintf(key, sizeof(key), "callpool.stack%d", i);
+            gf_proc_dump_call_stack_to_dict(trav, key, dict);
+            i++;
+        }
+        UNLOCK(&list->lock);
     }
 
-    ret = dict_set_int32(dict, "callpool.count", call_pool->cnt);
+    /* the stacks dumped, which is what the readers iterate over */
+    ret = dict_set_int32(dict, "callpool.count", i);
     if (ret)
-        goto out;
-
-    list_for_each_entry(trav, &call_pool->all_frames, all_frames)
-    {
-        snprintf(key, sizeof(key), "callpool.stack%d", i);
-        gf_proc_dump_call_stack_to_dict(trav, key, dict);
-        i++;
-    }
-
-out:
-    UNLOCK(&call_pool->lock);
-
-    return;
+        gf_msg_debug(THIS->name, -ret, "failed to set callpool.count");
 }
 
 gf_boolean_t
@@ -12,6 +12,7 @@
 #include "glusterfs/logging.h"
 #include "glusterfs/statedump.h"
 #include "glusterfs/syscall.h"
+#include "glusterfs/gf-event.h"
 
 #ifdef HAVE_MALLOC_H
 #include <malloc.h>
@@ -936,6 +937,9 @@ gf_proc_dump_info(int signum, glusterfs_ctx_t *ctx)
     if (GF_PROC_DUMP_IS_OPTION_ENABLED(callpool))
         gf_proc_dump_pending_frames(ctx->pool);
 
+    if (ctx->event_pool)
+        gf_event_pool_dump(ctx->event_pool);
+
     /* dictionary stats */
     gf_proc_dump_add_section("dict");
     gf_proc_dump_dict_info(ctx);
@@ -10,6 +10,7 @@
 
 #include "glusterfs/syncop.h"
 #include "glusterfs/syncop-utils.h"
+#include "glusterfs/timespec.h"
 #include "glusterfs/libglusterfs-messages.h"
 
 struct syncop_dir_scan_data {
@@ -454,6 +455,339 @@ out:
     return ret | retval;
 }
 
+/* A directory of a syncop_mt_ftw() crawl waiting to be read */
+struct syncop_crawl_dir {
+    struct list_head list;
+    inode_t *inode;
+};
+
+struct syncop_crawl {
+    call_frame_t *frame;
+    xlator_t *subvol;
+    int pid;
+    void *data;
+    syncop_dir_scan_fn_t fn;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    struct list_head dirs; /* read depth first, most recent first */
+    uint32_t qlen;         /* directories in dirs, each holds its inode */
+    uint32_t max_qlen;
+    uint32_t running;      /* synctasks reading directories */
+    int error;             /* first error, stops the crawl */
+    uint64_t entries;
+    uint64_t ndirs;
+};
+
+/* Shared by all the crawls of the process, so that the full heals of
+ * several subvolumes (AFR and EC are the only users so far) do not add up
+ * into more load than the bricks should see from crawlers. */
+static pthread_mutex_t crawl_budget_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t crawl_budget_used;
+
+/* A crawl without any job always gets one, so that it makes progress
+ * whatever the others take. */
+static gf_boolean_t
+_crawl_budget_take(gf_boolean_t force)
+{
+    gf_boolean_t taken = _gf_false;
+
+    pthread_mutex_lock(&crawl_budget_lock);
+    {
+        if (force || (crawl_budget_used < SYNCOP_CRAWL_BUDGET)) {
+            crawl_budget_used++;
+            taken = _gf_true;
+        }
+    }
+    pthread_mutex_unlock(&crawl_budget_lock);
+
+    return taken;
+}
+
+static void
+_crawl_budget_release(void)
+{
+    pthread_mutex_lock(&crawl_budget_lock);
+    {
+        crawl_budget_used--;
+    }
+    pthread_mutex_unlock(&crawl_budget_lock);
+}
+
+/* Called with crawl->mutex held */
+static int
+__crawl_dir_add(struct syncop_crawl *crawl, inode_t *inode)
+{
+    struct syncop_crawl_dir *dir = NULL;
+
+    dir = GF_MALLOC(sizeof(*dir), gf_common_mt_crawl_dir);
+    if (!dir)
+        return -ENOMEM;
+
+    dir->inode = inode_ref(inode);
+    list_add(&dir->list, &crawl->dirs);
+    crawl->qlen++;
+
+    /* the caller may have a job to start for it */
+    pthread_cond_broadcast(&crawl->cond);
+
+    return 0;
+}
+
+static void
+_crawl_dir_free(struct syncop_crawl_dir *dir)
+{
+    inode_unref(dir->inode);
+    GF_FREE(dir);
+}
+
+/* Passes the entries of a directory to the callback batch after batch,
+ * and queues its subdirectories for any job to pick up. With the queue
+ * full, the job reads the subdirectory itself, as syncop_ftw() would,
+ * rather than have the queue pin the inodes of a wide directory. */
+static int
+_crawl_dir(struct syncop_crawl *crawl, inode_t *inode)
+{
+    loc_t loc = {
+        0,
+    };
+    fd_t *fd = NULL;
+    uint64_t offset = 0;
+    uint64_t count = 0;
+    gf_dirent_t *entry = NULL;
+    gf_dirent_t entries;
+    gf_boolean_t queued = _gf_false;
+    int ret = 0;
+
+    loc.inode = inode;
+    gf_uuid_copy(loc.gfid, inode->gfid);
+
+    ret = syncop_dirfd(crawl->subvol, &loc, &fd, crawl->pid);
+    if (ret)
+        goto out;
+
+    INIT_LIST_HEAD(&entries.list);
+
+    while ((ret = syncop_readdirp(crawl->subvol, fd, 131072, offset, &entries,
+                                  NULL, NULL))) {
+        if (ret < 0)
+            break;
+
+        /* If the entries are only '.', and '..' then ret value will be
+         * non-zero. so set it to zero here. */
+        ret = 0;
+        count = 0;
+
+        list_for_each_entry(entry, &entries.list, list)
+        {
+            offset = entry->d_off;
+
+            if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+                continue;
+
+            if (crawl->error)
+                break;
+
+            gf_link_inode_from_dirent(fd->inode, entry);
+
+            ret = crawl->fn(crawl->subvol, entry, &loc, crawl->data);
+            if (ret)
+                break;
+            count++;
+
+            if (entry->d_stat.ia_type == IA_IFDIR) {
+                queued = _gf_false;
+                pthread_mutex_lock(&crawl->mutex);
+                {
+                    if (crawl->qlen < crawl->max_qlen) {
+                        ret = __crawl_dir_add(crawl, entry->inode);
+                        queued = _gf_true;
+                    } else {
+                        crawl->ndirs++;
+                    }
+                }
+                pthread_mutex_unlock(&crawl->mutex);
+                if (!queued)
+                    ret = _crawl_dir(crawl, entry->inode);
+                if (ret)
+                    break;
+            }
+        }
+
+        gf_dirent_free(&entries);
+
+        pthread_mutex_lock(&crawl->mutex);
+        {
+            crawl->entries += count;
+        }
+        pthread_mutex_unlock(&crawl->mutex);
+
+        if (ret || crawl->error)
+            break;
+    }
+
+out:
+    if (fd)
+        fd_unref(fd);
+    return ret;
+}
+
+/* A job reads directories until there are none left to read. It never
+ * waits for more to show up, synctasks must not block their thread: the
+ * caller of syncop_mt_ftw() starts jobs again as directories come in. */
+static int
+_crawl_job_fn(void *opaque)
+{
+    struct syncop_crawl *crawl = opaque;
+    struct syncop_crawl_dir *dir = NULL;
+    int ret = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&crawl->mutex);
+        {
+            if (ret && !crawl->error)
+                crawl->error = ret;
+
+            dir = NULL;
+            if (!crawl->error && !list_empty(&crawl->dirs)) {
+                dir = list_first_entry(&crawl->dirs, typeof(*dir), list);
+                list_del_init(&dir->list);
+                crawl->qlen--;
+                crawl->ndirs++;
+            } else {
+                /* crawl may be gone as soon as we unlock */
+                _crawl_budget_release();
+                crawl->running--;
+                pthread_cond_broadcast(&crawl->cond);
+            }
+        }
+        pthread_mutex_unlock(&crawl->mutex);
+
+        if (!dir)
+            break;
+
+        ret = _crawl_dir(crawl, dir->inode);
+        _crawl_dir_free(dir);
+    }
+
+    return 0;
+}
+
+static int
+_crawl_job_fn_cbk(int ret, call_frame_t *frame, void *opaque)
+{
+    return 0;
+}
+
+/**
+ * syncop_mt_ftw walks the tree under @loc like syncop_ftw, calling @fn for
+ * every entry, but reads up to @max_jobs directories at once: the
+ * directories found are queued and picked up by whichever job is free, so
+ * that wide and deep trees are crawled as fast as the bricks allow.
+ *
+ * @fn is called from several synctasks at once, for the entries of a
+ * directory only after it returned for the directory itself. The first
+ * error it returns stops the crawl and is returned.
+ *
+ * The jobs of all the crawls of the process together are kept within
+ * SYNCOP_CRAWL_BUDGET, and at most @max_qlen directories wait to be read.
+ * Like syncop_mt_dir_scan it cannot be called from a synctask.
+ */
+int
+syncop_mt_ftw(call_frame_t *frame, xlator_t *subvol, loc_t *loc, int pid,
+              void *data, syncop_dir_scan_fn_t fn, uint32_t max_jobs,
+              uint32_t max_qlen)
+{
+    struct syncop_crawl crawl = {
+        0,
+    };
+    struct syncop_crawl_dir *dir = NULL;
+    struct syncop_crawl_dir *tmp = NULL;
+    struct timespec start = {
+        0,
+    };
+    struct timespec elapsed = {
+        0,
+    };
+    xlator_t *this = NULL;
+    double secs = 0;
+    int ret = 0;
+
+    this = frame ? frame->this : THIS;
+
+    if (synctask_get())
+        return -ENOTSUP;
+
+    if (max_jobs == 0)
+        return -EINVAL;
+
+    crawl.frame = frame;
+    crawl.subvol = subvol;
+    crawl.pid = pid;
+    crawl.data = data;
+    crawl.fn = fn;
+    /* the directory to start from is always queued */
+    crawl.max_qlen = max_qlen ? max_qlen : 1;
+    pthread_mutex_init(&crawl.mutex, NULL);
+    pthread_cond_init(&crawl.cond, NULL);
+    INIT_LIST_HEAD(&crawl.dirs);
+
+    timespec_now(&start);
+
+    pthread_mutex_lock(&crawl.mutex);
+    {
+        crawl.error = __crawl_dir_add(&crawl, loc->inode);
+
+        for (;;) {
+            if (!crawl.error && this && this->cleanup_starting)
+                crawl.error = -ENOTCONN;
+
+            while (!crawl.error && !list_empty(&crawl.dirs) &&
+                   (crawl.running < max_jobs) &&
+                   _crawl_budget_take(crawl.running == 0)) {
+                crawl.running++;
+                pthread_mutex_unlock(&crawl.mutex);
+                ret = synctask_new(subvol->ctx->env, _crawl_job_fn,
+                                   _crawl_job_fn_cbk, frame, &crawl);
+                pthread_mutex_lock(&crawl.mutex);
+                if (ret) {
+                    _crawl_budget_release();
+                    crawl.running--;
+                    crawl.error = ret;
+                }
+            }
+
+            if ((crawl.running == 0) &&
+                (crawl.error || list_empty(&crawl.dirs)))
+                break;
+
+            pthread_cond_wait(&crawl.cond, &crawl.mutex);
+        }
+
+        ret = crawl.error;
+    }
+    pthread_mutex_unlock(&crawl.mutex);
+
+    list_for_each_entry_safe(dir, tmp, &crawl.dirs, list)
+    {
+        list_del_init(&dir->list);
+        _crawl_dir_free(dir);
+    }
+
+    timespec_now(&elapsed);
+    timespec_sub(&start, &elapsed, &elapsed);
+    secs = elapsed.tv_sec + elapsed.tv_nsec / 1e9;
+    gf_msg_debug(subvol->name, 0,
+                 "crawled %" PRIu64 " entries in %" PRIu64
+                 " directories in %.3fs (%.0f entries/s), ret: %d",
+                 crawl.entries, crawl.ndirs, secs,
+                 (secs > 0) ? crawl.entries / secs : 0, ret);
+
+    pthread_cond_destroy(&crawl.cond);
+    pthread_mutex_destroy(&crawl.mutex);
+
+    return ret;
+}
+
 int
 syncop_dir_scan(xlator_t *subvol, loc_t *loc, int pid, void *data,
                 int (*fn)(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
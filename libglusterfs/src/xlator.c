@@ -649,6 +649,49 @@ out:
     return ret;
 }
 
+/* The fop an xlator runs for index 'op', its pass-through one if it is in
+ * pass-through mode, as STACK_WIND() would pick it. */
+static void *
+xlator_fop_fn(xlator_t *xl, int op)
+{
+    if (xl->pass_through)
+        return get_the_pt_fop(&xl->pass_through_fops->stat, op);
+
+    return get_the_pt_fop(&xl->fops->stat, op);
+}
+
+/* Only hands the fop to its first child, without taking a frame nor
+ * looking at it: default_fop() does a STACK_WIND_TAIL() to FIRST_CHILD(). */
+static gf_boolean_t
+xlator_fop_forwards(xlator_t *xl, int op)
+{
+    if (!xl->fops || !xl->children || !xl->init_succeeded)
+        return _gf_false;
+
+    return xlator_fop_fn(xl, op) == get_the_pt_fop(&default_fops->stat, op);
+}
+
+/* Resolves, for every fop, the xlator a wind to 'xl' ends up running, so
+ * that STACK_WIND() goes straight there instead of hopping through each
+ * xlator forwarding it. To be redone whenever the xlator or one below it
+ * changes its pass-through mode. */
+void
+xlator_resolve_fop_targets(xlator_t *xl)
+{
+    xlator_t *target = NULL;
+    int nfops = sizeof(struct xlator_fops) / sizeof(void *);
+    int op = 0;
+
+    for (op = GF_FOP_NULL + 1; (op < GF_FOP_MAXVALUE) && (op <= nfops);
+         op++) {
+        target = xl;
+        while (xlator_fop_forwards(target, op))
+            target = FIRST_CHILD(target);
+
+        xl->fop_target[op] = (target != xl) ? target : NULL;
+    }
+}
+
 static void
 xlator_fini_rec(xlator_t *xl)
 {
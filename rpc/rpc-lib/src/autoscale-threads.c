@@ -15,8 +15,45 @@ void
 rpcsvc_autoscale_threads(glusterfs_ctx_t *ctx, rpcsvc_t *rpc, int incr)
 {
     struct event_pool *pool = ctx->event_pool;
-    int thread_count = pool->eventthreadcount;
 
     pool->auto_thread_count += incr;
-    (void)gf_event_reconfigure_threads(pool, thread_count + incr);
+    /* moves the load based autoscaling bounds along, if any */
+    (void)gf_event_autoscale_shift(pool, incr);
+}
+
+/* Number of requests queued to the request handler threads of the programs
+ * of the service and not picked up yet, sampled by the event thread
+ * autoscaler. */
+uint64_t
+rpcsvc_request_backlog(void *data)
+{
+    rpcsvc_t *svc = data;
+    rpcsvc_program_t *prog = NULL;
+    rpcsvc_request_queue_t *queue = NULL;
+    uint64_t backlog = 0;
+    uint64_t queued = 0;
+    uint64_t handled = 0;
+    int i;
+
+    if (pthread_rwlock_tryrdlock(&svc->rpclock))
+        return 0;
+    {
+        list_for_each_entry(prog, &svc->programs, program)
+        {
+            if (!prog->ownthread)
+                continue;
+
+            for (i = 0; i < EVENT_MAX_THREADS; i++) {
+                queue = &prog->request_queue[i];
+                /* handled first, so that it is never ahead */
+                handled = GF_ATOMIC_GET(queue->handled);
+                queued = GF_ATOMIC_GET(queue->queued);
+                if (queued > handled)
+                    backlog += queued - handled;
+            }
+        }
+    }
+    pthread_rwlock_unlock(&svc->rpclock);
+
+    return backlog;
 }
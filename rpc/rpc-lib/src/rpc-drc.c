@@ -15,68 +15,221 @@
 #include <glusterfs/locking.h>
 #include <glusterfs/statedump.h>
 #include <glusterfs/mem-pool.h>
+#include <glusterfs/hashfn.h>
 
 #include <netinet/in.h>
 #include <unistd.h>
 
+/*
+ * Each client (network address) of the service has its own cache of the
+ * non-idempotent requests it sent, guarded by its own lock: the ops are
+ * hashed by xid and a checksum of the call arguments, and kept in a ring
+ * in arrival order. The ring is bounded by the bytes its ops hold; the
+ * oldest ops, cached or still in transit, make room for the new ones.
+ *
+ * The global lock only protects the list of clients. A transport finds
+ * its client once, when it is accepted, so the requests never take it.
+ */
+
 /**
- * rpcsvc_drc_op_destroy - Destroys the cached reply
+ * rpcsvc_remove_drc_client - Cleanup the drc client
  *
- * @param drc - the main drc structure
- * @param reply - the cached reply to destroy
- * @return NULL if reply is destroyed, reply otherwise
+ * @param client - the drc client to be removed
+ * @return void
  */
-static drc_cached_op_t *
-rpcsvc_drc_op_destroy(rpcsvc_drc_globals_t *drc, drc_cached_op_t *reply)
+static void
+rpcsvc_remove_drc_client(drc_client_t *client)
 {
-    GF_ASSERT(drc);
-    GF_ASSERT(reply);
+    list_del(&client->client_list);
+    LOCK_DESTROY(&client->lock);
+    GF_FREE(client);
+}
 
-    if (reply->state == DRC_OP_IN_TRANSIT)
-        return reply;
+/**
+ * rpcsvc_drc_client_ref - ref the drc client
+ *
+ * Takes a new reference from one already held, or with drc->lock held.
+ *
+ * @param client - the drc client to ref
+ * @return client
+ */
+static drc_client_t *
+rpcsvc_drc_client_ref(drc_client_t *client)
+{
+    GF_ASSERT(client);
+    GF_ATOMIC_INC(client->ref);
+    return client;
+}
+
+/**
+ * rpcsvc_drc_client_unref - unref the drc client, and destroy
+ *                           the client on last unref
+ *
+ * References other than the last are dropped without locking. The last
+ * one is dropped under drc->lock, where rpcsvc_client_lookup() finds and
+ * refs the clients, so that a client being destroyed is never returned.
+ *
+ * @param client - the drc client to unref
+ * @return void
+ */
+static void
+rpcsvc_drc_client_unref(drc_client_t *client)
+{
+    rpcsvc_drc_globals_t *drc = NULL;
+    uint32_t refcount = 0;
+
+    for (;;) {
+        refcount = GF_ATOMIC_GET(client->ref);
+        if (refcount <= 1)
+            break;
+        if (GF_ATOMIC_CMP_SWAP(client->ref, refcount, refcount - 1))
+            return;
+    }
+
+    /* detached from its drc by rpcsvc_drc_deinit() */
+    drc = client->drc;
+    if (!drc) {
+        if (!GF_ATOMIC_DEC(client->ref))
+            rpcsvc_remove_drc_client(client);
+        return;
+    }
+
+    LOCK(&drc->lock);
+    {
+        refcount = GF_ATOMIC_DEC(client->ref);
+        if (!refcount) {
+            drc->client_count--;
+            rpcsvc_remove_drc_client(client);
+        }
+    }
+    UNLOCK(&drc->lock);
+}
+
+/**
+ * rpcsvc_drc_unref - unref the drc globals, and destroy them on last unref
+ *
+ * Ops still referenced by requests or replies in flight outlive
+ * rpcsvc_drc_deinit(), and go back to the mempool on their last unref.
+ * The mempool is destroyed with the last of them.
+ *
+ * @param drc - the drc globals to unref
+ * @return void
+ */
+static void
+rpcsvc_drc_unref(rpcsvc_drc_globals_t *drc)
+{
+    if (GF_ATOMIC_DEC(drc->ref))
+        return;
+
+    if (drc->mempool)
+        mem_pool_destroy(drc->mempool);
+    LOCK_DESTROY(&drc->lock);
+    GF_FREE(drc);
+}
+
+/**
+ * rpcsvc_drc_op_unref - unref a cached op, and destroy it on last unref
+ *
+ * The cache holds a reference on the ops it contains, the request an op
+ * was created for holds one until it is destroyed, and the senders of a
+ * cached reply hold one while the reply is submitted.
+ *
+ * @param reply - the cached op to unref
+ * @return void
+ */
+void
+rpcsvc_drc_op_unref(drc_cached_op_t *reply)
+{
+    drc_client_t *client = NULL;
+    rpcsvc_drc_globals_t *drc = NULL;
+
+    GF_ASSERT(reply);
 
-    iobref_unref(reply->msg.iobref);
-    if (reply->msg.rpchdr)
-        GF_FREE(reply->msg.rpchdr);
-    if (reply->msg.proghdr)
-        GF_FREE(reply->msg.proghdr);
-    if (reply->msg.progpayload)
-        GF_FREE(reply->msg.progpayload);
+    if (GF_ATOMIC_DEC(reply->ref))
+        return;
 
-    list_del(&reply->global_list);
-    reply->client->op_count--;
-    drc->op_count--;
+    client = reply->client;
+    drc = reply->drc;
+    if (reply->msg.iobref)
+        iobref_unref(reply->msg.iobref);
     mem_put(reply);
-    reply = NULL;
 
-    return reply;
+    rpcsvc_drc_client_unref(client);
+    rpcsvc_drc_unref(drc);
 }
 
 /**
- * rpcsvc_drc_op_rb_unref - This function is used in rb tree cleanup only
+ * __rpcsvc_drc_evict - remove an op from the cache of its client
  *
- * @param reply - the cached reply to unref
- * @param drc - the main drc structure
+ * Called with client->lock held. The reference of the cache is moved to
+ * the evicted list, to be dropped once the lock is released.
+ *
+ * @param client - the drc client of the op
+ * @param reply - the op to remove
+ * @param evicted - list of the evicted ops
  * @return void
  */
 static void
-rpcsvc_drc_rb_op_destroy(void *reply, void *drc)
+__rpcsvc_drc_evict(drc_client_t *client, drc_cached_op_t *reply,
+                   struct list_head *evicted)
 {
-    rpcsvc_drc_op_destroy(drc, (drc_cached_op_t *)reply);
+    list_del_init(&reply->hash_list);
+    list_move(&reply->ring_list, evicted);
+    client->op_count--;
+    client->bytes -= reply->size;
+    GF_ATOMIC_DEC(client->drc->op_count);
 }
 
 /**
- * rpcsvc_remove_drc_client - Cleanup the drc client
+ * rpcsvc_drc_put_evicted - drop the references of the cache on evicted ops
  *
- * @param client - the drc client to be removed
+ * @param evicted - list of the evicted ops
  * @return void
  */
 static void
-rpcsvc_remove_drc_client(drc_client_t *client)
+rpcsvc_drc_put_evicted(struct list_head *evicted)
 {
-    rb_destroy(client->rbtree, rpcsvc_drc_rb_op_destroy);
-    list_del(&client->client_list);
-    GF_FREE(client);
+    drc_cached_op_t *reply = NULL;
+    drc_cached_op_t *tmp = NULL;
+
+    list_for_each_entry_safe(reply, tmp, evicted, ring_list)
+    {
+        list_del_init(&reply->ring_list);
+        rpcsvc_drc_op_unref(reply);
+    }
+}
+
+/**
+ * __rpcsvc_drc_make_room - evict the oldest ops of a client until @size
+ *                          more bytes and @count more ops fit the budgets
+ *
+ * Called with client->lock held.
+ *
+ * @param client - the drc client
+ * @param size - bytes to make room for
+ * @param count - ops to make room for
+ * @param evicted - list of the evicted ops
+ * @return 0 if the budgets are met, -1 otherwise
+ */
+static int
+__rpcsvc_drc_make_room(drc_client_t *client, size_t size, uint32_t count,
+                       struct list_head *evicted)
+{
+    rpcsvc_drc_globals_t *drc = client->drc;
+    drc_cached_op_t *reply = NULL;
+
+    for (;;) {
+        if ((client->bytes + size <= drc->client_cache_size) &&
+            (GF_ATOMIC_GET(drc->op_count) + count <= drc->global_cache_size))
+            return 0;
+
+        if (list_empty(&client->ring))
+            return -1;
+
+        reply = list_entry(client->ring.prev, drc_cached_op_t, ring_list);
+        __rpcsvc_drc_evict(client, reply, evicted);
+        GF_ATOMIC_INC(drc->evictions);
+    }
 }
 
 /**
@@ -152,65 +305,33 @@ rpcsvc_client_lookup(rpcsvc_drc_globals_t *drc,
 }
 
 /**
- * drc_compare_reqs - Used by rbtree to determine if incoming req matches with
- *                    an existing node(cached reply) in rbtree
- *
- * @param item - pointer to the incoming req
- * @param rb_node_data - pointer to an rbtree node (cached reply)
- * @param param - drc pointer - unused here, but used in *op_destroy
- * @return 0 if req matches reply, else (req->xid - reply->xid)
- */
-int
-drc_compare_reqs(const void *item, const void *rb_node_data, void *param)
-{
-    int ret = -1;
-    drc_cached_op_t *req = NULL;
-    drc_cached_op_t *reply = NULL;
-
-    GF_ASSERT(item);
-    GF_ASSERT(rb_node_data);
-    GF_ASSERT(param);
-
-    req = (drc_cached_op_t *)item;
-    reply = (drc_cached_op_t *)rb_node_data;
-
-    ret = req->xid - reply->xid;
-    if (ret != 0)
-        return ret;
-
-    if (req->prognum == reply->prognum && req->procnum == reply->procnum &&
-        req->progversion == reply->progversion)
-        return 0;
-
-    return 1;
-}
-
-/**
- * drc_init_client_cache - initialize a drc client and its rb tree
+ * drc_init_client_cache - initialize a drc client and its cache
  *
  * @param drc - the main drc structure
  * @param client - the drc client to be initialized
- * @return 0 on success, -1 on failure
+ * @return void
  */
-static int
+static void
 drc_init_client_cache(rpcsvc_drc_globals_t *drc, drc_client_t *client)
 {
+    int i = 0;
+
     GF_ASSERT(drc);
     GF_ASSERT(client);
 
-    client->rbtree = rb_create(drc_compare_reqs, drc, NULL);
-    if (!client->rbtree) {
-        gf_log(GF_RPCSVC, GF_LOG_DEBUG, "rb tree creation failed");
-        return -1;
-    }
-
-    return 0;
+    client->drc = drc;
+    LOCK_INIT(&client->lock);
+    for (i = 0; i < DRC_CLIENT_BUCKETS; i++)
+        INIT_LIST_HEAD(&client->buckets[i]);
+    INIT_LIST_HEAD(&client->ring);
 }
 
 /**
  * rpcsvc_get_drc_client - find the drc client with given sockaddr, else
  *                         allocate and initialize a new drc client
  *
+ * Called with drc->lock held.
+ *
  * @param drc - the main drc structure
  * @param sockaddr - network address of client
  * @return drc client on success, NULL on failure
@@ -236,14 +357,9 @@ rpcsvc_get_drc_client(rpcsvc_drc_globals_t *drc,
     GF_ATOMIC_INIT(client->ref, 0);
     client->sock_union = (union gf_sock_union) * sockaddr;
     client->op_count = 0;
+    client->bytes = 0;
     INIT_LIST_HEAD(&client->client_list);
-
-    if (drc_init_client_cache(drc, client)) {
-        gf_log(GF_RPCSVC, GF_LOG_DEBUG, "initialization of drc client failed");
-        GF_FREE(client);
-        client = NULL;
-        goto out;
-    }
+    drc_init_client_cache(drc, client);
     drc->client_count++;
 
     list_add(&client->client_list, &drc->clients_head);
@@ -280,40 +396,59 @@ rpcsvc_need_drc(rpcsvc_request_t *req)
 }
 
 /**
- * rpcsvc_drc_client_ref - ref the drc client
+ * rpcsvc_drc_checksum - checksum of the arguments of a request
  *
- * @param client - the drc client to ref
- * @return client
+ * Tells apart the requests of a client reusing xids, after a restart for
+ * instance. Only the leading bytes of the arguments are hashed, with the
+ * length of the whole.
+ *
+ * @param req - incoming request
+ * @return the checksum
  */
-static drc_client_t *
-rpcsvc_drc_client_ref(drc_client_t *client)
+static uint32_t
+rpcsvc_drc_checksum(rpcsvc_request_t *req)
 {
-    GF_ASSERT(client);
-    GF_ATOMIC_INC(client->ref);
-    return client;
+    size_t len = 0;
+    uint32_t checksum = 0;
+
+    if (req->count > 0) {
+        len = min(req->msg[0].iov_len, DRC_CHECKSUM_LEN);
+        checksum = SuperFastHash(req->msg[0].iov_base, len);
+    }
+
+    return checksum ^ (uint32_t)iov_length(req->msg, req->count);
 }
 
 /**
- * rpcsvc_drc_client_unref - unref the drc client, and destroy
- *                           the client on last unref
+ * rpcsvc_drc_get_client - the drc client of the transport of a request
  *
- * @param drc - the main drc structure
- * @param client - the drc client to unref
- * @return NULL if it is the last unref, client otherwise
+ * @param req - incoming request
+ * @return drc client on success, NULL on failure
  */
 static drc_client_t *
-rpcsvc_drc_client_unref(rpcsvc_drc_globals_t *drc, drc_client_t *client)
+rpcsvc_drc_get_client(rpcsvc_request_t *req)
 {
-    uint32_t refcount;
+    rpcsvc_drc_globals_t *drc = req->svc->drc;
+    drc_client_t *client = req->trans->drc_client;
+    drc_client_t *old = NULL;
 
-    GF_ASSERT(drc);
+    /* set on accept, or left from a drc since reconfigured */
+    if (client && client->drc == drc)
+        return client;
 
-    refcount = GF_ATOMIC_DEC(client->ref);
-    if (!refcount) {
-        drc->client_count--;
-        rpcsvc_remove_drc_client(client);
-        client = NULL;
+    LOCK(&drc->lock);
+    {
+        client = rpcsvc_get_drc_client(drc, &req->trans->peerinfo.sockaddr);
+        if (client) {
+            old = req->trans->drc_client;
+            req->trans->drc_client = rpcsvc_drc_client_ref(client);
+        }
     }
+    UNLOCK(&drc->lock);
+
+    /* the client of a drc since reconfigured, detached from it */
+    if (old)
+        rpcsvc_drc_client_unref(old);
 
     return client;
 }
@@ -321,48 +456,140 @@ rpcsvc_drc_client_unref(rpcsvc_drc_globals_t *drc, drc_client_t *client)
 /**
  * rpcsvc_drc_lookup - lookup a request to see if it is already cached
  *
+ * A request that is not found is cached as in transit, and req->reply
+ * holds a reference on it until the request is destroyed.
+ *
  * @param req - incoming request
- * @return cached reply of req if found, NULL otherwise
+ * @param state - filled with the state of the cached op found
+ * @return cached op of req with a reference held if found, NULL otherwise
  */
 drc_cached_op_t *
-rpcsvc_drc_lookup(rpcsvc_request_t *req)
+rpcsvc_drc_lookup(rpcsvc_request_t *req, drc_op_state_t *state)
 {
     drc_client_t *client = NULL;
     drc_cached_op_t *reply = NULL;
-    drc_cached_op_t new = {
-        .xid = req->xid,
-        .prognum = req->prognum,
-        .progversion = req->progver,
-        .procnum = req->procnum,
-    };
+    drc_cached_op_t *tmp = NULL;
+    drc_cached_op_t *new = NULL;
+    rpcsvc_drc_globals_t *drc = NULL;
+    struct list_head *bucket = NULL;
+    uint32_t checksum = 0;
+    struct list_head evicted;
 
     GF_ASSERT(req);
 
-    if (!req->trans->drc_client) {
-        client = rpcsvc_get_drc_client(req->svc->drc,
-                                       &req->trans->peerinfo.sockaddr);
-        if (!client)
-            goto out;
+    INIT_LIST_HEAD(&evicted);
 
-        req->trans->drc_client = rpcsvc_drc_client_ref(client);
-    }
+    client = rpcsvc_drc_get_client(req);
+    if (!client)
+        goto out;
 
-    client = req->trans->drc_client;
+    checksum = rpcsvc_drc_checksum(req);
+    bucket = &client->buckets[(req->xid ^ checksum) & (DRC_CLIENT_BUCKETS - 1)];
+
+    new = mem_get0(req->svc->drc->mempool);
+    if (new) {
+        new->client = rpcsvc_drc_client_ref(client);
+        new->drc = req->svc->drc;
+        GF_ATOMIC_INC(new->drc->ref);
+        new->xid = req->xid;
+        new->checksum = checksum;
+        new->prognum = req->prognum;
+        new->progversion = req->progver;
+        new->procnum = req->procnum;
+        new->state = DRC_OP_IN_TRANSIT;
+        new->size = sizeof(*new);
+        /* one for the cache, one for the request */
+        GF_ATOMIC_INIT(new->ref, 2);
+        INIT_LIST_HEAD(&new->hash_list);
+        INIT_LIST_HEAD(&new->ring_list);
+    }
 
-    if (client->op_count == 0)
-        goto out;
+    LOCK(&client->lock);
+    {
+        list_for_each_entry(tmp, bucket, hash_list)
+        {
+            if (tmp->xid == req->xid && tmp->checksum == checksum &&
+                tmp->prognum == req->prognum &&
+                tmp->progversion == req->progver &&
+                tmp->procnum == req->procnum) {
+                reply = tmp;
+                GF_ATOMIC_INC(reply->ref);
+                *state = reply->state;
+                break;
+            }
+        }
 
-    reply = rb_find(client->rbtree, &new);
+        /* fresh request, cache it as in transit */
+        if (!reply && new &&
+            !__rpcsvc_drc_make_room(client, new->size, 1, &evicted)) {
+            list_add(&new->hash_list, bucket);
+            list_add(&new->ring_list, &client->ring);
+            client->op_count++;
+            client->bytes += new->size;
+            GF_ATOMIC_INC(client->drc->op_count);
+            req->reply = new;
+            new = NULL;
+        }
+    }
+    UNLOCK(&client->lock);
+
+    rpcsvc_drc_put_evicted(&evicted);
+
+    if (new) {
+        if (!reply)
+            gf_log(GF_RPCSVC, GF_LOG_DEBUG, "Failed to add op to drc cache");
+        drc = new->drc;
+        mem_put(new);
+        rpcsvc_drc_client_unref(client);
+        /* last, it may be the ref keeping the mempool alive */
+        rpcsvc_drc_unref(drc);
+    }
 
 out:
     return reply;
 }
 
+/**
+ * rpcsvc_drc_request_done - release the cached op of a destroyed request
+ *
+ * An op still in transit when its request is destroyed never got a reply,
+ * it is forgotten so that a retransmission is served again.
+ *
+ * @param req - request being destroyed
+ * @return void
+ */
+void
+rpcsvc_drc_request_done(rpcsvc_request_t *req)
+{
+    drc_cached_op_t *reply = NULL;
+    drc_client_t *client = NULL;
+    struct list_head evicted;
+
+    GF_ASSERT(req);
+    GF_ASSERT(req->reply);
+
+    reply = req->reply;
+    client = reply->client;
+    req->reply = NULL;
+    INIT_LIST_HEAD(&evicted);
+
+    LOCK(&client->lock);
+    {
+        if (reply->state == DRC_OP_IN_TRANSIT &&
+            !list_empty(&reply->hash_list))
+            __rpcsvc_drc_evict(client, reply, &evicted);
+    }
+    UNLOCK(&client->lock);
+
+    rpcsvc_drc_put_evicted(&evicted);
+    rpcsvc_drc_op_unref(reply);
+}
+
 /**
  * rpcsvc_send_cached_reply - send the cached reply for the incoming request
  *
  * @param req - incoming request (which is a duplicate in this case)
- * @param reply - the cached reply for req
+ * @param reply - the cached reply for req, referenced by the caller
  * @return 0 on successful reply submission, -1 or other non-zero value
  * otherwise
  */
@@ -379,12 +606,10 @@ rpcsvc_send_cached_reply(rpcsvc_request_t *req, drc_cached_op_t *reply)
            "client: %s",
            req->xid, req->trans->peerinfo.identifier);
 
-    rpcsvc_drc_client_ref(reply->client);
     ret = rpcsvc_transport_submit(
         req->trans, reply->msg.rpchdr, reply->msg.rpchdrcount,
         reply->msg.proghdr, reply->msg.proghdrcount, reply->msg.progpayload,
         reply->msg.progpayloadcount, reply->msg.iobref, req->trans_private);
-    rpcsvc_drc_client_unref(req->svc->drc, reply->client);
 
     return ret;
 }
@@ -392,6 +617,9 @@ rpcsvc_send_cached_reply(rpcsvc_request_t *req, drc_cached_op_t *reply)
 /**
  * rpcsvc_cache_reply - cache the reply for the processed request 'req'
  *
+ * The reply is copied into an iobuf of its own, so that the cache holds
+ * exactly the bytes it accounts for and not the buffers of the request.
+ *
  * @param req - processed request
  * @param iobref - iobref structure of the reply
  * @param rpchdr - rpc header of the reply
@@ -409,156 +637,68 @@ rpcsvc_cache_reply(rpcsvc_request_t *req, struct iobref *iobref,
 {
     int ret = -1;
     drc_cached_op_t *reply = NULL;
+    drc_client_t *client = NULL;
+    struct iobuf *iob = NULL;
+    struct iobref *copy = NULL;
+    char *ptr = NULL;
+    size_t len = 0;
+    size_t size = 0;
+    struct list_head evicted;
 
     GF_ASSERT(req);
     GF_ASSERT(req->reply);
 
     reply = req->reply;
-
-    reply->state = DRC_OP_CACHED;
-
-    reply->msg.iobref = iobref_ref(iobref);
-
-    reply->msg.rpchdrcount = rpchdrcount;
-    reply->msg.rpchdr = iov_dup(rpchdr, rpchdrcount);
-
-    reply->msg.proghdrcount = proghdrcount;
-    reply->msg.proghdr = iov_dup(proghdr, proghdrcount);
-
-    reply->msg.progpayloadcount = payloadcount;
-    if (payloadcount)
-        reply->msg.progpayload = iov_dup(payload, payloadcount);
-
-    //        rpcsvc_drc_client_unref (req->svc->drc, req->trans->drc_client);
-    //        rpcsvc_drc_op_unref (req->svc->drc, reply);
-    ret = 0;
-
-    return ret;
-}
-
-/**
- * rpcsvc_vacate_drc_entries - free up some percentage of drc cache
- *                             based on the lru factor
- *
- * @param drc - the main drc structure
- * @return void
- */
-static void
-rpcsvc_vacate_drc_entries(rpcsvc_drc_globals_t *drc)
-{
-    uint32_t i = 0;
-    uint32_t n = 0;
-    drc_cached_op_t *reply = NULL;
-    drc_cached_op_t *tmp = NULL;
-    drc_client_t *client = NULL;
-
-    GF_ASSERT(drc);
-
-    n = drc->global_cache_size / drc->lru_factor;
-
-    list_for_each_entry_safe_reverse(reply, tmp, &drc->cache_head, global_list)
-    {
-        /* Don't delete ops that are in transit */
-        if (reply->state == DRC_OP_IN_TRANSIT)
-            continue;
-
-        client = reply->client;
-
-        rb_delete(client->rbtree, reply);
-
-        rpcsvc_drc_op_destroy(drc, reply);
-        rpcsvc_drc_client_unref(drc, client);
-        i++;
-        if (i >= n)
-            break;
-    }
-}
-
-/**
- * rpcsvc_add_op_to_cache - insert the cached op into the client rbtree and drc
- * list
- *
- * @param drc - the main drc structure
- * @param reply - the op to be inserted
- * @return 0 on success, -1 on failure
- */
-static int
-rpcsvc_add_op_to_cache(rpcsvc_drc_globals_t *drc, drc_cached_op_t *reply)
-{
-    drc_client_t *client = NULL;
-    drc_cached_op_t **tmp_reply = NULL;
-
-    GF_ASSERT(drc);
-    GF_ASSERT(reply);
-
     client = reply->client;
+    INIT_LIST_HEAD(&evicted);
 
-    /* cache is full, free up some space */
-    if (drc->op_count >= drc->global_cache_size)
-        rpcsvc_vacate_drc_entries(drc);
-
-    tmp_reply = (drc_cached_op_t **)rb_probe(client->rbtree, reply);
-    if (!tmp_reply) {
-        /* mem alloc failed */
-        return -1;
-    } else if (*tmp_reply != reply) {
-        /* should never happen */
-        gf_log(GF_RPCSVC, GF_LOG_ERROR, "DRC failed to detect duplicates");
-        return -1;
-    }
-
-    client->op_count++;
-    list_add(&reply->global_list, &drc->cache_head);
-    drc->op_count++;
-
-    return 0;
-}
+    len = iov_length(rpchdr, rpchdrcount) + iov_length(proghdr, proghdrcount) +
+          iov_length(payload, payloadcount);
 
-/**
- * rpcsvc_cache_request - cache the in-transition incoming request
- *
- * @param req - incoming request
- * @return 0 on success, -1 on failure
- */
-int
-rpcsvc_cache_request(rpcsvc_request_t *req)
-{
-    int ret = -1;
-    drc_client_t *client = NULL;
-    drc_cached_op_t *reply = NULL;
-    rpcsvc_drc_globals_t *drc = NULL;
-
-    GF_ASSERT(req);
-
-    drc = req->svc->drc;
-
-    client = req->trans->drc_client;
-    if (!client) {
-        gf_log(GF_RPCSVC, GF_LOG_DEBUG, "drc client is NULL");
+    iob = iobuf_get2(req->svc->ctx->iobuf_pool, len);
+    if (!iob)
         goto out;
-    }
 
-    reply = mem_get0(drc->mempool);
-    if (!reply)
+    copy = iobref_new();
+    if (!copy) {
+        iobuf_unref(iob);
         goto out;
+    }
+    iobref_add(copy, iob);
+    size = iobuf_pagesize(iob);
 
-    reply->client = rpcsvc_drc_client_ref(client);
-    reply->xid = req->xid;
-    reply->prognum = req->prognum;
-    reply->progversion = req->progver;
-    reply->procnum = req->procnum;
-    reply->state = DRC_OP_IN_TRANSIT;
-    req->reply = reply;
-    INIT_LIST_HEAD(&reply->global_list);
+    ptr = iobuf_ptr(iob);
+    iov_unload(ptr, rpchdr, rpchdrcount);
+    ptr += iov_length(rpchdr, rpchdrcount);
+    iov_unload(ptr, proghdr, proghdrcount);
+    ptr += iov_length(proghdr, proghdrcount);
+    iov_unload(ptr, payload, payloadcount);
 
-    ret = rpcsvc_add_op_to_cache(drc, reply);
-    if (ret) {
-        req->reply = NULL;
-        rpcsvc_drc_op_destroy(drc, reply);
-        rpcsvc_drc_client_unref(drc, client);
-        gf_log(GF_RPCSVC, GF_LOG_DEBUG, "Failed to add op to drc cache");
+    LOCK(&client->lock);
+    {
+        /* the op may have been evicted while in transit */
+        if (!list_empty(&reply->hash_list)) {
+            reply->vector.iov_base = iobuf_ptr(iob);
+            reply->vector.iov_len = len;
+            reply->msg.rpchdr = &reply->vector;
+            reply->msg.rpchdrcount = 1;
+            reply->msg.iobref = copy;
+            reply->size += size;
+            client->bytes += size;
+            reply->state = DRC_OP_CACHED;
+            copy = NULL;
+
+            __rpcsvc_drc_make_room(client, 0, 0, &evicted);
+        }
     }
+    UNLOCK(&client->lock);
+
+    rpcsvc_drc_put_evicted(&evicted);
+    iobuf_unref(iob);
+    if (copy)
+        iobref_unref(copy);
 
+    ret = 0;
 out:
     return ret;
 }
@@ -597,19 +737,22 @@ rpcsvc_drc_priv(rpcsvc_drc_globals_t *drc)
     gf_proc_dump_write(key, "%d", drc->client_count);
 
     gf_proc_dump_build_key(key, "drc", "current_cache_size");
-    gf_proc_dump_write(key, "%d", drc->op_count);
+    gf_proc_dump_write(key, "%" PRId64, GF_ATOMIC_GET(drc->op_count));
 
     gf_proc_dump_build_key(key, "drc", "max_cache_size");
     gf_proc_dump_write(key, "%d", drc->global_cache_size);
 
-    gf_proc_dump_build_key(key, "drc", "lru_factor");
-    gf_proc_dump_write(key, "%d", drc->lru_factor);
+    gf_proc_dump_build_key(key, "drc", "max_client_cache_bytes");
+    gf_proc_dump_write(key, "%" PRIu64, drc->client_cache_size);
 
     gf_proc_dump_build_key(key, "drc", "duplicate_request_count");
-    gf_proc_dump_write(key, "%" PRIu64, drc->cache_hits);
+    gf_proc_dump_write(key, "%" PRId64, GF_ATOMIC_GET(drc->cache_hits));
 
     gf_proc_dump_build_key(key, "drc", "in_transit_duplicate_requests");
-    gf_proc_dump_write(key, "%" PRIu64, drc->intransit_hits);
+    gf_proc_dump_write(key, "%" PRId64, GF_ATOMIC_GET(drc->intransit_hits));
+
+    gf_proc_dump_build_key(key, "drc", "evictions");
+    gf_proc_dump_write(key, "%" PRId64, GF_ATOMIC_GET(drc->evictions));
 
     list_for_each_entry(client, &drc->clients_head, client_list)
     {
@@ -636,6 +779,8 @@ rpcsvc_drc_priv(rpcsvc_drc_globals_t *drc)
         gf_proc_dump_write(key, "%" PRIu32, GF_ATOMIC_GET(client->ref));
         gf_proc_dump_build_key(key, "client", "%d.op_count", i);
         gf_proc_dump_write(key, "%d", client->op_count);
+        gf_proc_dump_build_key(key, "client", "%d.cache_bytes", i);
+        gf_proc_dump_write(key, "%" PRIu64, client->bytes);
         i++;
     }
 
@@ -669,37 +814,60 @@ rpcsvc_drc_notify(rpcsvc_t *svc, void *xl, rpcsvc_event_t event, void *data)
     if (drc->status == DRC_UNINITIATED || drc->type == DRC_TYPE_NONE)
         return 0;
 
-    LOCK(&drc->lock);
-    {
-        trans = (rpc_transport_t *)data;
-        client = rpcsvc_get_drc_client(drc, &trans->peerinfo.sockaddr);
-        if (!client)
-            goto unlock;
-
-        switch (event) {
-            case RPCSVC_EVENT_ACCEPT:
-                trans->drc_client = rpcsvc_drc_client_ref(client);
-                ret = 0;
-                break;
+    trans = (rpc_transport_t *)data;
+
+    switch (event) {
+        case RPCSVC_EVENT_ACCEPT:
+            LOCK(&drc->lock);
+            {
+                client = rpcsvc_get_drc_client(drc, &trans->peerinfo.sockaddr);
+                if (client) {
+                    trans->drc_client = rpcsvc_drc_client_ref(client);
+                    ret = 0;
+                }
+            }
+            UNLOCK(&drc->lock);
+            break;
 
-            case RPCSVC_EVENT_DISCONNECT:
-                ret = 0;
-                if (list_empty(&drc->clients_head))
-                    break;
-                /* should be the last unref */
-                trans->drc_client = NULL;
-                rpcsvc_drc_client_unref(drc, client);
+        case RPCSVC_EVENT_DISCONNECT:
+            ret = 0;
+            client = trans->drc_client;
+            if (!client || client->drc != drc)
                 break;
+            /* the cached ops of the client keep it around */
+            trans->drc_client = NULL;
+            rpcsvc_drc_client_unref(client);
+            break;
 
-            default:
-                break;
-        }
+        default:
+            break;
     }
-unlock:
-    UNLOCK(&drc->lock);
+
     return ret;
 }
 
+/**
+ * rpcsvc_drc_client_size - the bytes the cached ops of a client may hold
+ *
+ * @param options - the options dictionary which configures drc
+ * @return the size set by "nfs.drc-client-size", or the default one
+ */
+static uint64_t
+rpcsvc_drc_client_size(dict_t *options)
+{
+    char *str = NULL;
+    uint64_t size = 0;
+
+    if (dict_get_str(options, "nfs.drc-client-size", &str) ||
+        gf_string2bytesize_uint64(str, &size) || !size) {
+        gf_log(GF_RPCSVC, GF_LOG_DEBUG,
+               "drc client size not set. Continuing with default size");
+        size = DRC_DEFAULT_CLIENT_CACHE_SIZE;
+    }
+
+    return size;
+}
+
 /**
  * rpcsvc_drc_init - Initialize the duplicate request cache service
  *
@@ -713,7 +881,6 @@ rpcsvc_drc_init(rpcsvc_t *svc, dict_t *options)
     int ret = 0;
     uint32_t drc_type = 0;
     uint32_t drc_size = 0;
-    uint32_t drc_factor = 0;
     rpcsvc_drc_globals_t *drc = NULL;
 
     GF_ASSERT(svc);
@@ -772,18 +939,15 @@ rpcsvc_drc_init(rpcsvc_t *svc, dict_t *options)
         goto post_unlock;
     }
 
-    /* What percent of cache to be evicted whenever it fills up */
-    ret = dict_get_uint32(options, "nfs.drc-lru-factor", &drc_factor);
-    if (ret) {
-        gf_log(GF_RPCSVC, GF_LOG_DEBUG,
-               "drc lru factor not set. Continuing with policy default");
-        drc_factor = DRC_DEFAULT_LRU_FACTOR;
-    }
-
-    drc->lru_factor = (drc_lru_factor_t)drc_factor;
+    /* Bytes the cached ops of a client may hold */
+    drc->client_cache_size = rpcsvc_drc_client_size(options);
 
+    GF_ATOMIC_INIT(drc->op_count, 0);
+    GF_ATOMIC_INIT(drc->cache_hits, 0);
+    GF_ATOMIC_INIT(drc->intransit_hits, 0);
+    GF_ATOMIC_INIT(drc->evictions, 0);
+    GF_ATOMIC_INIT(drc->ref, 1);
     INIT_LIST_HEAD(&drc->clients_head);
-    INIT_LIST_HEAD(&drc->cache_head);
 
     ret = rpcsvc_register_notify(svc, rpcsvc_drc_notify, THIS);
     if (ret) {
@@ -812,6 +976,9 @@ int
 rpcsvc_drc_deinit(rpcsvc_t *svc)
 {
     rpcsvc_drc_globals_t *drc = NULL;
+    drc_client_t *client = NULL;
+    drc_client_t *tmp = NULL;
+    struct list_head evicted;
 
     if (!svc)
         return (-1);
@@ -820,16 +987,34 @@ rpcsvc_drc_deinit(rpcsvc_t *svc)
     if (!drc)
         return (0);
 
+    INIT_LIST_HEAD(&evicted);
+
     LOCK(&drc->lock);
     (void)rpcsvc_unregister_notify(svc, rpcsvc_drc_notify, THIS);
-    if (drc->mempool) {
-        mem_pool_destroy(drc->mempool);
-        drc->mempool = NULL;
+
+    /* Empty the caches and detach the clients, the ones still referenced
+     * by transports or requests are freed on their last unref. */
+    list_for_each_entry_safe(client, tmp, &drc->clients_head, client_list)
+    {
+        LOCK(&client->lock);
+        {
+            while (!list_empty(&client->ring))
+                __rpcsvc_drc_evict(
+                    client,
+                    list_entry(client->ring.next, drc_cached_op_t, ring_list),
+                    &evicted);
+            client->drc = NULL;
+        }
+        UNLOCK(&client->lock);
+        list_del_init(&client->client_list);
     }
     UNLOCK(&drc->lock);
 
-    GF_FREE(drc);
+    rpcsvc_drc_put_evicted(&evicted);
+
     svc->drc = NULL;
+    /* the mempool goes with the last op still in flight */
+    rpcsvc_drc_unref(drc);
 
     return (0);
 }
@@ -884,6 +1069,9 @@ rpcsvc_drc_reconfigure(rpcsvc_t *svc, dict_t *options)
         if (dict_get_uint32(options, "nfs.drc-size", &drc_size))
             drc_size = DRC_DEFAULT_CACHE_SIZE;
 
+        /* the budget of the clients applies to the ops cached next */
+        drc->client_cache_size = rpcsvc_drc_client_size(options);
+
         /* case 1: sub-case 1*/
         if (drc->global_cache_size == drc_size)
             return (0);
@@ -14,15 +14,27 @@
 #include "rpcsvc.h"
 #include <glusterfs/locking.h>
 #include <glusterfs/dict.h>
-#include "rb.h"
+
+/* Hash buckets of the cache of each client, a power of two */
+#define DRC_CLIENT_BUCKETS 256
+
+/* Leading bytes of the call arguments covered by the checksum of an op */
+#define DRC_CHECKSUM_LEN 256
 
 /* per-client cache structure */
 struct drc_client {
     union gf_sock_union sock_union;
-    /* pointers to the cache */
-    struct rb_table *rbtree;
+    rpcsvc_drc_globals_t *drc;
+    /* protects the buckets, the ring and the counters below */
+    gf_lock_t lock;
+    /* cached ops hashed by xid and checksum */
+    struct list_head buckets[DRC_CLIENT_BUCKETS];
+    /* cached ops in arrival order, the oldest is evicted first */
+    struct list_head ring;
     /* no. of ops currently cached */
     uint32_t op_count;
+    /* bytes held by the cached ops */
+    uint64_t bytes;
     gf_atomic_uint32_t ref;
     struct list_head client_list;
 };
@@ -33,11 +45,18 @@ struct drc_cached_op {
     int progversion;
     int procnum;
     rpc_transport_msg_t msg;
+    /* the reply, copied into the iobuf of msg.iobref */
+    struct iovec vector;
     drc_client_t *client;
-    struct list_head client_list;
-    struct list_head global_list;
-    int32_t ref;
+    /* the pool the op comes from is kept as long as the op is */
+    rpcsvc_drc_globals_t *drc;
+    struct list_head hash_list;
+    struct list_head ring_list;
+    /* bytes accounted to the client for this op */
+    size_t size;
+    gf_atomic_int32_t ref;
     uint32_t xid;
+    uint32_t checksum;
 };
 
 /* global drc definitions */
@@ -45,22 +64,22 @@ enum drc_status { DRC_UNINITIATED, DRC_INITIATED };
 typedef enum drc_status drc_status_t;
 
 struct drc_globals {
-    /* allocator must be the first member since
-     * it is used so in gf_libavl_allocator
-     */
-    struct libavl_allocator allocator;
-    /* configurable size parameter */
+    /* protects clients_head and client_count */
     gf_lock_t lock;
-    uint64_t cache_hits;
-    uint64_t intransit_hits;
+    gf_atomic_t cache_hits;
+    gf_atomic_t intransit_hits;
+    gf_atomic_t evictions;
+    /* held by the service and by every op allocated from mempool */
+    gf_atomic_t ref;
     struct mem_pool *mempool;
-    struct list_head cache_head;
     struct list_head clients_head;
-    uint32_t op_count;
+    /* no. of ops cached for all the clients */
+    gf_atomic_t op_count;
     uint32_t client_count;
+    /* configurable size parameters */
     uint32_t global_cache_size;
+    uint64_t client_cache_size;
     drc_type_t type;
-    drc_lru_factor_t lru_factor;
     drc_status_t status;
 };
 
@@ -68,7 +87,13 @@ int
 rpcsvc_need_drc(rpcsvc_request_t *req);
 
 drc_cached_op_t *
-rpcsvc_drc_lookup(rpcsvc_request_t *req);
+rpcsvc_drc_lookup(rpcsvc_request_t *req, drc_op_state_t *state);
+
+void
+rpcsvc_drc_op_unref(drc_cached_op_t *reply);
+
+void
+rpcsvc_drc_request_done(rpcsvc_request_t *req);
 
 int
 rpcsvc_send_cached_reply(rpcsvc_request_t *req, drc_cached_op_t *reply);
@@ -78,9 +103,6 @@ rpcsvc_cache_reply(rpcsvc_request_t *req, struct iobref *iobref,
                    struct iovec *rpchdr, int rpchdrcount, struct iovec *proghdr,
                    int proghdrcount, struct iovec *payload, int payloadcount);
 
-int
-rpcsvc_cache_request(rpcsvc_request_t *req);
-
 int32_t
 rpcsvc_drc_priv(rpcsvc_drc_globals_t *drc);
 
@@ -77,6 +77,7 @@ typedef struct rpcsvc_state {
     gf_boolean_t allow_insecure;
     gf_boolean_t register_portmap;
     gf_boolean_t root_squash;
+    gf_boolean_t numa_affinity;
     gf_boolean_t all_squash;
 } rpcsvc_t;
 
@@ -87,14 +88,6 @@ typedef enum drc_op_type drc_op_type_t;
 enum drc_type { DRC_TYPE_NONE = 0, DRC_TYPE_IN_MEMORY = 1 };
 typedef enum drc_type drc_type_t;
 
-enum drc_lru_factor {
-    DRC_LRU_5_PC = 20,
-    DRC_LRU_10_PC = 10,
-    DRC_LRU_25_PC = 4,
-    DRC_LRU_50_PC = 2
-};
-typedef enum drc_lru_factor drc_lru_factor_t;
-
 enum drc_xid_state { DRC_XID_MONOTONOUS = 0, DRC_XID_WRAPPED = 1 };
 typedef enum drc_xid_state drc_xid_state_t;
 
@@ -107,7 +100,7 @@ typedef enum drc_policy drc_policy_t;
 /* Default policies for DRC */
 #define DRC_DEFAULT_TYPE DRC_TYPE_IN_MEMORY
 #define DRC_DEFAULT_CACHE_SIZE 0x20000
-#define DRC_DEFAULT_LRU_FACTOR DRC_LRU_25_PC
+#define DRC_DEFAULT_CLIENT_CACHE_SIZE (4 * GF_UNIT_MB)
 
 /* DRC END */
 
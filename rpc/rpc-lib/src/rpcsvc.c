@@ -98,6 +98,35 @@ rpcsvc_get_free_queue_index(rpcsvc_program_t *prog)
     return i * __BITS_PER_LONG + j;
 }
 
+static void
+rpcsvc_request_enqueue(rpcsvc_request_queue_t *queue, rpcsvc_request_t *req)
+{
+    int node = gf_numa_current_node();
+
+    GF_ATOMIC_INC(queue->queued);
+    if ((node >= 0) && (node != CMM_LOAD_SHARED(queue->node)))
+        GF_ATOMIC_INC(queue->cross_node);
+
+    cds_wfcq_node_init(&req->request_node);
+    if (cds_wfcq_enqueue(&queue->head, &queue->tail, &req->request_node)) {
+        /* the queue was not empty, so the handler is not asleep */
+        return;
+    }
+
+    /* Pairs with the barrier in rpcsvc_request_handler(): either the handler
+     * sees this request before sleeping or we see it waiting. */
+    cmm_smp_mb();
+    if (CMM_LOAD_SHARED(queue->waiting)) {
+        GF_ATOMIC_INC(queue->wakeups);
+
+        pthread_mutex_lock(&queue->queue_lock);
+        {
+            pthread_cond_signal(&queue->queue_cond);
+        }
+        pthread_mutex_unlock(&queue->queue_lock);
+    }
+}
+
 rpcsvc_notify_wrapper_t *
 rpcsvc_notify_wrapper_alloc(void)
 {
@@ -413,6 +442,10 @@ rpcsvc_request_destroy(rpcsvc_request_t *req)
         iobref_unref(req->iobref);
     }
 
+    if (req->reply) {
+        rpcsvc_drc_request_done(req);
+    }
+
     /* This marks the "end" of an RPC request. Reply is
        completely written to the socket and is on the way
        to the client. It is time to decrement the
@@ -462,7 +495,6 @@ rpcsvc_request_init(rpcsvc_t *svc, rpc_transport_t *trans,
     req->svc = svc;
     req->trans_private = msg->private;
 
-    INIT_LIST_HEAD(&req->request_list);
     req->payloadsize = 0;
 
     /* By this time, the data bytes for the auth scheme would have already
@@ -619,7 +651,7 @@ rpcsvc_queue_event_thread_death(rpcsvc_t *svc, rpcsvc_program_t *prog, int gen)
     int num = 0;
     void *value = NULL;
     rpcsvc_request_t *req = NULL;
-    char empty = 0;
+    gf_boolean_t duplicate = _gf_false;
 
     value = pthread_getspecific(prog->req_queue_key);
     if (value == NULL) {
@@ -630,8 +662,14 @@ rpcsvc_queue_event_thread_death(rpcsvc_t *svc, rpcsvc_program_t *prog, int gen)
 
     queue = &prog->request_queue[num];
 
-    if (queue->gen == gen) {
-        /* duplicate event */
+    pthread_mutex_lock(&queue->queue_lock);
+    {
+        duplicate = (queue->gen == gen);
+        queue->gen = gen;
+    }
+    pthread_mutex_unlock(&queue->queue_lock);
+
+    if (duplicate) {
         gf_log(GF_RPCSVC, GF_LOG_INFO,
                "not queuing duplicate event thread death. "
                "queue %d program %s",
@@ -646,17 +684,7 @@ rpcsvc_queue_event_thread_death(rpcsvc_t *svc, rpcsvc_program_t *prog, int gen)
            "queuing event thread death request to queue %d of program %s", num,
            prog->progname);
 
-    pthread_mutex_lock(&queue->queue_lock);
-    {
-        empty = list_empty(&queue->request_queue);
-
-        list_add_tail(&req->request_list, &queue->request_queue);
-        queue->gen = gen;
-
-        if (empty && queue->waiting)
-            pthread_cond_signal(&queue->queue_cond);
-    }
-    pthread_mutex_unlock(&queue->queue_lock);
+    rpcsvc_request_enqueue(queue, req);
 
     return;
 }
@@ -688,9 +716,10 @@ rpcsvc_handle_rpc_call(rpcsvc_t *svc, rpc_transport_t *trans,
     rpcsvc_request_t *req = NULL;
     int ret = -1;
     uint16_t port = 0;
-    gf_boolean_t is_unix = _gf_false, empty = _gf_false;
+    gf_boolean_t is_unix = _gf_false;
     gf_boolean_t unprivileged = _gf_false, spawn_request_handler = 0;
     drc_cached_op_t *reply = NULL;
+    drc_op_state_t state = DRC_OP_IN_TRANSIT;
     rpcsvc_drc_globals_t *drc = NULL;
     rpcsvc_request_queue_t *queue = NULL;
     long num = 0;
@@ -753,39 +782,33 @@ rpcsvc_handle_rpc_call(rpcsvc_t *svc, rpc_transport_t *trans,
     if (rpcsvc_need_drc(req)) {
         drc = req->svc->drc;
 
-        LOCK(&drc->lock);
-        {
-            reply = rpcsvc_drc_lookup(req);
-
-            /* retransmission of completed request, send cached reply */
-            if (reply && reply->state == DRC_OP_CACHED) {
-                gf_log(GF_RPCSVC, GF_LOG_INFO,
-                       "duplicate request:"
-                       " XID: 0x%x",
-                       req->xid);
-                ret = rpcsvc_send_cached_reply(req, reply);
-                drc->cache_hits++;
-                UNLOCK(&drc->lock);
-                goto out;
-
-            } /* retransmitted request, original op in transit, drop it */
-            else if (reply && reply->state == DRC_OP_IN_TRANSIT) {
-                gf_log(GF_RPCSVC, GF_LOG_INFO,
-                       "op in transit,"
-                       " discarding. XID: 0x%x",
-                       req->xid);
-                ret = 0;
-                drc->intransit_hits++;
-                rpcsvc_request_destroy(req);
-                UNLOCK(&drc->lock);
-                goto out;
+        /* a fresh request is cached as in-transit by the lookup */
+        reply = rpcsvc_drc_lookup(req, &state);
+
+        /* retransmission of completed request, send cached reply */
+        if (reply && state == DRC_OP_CACHED) {
+            gf_log(GF_RPCSVC, GF_LOG_INFO,
+                   "duplicate request:"
+                   " XID: 0x%x",
+                   req->xid);
+            ret = rpcsvc_send_cached_reply(req, reply);
+            GF_ATOMIC_INC(drc->cache_hits);
+            rpcsvc_drc_op_unref(reply);
+            rpcsvc_request_destroy(req);
+            goto out;
 
-            } /* fresh request, cache it as in-transit and proceed */
-            else {
-                ret = rpcsvc_cache_request(req);
-            }
+        } /* retransmitted request, original op in transit, drop it */
+        else if (reply) {
+            gf_log(GF_RPCSVC, GF_LOG_INFO,
+                   "op in transit,"
+                   " discarding. XID: 0x%x",
+                   req->xid);
+            ret = 0;
+            GF_ATOMIC_INC(drc->intransit_hits);
+            rpcsvc_drc_op_unref(reply);
+            rpcsvc_request_destroy(req);
+            goto out;
         }
-        UNLOCK(&drc->lock);
     }
 
     if (req->rpc_err == SUCCESS) {
@@ -840,6 +863,12 @@ rpcsvc_handle_rpc_call(rpcsvc_t *svc, rpc_transport_t *trans,
             queue = &req->prog->request_queue[num];
 
             if (spawn_request_handler) {
+                /* the handler is kept next to the event thread feeding
+                 * it, so that a request is read, run and replied to
+                 * on one NUMA node */
+                queue->node = gf_numa_current_node();
+                queue->bind = req->svc->numa_affinity;
+
                 ret = gf_thread_create(&queue->thread, NULL,
                                        rpcsvc_request_handler, queue,
                                        "rpcrqhnd");
@@ -868,16 +897,7 @@ rpcsvc_handle_rpc_call(rpcsvc_t *svc, rpc_transport_t *trans,
                 }
             }
 
-            pthread_mutex_lock(&queue->queue_lock);
-            {
-                empty = list_empty(&queue->request_queue);
-
-                list_add_tail(&req->request_list, &queue->request_queue);
-
-                if (empty && queue->waiting)
-                    pthread_cond_signal(&queue->queue_cond);
-            }
-            pthread_mutex_unlock(&queue->queue_lock);
+            rpcsvc_request_enqueue(queue, req);
 
             ret = 0;
         } else {
@@ -1494,7 +1514,6 @@ rpcsvc_submit_generic(rpcsvc_request_t *req, struct iovec *proghdr,
     size_t msglen = 0;
     size_t hdrlen = 0;
     char new_iobref = 0;
-    rpcsvc_drc_globals_t *drc = NULL;
     gf_latency_t *lat = NULL;
     struct timespec end;
 
@@ -1540,12 +1559,8 @@ rpcsvc_submit_generic(rpcsvc_request_t *req, struct iovec *proghdr,
 
     /* cache the request in the duplicate request cache for appropriate ops */
     if ((req->reply) && (rpcsvc_need_drc(req))) {
-        drc = req->svc->drc;
-
-        LOCK(&drc->lock);
         ret = rpcsvc_cache_reply(req, iobref, &recordhdr, 1, proghdr, hdrcount,
                                  payload, payloadcount);
-        UNLOCK(&drc->lock);
         if (ret < 0) {
             gf_log(GF_RPCSVC, GF_LOG_ERROR, "failed to cache reply");
         }
@@ -2157,91 +2172,107 @@ out:
     return ret;
 }
 
+static void
+rpcsvc_request_handler_bind(rpcsvc_request_queue_t *queue)
+{
+#ifdef GF_LINUX_HOST_OS
+    cpu_set_t cpus;
+    int ret = 0;
+
+    if (!queue->bind || (gf_numa_node_cpus(queue->node, &cpus) != 0))
+        return;
+
+    ret = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    if (ret != 0) {
+        gf_log(GF_RPCSVC, GF_LOG_WARNING,
+               "failed to bind request handler of queue %d to NUMA node %d "
+               "(%s)",
+               (int)(queue - &queue->program->request_queue[0]), queue->node,
+               strerror(ret));
+        queue->bind = _gf_false;
+    }
+#endif
+}
+
 void *
 rpcsvc_request_handler(void *arg)
 {
     rpcsvc_request_queue_t *queue = NULL;
     rpcsvc_program_t *program = NULL;
-    rpcsvc_request_t *req = NULL, *tmp_req = NULL;
+    rpcsvc_request_t *req = NULL;
     rpcsvc_actor_t *actor = NULL;
+    struct cds_wfcq_node *node = NULL;
     gf_boolean_t done = _gf_false;
     int ret = 0;
-    struct list_head tmp_list;
 
     queue = arg;
     program = queue->program;
 
-    INIT_LIST_HEAD(&tmp_list);
-
     if (!program)
         return NULL;
 
-    while (1) {
-        pthread_mutex_lock(&queue->queue_lock);
-        {
-            if (!program->alive && list_empty(&queue->request_queue)) {
-                done = 1;
-                goto unlock;
-            }
+    rpcsvc_request_handler_bind(queue);
 
-            while (list_empty(&queue->request_queue)) {
-                queue->waiting = _gf_true;
-                pthread_cond_wait(&queue->queue_cond, &queue->queue_lock);
-            }
+    while (!done) {
+        node = cds_wfcq_dequeue_blocking(&queue->head, &queue->tail);
+        if (node == NULL) {
+            if (!program->alive)
+                break;
 
-            queue->waiting = _gf_false;
+            pthread_mutex_lock(&queue->queue_lock);
+            {
+                CMM_STORE_SHARED(queue->waiting, _gf_true);
+                /* Pairs with the barrier in rpcsvc_request_enqueue(). */
+                cmm_smp_mb();
 
-            if (!list_empty(&queue->request_queue)) {
-                INIT_LIST_HEAD(&tmp_list);
-                list_splice_init(&queue->request_queue, &tmp_list);
+                while (cds_wfcq_empty(&queue->head, &queue->tail))
+                    pthread_cond_wait(&queue->queue_cond, &queue->queue_lock);
+
+                CMM_STORE_SHARED(queue->waiting, _gf_false);
             }
+            pthread_mutex_unlock(&queue->queue_lock);
+
+            if (!queue->bind)
+                CMM_STORE_SHARED(queue->node, gf_numa_current_node());
+
+            continue;
         }
-    unlock:
-        pthread_mutex_unlock(&queue->queue_lock);
 
-        list_for_each_entry_safe(req, tmp_req, &tmp_list, request_list)
-        {
-            if (req) {
-                list_del_init(&req->request_list);
-
-                if (req->prognum == RPCSVC_INFRA_PROGRAM) {
-                    switch (req->procnum) {
-                        case RPCSVC_PROC_EVENT_THREAD_DEATH:
-                            gf_log(GF_RPCSVC, GF_LOG_INFO,
-                                   "event thread died, exiting request handler "
-                                   "thread for queue %d of program %s",
-                                   (int)(queue - &program->request_queue[0]),
-                                   program->progname);
-                            done = 1;
-                            pthread_mutex_lock(&program->thr_lock);
-                            {
-                                rpcsvc_toggle_queue_status(
-                                    program, queue,
-                                    program->request_queue_status);
-                                program->threadcount--;
-                            }
-                            pthread_mutex_unlock(&program->thr_lock);
-                            rpcsvc_request_destroy(req);
-                            break;
-
-                        default:
-                            break;
-                    }
-                } else {
-                    THIS = req->svc->xl;
-                    actor = rpcsvc_program_actor(req);
-                    ret = actor->actor(req);
+        req = caa_container_of(node, rpcsvc_request_t, request_node);
+        GF_ATOMIC_INC(queue->handled);
 
-                    if (ret != 0) {
-                        rpcsvc_check_and_reply_error(ret, NULL, req);
+        if (req->prognum == RPCSVC_INFRA_PROGRAM) {
+            switch (req->procnum) {
+                case RPCSVC_PROC_EVENT_THREAD_DEATH:
+                    gf_log(GF_RPCSVC, GF_LOG_INFO,
+                           "event thread died, exiting request handler "
+                           "thread for queue %d of program %s",
+                           (int)(queue - &program->request_queue[0]),
+                           program->progname);
+                    done = 1;
+                    pthread_mutex_lock(&program->thr_lock);
+                    {
+                        rpcsvc_toggle_queue_status(
+                            program, queue, program->request_queue_status);
+                        program->threadcount--;
                     }
-                    req = NULL;
-                }
+                    pthread_mutex_unlock(&program->thr_lock);
+                    rpcsvc_request_destroy(req);
+                    break;
+
+                default:
+                    break;
             }
-        }
+        } else {
+            THIS = req->svc->xl;
+            actor = rpcsvc_program_actor(req);
+            ret = actor->actor(req);
 
-        if (done)
-            break;
+            if (ret != 0) {
+                rpcsvc_check_and_reply_error(ret, NULL, req);
+            }
+        }
+        req = NULL;
     }
 
     return NULL;
@@ -2299,10 +2330,16 @@ rpcsvc_program_register(rpcsvc_t *svc, rpcsvc_program_t *program,
     pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_ADAPTIVE_NP);
 
     for (i = 0; i < EVENT_MAX_THREADS; i++) {
-        INIT_LIST_HEAD(&newprog->request_queue[i].request_queue);
+        cds_wfcq_init(&newprog->request_queue[i].head,
+                      &newprog->request_queue[i].tail);
         pthread_mutex_init(&newprog->request_queue[i].queue_lock, &attr);
         pthread_cond_init(&newprog->request_queue[i].queue_cond, NULL);
         newprog->request_queue[i].program = newprog;
+        newprog->request_queue[i].node = -1;
+        GF_ATOMIC_INIT(newprog->request_queue[i].queued, 0);
+        GF_ATOMIC_INIT(newprog->request_queue[i].handled, 0);
+        GF_ATOMIC_INIT(newprog->request_queue[i].wakeups, 0);
+        GF_ATOMIC_INIT(newprog->request_queue[i].cross_node, 0);
     }
 
     pthread_mutex_init(&newprog->thr_lock, &attr);
@@ -2521,7 +2558,8 @@ rpcsvc_init_options(rpcsvc_t *svc, dict_t *options)
         gf_log(GF_RPCSVC, GF_LOG_DEBUG,
                "Portmap registration "
                "disabled");
-    ret = 0;
+
+    ret = rpcsvc_set_numa_affinity(svc, options);
 out:
     return ret;
 }
@@ -2699,6 +2737,34 @@ rpcsvc_set_outstanding_rpc_limit(rpcsvc_t *svc, dict_t *options, int defvalue)
     return (0);
 }
 
+/*
+ * Configure() the rpc.numa-affinity param: when on, the event threads are
+ * pinned to the NUMA nodes of the host and request handler threads started
+ * from now on are bound to the node of their event thread.
+ * Returns 0 on success, -1 on an invalid value.
+ */
+int
+rpcsvc_set_numa_affinity(rpcsvc_t *svc, dict_t *options)
+{
+    int ret = -1;
+
+    if ((!svc) || (!options))
+        return -1;
+
+    ret = dict_get_str_boolean(options, "rpc.numa-affinity", _gf_false);
+    if (ret < 0) {
+        gf_log(GF_RPCSVC, GF_LOG_ERROR,
+               "Failed to parse "
+               "rpc.numa-affinity");
+        return -1;
+    }
+
+    svc->numa_affinity = ret;
+    glusterfs_ctx_set_numa(svc->ctx, svc->numa_affinity);
+
+    return 0;
+}
+
 /*
  * Enable throttling for rpcsvc_t svc.
  * Returns 0 on success, -1 otherwise.
@@ -2756,6 +2822,10 @@ rpcsvc_destroy(rpcsvc_t *svc)
     if (!svc)
         return ret;
 
+    if (svc->ctx)
+        gf_event_autoscale_del_source(svc->ctx->event_pool,
+                                      rpcsvc_request_backlog, svc);
+
     list_for_each_entry_safe(listener, next, &svc->listeners, list)
     {
         rpcsvc_listener_destroy(listener);
@@ -2800,6 +2870,7 @@ rpcsvc_init(xlator_t *xl, glusterfs_ctx_t *ctx, dict_t *options,
     INIT_LIST_HEAD(&svc->notify);
     INIT_LIST_HEAD(&svc->listeners);
     INIT_LIST_HEAD(&svc->programs);
+    svc->ctx = ctx;
 
     ret = rpcsvc_init_options(svc, options);
     if (ret == -1) {
@@ -2828,7 +2899,6 @@ rpcsvc_init(xlator_t *xl, glusterfs_ctx_t *ctx, dict_t *options,
 
     ret = -1;
     svc->options = options;
-    svc->ctx = ctx;
     svc->xl = xl;
     gf_log(GF_RPCSVC, GF_LOG_DEBUG, "RPC service inited.");
 
@@ -2840,6 +2910,14 @@ rpcsvc_init(xlator_t *xl, glusterfs_ctx_t *ctx, dict_t *options,
         goto free_svc;
     }
 
+    /* the requests waiting for their handler thread tell the event thread
+     * autoscaler that more threads are needed */
+    if (ctx->event_pool &&
+        gf_event_autoscale_add_source(ctx->event_pool, rpcsvc_request_backlog,
+                                      svc))
+        gf_log(GF_RPCSVC, GF_LOG_DEBUG,
+               "request backlog not reported to the autoscaler");
+
     ret = 0;
 free_svc:
     if (ret == -1) {
@@ -3241,6 +3319,7 @@ rpcsvc_program_dump(rpcsvc_program_t *prog)
 {
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
     char key[GF_DUMP_MAX_BUF_LEN];
+    rpcsvc_request_queue_t *queue = NULL;
     int i;
 
     snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s", prog->progname);
@@ -3252,6 +3331,23 @@ rpcsvc_program_dump(rpcsvc_program_t *prog)
     gf_proc_dump_build_key(key, key_prefix, "program-version");
     gf_proc_dump_write(key, "%d", prog->progver);
 
+    if (prog->ownthread) {
+        for (i = 0; i < EVENT_MAX_THREADS; i++) {
+            queue = &prog->request_queue[i];
+            if (GF_ATOMIC_GET(queue->queued) == 0)
+                continue;
+
+            gf_proc_dump_build_key(key, key_prefix, "request-queue[%d]", i);
+            gf_proc_dump_write(key,
+                               "node=%d, bound=%d, queued=%" PRIu64
+                               ", wakeups=%" PRIu64 ", cross-node=%" PRIu64,
+                               queue->node, queue->bind,
+                               GF_ATOMIC_GET(queue->queued),
+                               GF_ATOMIC_GET(queue->wakeups),
+                               GF_ATOMIC_GET(queue->cross_node));
+        }
+    }
+
     strncat(key_prefix, ".latency",
             sizeof(key_prefix) - strlen(key_prefix) - 1);
 
@@ -213,7 +213,7 @@ struct rpcsvc_request {
     drc_cached_op_t *reply;
 
     /* request queue in rpcsvc */
-    struct list_head request_list;
+    struct cds_wfcq_node request_node;
 
     /* Status of the RPC call, whether it was accepted or denied. */
     int rpc_status;
@@ -364,14 +364,25 @@ typedef struct rpcsvc_actor_desc {
     gf_boolean_t unprivileged;
 } rpcsvc_actor_t;
 
+/* Each event thread hands its requests to its own handler thread. Requests
+ * are queued without taking a lock; queue_lock and queue_cond are only used
+ * to put the handler to sleep when there is nothing left to run.
+ */
 typedef struct rpcsvc_request_queue {
-    struct list_head request_queue;
+    struct cds_wfcq_head head;
+    struct cds_wfcq_tail tail;
     pthread_mutex_t queue_lock;
     pthread_cond_t queue_cond;
     pthread_t thread;
     struct rpcsvc_program *program;
+    gf_atomic_t queued;
+    gf_atomic_t handled;
+    gf_atomic_t wakeups;
+    gf_atomic_t cross_node; /* queued from another NUMA node */
+    int node;               /* NUMA node the handler runs on */
     int gen;
     gf_boolean_t waiting;
+    gf_boolean_t bind; /* keep the handler on its NUMA node */
 } rpcsvc_request_queue_t;
 
 /* Describes a program and its version along with the function pointers
@@ -654,6 +665,8 @@ int
 rpcsvc_set_all_squash(rpcsvc_t *svc, dict_t *options);
 int
 rpcsvc_set_outstanding_rpc_limit(rpcsvc_t *svc, dict_t *options, int defvalue);
+int
+rpcsvc_set_numa_affinity(rpcsvc_t *svc, dict_t *options);
 
 int
 rpcsvc_set_throttle_on(rpcsvc_t *svc);
@@ -672,6 +685,9 @@ rpcsvc_get_program_vector_sizer(rpcsvc_t *svc, uint32_t prognum,
 void
 rpcsvc_autoscale_threads(glusterfs_ctx_t *ctx, rpcsvc_t *rpc, int incr);
 
+uint64_t
+rpcsvc_request_backlog(void *data);
+
 extern int
 rpcsvc_destroy(rpcsvc_t *svc);
 void
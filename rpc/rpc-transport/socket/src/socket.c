@@ -574,68 +574,67 @@ __socket_ssl_read(rpc_transport_t *this, void *buf, size_t count)
     return ret;
 }
 
+static void
+__socket_rx_buf_release(socket_private_t *priv)
+{
+    int saved_errno = errno;
+
+    if (priv->rx_iobuf) {
+        iobuf_unref(priv->rx_iobuf);
+        priv->rx_iobuf = NULL;
+    }
+    priv->rx_start = priv->rx_end = 0;
+
+    errno = saved_errno;
+}
+
+/*
+ * Serve a read from the receive buffer, refilling it with one large read
+ * when it is empty. Reads that are at least as large as the buffer (bulk
+ * payloads) bypass it so that their data is not copied twice. The buffer
+ * is an iobuf taken for the refill and given back once drained, so an idle
+ * connection holds none.
+ */
 static int
-__socket_cached_read(rpc_transport_t *this, struct iovec *opvector, int opcount)
+__socket_buffered_read(rpc_transport_t *this, struct iovec *opvector,
+                       int opcount)
 {
     socket_private_t *priv = NULL;
-    struct gf_sock_incoming *in = NULL;
-    int req_len = -1;
+    size_t req_len = 0;
     int ret = -1;
 
     priv = this->private;
-    in = &priv->incoming;
     req_len = iov_length(opvector, opcount);
 
-    if (in->record_state == SP_STATE_READING_FRAGHDR) {
-        in->ra_read = 0;
-        in->ra_served = 0;
-        in->ra_max = 0;
-        in->ra_buf = NULL;
-        goto uncached;
-    }
-
-    if (!in->ra_max) {
-        /* first call after passing SP_STATE_READING_FRAGHDR */
-        in->ra_max = min(RPC_FRAGSIZE(in->fraghdr), GF_SOCKET_RA_MAX);
-        /* Note that the in->iobuf is the primary iobuf into which
-           headers are read into, and in->frag.fragcurrent points to
-           some position in the buffer. By using this itself as our
-           read-ahead cache, we can avoid memory copies in iov_load
-        */
-        in->ra_buf = in->frag.fragcurrent;
-    }
-
-    /* fill read-ahead */
-    if (in->ra_read < in->ra_max) {
-        ret = __socket_ssl_read(this, &in->ra_buf[in->ra_read],
-                                (in->ra_max - in->ra_read));
-        if (ret > 0)
-            in->ra_read += ret;
+    if (priv->rx_start == priv->rx_end) {
+        if (req_len >= GF_SOCKET_RX_BUF_SIZE)
+            goto direct;
 
-        /* we proceed to test if there is still cached data to
-           be served even if readahead could not progress */
-    }
+        priv->rx_iobuf = iobuf_get2(this->ctx->iobuf_pool,
+                                    GF_SOCKET_RX_BUF_SIZE);
+        if (!priv->rx_iobuf)
+            goto direct;
 
-    /* serve cached */
-    if (in->ra_served < in->ra_read) {
-        ret = iov_load(opvector, opcount, &in->ra_buf[in->ra_served],
-                       min(req_len, (in->ra_read - in->ra_served)));
+        ret = __socket_ssl_read(this, iobuf_ptr(priv->rx_iobuf),
+                                GF_SOCKET_RX_BUF_SIZE);
+        if (ret <= 0) {
+            __socket_rx_buf_release(priv);
+            goto out;
+        }
 
-        in->ra_served += ret;
-        /* Do not read uncached and cached in the same call */
-        goto out;
+        priv->rx_start = 0;
+        priv->rx_end = ret;
     }
 
-    if (in->ra_read < in->ra_max)
-        /* If there was no cached data to be served, (and we are
-           guaranteed to have already performed an attempt to progress
-           readahead above), and we have not yet read out the full
-           readahead capacity, then bail out for now without doing
-           the uncached read below (as that will overtake future cached
-           read)
-        */
-        goto out;
-uncached:
+    ret = iov_load(opvector, opcount,
+                   (char *)iobuf_ptr(priv->rx_iobuf) + priv->rx_start,
+                   min(req_len, priv->rx_end - priv->rx_start));
+    priv->rx_start += ret;
+    if (priv->rx_start == priv->rx_end)
+        __socket_rx_buf_release(priv);
+    goto out;
+
+direct:
     ret = __socket_ssl_readv(this, opvector, opcount);
 out:
     return ret;
@@ -718,7 +717,7 @@ __socket_rwv(rpc_transport_t *this, struct iovec *vector, int count,
             } else if (ret > 0)
                 this->total_bytes_write += ret;
         } else {
-            ret = __socket_cached_read(this, opvector, opcount);
+            ret = __socket_buffered_read(this, opvector, opcount);
             if (ret == 0) {
                 gf_log(this->name, GF_LOG_DEBUG,
                        "EOF on socket %d (errno:%d:%s); returning ENODATA",
@@ -1155,6 +1154,8 @@ __socket_reset(rpc_transport_t *this)
 
     memset(&priv->incoming, 0, sizeof(priv->incoming));
 
+    __socket_rx_buf_release(priv);
+
     gf_event_unregister_close(this->ctx->event_pool, priv->sock, priv->idx);
     if (priv->use_ssl && priv->ssl_ssl) {
         SSL_clear(priv->ssl_ssl);
@@ -1309,6 +1310,112 @@ __socket_ioq_churn_entry(rpc_transport_t *this, struct ioq *entry,
     return ret;
 }
 
+/*
+ * Advance the pending vector of an entry by up to *size bytes already
+ * written. Returns true once the entry has been completely written.
+ */
+static gf_boolean_t
+__socket_ioq_entry_advance(struct ioq *entry, size_t *size)
+{
+    while ((entry->pending_count > 0) && (*size > 0)) {
+        if (*size >= entry->pending_vector[0].iov_len) {
+            *size -= entry->pending_vector[0].iov_len;
+            entry->pending_vector++;
+            entry->pending_count--;
+        } else {
+            entry->pending_vector[0].iov_base += *size;
+            entry->pending_vector[0].iov_len -= *size;
+            *size = 0;
+        }
+    }
+
+    /* skip trailing zero length vectors */
+    while ((entry->pending_count > 0) &&
+           (entry->pending_vector[0].iov_len == 0)) {
+        entry->pending_vector++;
+        entry->pending_count--;
+    }
+
+    return entry->pending_count == 0;
+}
+
+/*
+ * Write as many queued entries as fit in one gather list with a single
+ * sendmsg(). MSG_MORE is set while more entries remain queued, so that the
+ * tail of this batch can share a segment with the next one.
+ *
+ * return value:
+ *   0 = all the gathered entries have been written
+ *  -1 = error
+ * > 0 = incomplete
+ */
+static int
+__socket_ioq_churn_gather(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct iovec vector[GF_SOCKET_GATHER_IOV];
+    struct msghdr msg = {
+        0,
+    };
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+    gf_boolean_t more = _gf_false;
+    size_t size = 0;
+    size_t entry_size = 0;
+    ssize_t ret = 0;
+    int max = IOV_MIN(GF_SOCKET_GATHER_IOV);
+    int count = 0;
+
+    list_for_each_entry(entry, &priv->ioq, list)
+    {
+        entry_size = iov_length(entry->pending_vector, entry->pending_count);
+        if ((count + entry->pending_count > max) ||
+            ((count > 0) && (size + entry_size > GF_SOCKET_GATHER_SIZE))) {
+            more = _gf_true;
+            break;
+        }
+
+        memcpy(&vector[count], entry->pending_vector,
+               entry->pending_count * sizeof(struct iovec));
+        count += entry->pending_count;
+        size += entry_size;
+    }
+
+    msg.msg_iov = vector;
+    msg.msg_iovlen = count;
+
+    do {
+        ret = sendmsg(priv->sock, &msg, more ? MSG_MORE : 0);
+    } while ((ret < 0) && (errno == EINTR));
+
+    if (ret < 0) {
+        if (errno == EAGAIN)
+            return 1;
+
+        if (__does_socket_rwv_error_need_logging(priv, 1)) {
+            GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                                "writev on %s failed (%s)",
+                                this->peerinfo.identifier, strerror(errno));
+        }
+        return -1;
+    }
+
+    this->total_bytes_write += ret;
+    size = ret;
+
+    list_for_each_entry_safe(entry, tmp, &priv->ioq, list)
+    {
+        if (!__socket_ioq_entry_advance(entry, &size))
+            return 1;
+
+        __socket_ioq_entry_free(entry);
+        if (size == 0)
+            break;
+    }
+
+    return 0;
+}
+
 static int
 __socket_ioq_churn(rpc_transport_t *this)
 {
@@ -1322,7 +1429,14 @@ __socket_ioq_churn(rpc_transport_t *this)
         /* pick next entry */
         entry = priv->ioq_next;
 
-        ret = __socket_ioq_churn_entry(this, entry, _gf_true);
+        /* Several small messages waiting (e.g. replies to a burst of
+         * lookups) are sent with a single system call. SSL writes one
+         * buffer at a time, so there is nothing to gather there. */
+        if (!priv->use_ssl && (entry->list.next != &priv->ioq)) {
+            ret = __socket_ioq_churn_gather(this);
+        } else {
+            ret = __socket_ioq_churn_entry(this, entry, _gf_true);
+        }
 
         if (ret != 0)
             break;
@@ -2385,33 +2499,54 @@ socket_event_poll_in_async(gf_async_t *async)
     pthread_mutex_unlock(&priv->notify.lock);
 }
 
+/*
+ * Parse every complete record available in the receive buffer and re-arm
+ * the fd once for the whole batch. The fd stays disarmed while buffered
+ * records remain, since no further POLLIN would arrive for them; if the
+ * batch fills up first, it is handed up before parsing continues.
+ */
 static int
 socket_event_poll_in(rpc_transport_t *this, gf_boolean_t notify_handled)
 {
     int ret = -1;
     rpc_transport_pollin_t *pollin = NULL;
+    rpc_transport_pollin_t *batch[GF_SOCKET_RX_BATCH];
     socket_private_t *priv = this->private;
     glusterfs_ctx_t *ctx = NULL;
+    gf_boolean_t more = _gf_false;
+    int count = 0;
+    int i = 0;
 
     ctx = this->ctx;
 
-    ret = socket_proto_state_machine(this, &pollin);
+    do {
+        pollin = NULL;
+        ret = socket_proto_state_machine(this, &pollin);
 
-    if (pollin) {
-        pthread_mutex_lock(&priv->notify.lock);
-        {
-            priv->notify.in_progress++;
+        if (pollin) {
+            pthread_mutex_lock(&priv->notify.lock);
+            {
+                priv->notify.in_progress++;
+            }
+            pthread_mutex_unlock(&priv->notify.lock);
+
+            batch[count++] = pollin;
         }
-        pthread_mutex_unlock(&priv->notify.lock);
-    }
 
-    if (notify_handled && (ret >= 0))
-        gf_event_handled(ctx->event_pool, priv->sock, priv->idx, priv->gen);
+        more = (ret == 0) && (pollin != NULL) &&
+               (priv->rx_start < priv->rx_end);
 
-    if (pollin) {
-        rpc_transport_ref(this);
-        gf_async(&pollin->async, socket_event_poll_in_async);
-    }
+        if (!more && notify_handled && (ret >= 0))
+            gf_event_handled(ctx->event_pool, priv->sock, priv->idx, priv->gen);
+
+        if (!more || (count == GF_SOCKET_RX_BATCH)) {
+            for (i = 0; i < count; i++) {
+                rpc_transport_ref(this);
+                gf_async(&batch[i]->async, socket_event_poll_in_async);
+            }
+            count = 0;
+        }
+    } while (more);
 
     return ret;
 }
@@ -4476,6 +4611,8 @@ fini(rpc_transport_t *this)
         }
         gf_log(this->name, GF_LOG_TRACE, "transport %p destroyed", this);
 
+        __socket_rx_buf_release(priv);
+
         pthread_mutex_destroy(&priv->out_lock);
 
         GF_ASSERT(priv->notify.in_progress == 0);
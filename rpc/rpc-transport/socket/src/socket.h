@@ -158,7 +158,18 @@ struct gf_sock_incoming_frag {
     sp_rpcfrag_state_t state;
 };
 
-#define GF_SOCKET_RA_MAX 1024
+/* Size of the buffer that records are received through, so that a single
+ * read returns several small records at once. A connection only holds one
+ * while it has received bytes not parsed yet. Reads at least this large go
+ * straight into their destination. */
+#define GF_SOCKET_RX_BUF_SIZE (64 * GF_UNIT_KB)
+
+/* Records parsed from the receive buffer before they are handed up. */
+#define GF_SOCKET_RX_BATCH 16
+
+/* Limits of a single writev gathering several queued messages. */
+#define GF_SOCKET_GATHER_IOV 256
+#define GF_SOCKET_GATHER_SIZE (256 * GF_UNIT_KB)
 
 struct gf_sock_incoming {
     char *proghdr_base_addr;
@@ -174,10 +185,6 @@ struct gf_sock_incoming {
     int pending_count;
     size_t total_bytes_read;
 
-    size_t ra_read;
-    size_t ra_max;
-    size_t ra_served;
-    char *ra_buf;
     uint32_t fraghdr;
     msg_type_t msg_type;
     sp_rpcrecord_state_t record_state;
@@ -229,6 +236,10 @@ typedef struct {
     char *ssl_ca_list;
     char *crl_path;
     struct gf_sock_incoming incoming;
+    /* received but not yet parsed bytes are rx_iobuf[rx_start..rx_end) */
+    struct iobuf *rx_iobuf;
+    size_t rx_start;
+    size_t rx_end;
     mgmt_ssl_t srvr_ssl;
     /* -1 = not connected. 0 = in progress. 1 = connected */
     char connected;
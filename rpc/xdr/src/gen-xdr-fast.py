@@ -0,0 +1,464 @@
+#!/usr/bin/python3
+#
+# Generates specialized XDR encoders and decoders for the hot messages of
+# an rpcgen .x file. The generated code produces exactly the same bytes as
+# the rpcgen routines and decodes into the same C structures, with the same
+# memory ownership, but works directly on a buffer instead of going through
+# an XDR stream, and computes encoded sizes without a dry run.
+#
+# usage: gen-xdr-fast.py <file.x> <header.h> > <output.c>
+
+from __future__ import print_function
+import re
+import sys
+
+# Messages that get a fast codec: small, frequent fop requests and replies.
+# gfx_dict is sized on its own too, by dict_to_xdr() for every xdata.
+HOT_MESSAGES = [
+    "gfx_dict",
+    "gfx_lookup_req",
+    "gfx_stat_req",
+    "gfx_fstat_req",
+    "gfx_access_req",
+    "gfx_open_req",
+    "gfx_opendir_req",
+    "gfx_read_req",
+    "gfx_readdirp_req",
+    "gfx_getxattr_req",
+    "gfx_common_rsp",
+    "gfx_common_iatt_rsp",
+    "gfx_common_2iatt_rsp",
+    "gfx_common_3iatt_rsp",
+    "gfx_common_dict_rsp",
+    "gfx_open_rsp",
+    "gfx_read_rsp",
+    "gfx_readdirp_rsp",
+]
+
+# xdr scalar type -> (C type, wire size, signed)
+SCALARS = {
+    "int": ("int", 4, True),
+    "unsigned int": ("u_int", 4, False),
+    "unsigned": ("u_int", 4, False),
+    "u_int": ("u_int", 4, False),
+    "int32_t": ("int32_t", 4, True),
+    "uint32_t": ("uint32_t", 4, False),
+    "bool": ("bool_t", 4, False),
+    "hyper": ("quad_t", 8, True),
+    "unsigned hyper": ("u_quad_t", 8, False),
+    "quad_t": ("quad_t", 8, True),
+    "u_quad_t": ("u_quad_t", 8, False),
+    "int64_t": ("int64_t", 8, True),
+    "uint64_t": ("uint64_t", 8, False),
+    "double": ("double", 8, True),
+}
+
+
+class Decl(object):
+    """One member: kind is scalar, opaque, opaque_var, string, array_var,
+    array_fixed, pointer, or type (a named struct/union)."""
+
+    def __init__(self, kind, type, name, size=None):
+        self.kind = kind
+        self.type = type
+        self.name = name
+        self.size = size
+
+
+def tokenize(text):
+    text = re.sub(r"/\*.*?\*/", " ", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", " ", text)
+    lines = [l for l in text.split("\n") if not l.lstrip().startswith(("%", "#"))]
+    return re.findall(r"[A-Za-z_][A-Za-z0-9_]*|\d+|\S", "\n".join(lines))
+
+
+class Parser(object):
+    def __init__(self, tokens):
+        self.tokens = tokens
+        self.pos = 0
+        self.structs = {}
+        self.unions = {}
+
+    def peek(self, n=0):
+        if self.pos + n < len(self.tokens):
+            return self.tokens[self.pos + n]
+        return None
+
+    def next(self):
+        tok = self.tokens[self.pos]
+        self.pos += 1
+        return tok
+
+    def expect(self, tok):
+        got = self.next()
+        if got != tok:
+            raise SyntaxError("expected '%s', got '%s'" % (tok, got))
+
+    def parse(self):
+        while self.peek() is not None:
+            tok = self.next()
+            if tok == "struct":
+                name = self.next()
+                self.structs[name] = self.parse_struct_body()
+            elif tok == "union":
+                name = self.next()
+                self.unions[name] = self.parse_union_body()
+            else:
+                # enums, consts, typedefs and programs are not needed by
+                # the hot messages: skip to the end of the definition.
+                depth = 0
+                while True:
+                    tok = self.next()
+                    if tok == "{":
+                        depth += 1
+                    elif tok == "}":
+                        depth -= 1
+                    elif tok == ";" and depth == 0:
+                        break
+        return self
+
+    def parse_struct_body(self):
+        self.expect("{")
+        members = []
+        while self.peek() != "}":
+            members.append(self.parse_decl())
+        self.expect("}")
+        self.expect(";")
+        return members
+
+    def parse_union_body(self):
+        self.expect("switch")
+        self.expect("(")
+        disc = self.parse_decl(terminator=")")
+        self.expect("{")
+        arms = []
+        labels = []
+        default = None
+        while self.peek() != "}":
+            tok = self.next()
+            if tok == "case":
+                labels.append(self.next())
+                self.expect(":")
+                if self.peek() in ("case", "default"):
+                    continue
+                arms.append((labels, self.parse_decl()))
+                labels = []
+            elif tok == "default":
+                self.expect(":")
+                default = self.parse_decl()
+            else:
+                raise SyntaxError("unexpected '%s' in union" % tok)
+        self.expect("}")
+        self.expect(";")
+        return (disc, arms, default)
+
+    def parse_decl(self, terminator=";"):
+        tok = self.next()
+        if tok == "void":
+            self.expect(terminator)
+            return None
+        if tok == "struct":
+            tok = self.next()
+        if tok == "unsigned":
+            if self.peek() in ("int", "hyper"):
+                tok = "unsigned " + self.next()
+        pointer = False
+        if self.peek() == "*":
+            self.next()
+            pointer = True
+        name = self.next()
+        decl = None
+        if pointer:
+            decl = Decl("pointer", tok, name)
+        elif self.peek() == "[":
+            self.next()
+            size = self.next()
+            self.expect("]")
+            if tok == "opaque":
+                decl = Decl("opaque", tok, name, size)
+            else:
+                decl = Decl("array_fixed", tok, name, size)
+        elif self.peek() == "<":
+            self.next()
+            size = None
+            if self.peek() != ">":
+                size = self.next()
+            self.expect(">")
+            if tok == "opaque":
+                decl = Decl("opaque_var", tok, name, size)
+            elif tok == "string":
+                decl = Decl("string", tok, name, size)
+            else:
+                decl = Decl("array_var", tok, name, size)
+        elif tok in SCALARS:
+            decl = Decl("scalar", tok, name)
+        else:
+            decl = Decl("type", tok, name)
+        self.expect(terminator)
+        return decl
+
+
+def closure(parser, names):
+    """All the named types the given messages depend on, dependencies
+    first."""
+    order = []
+    seen = set()
+
+    def visit(name):
+        if name in seen:
+            return
+        seen.add(name)
+        if name in parser.structs:
+            decls = parser.structs[name]
+        elif name in parser.unions:
+            disc, arms, default = parser.unions[name]
+            decls = [d for l, d in arms] + [default]
+        else:
+            raise KeyError("unknown type '%s'" % name)
+        for d in decls:
+            if d is None:
+                continue
+            if d.kind in ("type", "pointer", "array_var", "array_fixed"):
+                if d.type not in SCALARS:
+                    visit(d.type)
+        order.append(name)
+
+    for name in names:
+        visit(name)
+    return order
+
+
+def bound(decl):
+    return decl.size if decl.size else "~0u"
+
+
+class Emitter(object):
+    def __init__(self, parser):
+        self.parser = parser
+        self.out = []
+
+    def emit(self, line=""):
+        self.out.append(line)
+
+    # Each helper returns a list of C statements for one member. 'ref' is
+    # an lvalue expression of the member.
+
+    def enc_scalar(self, type, ref):
+        ctype, size, signed = SCALARS[type]
+        if type == "double":
+            return ["GFX_FAST_TRY(gfx_fast_put_double(c, %s));" % ref]
+        return ["GFX_FAST_TRY(gfx_fast_put_%d(c, (uint%d_t)%s));"
+                % (size * 8, size * 8, ref)]
+
+    def dec_scalar(self, type, ref):
+        ctype, size, signed = SCALARS[type]
+        if type == "double":
+            return ["GFX_FAST_TRY(gfx_fast_get_double(c, &%s));" % ref]
+        if type == "bool":
+            return ["GFX_FAST_TRY(gfx_fast_get_bool(c, &%s));" % ref]
+        return ["GFX_FAST_TRY(gfx_fast_get_%d(c, &tmp%d));" % (size * 8, size * 8),
+                "%s = (%s)tmp%d;" % (ref, ctype, size * 8)]
+
+    def size_scalar(self, type, ref):
+        return ["size += %d;" % SCALARS[type][1]]
+
+    def member_code(self, mode, d, ref):
+        if d.kind == "scalar":
+            return getattr(self, mode + "_scalar")(d.type, ref)
+        if d.kind == "type":
+            if mode == "size":
+                return ["size += gfx_fast_size_%s(&%s);" % (d.type, ref)]
+            return ["GFX_FAST_TRY(gfx_fast_%s_%s(c, &%s));" % (mode, d.type, ref)]
+        if d.kind == "opaque":
+            if mode == "size":
+                return ["size += GFX_FAST_RNDUP(%s);" % d.size]
+            if mode == "enc":
+                return ["GFX_FAST_TRY(gfx_fast_put_opaque(c, %s, %s));"
+                        % (ref, d.size)]
+            return ["GFX_FAST_TRY(gfx_fast_get_opaque(c, %s, %s));"
+                    % (ref, d.size)]
+        if d.kind == "opaque_var":
+            len_ref = "%s.%s_len" % (ref, d.name)
+            val_ref = "%s.%s_val" % (ref, d.name)
+            if mode == "size":
+                return ["size += 4 + GFX_FAST_RNDUP(%s);" % len_ref]
+            if mode == "enc":
+                return ["GFX_FAST_TRY(gfx_fast_put_bytes(c, %s, %s, %s));"
+                        % (val_ref, len_ref, bound(d))]
+            return ["GFX_FAST_TRY(gfx_fast_get_bytes(c, &%s, &%s, %s));"
+                    % (val_ref, len_ref, bound(d))]
+        if d.kind == "string":
+            if mode == "size":
+                return ["if (%s)" % ref,
+                        "    size += 4 + GFX_FAST_RNDUP(strlen(%s));" % ref]
+            if mode == "enc":
+                return ["GFX_FAST_TRY(gfx_fast_put_string(c, %s, %s));"
+                        % (ref, bound(d))]
+            return ["GFX_FAST_TRY(gfx_fast_get_string(c, &%s, %s));"
+                    % (ref, bound(d))]
+        if d.kind == "pointer":
+            if mode == "size":
+                return ["size += 4;",
+                        "if (%s)" % ref,
+                        "    size += gfx_fast_size_%s(%s);" % (d.type, ref)]
+            if mode == "enc":
+                return ["GFX_FAST_TRY(gfx_fast_put_32(c, %s != NULL));" % ref,
+                        "if (%s)" % ref,
+                        "    GFX_FAST_TRY(gfx_fast_enc_%s(c, %s));"
+                        % (d.type, ref)]
+            return ["GFX_FAST_TRY(gfx_fast_get_bool(c, &present));",
+                    "if (!present) {",
+                    "    %s = NULL;" % ref,
+                    "} else {",
+                    "    if (!%s) {" % ref,
+                    "        %s = calloc(1, sizeof(*%s));" % (ref, ref),
+                    "        if (!%s)" % ref,
+                    "            return -1;",
+                    "    }",
+                    "    GFX_FAST_TRY(gfx_fast_dec_%s(c, %s));" % (d.type, ref),
+                    "}"]
+        if d.kind in ("array_var", "array_fixed"):
+            if d.kind == "array_var":
+                len_ref = "%s.%s_len" % (ref, d.name)
+                val_ref = "%s.%s_val" % (ref, d.name)
+            else:
+                len_ref = d.size
+                val_ref = ref
+            elem = Decl("scalar" if d.type in SCALARS else "type", d.type,
+                        d.name)
+            body = self.member_code(mode, elem, "%s[i]" % val_ref)
+            lines = []
+            if d.kind == "array_var":
+                if mode == "size":
+                    lines.append("size += 4;")
+                elif mode == "enc":
+                    if d.size:
+                        lines += ["if (%s > %s)" % (len_ref, d.size),
+                                  "    return -1;"]
+                    lines.append("GFX_FAST_TRY(gfx_fast_put_32(c, %s));"
+                                 % len_ref)
+                else:
+                    lines.append("GFX_FAST_TRY(gfx_fast_get_32(c, &tmp32));")
+                    if d.size:
+                        lines += ["if (tmp32 > %s)" % d.size,
+                                  "    return -1;"]
+                    lines += ["%s = tmp32;" % len_ref,
+                              "if (tmp32 && !%s) {" % val_ref,
+                              "    %s = gfx_fast_alloc_array(tmp32, sizeof(*%s));"
+                              % (val_ref, val_ref),
+                              "    if (!%s)" % val_ref,
+                              "        return -1;",
+                              "}"]
+            lines.append("for (i = 0; i < %s; i++) {" % len_ref)
+            lines += ["    " + l for l in body]
+            lines.append("}")
+            return lines
+        raise ValueError("unsupported member kind '%s'" % d.kind)
+
+    def emit_function(self, mode, name):
+        if mode == "size":
+            self.emit("static size_t")
+            self.emit("gfx_fast_size_%s(const %s *v)" % (name, name))
+        elif mode == "enc":
+            self.emit("static int")
+            self.emit("gfx_fast_enc_%s(gfx_fast_cursor_t *c, const %s *v)"
+                      % (name, name))
+        else:
+            self.emit("static int")
+            self.emit("gfx_fast_dec_%s(gfx_fast_cursor_t *c, %s *v)"
+                      % (name, name))
+        self.emit("{")
+
+        body = []
+        if name in self.parser.structs:
+            for d in self.parser.structs[name]:
+                body += self.member_code(mode, d, "v->%s" % d.name)
+        else:
+            disc, arms, default = self.parser.unions[name]
+            body += self.member_code(mode, disc, "v->%s" % disc.name)
+            body.append("switch (v->%s) {" % disc.name)
+            for labels, d in arms:
+                for l in labels:
+                    body.append("    case %s:" % l)
+                if d is not None:
+                    ref = "v->%s_u.%s" % (name, d.name)
+                    body += ["        " + l for l in
+                             self.member_code(mode, d, ref)]
+                body.append("        break;")
+            body.append("    default:")
+            if default is not None:
+                ref = "v->%s_u.%s" % (name, default.name)
+                body += ["        " + l for l in
+                         self.member_code(mode, default, ref)]
+                body.append("        break;")
+            elif mode == "size":
+                body.append("        break;")
+            else:
+                body.append("        return -1;")
+            body.append("}")
+
+        text = "\n".join(body)
+        if mode == "size":
+            self.emit("    size_t size = 0;")
+        if re.search(r"\bi\b", text):
+            self.emit("    u_int i;")
+        if mode == "dec":
+            if "tmp32" in text:
+                self.emit("    uint32_t tmp32;")
+            if "tmp64" in text:
+                self.emit("    uint64_t tmp64;")
+            if "present" in text:
+                self.emit("    bool_t present;")
+        if self.out[-1] != "{":
+            self.emit()
+        for l in body:
+            self.emit("    " + l if l else "")
+        self.emit()
+        self.emit("    return %s;" % ("size" if mode == "size" else "0"))
+        self.emit("}")
+        self.emit()
+
+
+def main():
+    xfile, header = sys.argv[1], sys.argv[2]
+    parser = Parser(tokenize(open(xfile).read())).parse()
+    types = closure(parser, HOT_MESSAGES)
+    em = Emitter(parser)
+
+    em.emit("/* Generated by gen-xdr-fast.py from %s, do not edit. */"
+            % xfile.split("/")[-1])
+    em.emit()
+    em.emit('#include "%s"' % header)
+    em.emit('#include "xdr-fast.h"')
+    em.emit()
+    for name in types:
+        for mode in ("size", "enc", "dec"):
+            em.emit("static %s" % ("size_t" if mode == "size" else "int"))
+            if mode == "size":
+                em.emit("gfx_fast_size_%s(const %s *v);" % (name, name))
+            elif mode == "enc":
+                em.emit("gfx_fast_enc_%s(gfx_fast_cursor_t *c, const %s *v);"
+                        % (name, name))
+            else:
+                em.emit("gfx_fast_dec_%s(gfx_fast_cursor_t *c, %s *v);"
+                        % (name, name))
+    em.emit()
+    for name in types:
+        for mode in ("size", "enc", "dec"):
+            em.emit_function(mode, name)
+
+    for name in HOT_MESSAGES:
+        em.emit("GFX_FAST_CODEC(%s)" % name)
+        em.emit()
+
+    em.emit("const gfx_fast_codec_t gfx_fast_codecs[] = {")
+    for name in HOT_MESSAGES:
+        em.emit("    GFX_FAST_CODEC_ENTRY(%s)," % name)
+    em.emit("    {NULL, NULL, NULL, NULL, NULL},")
+    em.emit("};")
+
+    print("\n".join(em.out))
+
+
+if __name__ == "__main__":
+    main()
@@ -677,7 +677,9 @@ gfx_stat_from_iattx(struct gfx_iattx *gf_stat, struct iatt *iatt)
     gf_stat->mode = st_mode_from_ia(iatt->ia_prot, iatt->ia_type);
 }
 
-/* dict_to_xdr () */
+/* dict_to_xdr () - the pairs point into the values of the dict, but the
+ * pairs array itself is allocated here and freed by the caller with
+ * GF_FREE() once the message is encoded. */
 static inline int
 dict_to_xdr(dict_t *this, gfx_dict *dict)
 {
@@ -796,7 +798,7 @@ dict_to_xdr(dict_t *this, gfx_dict *dict)
        boundary for proper payload. Hence only send the size of
        variable XDR size. ie, the formula should be:
        xdr_size = total size - (xdr_size + count + pairs.pairs_len))  */
-    size = xdr_sizeof((xdrproc_t)xdr_gfx_dict, dict);
+    size = xdr_sizeof_generic((xdrproc_t)xdr_gfx_dict, dict);
 
     dict->xdr_size = (size > 12) ? (size - 12) : 0;
 
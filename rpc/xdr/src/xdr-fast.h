@@ -0,0 +1,265 @@
+/*
+  Copyright (c) 2024 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef _XDR_FAST_H
+#define _XDR_FAST_H
+
+/* Building blocks of the codecs generated by gen-xdr-fast.py. They write
+ * and read the XDR wire format directly on a buffer. Decoding allocates
+ * variable length data with malloc()/calloc(), like the rpcgen routines,
+ * so that the results are released by the same code.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <rpc/types.h>
+#include <rpc/xdr.h>
+
+#include <glusterfs/compat.h>
+
+typedef struct gfx_fast_cursor {
+    char *pos;
+    char *end;
+} gfx_fast_cursor_t;
+
+typedef struct gfx_fast_codec {
+    xdrproc_t proc;
+    const char *name;
+    size_t (*size)(const void *msg);
+    ssize_t (*encode)(char *buf, size_t len, const void *msg);
+    ssize_t (*decode)(char *buf, size_t len, void *msg);
+} gfx_fast_codec_t;
+
+/* Terminated by an entry with a NULL proc. */
+extern const gfx_fast_codec_t gfx_fast_codecs[];
+
+#define GFX_FAST_RNDUP(x) (((size_t)(x) + 3) & ~(size_t)3)
+
+#define GFX_FAST_TRY(expr)                                                     \
+    do {                                                                       \
+        if ((expr) < 0)                                                        \
+            return -1;                                                         \
+    } while (0)
+
+static inline int
+gfx_fast_room(gfx_fast_cursor_t *c, size_t len)
+{
+    return ((size_t)(c->end - c->pos) < len) ? -1 : 0;
+}
+
+static inline int
+gfx_fast_put_32(gfx_fast_cursor_t *c, uint32_t v)
+{
+    GFX_FAST_TRY(gfx_fast_room(c, 4));
+    v = htobe32(v);
+    memcpy(c->pos, &v, 4);
+    c->pos += 4;
+    return 0;
+}
+
+static inline int
+gfx_fast_put_64(gfx_fast_cursor_t *c, uint64_t v)
+{
+    GFX_FAST_TRY(gfx_fast_room(c, 8));
+    v = htobe64(v);
+    memcpy(c->pos, &v, 8);
+    c->pos += 8;
+    return 0;
+}
+
+static inline int
+gfx_fast_get_32(gfx_fast_cursor_t *c, uint32_t *v)
+{
+    GFX_FAST_TRY(gfx_fast_room(c, 4));
+    memcpy(v, c->pos, 4);
+    *v = be32toh(*v);
+    c->pos += 4;
+    return 0;
+}
+
+static inline int
+gfx_fast_get_64(gfx_fast_cursor_t *c, uint64_t *v)
+{
+    GFX_FAST_TRY(gfx_fast_room(c, 8));
+    memcpy(v, c->pos, 8);
+    *v = be64toh(*v);
+    c->pos += 8;
+    return 0;
+}
+
+/* As xdr_bool(), any non zero value decodes as TRUE. */
+static inline int
+gfx_fast_get_bool(gfx_fast_cursor_t *c, bool_t *v)
+{
+    uint32_t tmp;
+
+    GFX_FAST_TRY(gfx_fast_get_32(c, &tmp));
+    *v = (tmp != 0);
+    return 0;
+}
+
+static inline int
+gfx_fast_put_double(gfx_fast_cursor_t *c, double v)
+{
+    uint64_t tmp;
+
+    memcpy(&tmp, &v, sizeof(tmp));
+    return gfx_fast_put_64(c, tmp);
+}
+
+static inline int
+gfx_fast_get_double(gfx_fast_cursor_t *c, double *v)
+{
+    uint64_t tmp;
+
+    GFX_FAST_TRY(gfx_fast_get_64(c, &tmp));
+    memcpy(v, &tmp, sizeof(tmp));
+    return 0;
+}
+
+static inline int
+gfx_fast_put_opaque(gfx_fast_cursor_t *c, const char *data, u_int len)
+{
+    size_t padded = GFX_FAST_RNDUP(len);
+
+    GFX_FAST_TRY(gfx_fast_room(c, padded));
+    if (len)
+        memcpy(c->pos, data, len);
+    memset(c->pos + len, 0, padded - len);
+    c->pos += padded;
+    return 0;
+}
+
+static inline int
+gfx_fast_get_opaque(gfx_fast_cursor_t *c, char *data, u_int len)
+{
+    size_t padded = GFX_FAST_RNDUP(len);
+
+    GFX_FAST_TRY(gfx_fast_room(c, padded));
+    memcpy(data, c->pos, len);
+    c->pos += padded;
+    return 0;
+}
+
+static inline int
+gfx_fast_put_bytes(gfx_fast_cursor_t *c, const char *data, u_int len,
+                   u_int maxlen)
+{
+    if (len > maxlen)
+        return -1;
+
+    GFX_FAST_TRY(gfx_fast_put_32(c, len));
+    return gfx_fast_put_opaque(c, data, len);
+}
+
+static inline int
+gfx_fast_get_bytes(gfx_fast_cursor_t *c, char **data, u_int *len,
+                   u_int maxlen)
+{
+    uint32_t tmp;
+
+    GFX_FAST_TRY(gfx_fast_get_32(c, &tmp));
+    if (tmp > maxlen)
+        return -1;
+
+    *len = tmp;
+    if (tmp == 0)
+        return 0;
+
+    GFX_FAST_TRY(gfx_fast_room(c, GFX_FAST_RNDUP(tmp)));
+    if (!*data) {
+        *data = malloc(tmp);
+        if (!*data)
+            return -1;
+    }
+
+    return gfx_fast_get_opaque(c, *data, tmp);
+}
+
+static inline int
+gfx_fast_put_string(gfx_fast_cursor_t *c, const char *str, u_int maxlen)
+{
+    size_t len;
+
+    if (!str)
+        return -1;
+
+    len = strlen(str);
+    if (len > maxlen)
+        return -1;
+
+    return gfx_fast_put_bytes(c, str, len, maxlen);
+}
+
+static inline int
+gfx_fast_get_string(gfx_fast_cursor_t *c, char **str, u_int maxlen)
+{
+    uint32_t tmp;
+
+    GFX_FAST_TRY(gfx_fast_get_32(c, &tmp));
+    if ((tmp > maxlen) || (tmp == UINT32_MAX))
+        return -1;
+
+    GFX_FAST_TRY(gfx_fast_room(c, GFX_FAST_RNDUP(tmp)));
+    if (!*str) {
+        *str = malloc(tmp + 1);
+        if (!*str)
+            return -1;
+    }
+
+    (*str)[tmp] = '\0';
+    return gfx_fast_get_opaque(c, *str, tmp);
+}
+
+static inline void *
+gfx_fast_alloc_array(u_int count, size_t size)
+{
+    if (count > UINT_MAX / size)
+        return NULL;
+
+    return calloc(count, size);
+}
+
+/* Buffer level entry points of a generated codec. */
+#define GFX_FAST_CODEC(type)                                                   \
+    static size_t gfx_fast_msg_size_##type(const void *msg)                    \
+    {                                                                          \
+        return gfx_fast_size_##type(msg);                                      \
+    }                                                                          \
+                                                                               \
+    static ssize_t gfx_fast_msg_enc_##type(char *buf, size_t len,              \
+                                           const void *msg)                    \
+    {                                                                          \
+        gfx_fast_cursor_t c = {buf, buf + len};                                \
+                                                                               \
+        if (gfx_fast_enc_##type(&c, msg) < 0)                                  \
+            return -1;                                                         \
+        return c.pos - buf;                                                    \
+    }                                                                          \
+                                                                               \
+    static ssize_t gfx_fast_msg_dec_##type(char *buf, size_t len, void *msg)   \
+    {                                                                          \
+        gfx_fast_cursor_t c = {buf, buf + len};                                \
+                                                                               \
+        if (gfx_fast_dec_##type(&c, msg) < 0)                                  \
+            return -1;                                                         \
+        return c.pos - buf;                                                    \
+    }
+
+#define GFX_FAST_CODEC_ENTRY(type)                                             \
+    {                                                                          \
+        (xdrproc_t)xdr_##type, #type, gfx_fast_msg_size_##type,                \
+            gfx_fast_msg_enc_##type, gfx_fast_msg_dec_##type                   \
+    }
+
+#endif /* !_XDR_FAST_H */
@@ -8,17 +8,88 @@
   cases as published by the Free Software Foundation.
 */
 
+#include <pthread.h>
+
 #include "xdr-generic.h"
+#include "xdr-fast.h"
+
+/* Open addressed index of gfx_fast_codecs by xdrproc pointer, built once.
+ * Must be a power of 2 and well above the number of codecs. */
+#define XDR_FAST_SLOTS 64
+
+static const gfx_fast_codec_t *xdr_fast_slots[XDR_FAST_SLOTS];
+static pthread_once_t xdr_fast_once = PTHREAD_ONCE_INIT;
+
+static uint32_t
+xdr_fast_slot(xdrproc_t proc)
+{
+    uintptr_t key = (uintptr_t)proc;
+
+    return (uint32_t)((key >> 4) ^ (key >> 10)) & (XDR_FAST_SLOTS - 1);
+}
+
+static void
+xdr_fast_index(void)
+{
+    const gfx_fast_codec_t *codec = NULL;
+    uint32_t slot = 0;
+    int count = 0;
+
+    for (codec = gfx_fast_codecs; codec->proc; codec++) {
+        /* keep empty slots so that misses stop early */
+        if (++count > XDR_FAST_SLOTS / 2)
+            break;
+
+        slot = xdr_fast_slot(codec->proc);
+        while (xdr_fast_slots[slot])
+            slot = (slot + 1) & (XDR_FAST_SLOTS - 1);
+        xdr_fast_slots[slot] = codec;
+    }
+}
+
+/* Generated codec for proc, if the message is one of the hot ones. */
+static const gfx_fast_codec_t *
+xdr_fast_codec(xdrproc_t proc)
+{
+    const gfx_fast_codec_t *codec = NULL;
+    uint32_t slot = 0;
+
+    pthread_once(&xdr_fast_once, xdr_fast_index);
+
+    for (slot = xdr_fast_slot(proc); (codec = xdr_fast_slots[slot]);
+         slot = (slot + 1) & (XDR_FAST_SLOTS - 1)) {
+        if (codec->proc == proc)
+            return codec;
+    }
+
+    return NULL;
+}
+
+size_t
+xdr_sizeof_generic(xdrproc_t proc, void *res)
+{
+    const gfx_fast_codec_t *codec = xdr_fast_codec(proc);
+
+    if (codec)
+        return codec->size(res);
+
+    return xdr_sizeof(proc, res);
+}
 
 ssize_t
 xdr_serialize_generic(struct iovec outmsg, void *res, xdrproc_t proc)
 {
     ssize_t ret = -1;
+    const gfx_fast_codec_t *codec = NULL;
     XDR xdr;
 
     if ((!outmsg.iov_base) || (!res) || (!proc))
         return -1;
 
+    codec = xdr_fast_codec(proc);
+    if (codec)
+        return codec->encode(outmsg.iov_base, outmsg.iov_len, res);
+
     xdrmem_create(&xdr, outmsg.iov_base, (unsigned int)outmsg.iov_len,
                   XDR_ENCODE);
 
@@ -38,10 +109,15 @@ xdr_to_generic(struct iovec inmsg, void *args, xdrproc_t proc)
 {
     XDR xdr;
     ssize_t ret = -1;
+    const gfx_fast_codec_t *codec = NULL;
 
     if ((!inmsg.iov_base) || (!args) || (!proc))
         return -1;
 
+    codec = xdr_fast_codec(proc);
+    if (codec)
+        return codec->decode(inmsg.iov_base, inmsg.iov_len, args);
+
     xdrmem_create(&xdr, inmsg.iov_base, (unsigned int)inmsg.iov_len,
                   XDR_DECODE);
 
@@ -61,10 +137,21 @@ xdr_to_generic_payload(struct iovec inmsg, void *args, xdrproc_t proc,
 {
     XDR xdr;
     ssize_t ret = -1;
+    const gfx_fast_codec_t *codec = NULL;
 
     if ((!inmsg.iov_base) || (!args) || (!proc))
         return -1;
 
+    codec = xdr_fast_codec(proc);
+    if (codec) {
+        ret = codec->decode(inmsg.iov_base, inmsg.iov_len, args);
+        if ((ret >= 0) && pendingpayload) {
+            pendingpayload->iov_base = (char *)inmsg.iov_base + ret;
+            pendingpayload->iov_len = inmsg.iov_len - ret;
+        }
+        return ret;
+    }
+
     xdrmem_create(&xdr, inmsg.iov_base, (unsigned int)inmsg.iov_len,
                   XDR_DECODE);
 
@@ -57,6 +57,11 @@
 ssize_t
 xdr_serialize_generic(struct iovec outmsg, void *res, xdrproc_t proc);
 
+/* Encoded size of res, as xdr_sizeof() but without a dry run for the
+ * messages that have a generated codec. */
+size_t
+xdr_sizeof_generic(xdrproc_t proc, void *res);
+
 ssize_t
 xdr_to_generic(struct iovec inmsg, void *args, xdrproc_t proc);
 
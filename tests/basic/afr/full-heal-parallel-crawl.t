@@ -0,0 +1,46 @@
+#!/bin/bash
+#Full heal crawls the tree with up to cluster.shd-max-threads directories
+#read at once, and still heals every directory before its contents
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+function brick_tree_count()
+{
+    find $1 -path "$1/.glusterfs" -prune -o -print | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/${V0}{0,1,2}
+TEST $CLI volume set $V0 cluster.shd-max-threads 4
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+#wide at the top and deep underneath
+for a in {1..4}; do
+    for b in {1..4}; do
+        TEST mkdir -p $M0/d$a/d$b/deep/er/still
+        for f in {1..5}; do
+            echo "$a $b $f" > $M0/d$a/d$b/f$f
+            echo "$a $b $f" > $M0/d$a/d$b/deep/er/still/f$f
+        done
+    done
+done
+EXPECT "$(brick_tree_count $B0/${V0}0)" brick_tree_count $B0/${V0}1
+
+#an empty brick gets the whole tree back from the crawl
+TEST $CLI volume replace-brick $V0 $H0:$B0/${V0}2 $H0:$B0/${V0}3 commit force
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 2
+
+TEST $CLI volume heal $V0 full
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "$(brick_tree_count $B0/${V0}0)" \
+    brick_tree_count $B0/${V0}3
+EXPECT "4 4 5" cat $B0/${V0}3/d4/d4/deep/er/still/f5
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
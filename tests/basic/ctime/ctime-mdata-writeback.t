@@ -0,0 +1,41 @@
+#!/bin/bash
+#Parent directory times updated in memory must reach the mdata xattr
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.ctime-writeback-delay-usec 1000000
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 --attribute-timeout=0 $M0;
+
+TEST mkdir $M0/DIR
+sleep 2
+for i in {1..20}; do
+    TEST touch $M0/DIR/f$i
+done
+mtime=$(stat -c %Y.%y $M0/DIR)
+EXPECT_NOT "^0$" get_value_from_brick_statedump $V0 $H0 $B0/${V0}0 "mdata_deferred"
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "^[1-9]" get_value_from_brick_statedump $V0 $H0 $B0/${V0}0 "mdata_writebacks"
+
+#Times served after a brick restart come from the xattr written back
+TEST $CLI volume stop $V0
+TEST $CLI volume start $V0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" brick_up_status $V0 $H0 $B0/${V0}0
+EXPECT "$mtime" stat -c %Y.%y $M0/DIR
+
+#fsyncdir writes a pending update without waiting for the flusher
+TEST $CLI volume set $V0 storage.ctime-writeback-delay-usec 60000000
+TEST touch $M0/DIR/g
+mtime=$(stat -c %Y.%y $M0/DIR)
+TEST $PYTHON -c "import os; fd = os.open('$M0/DIR', os.O_RDONLY); os.fsync(fd); os.close(fd)"
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" brick_up_status $V0 $H0 $B0/${V0}0
+EXPECT "$mtime" stat -c %Y.%y $M0/DIR
+
+cleanup;
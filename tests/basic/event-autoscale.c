@@ -0,0 +1,98 @@
+/*
+ * Replays load steps through the event thread autoscaler and checks the
+ * number of threads it settles on after each of them. The load of a step is
+ * the work arriving per second, in threads worth of it: what the threads
+ * cannot absorb piles up as backlog.
+ *
+ * usage: event-autoscale [-v]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <glusterfs/gf-event.h>
+
+#define MIN_THREADS 2
+#define MAX_THREADS 8
+#define SECOND 1000000000ULL
+
+struct step {
+    const char *name;
+    int seconds;
+    double demand;    /* threads worth of work per second */
+    uint64_t backlog; /* requests queued on top of the overflow */
+    int expected;     /* threads at the end of the step */
+};
+
+static struct step steps[] = {
+    {"idle", 30, 0.2, 0, MIN_THREADS},
+    {"daytime", 30, 6.0, 0, MAX_THREADS},
+    {"spike", 10, 12.0, 0, MAX_THREADS},
+    {"evening", 60, 1.0, 0, 3},
+    {"night", 60, 0.1, 0, MIN_THREADS},
+    {"slow-handlers", 10, 0.5, 64, MAX_THREADS},
+    {"idle-again", 120, 0.0, 0, MIN_THREADS},
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int
+main(int argc, char *argv[])
+{
+    struct event_autoscale as;
+    struct event_load load;
+    double absorbed, start, elapsed = 0;
+    long samples = 0;
+    int verbose = (argc > 1) && !strcmp(argv[1], "-v");
+    int threads = MIN_THREADS;
+    int ret = 0;
+    int i, s;
+
+    memset(&as, 0, sizeof(as));
+    as.min = MIN_THREADS;
+    as.max = MAX_THREADS;
+
+    for (i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+        for (s = 0; s < steps[i].seconds; s++) {
+            absorbed = (steps[i].demand < threads) ? steps[i].demand : threads;
+
+            memset(&load, 0, sizeof(load));
+            load.interval_ns = SECOND;
+            load.busy_ns = absorbed * SECOND;
+            load.wakeups = steps[i].demand * 10000;
+            load.backlog = (steps[i].demand - absorbed) * 10000 +
+                           steps[i].backlog;
+            load.threads = threads;
+
+            start = now();
+            threads = gf_event_autoscale_decide(&as, &load);
+            elapsed += now() - start;
+            samples++;
+
+            if (verbose)
+                printf("%-14s %3ds demand %5.1f threads %d\n", steps[i].name,
+                       s, steps[i].demand, threads);
+        }
+
+        printf("%-14s demand %5.1f -> %d threads (expected %d)\n",
+               steps[i].name, steps[i].demand, threads, steps[i].expected);
+        if (threads != steps[i].expected)
+            ret = 1;
+    }
+
+    printf("%" PRIu64 " scale-ups, %" PRIu64 " scale-downs, %.1f ns/sample\n",
+           as.scale_ups, as.scale_downs, elapsed / samples);
+
+    if (ret == 0)
+        printf("OK\n");
+
+    return ret;
+}
@@ -0,0 +1,82 @@
+#!/bin/bash
+#The event threads follow the load between event-threads and
+#event-threads-max, and the autoscaler reports itself in the statedump
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function brick_event_pool()
+{
+    local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+    grep -a "^$1=" $fpath | head -1 | cut -d'=' -f2
+    cleanup_statedump $(get_brick_pid $V0 $H0 $B0/${V0}0)
+}
+
+function threads_within_bounds()
+{
+    local threads=$(brick_event_pool threads)
+    [ -n "$threads" ] && [ $threads -ge 1 ] && [ $threads -le 4 ] && \
+        echo "Y" || echo "N"
+}
+
+function threads_scaled_up()
+{
+    local threads=$(brick_event_pool threads)
+    [ -n "$threads" ] && [ $threads -gt 1 ] && echo "Y" || echo "N"
+}
+
+#Keeps 32 synchronous writers busy on the brick until $B0/stop-load exists
+function load_brick()
+{
+    local i
+    while [ ! -e $B0/stop-load ]; do
+        for i in {1..32}; do
+            dd if=/dev/zero of=$M0/file$i bs=4k count=256 oflag=sync \
+               2>/dev/null &
+        done
+        wait
+    done
+}
+
+#Load steps replayed through the controller, the thread count it settles on
+#after each of them is checked
+TEST build_tester $(dirname $0)/event-autoscale.c -lglusterfs \
+     -D_GNU_SOURCE -DGF_LINUX_HOST_OS
+EXPECT "OK" $(dirname $0)/event-autoscale
+TEST rm -f $(dirname $0)/event-autoscale
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.event-threads 1
+TEST $CLI volume set $V0 server.event-threads-max 4
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" brick_event_pool autoscale
+EXPECT "1" brick_event_pool autoscale.min-threads
+EXPECT "4" brick_event_pool autoscale.max-threads
+
+#Sustained load adds threads, never beyond the maximum
+load_brick &
+load_pid=$!
+EXPECT_WITHIN 60 "Y" threads_scaled_up
+EXPECT "Y" threads_within_bounds
+TEST [ $(brick_event_pool autoscale.scale-ups) -ge 1 ]
+
+#Once idle, one thread goes per 10 idle samples, down to the minimum
+TEST touch $B0/stop-load
+wait $load_pid
+EXPECT_WITHIN 60 "1" brick_event_pool threads
+TEST [ $(brick_event_pool autoscale.scale-downs) -ge 1 ]
+EXPECT "Y" threads_within_bounds
+
+TEST $CLI volume set $V0 server.event-threads-max 0
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" brick_event_pool autoscale
+EXPECT "1" brick_event_pool threads
+
+TEST rm -f $M0/file* $B0/stop-load
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,168 @@
+/*
+ * Looks up and recycles fds of a single fdtable from several threads, the
+ * way the bricks and fuse do on every fop, and checks that a lookup never
+ * returns an fd it was not given nor loses a reference.
+ *
+ * usage: fdtable-bench [threads] [seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/globals.h>
+#include <glusterfs/fd.h>
+#include <glusterfs/inode.h>
+
+#define FDS_PER_THREAD 256
+#define REFS (1 << 20)
+
+struct worker {
+    pthread_t thread;
+    fdtable_t *fdtable;
+    inode_t inode;
+    fd_t fds[FDS_PER_THREAD];
+    int32_t fdnos[FDS_PER_THREAD];
+    unsigned long lookups;
+    unsigned long recycles;
+    int errors;
+};
+
+static volatile int stop;
+static int nworkers;
+static struct worker *workers;
+
+static int
+owned(fd_t *fd)
+{
+    int i;
+
+    for (i = 0; i < nworkers; i++)
+        if ((fd >= workers[i].fds) && (fd < workers[i].fds + FDS_PER_THREAD))
+            return 1;
+
+    return 0;
+}
+
+static void *
+work(void *data)
+{
+    struct worker *w = data;
+    unsigned int seed = (unsigned long)w;
+    fd_t *fd = NULL;
+    int64_t fdno = 0;
+    int i;
+
+    while (!stop) {
+        /* lookups of our own fds, which nobody else puts */
+        i = rand_r(&seed) % FDS_PER_THREAD;
+        fd = gf_fd_fdptr_get(w->fdtable, w->fdnos[i]);
+        if (fd != &w->fds[i])
+            w->errors++;
+        if (fd)
+            fd_unref(fd);
+
+        /* lookups of any fd, possibly racing with its put */
+        fdno = rand_r(&seed) % (nworkers * FDS_PER_THREAD);
+        fd = gf_fd_fdptr_get(w->fdtable, fdno);
+        if (fd) {
+            if (!owned(fd))
+                w->errors++;
+            fd_unref(fd);
+        }
+        w->lookups += 2;
+
+        if ((w->lookups % 32) == 0) {
+            fd_ref(&w->fds[i]);
+            gf_fd_put(w->fdtable, w->fdnos[i]);
+            w->fdnos[i] = gf_fd_unused_get(w->fdtable, &w->fds[i]);
+            if (w->fdnos[i] < 0) {
+                w->errors++;
+                break;
+            }
+            w->recycles++;
+        }
+    }
+
+    return NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glusterfs_ctx_t *ctx = NULL;
+    fdtable_t *fdtable = NULL;
+    fd_t *fd = NULL;
+    unsigned long lookups = 0, recycles = 0;
+    int seconds = 3;
+    int errors = 0;
+    int i, j;
+
+    nworkers = (argc > 1) ? atoi(argv[1]) : 8;
+    if (argc > 2)
+        seconds = atoi(argv[2]);
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx))
+        return 1;
+    THIS->ctx = ctx;
+
+    fdtable = gf_fd_fdtable_alloc();
+    workers = calloc(nworkers, sizeof(*workers));
+    if (!fdtable || !workers)
+        return 1;
+
+    for (i = 0; i < nworkers; i++) {
+        workers[i].fdtable = fdtable;
+        LOCK_INIT(&workers[i].inode.lock);
+        for (j = 0; j < FDS_PER_THREAD; j++) {
+            GF_ATOMIC_INIT(workers[i].fds[j].refcount, REFS);
+            INIT_LIST_HEAD(&workers[i].fds[j].inode_list);
+            workers[i].fds[j].inode = &workers[i].inode;
+            workers[i].fdnos[j] = gf_fd_unused_get(fdtable,
+                                                   &workers[i].fds[j]);
+            if (workers[i].fdnos[j] < 0)
+                return 1;
+        }
+    }
+
+    for (i = 0; i < nworkers; i++)
+        pthread_create(&workers[i].thread, NULL, work, &workers[i]);
+    sleep(seconds);
+    stop = 1;
+
+    for (i = 0; i < nworkers; i++) {
+        pthread_join(workers[i].thread, NULL);
+        lookups += workers[i].lookups;
+        recycles += workers[i].recycles;
+        errors += workers[i].errors;
+    }
+
+    /* every reference taken by a lookup has been dropped */
+    for (i = 0; i < nworkers; i++) {
+        for (j = 0; j < FDS_PER_THREAD; j++) {
+            fd = gf_fd_fdptr_get(fdtable, workers[i].fdnos[j]);
+            if (fd != &workers[i].fds[j])
+                errors++;
+            if (fd)
+                fd_unref(fd);
+            gf_fd_put(fdtable, workers[i].fdnos[j]);
+            if (GF_ATOMIC_GET(workers[i].fds[j].refcount) != REFS - 1)
+                errors++;
+        }
+    }
+
+    printf("%d threads: %.0f lookups/s, %.0f recycles/s, %d errors\n",
+           nworkers, (double)lookups / seconds, (double)recycles / seconds,
+           errors);
+
+    gf_fd_fdtable_destroy(fdtable);
+
+    if (errors == 0)
+        printf("OK\n");
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,14 @@
+#!/bin/bash
+#Lookups of fds do not serialize on the fdtable, and stay correct while the
+#fds are put and reallocated by other threads
+
+. $(dirname $0)/../include.rc
+
+cleanup;
+
+TEST build_tester $(dirname $0)/fdtable-bench.c -lglusterfs \
+     -D_GNU_SOURCE -DGF_LINUX_HOST_OS -lpthread
+EXPECT "OK" echo $($(dirname $0)/fdtable-bench 8 3 | tail -1)
+TEST rm -f $(dirname $0)/fdtable-bench
+
+cleanup;
@@ -0,0 +1,46 @@
+#!/bin/bash
+#io-cache keeps within its cache-size and serves hits from the sharded cache
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function iocache_priv_value()
+{
+    local fpath=$(generate_mount_statedump $V0 $M0)
+    grep -a -A12 "^\[io-cache.priv\]" $fpath | \
+        grep "^$1=" | cut -f2 -d'='
+    cleanup_mount_statedump $V0
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-cache on
+TEST $CLI volume set $V0 performance.io-cache-size 4MB
+TEST $CLI volume set $V0 performance.io-cache-page-size 64KB
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+EXPECT "65536" iocache_priv_value page_size
+
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=16
+TEST cp $B0/data $M0/file
+sum=$(md5sum < $B0/data)
+
+#Reading more than fits must evict, and both passes must see the data
+EXPECT "$sum" echo $(md5sum < $M0/file)
+EXPECT "$sum" echo $(md5sum < $M0/file)
+EXPECT_NOT "^0$" iocache_priv_value evictions
+TEST [ $(iocache_priv_value cache_used) -le 4194304 ]
+
+#A file which fits is served from the cache the second time
+TEST dd if=$B0/data of=$M0/small bs=1M count=1
+TEST cat $M0/small
+TEST cat $M0/small
+EXPECT_NOT "^0$" iocache_priv_value hits
+
+cleanup;
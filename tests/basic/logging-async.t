@@ -0,0 +1,46 @@
+#!/bin/bash
+#Messages logged with diagnostics.log-async must reach the log files
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+logdir=`gluster --print-logdir`
+
+function client-log-file-name()
+{
+    logfilename=$M0".log"
+    echo ${logfilename:1} | tr / -
+}
+
+function count_debug_msgs()
+{
+    grep " D " $1 | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 diagnostics.log-async on
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+log_file=$logdir"/"`client-log-file-name`
+EXPECT "0" count_debug_msgs $log_file
+
+TEST $CLI volume set $V0 diagnostics.client-log-level DEBUG
+for i in {1..100}; do
+    TEST touch $M0/f$i
+done
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "^[1-9]" count_debug_msgs $log_file
+
+#Turning it off writes synchronously again
+TEST $CLI volume set $V0 diagnostics.log-async off
+TEST $CLI volume set $V0 diagnostics.client-log-level INFO
+nmsgs=$(wc -l < $log_file)
+TEST $CLI volume set $V0 diagnostics.client-log-level DEBUG
+TEST ls -l $M0
+TEST [ $(wc -l < $log_file) -gt $nmsgs ]
+
+cleanup;
@@ -0,0 +1,60 @@
+#!/bin/bash
+#diagnostics.metrics-socket serves live metrics on a unix socket
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function read_metrics()
+{
+    $PYTHON -c "
+import socket, sys
+s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+s.connect(sys.argv[1])
+data = b''
+while True:
+    buf = s.recv(65536)
+    if not buf:
+        break
+    data += buf
+sys.stdout.write(data.decode())
+" $1
+}
+
+function check_if_socket()
+{
+    [ -S $1 ] && echo "Y" || echo "N"
+}
+
+function metric_value()
+{
+    read_metrics $1 | grep "^$2" | head -1 | awk '{print $2}'
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 diagnostics.metrics-socket on
+TEST $CLI volume set $V0 diagnostics.latency-measurement on
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" brick_up_status $V0 $H0 $B0/${V0}0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+brick_pid=$(get_brick_pid $V0 $H0 $B0/${V0}0)
+sock=/var/run/gluster/metrics/gmetrics.$brick_pid.sock
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" check_if_socket $sock
+
+for i in {1..10}; do
+    TEST dd if=/dev/zero of=$M0/f$i bs=4k count=4
+done
+EXPECT "^[1-9]" metric_value $sock "gluster_xlator_fops_total{.*fop=\"WRITE\""
+EXPECT "^[1-9]" metric_value $sock "gluster_fop_latency_microseconds_count{.*fop=\"WRITE\""
+EXPECT "163840" metric_value $sock "gluster_written_bytes_total"
+EXPECT "^[0-9]" metric_value $sock "gluster_posix_xattr_cache_hits_total"
+
+#The socket goes away when the option is turned off
+TEST $CLI volume set $V0 diagnostics.metrics-socket off
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "N" check_if_socket $sock
+
+cleanup;
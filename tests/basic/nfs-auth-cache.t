@@ -0,0 +1,57 @@
+#!/bin/bash
+#With exports authentication enabled, file handles are authorized through the
+#binary auth cache and subdirectory mounts through the exports trie
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../nfs.rc
+
+#G_TESTDEF_TEST_STATUS_CENTOS6=NFS_TEST
+
+cleanup;
+
+function nfs_auth_value()
+{
+    local fpath=$(generate_nfs_statedump)
+    grep -a "^auth.$1=" $fpath | cut -d'=' -f2
+    cleanup_statedump $(get_nfs_pid)
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST mkdir -p $B0/${V0}0/L1/L2
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 nfs.disable off
+TEST $CLI volume start $V0
+
+NFSDIR=$( $CLI volume get $V0 nfs.mount-rmtab | \
+          awk '/^nfs.mount-rmtab/{print $2}' | \
+          xargs dirname )
+printf "/$V0 $H0(sec=sys,rw,anonuid=0)\n" > $NFSDIR/exports
+printf "/$V0/L1/L2 1.2.3.4(sec=sys,ro,anonuid=0)\n" >> $NFSDIR/exports
+
+TEST $CLI volume stop $V0
+TEST $CLI volume set $V0 nfs.exports-auth-enable on
+TEST $CLI volume start $V0
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT 1 is_nfs_export_available
+
+TEST mount_nfs $H0:/$V0 $N0 nolock
+for i in {1..20}; do
+    TEST dd if=/dev/zero of=$N0/file$i bs=4k count=1
+done
+TEST ls -l $N0
+EXPECT_NOT "^0$" nfs_auth_value fh-requests
+EXPECT_NOT "^0$" nfs_auth_value cache-hits
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+#/$V0/L1 is not exported itself, it is authorized by its parent /$V0
+TEST mount_nfs $H0:/$V0/L1 $N0 nolock
+TEST touch $N0/L2/file
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+#/$V0/L1/L2 is exported to another host only, /$V0 still authorizes us
+TEST mount_nfs $H0:/$V0/L1/L2 $N0 nolock
+TEST ls $N0/file
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+cleanup;
@@ -0,0 +1,51 @@
+#!/bin/bash
+#The duplicate request cache of gNFS keeps the requests of each client
+#within nfs.drc-client-size, evicting the oldest ones
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../nfs.rc
+
+#G_TESTDEF_TEST_STATUS_CENTOS6=NFS_TEST
+
+cleanup;
+
+function drc_value()
+{
+    local fpath=$(generate_nfs_statedump)
+    grep -a "^$1=" $fpath | head -1 | cut -d'=' -f2
+    cleanup_statedump $(get_nfs_pid)
+}
+
+function drc_within_budget()
+{
+    local bytes=$(drc_value client.0.cache_bytes)
+    [ -n "$bytes" ] && [ $bytes -le $((128 * 1024)) ] && echo "Y" || echo "N"
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 nfs.disable off
+TEST $CLI volume set $V0 nfs.drc on
+TEST $CLI volume set $V0 nfs.drc-client-size 128KB
+TEST $CLI volume start $V0
+
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT 1 is_nfs_export_available
+TEST mount_nfs $H0:/$V0 $N0 nolock
+
+TEST mkdir $N0/dir
+for i in {1..500}; do
+    echo $i > $N0/dir/file$i
+done
+TEST rm -f $N0/dir/file{1..250}
+EXPECT "250" echo $(ls $N0/dir | wc -l)
+
+EXPECT_NOT "^0$" drc_value drc.current_cache_size
+EXPECT_NOT "^0$" drc_value drc.evictions
+EXPECT "Y" drc_within_budget
+
+TEST rm -rf $N0/dir
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+cleanup;
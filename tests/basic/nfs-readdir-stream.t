@@ -0,0 +1,44 @@
+#!/bin/bash
+#gNFS keeps the position of the directory listings in progress between
+#READDIRPLUS calls, listings must be complete with and without it
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../nfs.rc
+
+#G_TESTDEF_TEST_STATUS_CENTOS6=NFS_TEST
+
+cleanup;
+
+function list_count()
+{
+    ls -f $N0/dir | grep -c '^file'
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 nfs.disable off
+TEST $CLI volume start $V0
+
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT 1 is_nfs_export_available
+TEST mount_nfs $H0:/$V0 $N0 nolock
+
+TEST mkdir $N0/dir
+TEST touch $N0/dir/file{1..2000}
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+TEST mount_nfs $H0:/$V0 $N0 nolock,noac
+EXPECT "2000" list_count
+EXPECT "2000" list_count
+TEST rm -f $N0/dir/file{1..1000}
+EXPECT "1000" list_count
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+TEST $CLI volume set $V0 nfs.readdir-streams 0
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT 1 is_nfs_export_available
+TEST mount_nfs $H0:/$V0 $N0 nolock,noac
+EXPECT "1000" list_count
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+cleanup;
@@ -0,0 +1,74 @@
+#!/bin/bash
+#UNSTABLE writes gathered by gNFS and the COMMITs answered by batched fsyncs
+#must leave the same data as plain writes, and writes must be gathered only
+#while nfs.write-gather is on.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+. $(dirname $0)/../nfs.rc
+
+#G_TESTDEF_TEST_STATUS_CENTOS6=NFS_TEST
+
+cleanup;
+
+function nfs_write_file()
+{
+    local name=$1
+    dd if=$B0/source of=$N0/$name bs=4k conv=fsync 2>/dev/null
+    md5sum < $N0/$name | cut -d' ' -f1
+}
+
+function nfs_write_gather_stat()
+{
+    local key=$1
+    local dump=$(generate_nfs_statedump)
+    grep "^write-gather.$key=" $dump | cut -f2 -d'='
+}
+
+function nfs_gathered_requests()
+{
+    echo $(($(nfs_write_gather_stat requests) - $(nfs_write_gather_stat writes)))
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 nfs.disable false
+#Let the writes reach the NFS server unaggregated
+TEST $CLI volume set $V0 performance.nfs.write-behind off
+TEST $CLI volume set $V0 nfs.write-gather on
+TEST $CLI volume start $V0
+
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT 1 is_nfs_export_available
+#Small writes, sent by the client in parallel
+TEST mount_nfs $H0:/$V0 $N0 nolock,wsize=4096
+
+TEST dd if=/dev/urandom of=$B0/source bs=1M count=16
+sum=$(md5sum < $B0/source | cut -d' ' -f1)
+
+EXPECT "$sum" nfs_write_file gathered
+#Some of the writes were sent together
+EXPECT_NOT "^0$" nfs_gathered_requests
+#Several writers on the same file, at different offsets
+for i in {0..3}; do
+    dd if=$B0/source of=$N0/shared bs=4k skip=$((i * 1024)) \
+       seek=$((i * 1024)) count=1024 conv=notrunc,fsync 2>/dev/null &
+done
+wait
+EXPECT "$sum" echo $(md5sum < $N0/shared | cut -d' ' -f1)
+
+TEST $CLI volume set $V0 nfs.write-gather off
+EXPECT_WITHIN $NFS_EXPORT_TIMEOUT 1 is_nfs_export_available
+EXPECT "0" nfs_write_gather_stat enabled
+requests=$(nfs_write_gather_stat requests)
+EXPECT "$sum" nfs_write_file plain
+EXPECT "$requests" nfs_write_gather_stat requests
+
+#The data written both ways is on the brick
+EXPECT "$sum" echo $(md5sum < $B0/${V0}0/gathered | cut -d' ' -f1)
+EXPECT "$sum" echo $(md5sum < $B0/${V0}0/plain | cut -d' ' -f1)
+
+TEST rm -f $N0/gathered $N0/plain $N0/shared $B0/source
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $N0
+
+cleanup;
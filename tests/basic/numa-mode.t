@@ -0,0 +1,63 @@
+#!/bin/bash
+#With server.numa-affinity on, a brick on a host with several NUMA nodes
+#gives every node an epoll fd of its own with event threads bound to it, and
+#takes its large iobufs from arenas placed on the node of the thread using
+#them. Single node hosts run as before.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function brick_key()
+{
+    local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+    grep -a "^$1=" $fpath | head -1 | cut -d'=' -f2
+    cleanup_statedump $(get_brick_pid $V0 $H0 $B0/${V0}0)
+}
+
+function brick_threads_cover_nodes()
+{
+    local threads=$(brick_key threads)
+    [ -n "$threads" ] && [ $threads -ge $NODES ] && echo "Y" || echo "N"
+}
+
+NODES=$(ls -d /sys/devices/system/node/node[0-9]* 2>/dev/null | wc -l)
+if [ $NODES -gt 1 ]; then
+    NUMA=1
+else
+    NUMA=0
+    NODES=0
+fi
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.event-threads 1
+TEST $CLI volume set $V0 server.numa-affinity on
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "$NUMA" brick_key numa
+EXPECT "$NODES" brick_key numa-nodes
+EXPECT "$NUMA" brick_key iobuf_pool.numa
+EXPECT "Y" brick_threads_cover_nodes
+
+#Large writes and reads go through the arenas of the nodes
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=8
+TEST cp $B0/data $M0/data
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M0/data)"
+TEST $CLI volume set $V0 performance.io-thread-count 4
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M0/data)"
+
+#Turning it off keeps the node fds, their connections stay served
+TEST $CLI volume set $V0 server.numa-affinity off
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" brick_key numa
+EXPECT "$NODES" brick_key numa-nodes
+EXPECT "0" brick_key iobuf_pool.numa
+TEST cp $B0/data $M0/data2
+EXPECT "$(md5sum < $B0/data)" echo "$(md5sum < $M0/data2)"
+TEST rm -f $M0/data $M0/data2 $B0/data
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
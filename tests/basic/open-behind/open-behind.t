@@ -176,6 +176,37 @@ EXPECT "1" count_open "/test"
 TEST tester_send fd close 0
 EXPECT_WITHIN 5 "0" count_open "/test"
 
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST ${CLI} volume set ${V0} anonymous-reads on
+TEST ${GFS} --volfile-id=/${V0} --volfile-server=${H0} ${M0};
+
+# Reads from any number of fds don't open the file on the brick
+TEST tester_send fd open 0 "${M0}/test"
+TEST tester_send fd open 1 "${M0}/test"
+EXPECT "test" tester_send fd read 0 64
+EXPECT "test" tester_send fd read 1 64
+EXPECT "0" count_open "/test"
+TEST tester_send fd close 0
+TEST tester_send fd close 1
+EXPECT "0" count_open "/test"
+
+# A write needs the real open of its own fd only
+TEST tester_send fd open 0 "${M0}/test"
+TEST tester_send fd open 1 "${M0}/test"
+TEST tester_send fd write 0 "test"
+EXPECT "1" count_open "/test"
+EXPECT "test" tester_send fd read 1 64
+EXPECT "1" count_open "/test"
+TEST tester_send fd close 0
+TEST tester_send fd close 1
+EXPECT_WITHIN 5 "0" count_open "/test"
+
+# Files being read are really opened before being unlinked
+TEST tester_send fd open 0 "${M0}/test"
+TEST rm -f "${M0}/test"
+EXPECT "test" tester_send fd read 0 64
+TEST tester_send fd close 0
+
 EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
 
 TEST tester_stop
@@ -0,0 +1,77 @@
+#!/bin/bash
+#Directory handles resolved through cached O_PATH fds must follow renames
+#and must not be used once the directory is removed
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+cleanup;
+
+function pathinfo_through_fd()
+{
+    getfattr --only-values -n trusted.glusterfs.pathinfo $1 2>/dev/null | \
+        grep -c "/proc/self/fd"
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 storage.handle-fd-cache-size 1024
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 --attribute-timeout=0 --aux-gfid-mount $M0;
+
+EXPECT "1024" get_value_from_brick_statedump $V0 $H0 $B0/${V0}0 "handle_fd_cache_size"
+
+TEST mkdir -p $M0/a/b/c
+for i in {1..10}; do
+    TEST touch $M0/a/b/c/f$i
+done
+TEST ls -l $M0/a/b/c
+EXPECT_NOT "^0$" get_value_from_brick_statedump $V0 $H0 $B0/${V0}0 "handle_fd_hits"
+EXPECT_NOT "^0$" get_value_from_brick_statedump $V0 $H0 $B0/${V0}0 "handle_fds"
+
+#Cached fd follows the directory across a rename
+TEST mv $M0/a/b $M0/b2
+TEST touch $M0/b2/c/g
+TEST stat $B0/${V0}0/b2/c/g
+TEST ! stat $B0/${V0}0/a/b
+
+#A removed directory is not resolved through its fd anymore
+TEST rm -rf $M0/b2/c
+TEST ! stat $M0/b2/c
+TEST mkdir $M0/b2/c
+TEST touch $M0/b2/c/h
+TEST stat $B0/${V0}0/b2/c/h
+
+#Overwriting a directory by rename
+TEST mkdir $M0/d1 $M0/d2
+TEST touch $M0/d2/x
+TEST rm -f $M0/d2/x
+TEST mv -T $M0/d1 $M0/d2
+TEST ! stat $M0/d1
+TEST touch $M0/d2/y
+TEST stat $B0/${V0}0/d2/y
+
+#pathinfo of a directory looked up by gfid names its handle, not the fd
+TEST ls $M0/d2
+gfid=$(get_gfid_string $M0/d2)
+TEST getfattr -n trusted.glusterfs.pathinfo $M0/.gfid/$gfid
+EXPECT "0" pathinfo_through_fd $M0/.gfid/$gfid
+
+#gfid2path, on disk and resolved, names the real path under a cached fd
+TEST mkdir $M0/b2/e
+TEST ls $M0/b2/e
+TEST touch $M0/b2/e/f
+pgfid=$(get_gfid_string $M0/b2/e)
+EXPECT "$pgfid/f" get_text_xattr trusted.gfid2path $B0/${V0}0/b2/e/f
+gfid=$(get_gfid_string $M0/b2/e/f)
+EXPECT "/b2/e/f" get_gfid2path $M0/.gfid/$gfid
+EXPECT "/b2/e" get_gfid2path $M0/.gfid/$pgfid
+TEST mv $M0/b2/e/f $M0/b2/e/g
+EXPECT "/b2/e/g" get_gfid2path $M0/.gfid/$gfid
+
+TEST $CLI volume set $V0 storage.handle-fd-cache-size 0
+TEST touch $M0/b2/c/i
+TEST stat $B0/${V0}0/b2/c/i
+
+cleanup;
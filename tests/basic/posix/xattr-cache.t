@@ -0,0 +1,54 @@
+#!/bin/bash
+#Lookups served from the posix xattr cache must see xattr modifications
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+. $(dirname $0)/../../afr.rc
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 3 $H0:$B0/brick{0,1,2}
+TEST $CLI volume set $V0 storage.xattr-cache on
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.flush-behind off
+TEST $CLI volume start $V0
+TEST $CLI volume heal $V0 disable
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 --attribute-timeout=0 $M0;
+
+EXPECT "on" get_value_from_brick_statedump $V0 $H0 $B0/brick0 "xattr_cache"
+
+echo abc > $M0/a
+for i in {1..10}; do
+    TEST stat $M0/a
+done
+EXPECT_NOT "^0$" get_value_from_brick_statedump $V0 $H0 $B0/brick0 "xattr_cache_hits"
+
+#Once cached, lookups need no xattr syscalls, not even for the keys the
+#file does not have
+syscalls=$(get_value_from_brick_statedump $V0 $H0 $B0/brick0 "xattr_syscalls")
+for i in {1..10}; do
+    TEST stat $M0/a
+done
+EXPECT "$syscalls" get_value_from_brick_statedump $V0 $H0 $B0/brick0 "xattr_syscalls"
+
+#Pending xattrs set by xattrop must be visible to the next lookup
+TEST kill_brick $V0 $H0 $B0/brick0
+echo def >> $M0/a
+TEST stat $M0/a
+TEST $CLI volume heal $V0 enable
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "0" get_pending_heal_count $V0
+TEST diff $B0/brick0/a $B0/brick1/a
+
+#User xattrs set and removed from the mount are seen by later lookups
+TEST setfattr -n user.foo -v bar $M0/a
+EXPECT "bar" echo $(getfattr --only-values -n user.foo $B0/brick1/a 2>/dev/null)
+TEST setfattr -x user.foo $M0/a
+TEST stat $M0/a
+TEST ! getfattr -n user.foo $M0/a
+
+cleanup;
@@ -0,0 +1,52 @@
+#!/bin/bash
+#features.qos sorts the requests of a brick into classes served within their
+#limits, and io-stats accounts the requests and queueing delay of each class
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function brick_qos()
+{
+    local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+    grep -a "^$1=" $fpath | head -1 | cut -d'=' -f2
+    cleanup_statedump $(get_brick_pid $V0 $H0 $B0/${V0}0)
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 features.qos on
+TEST $CLI volume set $V0 features.qos-class-by uid
+TEST $CLI volume set $V0 features.qos-class-limits "0=iops:50/weight:2"
+TEST ! $CLI volume set $V0 features.qos-class-by pid
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "uid" brick_qos class_by
+
+#root is held to 50 requests per second, some of them wait for their turn
+TEST mkdir $M0/dir
+for i in {1..100}; do
+    echo $i > $M0/dir/file$i
+done
+EXPECT "100" echo $(ls $M0/dir | wc -l)
+EXPECT_NOT "^0$" brick_qos qos.0.requests
+EXPECT_NOT "^0$" brick_qos qos.0.delayed
+EXPECT "50" brick_qos class.0.iops
+
+TEST $CLI volume set $V0 features.qos-class-limits ""
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" brick_qos class.0.iops
+TEST ! $CLI volume set $V0 features.qos-class-limits "0=iops:many"
+TEST ! $CLI volume set $V0 features.qos-class-limits "0=weight:0"
+
+#The classes of the old kind leave the table when class-by changes
+EXPECT "1" brick_qos classes
+TEST $CLI volume set $V0 features.qos-class-by gid
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "gid" brick_qos class_by
+EXPECT "0" brick_qos classes
+TEST rm -rf $M0/dir
+
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+cleanup;
@@ -0,0 +1,71 @@
+#!/bin/bash
+#quick-read serves compressed cached content and keeps hot files cached
+#across a scan of files read only once
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function qr_priv_value()
+{
+    local fpath=$(generate_mount_statedump $V0 $M0)
+    grep -a -A20 "^\[xlator.performance.quick-read.priv\]" $fpath | \
+        grep "^$1=" | cut -f2 -d'='
+    cleanup_mount_statedump $V0
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.quick-read on
+TEST $CLI volume set $V0 performance.quick-read-compress on
+TEST $CLI volume set $V0 performance.quick-read-cache-size 1MB
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 \
+    --attribute-timeout=0 --direct-io-mode=yes $M0
+
+EXPECT "on" qr_priv_value compress
+EXPECT "off" qr_priv_value admission
+TEST $CLI volume set $V0 performance.quick-read-admission on
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "on" qr_priv_value admission
+
+#Compressible files come back intact, both cold and from the cache
+for i in {1..8}; do
+    yes "line $i of a compressible file" | head -c 48K > $B0/text.$i
+    TEST cp $B0/text.$i $M0/text.$i
+done
+for pass in 1 2; do
+    for i in {1..8}; do
+        TEST cmp $B0/text.$i $M0/text.$i
+    done
+done
+EXPECT_NOT "^0$" qr_priv_value bytes-saved
+EXPECT_NOT "^0$" qr_priv_value cache-hit
+
+#Incompressible content is kept as it is and still read back correctly
+TEST dd if=/dev/urandom of=$B0/random bs=32K count=1
+TEST cp $B0/random $M0/random
+TEST cmp $B0/random $M0/random
+TEST cmp $B0/random $M0/random
+
+#A scan of many files read once is not admitted over the hot files
+EXPECT "65536" qr_priv_value max_file_size
+for i in {1..200}; do
+    dd if=/dev/urandom of=$M0/scan.$i bs=60K count=1 2>/dev/null
+done
+for i in {1..200}; do
+    cat $M0/scan.$i > /dev/null
+done
+EXPECT_NOT "^0$" qr_priv_value admission-rejects
+for i in {1..8}; do
+    TEST cmp $B0/text.$i $M0/text.$i
+done
+
+TEST $CLI volume set $V0 performance.quick-read-compress off
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "off" qr_priv_value compress
+
+cleanup;
@@ -0,0 +1,71 @@
+#!/bin/bash
+#read-ahead follows sequential and strided streams on one fd and keeps its
+#pages within the cache budget
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function ra_dump_value()
+{
+    local fpath=$(generate_mount_statedump $V0 $M0)
+    grep -a -A8 "^\[xlator.performance.read-ahead.priv\]" $fpath | \
+        grep "^$1=" | cut -f2 -d'='
+    cleanup_mount_statedump $V0
+}
+
+function ra_stream_strides()
+{
+    local fpath=$(generate_mount_statedump $V0 $M0)
+    grep -a "^stream\[" $fpath | grep -o "stride=[0-9]*" | sort -u | \
+        tr '\n' ' '
+    cleanup_mount_statedump $V0
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.read-ahead on
+TEST $CLI volume set $V0 performance.read-ahead-page-count 8
+TEST $CLI volume set $V0 performance.read-ahead-cache-size 1MB
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0 --direct-io-mode=yes
+
+EXPECT "1048576" ra_dump_value cache_size
+
+TEST dd if=/dev/urandom of=$B0/data bs=1M count=16
+TEST cp $B0/data $M0/file
+
+#Interleave a sequential and a strided reader on one fd, checking the data
+$PYTHON - $M0/file $B0/data $M0/.done <<EOF &
+import os, sys, time
+fd = os.open(sys.argv[1], os.O_RDONLY)
+ref = open(sys.argv[2], "rb").read()
+ok = True
+for i in range(32):
+    off = i * 131072
+    if os.pread(fd, 131072, off) != ref[off:off + 131072]:
+        ok = False
+    off = 8388608 + i * 262144
+    if os.pread(fd, 16384, off) != ref[off:off + 16384]:
+        ok = False
+open(sys.argv[3], "w").write("ok" if ok else "bad")
+time.sleep(60)
+EOF
+reader=$!
+
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "ok" cat $M0/.done
+EXPECT "stride=131072 stride=262144 " ra_stream_strides
+TEST [ $(ra_dump_value cache_used) -le 1048576 ]
+kill $reader
+wait $reader 2>/dev/null
+
+#Plain sequential reads still return the right data
+sum=$(md5sum < $B0/data)
+EXPECT "$sum" echo $(md5sum < $M0/file)
+
+cleanup;
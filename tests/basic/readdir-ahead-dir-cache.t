@@ -0,0 +1,84 @@
+#!/bin/bash
+#readdir-ahead serves repeated listings of a directory from its listing cache
+#and drops the cached listing when entries change, locally or on another
+#client
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function rda_priv_value()
+{
+    local fpath=$(generate_mount_statedump $V0 $M0)
+    grep -a -A12 "^\[xlator.performance.readdir-ahead.priv\]" $fpath | \
+        grep "^$1=" | cut -f2 -d'='
+    cleanup_mount_statedump $V0
+}
+
+function entry_count()
+{
+    ls $1 | wc -l
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.readdir-ahead on
+TEST $CLI volume set $V0 performance.rda-dir-cache on
+TEST $CLI volume set $V0 features.cache-invalidation on
+TEST $CLI volume set $V0 performance.nl-cache off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 \
+    --attribute-timeout=0 $M0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 --entry-timeout=0 \
+    --attribute-timeout=0 $M1
+
+EXPECT "on" rda_priv_value dir_cache
+
+TEST mkdir $M0/dir
+TEST touch $M0/dir/file{1..200}
+
+#The first listing fills the cache, the following ones are served from it
+EXPECT "200" entry_count $M0/dir
+EXPECT "200" entry_count $M0/dir
+EXPECT "200" entry_count $M0/dir
+EXPECT_NOT "^0$" rda_priv_value dir_cache_hits
+EXPECT_NOT "^0$" rda_priv_value dir_cache_size
+
+#Entry changes made through this client are seen by the next listing
+TEST touch $M0/dir/new
+EXPECT "201" entry_count $M0/dir
+TEST rm -f $M0/dir/file1
+EXPECT "200" entry_count $M0/dir
+TEST mv $M0/dir/file2 $M0/moved
+EXPECT "199" entry_count $M0/dir
+TEST mv $M0/moved $M0/dir/file2
+EXPECT "200" entry_count $M0/dir
+
+#Entry changes made on another client reach us through upcalls
+EXPECT "200" entry_count $M0/dir
+TEST touch $M1/dir/remote
+EXPECT_WITHIN $MDC_TIMEOUT "201" entry_count $M0/dir
+TEST rm -f $M1/dir/remote
+EXPECT_WITHIN $MDC_TIMEOUT "200" entry_count $M0/dir
+EXPECT_NOT "^0$" rda_priv_value dir_cache_invalidations
+
+#Shrinking the budget drops what no longer fits
+TEST $CLI volume set $V0 performance.rda-dir-cache-limit 0
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" rda_priv_value dir_cache_size
+EXPECT "200" entry_count $M0/dir
+EXPECT "0" rda_priv_value dir_cache_size
+TEST $CLI volume set $V0 performance.rda-dir-cache-limit 32MB
+
+#A listing older than rda-dir-cache-timeout is read from the bricks again
+TEST $CLI volume set $V0 performance.rda-dir-cache-timeout 2
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "2" rda_priv_value dir_cache_timeout
+EXPECT "200" entry_count $M0/dir
+EXPECT_NOT "^0$" rda_priv_value dir_cache_size
+hits=$(rda_priv_value dir_cache_hits)
+sleep 3
+EXPECT "200" entry_count $M0/dir
+EXPECT "$hits" rda_priv_value dir_cache_hits
+
+cleanup;
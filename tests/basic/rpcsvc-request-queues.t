@@ -0,0 +1,38 @@
+#!/bin/bash
+#Requests handed to the brick's request handler threads are served through
+#the per event thread queues, with or without NUMA affinity
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function request_queue_count()
+{
+    local fpath=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+    grep -a "request-queue\[[0-9]*\]=" $fpath | grep -c "queued=[1-9]"
+    cleanup_statedump $(get_brick_pid $V0 $H0 $B0/${V0}0)
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 server.numa-affinity on
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+TEST mkdir $M0/dir
+for i in {1..50}; do
+    echo "data $i" > $M0/dir/file$i
+done
+for i in {1..50}; do
+    EXPECT "data $i" cat $M0/dir/file$i
+done
+EXPECT_NOT "^0$" request_queue_count
+
+#Turning affinity off keeps serving requests
+TEST $CLI volume set $V0 server.numa-affinity off
+TEST dd if=/dev/zero of=$M0/big bs=128k count=64
+TEST rm -rf $M0/dir $M0/big
+
+cleanup;
@@ -0,0 +1,54 @@
+#!/bin/bash
+#Requests and replies received several per read through the socket receive
+#buffer, or straight into their iobufs for bulk payloads, must arrive
+#intact.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function small_files_bad()
+{
+    local bad=0
+    for i in {1..200}; do
+        [ "$(cat $M0/small/f$i)" == "content of f$i" ] || bad=$((bad + 1))
+    done
+    echo $bad
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+#Let every small request reach the wire on its own
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+#Many small requests in flight at once
+TEST mkdir $M0/small
+for i in {1..200}; do
+    echo "content of f$i" > $M0/small/f$i &
+done
+wait
+TEST dd if=/dev/urandom of=$B0/source bs=1M count=32
+TEST cp $B0/source $M0/big
+sum=$(md5sum < $B0/source | cut -d' ' -f1)
+
+#Read back through a new connection, small replies and bulk payloads mixed
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+md5sum < $M0/big > $B0/big.sum &
+EXPECT "0" small_files_bad
+wait
+EXPECT "$sum" echo $(cut -d' ' -f1 < $B0/big.sum)
+EXPECT "$sum" echo $(md5sum < $B0/${V0}0/big | cut -d' ' -f1)
+EXPECT "200" echo $(ls $M0/small | wc -l)
+
+TEST rm -rf $M0/small $M0/big $B0/source $B0/big.sum
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+cleanup;
@@ -0,0 +1,64 @@
+#!/bin/bash
+#Messages piling up in the socket output queue are sent several per
+#sendmsg, a partial write resuming in the middle of one. Small replies
+#and bulk payloads queued together, in both directions, must arrive intact.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+cleanup;
+
+function small_files_bad()
+{
+    local bad=0
+    for i in {1..200}; do
+        [ "$(cat $M0/small/f$i)" == "content of f$i" ] || bad=$((bad + 1))
+    done
+    echo $bad
+}
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+#Let every request and reply reach the wire on its own
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.stat-prefetch off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+
+#Requests queue up on the client: many writers at once
+TEST mkdir $M0/small
+for i in {1..200}; do
+    echo "content of f$i" > $M0/small/f$i &
+done
+TEST dd if=/dev/urandom of=$B0/source bs=1M count=32
+for i in {1..4}; do
+    cp $B0/source $M0/big$i &
+done
+wait
+sum=$(md5sum < $B0/source | cut -d' ' -f1)
+
+#Replies queue up on the brick: bulk reads mixed with a flood of small ones
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=$V0 --volfile-server=$H0 $M0
+for i in {1..4}; do
+    md5sum < $M0/big$i > $B0/big$i.sum &
+done
+for i in {1..200}; do
+    stat $M0/small/f$i > /dev/null &
+done
+EXPECT "0" small_files_bad
+wait
+for i in {1..4}; do
+    EXPECT "$sum" echo $(cut -d' ' -f1 < $B0/big$i.sum)
+    EXPECT "$sum" echo $(md5sum < $B0/${V0}0/big$i | cut -d' ' -f1)
+done
+EXPECT "200" echo $(ls $M0/small | wc -l)
+
+TEST rm -rf $M0/small $M0/big* $B0/source $B0/big*.sum
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+
+cleanup;
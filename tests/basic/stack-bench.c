@@ -0,0 +1,191 @@
+/*
+ * Winds and unwinds stat through a chain of translators from several
+ * threads at once, each round trip creating and destroying its call stack
+ * like a fop coming from fuse, gfapi or the bricks, and reports the round
+ * trips per second. Only the top and the bottom translators implement stat,
+ * the ones in between use the default fops, first as they are and then
+ * with the fop targets of the chain resolved. No stack may be left in
+ * flight afterwards.
+ *
+ * usage: stack-bench [threads] [seconds] [xlators]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/defaults.h>
+#include <glusterfs/globals.h>
+#include <glusterfs/mem-pool.h>
+#include <glusterfs/stack.h>
+#include <glusterfs/xlator.h>
+
+#define MAX_XLATORS 32
+
+static volatile int stop;
+static xlator_t xlators[MAX_XLATORS];
+static xlator_list_t children[MAX_XLATORS];
+static struct xlator_fops fops;
+static int nxlators = 8;
+
+static int32_t
+noop_stat_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *buf,
+              dict_t *xdata)
+{
+    STACK_UNWIND_STRICT(stat, frame, op_ret, op_errno, buf, xdata);
+    return 0;
+}
+
+static int32_t
+noop_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    xlator_t *next = this->children ? FIRST_CHILD(this) : NULL;
+
+    if (next)
+        STACK_WIND(frame, noop_stat_cbk, next, next->fops->stat, loc, xdata);
+    else
+        STACK_UNWIND_STRICT(stat, frame, 0, 0, NULL, xdata);
+
+    return 0;
+}
+
+static int32_t
+bench_stat_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *buf,
+               dict_t *xdata)
+{
+    STACK_DESTROY(frame->root);
+    return 0;
+}
+
+static void *
+bench(void *data)
+{
+    unsigned long *ops = data;
+    xlator_t *top = &xlators[0];
+    call_frame_t *frame = NULL;
+    loc_t loc = {
+        0,
+    };
+
+    while (!stop) {
+        frame = create_frame(top, top->ctx->pool);
+        if (!frame)
+            break;
+
+        STACK_WIND(frame, bench_stat_cbk, top, top->fops->stat, &loc, NULL);
+        (*ops)++;
+    }
+
+    return NULL;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glusterfs_ctx_t *ctx = NULL;
+    call_pool_t *pool = NULL;
+    pthread_t *threads = NULL;
+    unsigned long *ops = NULL;
+    unsigned long total = 0;
+    unsigned long done = 0;
+    long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+    double rate = 0;
+    int nthreads = 4;
+    int phase = 0;
+    int seconds = 3;
+    int i;
+
+    if (argc > 1)
+        nthreads = atoi(argv[1]);
+    if (argc > 2)
+        seconds = atoi(argv[2]);
+    if (argc > 3)
+        nxlators = atoi(argv[3]);
+    if ((nxlators < 1) || (nxlators > MAX_XLATORS))
+        return 1;
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx))
+        return 1;
+    THIS->ctx = ctx;
+    mem_pools_init();
+
+    pool = calloc(1, sizeof(*pool));
+    if (!pool)
+        return 1;
+    call_pool_init(pool);
+    pool->frame_mem_pool = mem_pool_new(call_frame_t, 4096);
+    pool->stack_mem_pool = mem_pool_new(call_stack_t, 1024);
+    if (!pool->frame_mem_pool || !pool->stack_mem_pool)
+        return 1;
+    ctx->pool = pool;
+
+    fops.stat = noop_stat;
+    for (i = 0; i < nxlators; i++) {
+        xlators[i].name = "noop";
+        xlators[i].ctx = ctx;
+        xlators[i].init_succeeded = 1;
+        xlators[i].pass_through_fops = default_fops;
+        if ((i == 0) || (i == nxlators - 1))
+            xlators[i].fops = &fops;
+        else
+            xlators[i].fops = default_fops;
+        if (i + 1 < nxlators) {
+            children[i].xlator = &xlators[i + 1];
+            xlators[i].children = &children[i];
+        }
+    }
+
+    threads = calloc(nthreads, sizeof(*threads));
+    ops = calloc(nthreads, sizeof(*ops));
+    if (!threads || !ops)
+        return 1;
+
+    for (phase = 0; phase < 2; phase++) {
+        if (phase == 1) {
+            for (i = 0; i < nxlators; i++)
+                xlator_resolve_fop_targets(&xlators[i]);
+        }
+
+        stop = 0;
+        memset(ops, 0, nthreads * sizeof(*ops));
+        for (i = 0; i < nthreads; i++)
+            pthread_create(&threads[i], NULL, bench, &ops[i]);
+        sleep(seconds);
+        stop = 1;
+        for (i = 0; i < nthreads; i++) {
+            pthread_join(threads[i], NULL);
+            total += ops[i];
+        }
+
+        rate = (double)(total - done) / seconds;
+        printf("%s: %d threads, %d xlators: %.0f round trips/s, "
+               "%.0f ns of cpu/stat\n",
+               phase ? "resolved" : "unresolved", nthreads, nxlators, rate,
+               1e9 * ((nthreads < ncpus) ? nthreads : ncpus) / rate);
+        done = total;
+    }
+
+    if ((call_pool_inflight(pool) != 0) || (call_pool_total(pool) != total)) {
+        printf("%" PRId64 " stacks in flight, %" PRIu64 " created\n",
+               call_pool_inflight(pool), call_pool_total(pool));
+        return 1;
+    }
+
+    /* only the top and bottom xlators took a frame */
+    if (xlators[0].fop_target[GF_FOP_STAT] ||
+        (nxlators > 2 &&
+         xlators[1].fop_target[GF_FOP_STAT] != &xlators[nxlators - 1])) {
+        printf("stat not resolved to the bottom xlator\n");
+        return 1;
+    }
+
+    printf("OK\n");
+
+    return 0;
+}
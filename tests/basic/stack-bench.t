@@ -0,0 +1,16 @@
+#!/bin/bash
+#Call stacks are created and destroyed from several threads without
+#contending on the call pool, and none is lost from its accounting. Fops
+#wound through translators which only forward them go straight to the one
+#implementing them
+
+. $(dirname $0)/../include.rc
+
+cleanup;
+
+TEST build_tester $(dirname $0)/stack-bench.c -lglusterfs \
+     -D_GNU_SOURCE -DGF_LINUX_HOST_OS -lpthread
+EXPECT "OK" echo $($(dirname $0)/stack-bench 4 3 14 | tail -1)
+TEST rm -f $(dirname $0)/stack-bench
+
+cleanup;
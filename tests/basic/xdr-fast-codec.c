@@ -0,0 +1,341 @@
+/*
+ * Checks that the generated codecs of the hot v4 messages produce the same
+ * bytes as rpcgen and decode back into the same messages, and measures both
+ * per message when given an iteration count.
+ *
+ * usage: xdr-fast-codec [iterations]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <glusterfs/rpc/glusterfs4-xdr.h>
+#include <glusterfs/rpc/xdr-generic.h>
+
+#define BUF_SIZE 65536
+
+static char buf_rpcgen[BUF_SIZE];
+static char buf_fast[BUF_SIZE];
+static char buf_again[BUF_SIZE];
+
+static gfx_dict_pair sample_pairs[4];
+static gfx_dirplist sample_entries[3];
+
+struct sample {
+    const char *name;
+    xdrproc_t proc;
+    void *msg;
+    size_t size;
+};
+
+static ssize_t
+rpcgen_encode(xdrproc_t proc, void *msg, char *buf, size_t len)
+{
+    XDR xdr;
+
+    xdrmem_create(&xdr, buf, len, XDR_ENCODE);
+    if (!proc(&xdr, msg, 0))
+        return -1;
+
+    return xdr_getpos(&xdr);
+}
+
+static ssize_t
+rpcgen_decode(xdrproc_t proc, void *msg, char *buf, size_t len)
+{
+    XDR xdr;
+
+    xdrmem_create(&xdr, buf, len, XDR_DECODE);
+    if (!proc(&xdr, msg, 0))
+        return -1;
+
+    return xdr_getpos(&xdr);
+}
+
+static void
+fill_iatt(gfx_iattx *iatt, int seed)
+{
+    memset(iatt, 0, sizeof(*iatt));
+    memset(iatt->ia_gfid, seed, sizeof(iatt->ia_gfid));
+    iatt->ia_ino = 0x0102030405060708ULL + seed;
+    iatt->ia_size = 4096 * seed;
+    iatt->ia_blocks = 8 * seed;
+    iatt->ia_atime = -1 - seed;
+    iatt->ia_mtime = 1700000000 + seed;
+    iatt->ia_mtime_nsec = 999999999;
+    iatt->ia_nlink = 1;
+    iatt->ia_uid = 0xfffffffe;
+    iatt->mode = 0100644;
+}
+
+static void
+fill_dict(gfx_dict *dict)
+{
+    sample_pairs[0].key.key_val = "trusted.glusterfs.dht";
+    sample_pairs[0].key.key_len = strlen(sample_pairs[0].key.key_val) + 1;
+    sample_pairs[0].value.type = GF_DATA_TYPE_STR;
+    sample_pairs[0].value.gfx_value_u.val_string.val_string_val = "abcde";
+    sample_pairs[0].value.gfx_value_u.val_string.val_string_len = 5;
+
+    sample_pairs[1].key.key_val = "link-count";
+    sample_pairs[1].key.key_len = strlen(sample_pairs[1].key.key_val) + 1;
+    sample_pairs[1].value.type = GF_DATA_TYPE_INT;
+    sample_pairs[1].value.gfx_value_u.value_int = -42;
+
+    sample_pairs[2].key.key_val = "gfid-req";
+    sample_pairs[2].key.key_len = strlen(sample_pairs[2].key.key_val) + 1;
+    sample_pairs[2].value.type = GF_DATA_TYPE_GFUUID;
+    memset(sample_pairs[2].value.gfx_value_u.uuid, 0xab, 16);
+
+    sample_pairs[3].key.key_val = "iatt";
+    sample_pairs[3].key.key_len = strlen(sample_pairs[3].key.key_val) + 1;
+    sample_pairs[3].value.type = GF_DATA_TYPE_IATT;
+    fill_iatt(&sample_pairs[3].value.gfx_value_u.iatt, 9);
+
+    dict->count = 4;
+    dict->xdr_size = 128;
+    dict->pairs.pairs_len = 4;
+    dict->pairs.pairs_val = sample_pairs;
+}
+
+static int
+check(struct sample *s)
+{
+    ssize_t len_rpcgen, len_fast, len_again;
+    size_t size;
+    void *decoded;
+    ssize_t i;
+
+    len_rpcgen = rpcgen_encode(s->proc, s->msg, buf_rpcgen, BUF_SIZE);
+    len_fast = xdr_serialize_generic(
+        (struct iovec){.iov_base = buf_fast, .iov_len = BUF_SIZE}, s->msg,
+        s->proc);
+    if ((len_rpcgen < 0) || (len_rpcgen != len_fast) ||
+        memcmp(buf_rpcgen, buf_fast, len_rpcgen)) {
+        printf("%s: encoding differs (%zd/%zd bytes)\n", s->name, len_rpcgen,
+               len_fast);
+        return -1;
+    }
+
+    size = xdr_sizeof_generic(s->proc, s->msg);
+    if (size != xdr_sizeof(s->proc, s->msg) || size != len_rpcgen) {
+        printf("%s: size differs (%zu/%zd)\n", s->name, size, len_rpcgen);
+        return -1;
+    }
+
+    /* too small a buffer fails to encode */
+    if (xdr_serialize_generic(
+            (struct iovec){.iov_base = buf_fast, .iov_len = len_rpcgen - 4},
+            s->msg, s->proc) != -1) {
+        printf("%s: encoded into a short buffer\n", s->name);
+        return -1;
+    }
+
+    decoded = calloc(1, s->size);
+    if (xdr_to_generic(
+            (struct iovec){.iov_base = buf_fast, .iov_len = len_fast}, decoded,
+            s->proc) != len_fast) {
+        printf("%s: decoding failed\n", s->name);
+        return -1;
+    }
+    len_again = rpcgen_encode(s->proc, decoded, buf_again, BUF_SIZE);
+    if ((len_again != len_rpcgen) ||
+        memcmp(buf_rpcgen, buf_again, len_rpcgen)) {
+        printf("%s: decoded message differs\n", s->name);
+        return -1;
+    }
+    xdr_free(s->proc, decoded);
+
+    /* every truncation of the message is rejected */
+    for (i = 0; i < len_fast; i += 4) {
+        memset(decoded, 0, s->size);
+        if (xdr_to_generic(
+                (struct iovec){.iov_base = buf_fast, .iov_len = i}, decoded,
+                s->proc) != -1) {
+            printf("%s: decoded a message truncated to %zd bytes\n", s->name,
+                   i);
+            return -1;
+        }
+        xdr_free(s->proc, decoded);
+    }
+    free(decoded);
+
+    return 0;
+}
+
+static double
+now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void
+bench(struct sample *s, long iterations)
+{
+    double start, rpcgen_enc, fast_enc, rpcgen_dec, fast_dec;
+    ssize_t len;
+    void *decoded;
+    long i;
+
+    decoded = calloc(1, s->size);
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        xdr_sizeof(s->proc, s->msg);
+        rpcgen_encode(s->proc, s->msg, buf_rpcgen, BUF_SIZE);
+    }
+    rpcgen_enc = (now() - start) / iterations;
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        xdr_sizeof_generic(s->proc, s->msg);
+        len = xdr_serialize_generic(
+            (struct iovec){.iov_base = buf_fast, .iov_len = BUF_SIZE}, s->msg,
+            s->proc);
+    }
+    fast_enc = (now() - start) / iterations;
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        rpcgen_decode(s->proc, decoded, buf_rpcgen, len);
+        xdr_free(s->proc, decoded);
+        memset(decoded, 0, s->size);
+    }
+    rpcgen_dec = (now() - start) / iterations;
+
+    start = now();
+    for (i = 0; i < iterations; i++) {
+        xdr_to_generic((struct iovec){.iov_base = buf_fast, .iov_len = len},
+                       decoded, s->proc);
+        xdr_free(s->proc, decoded);
+        memset(decoded, 0, s->size);
+    }
+    fast_dec = (now() - start) / iterations;
+
+    printf("%-22s %5zd bytes  encode %7.1f -> %7.1f ns  decode %7.1f -> "
+           "%7.1f ns\n",
+           s->name, len, rpcgen_enc, fast_enc, rpcgen_dec, fast_dec);
+
+    free(decoded);
+}
+
+#define SAMPLE(type, var)                                                      \
+    {                                                                          \
+        #type, (xdrproc_t)xdr_##type, &var, sizeof(type)                       \
+    }
+
+int
+main(int argc, char *argv[])
+{
+    gfx_dict dict = {
+        0,
+    };
+    gfx_lookup_req lookup_req = {
+        {0},
+    };
+    gfx_stat_req stat_req = {
+        {0},
+    };
+    gfx_readdirp_req readdirp_req = {
+        {0},
+    };
+    gfx_common_rsp common_rsp = {
+        0,
+    };
+    gfx_common_iatt_rsp iatt_rsp = {
+        0,
+    };
+    gfx_common_2iatt_rsp iatt2_rsp = {
+        0,
+    };
+    gfx_common_dict_rsp dict_rsp = {
+        0,
+    };
+    gfx_read_rsp read_rsp = {
+        0,
+    };
+    gfx_readdirp_rsp readdirp_rsp = {
+        0,
+    };
+    long iterations = 0;
+    int ret = 0;
+    int i;
+
+    if (argc > 1)
+        iterations = atol(argv[1]);
+
+    fill_dict(&dict);
+
+    memset(lookup_req.pargfid, 1, 16);
+    lookup_req.flags = 3;
+    lookup_req.bname = "a-file-name.txt";
+    fill_dict(&lookup_req.xdata);
+
+    memset(stat_req.gfid, 2, 16);
+
+    memset(readdirp_req.gfid, 3, 16);
+    readdirp_req.fd = -5;
+    readdirp_req.offset = 1ULL << 40;
+    readdirp_req.size = 131072;
+    fill_dict(&readdirp_req.xdata);
+
+    common_rsp.op_ret = -1;
+    common_rsp.op_errno = 2;
+
+    fill_iatt(&iatt_rsp.stat, 1);
+    fill_dict(&iatt_rsp.xdata);
+
+    fill_iatt(&iatt2_rsp.prestat, 2);
+    fill_iatt(&iatt2_rsp.poststat, 3);
+
+    fill_dict(&dict_rsp.dict);
+    fill_iatt(&dict_rsp.poststat, 4);
+
+    read_rsp.op_ret = 4096;
+    read_rsp.size = 4096;
+    fill_iatt(&read_rsp.stat, 5);
+
+    readdirp_rsp.op_ret = 3;
+    for (i = 0; i < 3; i++) {
+        sample_entries[i].d_ino = i + 10;
+        sample_entries[i].d_off = i + 1;
+        sample_entries[i].d_type = 8;
+        sample_entries[i].name = (i == 1) ? "" : "entry";
+        sample_entries[i].d_len = strlen(sample_entries[i].name);
+        fill_iatt(&sample_entries[i].stat, 6 + i);
+        if (i < 2)
+            sample_entries[i].nextentry = &sample_entries[i + 1];
+    }
+    fill_dict(&sample_entries[2].dict);
+    readdirp_rsp.reply = &sample_entries[0];
+
+    struct sample samples[] = {
+        SAMPLE(gfx_dict, dict),
+        SAMPLE(gfx_lookup_req, lookup_req),
+        SAMPLE(gfx_stat_req, stat_req),
+        SAMPLE(gfx_readdirp_req, readdirp_req),
+        SAMPLE(gfx_common_rsp, common_rsp),
+        SAMPLE(gfx_common_iatt_rsp, iatt_rsp),
+        SAMPLE(gfx_common_2iatt_rsp, iatt2_rsp),
+        SAMPLE(gfx_common_dict_rsp, dict_rsp),
+        SAMPLE(gfx_read_rsp, read_rsp),
+        SAMPLE(gfx_readdirp_rsp, readdirp_rsp),
+    };
+
+    for (i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        if (check(&samples[i]) != 0)
+            ret = 1;
+        else if (iterations > 0)
+            bench(&samples[i], iterations);
+    }
+
+    if (ret == 0)
+        printf("OK\n");
+
+    return ret;
+}
@@ -0,0 +1,23 @@
+#!/bin/bash
+#The generated codecs of the hot fop messages must encode exactly as rpcgen
+#does and decode back into the same messages
+
+. $(dirname $0)/../include.rc
+
+cleanup;
+
+#A short run of the microbenchmarks, rpcgen vs generated timings per message
+function run_benchmark()
+{
+    $(dirname $0)/xdr-fast-codec 1000 | tail -1
+}
+
+TEST build_tester $(dirname $0)/xdr-fast-codec.c -lgfxdr \
+     -D_GNU_SOURCE -DGF_LINUX_HOST_OS \
+     $(pkg-config --cflags --libs libtirpc 2>/dev/null)
+
+EXPECT "OK" $(dirname $0)/xdr-fast-codec
+EXPECT "OK" run_benchmark
+
+TEST rm -f $(dirname $0)/xdr-fast-codec
+cleanup;
@@ -547,8 +547,9 @@ afr_shd_full_sweep(struct subvol_healer *healer, inode_t *inode)
 
     priv = healer->this->private;
     loc.inode = inode;
-    return syncop_ftw(priv->children[healer->subvol], &loc,
-                      GF_CLIENT_PID_SELF_HEALD, healer, afr_shd_full_heal);
+    return syncop_mt_ftw(NULL, priv->children[healer->subvol], &loc,
+                         GF_CLIENT_PID_SELF_HEALD, healer, afr_shd_full_heal,
+                         priv->shd.max_threads, priv->shd.wait_qlength);
 }
 
 int
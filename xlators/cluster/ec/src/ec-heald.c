@@ -380,8 +380,9 @@ ec_shd_full_sweep(struct subvol_healer *healer, inode_t *inode)
     ec = healer->this->private;
     loc.inode = inode;
     _mask_cancellation();
-    ret = syncop_ftw(ec->xl_list[healer->subvol], &loc,
-                     GF_CLIENT_PID_SELF_HEALD, healer, ec_shd_full_heal);
+    ret = syncop_mt_ftw(NULL, ec->xl_list[healer->subvol], &loc,
+                        GF_CLIENT_PID_SELF_HEALD, healer, ec_shd_full_heal,
+                        ec->shd.max_threads, ec->shd.wait_qlength);
     _unmask_cancellation();
     return ret;
 }
@@ -38,6 +38,7 @@
 #include <grp.h>
 #include <glusterfs/upcall-utils.h>
 #include <glusterfs/async.h>
+#include <glusterfs/monitoring.h>
 
 #define MAX_LIST_MEMBERS 100
 #define DEFAULT_PWD_BUF_SZ 16384
@@ -140,6 +141,20 @@ struct ios_global_stats {
     struct timeval max_openfd_time;
 };
 
+/* Slots of the requests features/qos classified, by class. A slot is keyed
+ * by the class name the frames point at, which features/qos keeps as long
+ * as it is loaded. */
+#define IOS_QOS_CLASSES 2048
+
+struct ios_qos_stat {
+    const char *class;
+    char *name; /* own copy, for the dumps */
+    gf_atomic_t requests;
+    gf_atomic_t delayed;
+    gf_atomic_t delay_total; /* ns */
+    uint64_t delay_max;      /* ns */
+};
+
 typedef enum {
     IOS_DUMP_TYPE_NONE = 0,
     IOS_DUMP_TYPE_FILE = 1,
@@ -182,6 +197,15 @@ struct ios_conf {
      */
     char *unique_id;
     ios_dump_type_t dump_format;
+    /* live metrics, registered the first time metrics-socket is enabled */
+    gf_boolean_t metrics_socket;
+    gf_metric_t *fop_latency[GF_FOP_MAXVALUE];
+    gf_metric_t *data_read;
+    gf_metric_t *data_written;
+    /* per QoS class stats, allocated the first time a classified request
+     * shows up */
+    struct ios_qos_stat *qos_stats;
+    gf_atomic_t qos_untracked;
 };
 
 struct ios_fd {
@@ -216,6 +240,124 @@ is_fop_latency_started(call_frame_t *frame)
     return memcmp(&frame->begin, &epoch, sizeof(epoch));
 }
 
+static struct ios_qos_stat *
+ios_qos_stat_get(struct ios_conf *conf, const char *class)
+{
+    struct ios_qos_stat *stats = conf->qos_stats;
+    struct ios_qos_stat *slot = NULL;
+    uint32_t first = ((uintptr_t)class >> 4) % IOS_QOS_CLASSES;
+    uint32_t i = 0;
+    uint32_t n = 0;
+
+    if (stats) {
+        for (n = 0, i = first; n < IOS_QOS_CLASSES;
+             n++, i = (i + 1) % IOS_QOS_CLASSES) {
+            if (stats[i].class == class)
+                return &stats[i];
+            if (!stats[i].class)
+                break;
+        }
+    }
+
+    /* first request of the class, or of any class */
+    LOCK(&conf->lock);
+    {
+        if (!conf->qos_stats) {
+            conf->qos_stats = GF_CALLOC(IOS_QOS_CLASSES, sizeof(*stats),
+                                        gf_io_stats_mt_ios_qos_stat);
+            for (i = 0; conf->qos_stats && (i < IOS_QOS_CLASSES); i++) {
+                GF_ATOMIC_INIT(conf->qos_stats[i].requests, 0);
+                GF_ATOMIC_INIT(conf->qos_stats[i].delayed, 0);
+                GF_ATOMIC_INIT(conf->qos_stats[i].delay_total, 0);
+            }
+        }
+        stats = conf->qos_stats;
+
+        for (n = 0, i = first; stats && (n < IOS_QOS_CLASSES);
+             n++, i = (i + 1) % IOS_QOS_CLASSES) {
+            if (stats[i].class == class) {
+                slot = &stats[i];
+                break;
+            }
+            if (!stats[i].class) {
+                stats[i].name = gf_strdup(class);
+                if (stats[i].name) {
+                    stats[i].class = class;
+                    slot = &stats[i];
+                }
+                break;
+            }
+        }
+    }
+    UNLOCK(&conf->lock);
+
+    return slot;
+}
+
+/* Accounts a request features/qos classified, and the time it held it */
+static void
+ios_qos_update(struct ios_conf *conf, call_frame_t *frame)
+{
+    struct ios_qos_stat *slot = NULL;
+    uint64_t delay = frame->root->qos_delay;
+
+    slot = ios_qos_stat_get(conf, frame->root->qos_class);
+    if (!slot) {
+        GF_ATOMIC_INC(conf->qos_untracked);
+        return;
+    }
+
+    GF_ATOMIC_INC(slot->requests);
+    if (delay) {
+        GF_ATOMIC_INC(slot->delayed);
+        GF_ATOMIC_ADD(slot->delay_total, delay);
+        /* racing updates may lose a maximum, which is only indicative */
+        if (delay > slot->delay_max)
+            slot->delay_max = delay;
+    }
+}
+
+static void
+ios_qos_dump(struct ios_conf *conf)
+{
+    struct ios_qos_stat *slot = NULL;
+    char key[GF_DUMP_MAX_BUF_LEN];
+    uint64_t delayed = 0;
+    int i = 0;
+
+    if (!conf->qos_stats)
+        return;
+
+    LOCK(&conf->lock);
+    {
+        for (i = 0; i < IOS_QOS_CLASSES; i++) {
+            slot = &conf->qos_stats[i];
+            if (!slot->class)
+                continue;
+
+            delayed = GF_ATOMIC_GET(slot->delayed);
+            gf_proc_dump_build_key(key, "qos", "%s.requests", slot->name);
+            gf_proc_dump_write(key, "%" GF_PRI_ATOMIC,
+                               GF_ATOMIC_GET(slot->requests));
+            gf_proc_dump_build_key(key, "qos", "%s.delayed", slot->name);
+            gf_proc_dump_write(key, "%" PRIu64, delayed);
+            gf_proc_dump_build_key(key, "qos", "%s.delay_avg_usec",
+                                   slot->name);
+            gf_proc_dump_write(
+                key, "%" PRIu64,
+                delayed ? GF_ATOMIC_GET(slot->delay_total) / delayed / 1000
+                        : 0);
+            gf_proc_dump_build_key(key, "qos", "%s.delay_max_usec",
+                                   slot->name);
+            gf_proc_dump_write(key, "%" PRIu64, slot->delay_max / 1000);
+        }
+    }
+    UNLOCK(&conf->lock);
+
+    gf_proc_dump_write("qos.untracked", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(conf->qos_untracked));
+}
+
 #define _IOS_SAMP_DIR DEFAULT_LOG_FILE_DIRECTORY "/samples"
 #ifdef GF_LINUX_HOST_OS
 #define _IOS_DUMP_DIR DATADIR "/lib/glusterd/stats"
@@ -261,9 +403,11 @@ is_fop_latency_started(call_frame_t *frame)
     do {                                                                       \
         struct ios_conf *conf = NULL;                                          \
                                                                                \
+        conf = this->private;                                                  \
+        if (conf && frame->root->qos_class)                                    \
+            ios_qos_update(conf, frame);                                       \
         if (!is_fop_latency_started(frame))                                    \
             break;                                                             \
-        conf = this->private;                                                  \
         if (conf && conf->measure_latency && conf->count_fop_hits) {           \
             BUMP_FOP(op);                                                      \
             timespec_now(&frame->end);                                         \
@@ -1858,6 +2002,87 @@ update_ios_latency(struct ios_conf *conf, call_frame_t *frame,
     update_ios_latency_stats(&conf->incremental, elapsed, op);
     collect_ios_latency_sample(conf, op, elapsed, frame);
 
+    if (conf->metrics_socket && conf->fop_latency[op])
+        gf_metric_observe(conf->fop_latency[op], elapsed / 1000);
+
+    return 0;
+}
+
+static void
+ios_metrics_unregister(struct ios_conf *conf)
+{
+    int i = 0;
+
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        gf_metric_unregister(conf->fop_latency[i]);
+        conf->fop_latency[i] = NULL;
+    }
+    gf_metric_unregister(conf->data_read);
+    conf->data_read = NULL;
+    gf_metric_unregister(conf->data_written);
+    conf->data_written = NULL;
+}
+
+static int
+ios_metrics_register(xlator_t *this, struct ios_conf *conf)
+{
+    char labels[512];
+    char name[256];
+    int i = 0;
+
+    if (conf->data_read)
+        return 0;
+
+    gf_metric_label_escape(name, sizeof(name), this->name);
+    snprintf(labels, sizeof(labels), "xlator=\"%s\"", name);
+    conf->data_read = gf_metric_register_fn(
+        "gluster_read_bytes_total", labels, "Bytes read through the volume",
+        GF_METRIC_COUNTER, gf_metric_read_atomic, &conf->cumulative.data_read);
+    conf->data_written = gf_metric_register_fn(
+        "gluster_written_bytes_total", labels,
+        "Bytes written through the volume", GF_METRIC_COUNTER,
+        gf_metric_read_atomic, &conf->cumulative.data_written);
+    if (!conf->data_read || !conf->data_written)
+        goto err;
+
+    /* fed from update_ios_latency(), so only while latency-measurement is
+     * on */
+    for (i = GF_FOP_NULL + 1; i < GF_FOP_MAXVALUE; i++) {
+        snprintf(labels, sizeof(labels), "xlator=\"%s\",fop=\"%s\"", name,
+                 gf_fop_list[i]);
+        conf->fop_latency[i] = gf_metric_register(
+            "gluster_fop_latency_microseconds", labels,
+            "Latency of fops seen by io-stats", GF_METRIC_HISTOGRAM);
+        if (!conf->fop_latency[i])
+            goto err;
+    }
+
+    return 0;
+err:
+    gf_log(this->name, GF_LOG_ERROR, "failed to register metrics");
+    ios_metrics_unregister(conf);
+    return -1;
+}
+
+/* The metrics stay registered once created, the fop path may be updating
+ * them while the option is turned off. They go away in ios_conf_destroy(). */
+static int
+ios_set_metrics_socket(xlator_t *this, struct ios_conf *conf,
+                       gf_boolean_t enable)
+{
+    if (enable == conf->metrics_socket)
+        return 0;
+
+    if (enable) {
+        if (ios_metrics_register(this, conf))
+            return -1;
+        if (gf_metrics_server_start(this->ctx))
+            return -1;
+    } else {
+        gf_metrics_server_stop();
+    }
+
+    conf->metrics_socket = enable;
     return 0;
 }
 
@@ -3697,6 +3922,8 @@ io_priv(xlator_t *this)
     if (!conf)
         return -1;
 
+    ios_qos_dump(conf);
+
     if (!conf->count_fop_hits || !conf->measure_latency)
         return -1;
 
@@ -3852,6 +4079,8 @@ reconfigure(xlator_t *this, dict_t *options)
     int logger = -1;
     uint32_t log_buf_size = 0;
     time_t log_flush_timeout = 0;
+    gf_boolean_t log_async = _gf_false;
+    gf_boolean_t metrics_socket = _gf_false;
     int32_t old_dump_interval;
     int32_t threads;
 
@@ -3868,6 +4097,12 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("latency-measurement", conf->measure_latency, options,
                      bool, out);
 
+    GF_OPTION_RECONF("metrics-socket", metrics_socket, options, bool, out);
+    ret = ios_set_metrics_socket(this, conf, metrics_socket);
+    if (ret)
+        goto out;
+    ret = -1;
+
     old_dump_interval = conf->ios_dump_interval;
     GF_OPTION_RECONF("ios-dump-interval", conf->ios_dump_interval, options,
                      int32, out);
@@ -3931,6 +4166,9 @@ reconfigure(xlator_t *this, dict_t *options)
                      out);
     gf_log_set_log_flush_timeout(log_flush_timeout);
 
+    GF_OPTION_RECONF("log-async", log_async, options, bool, out);
+    gf_log_set_async(log_async);
+
     GF_OPTION_RECONF("threads", threads, options, int32, out);
     gf_async_adjust_threads(threads);
 
@@ -3974,12 +4212,20 @@ gf_dnscache_deinit(struct dnscache *cache)
 void
 ios_conf_destroy(struct ios_conf *conf)
 {
+    int i = 0;
+
     if (!conf)
         return;
 
+    if (conf->metrics_socket)
+        gf_metrics_server_stop();
+    ios_metrics_unregister(conf);
     ios_destroy_top_stats(conf);
     _ios_destroy_dump_thread(conf);
     ios_destroy_sample_buf(conf->ios_sample_buf);
+    for (i = 0; conf->qos_stats && (i < IOS_QOS_CLASSES); i++)
+        GF_FREE(conf->qos_stats[i].name);
+    GF_FREE(conf->qos_stats);
     LOCK_DESTROY(&conf->lock);
     if (conf->dnscache)
         gf_dnscache_deinit(conf->dnscache);
@@ -4051,6 +4297,8 @@ init(xlator_t *this)
     int ret = -1;
     uint32_t log_buf_size = 0;
     time_t log_flush_timeout = 0;
+    gf_boolean_t log_async = _gf_false;
+    gf_boolean_t metrics_socket = _gf_false;
     int32_t threads;
 
     if (!this)
@@ -4093,6 +4341,7 @@ init(xlator_t *this)
 
     ios_init_stats(&conf->cumulative);
     ios_init_stats(&conf->incremental);
+    GF_ATOMIC_INIT(conf->qos_untracked, 0);
 
     ret = ios_init_top_stats(conf);
     if (ret)
@@ -4104,6 +4353,11 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("latency-measurement", conf->measure_latency, bool, out);
 
+    GF_OPTION_INIT("metrics-socket", metrics_socket, bool, out);
+    ret = ios_set_metrics_socket(this, conf, metrics_socket);
+    if (ret)
+        goto out;
+
     GF_OPTION_INIT("ios-dump-interval", conf->ios_dump_interval, int32, out);
 
     GF_OPTION_INIT("ios-sample-interval", conf->ios_sample_interval, int32,
@@ -4164,6 +4418,9 @@ init(xlator_t *this)
     GF_OPTION_INIT("log-flush-timeout", log_flush_timeout, time, out);
     gf_log_set_log_flush_timeout(log_flush_timeout);
 
+    GF_OPTION_INIT("log-async", log_async, bool, out);
+    gf_log_set_async(log_async);
+
     GF_OPTION_INIT("threads", threads, int32, out);
     gf_async_adjust_threads(threads);
 
@@ -4603,6 +4860,30 @@ struct volume_options options[] = {
      .description = "This option determines the maximum number of unique "
                     "log messages that can be buffered for a time equal to"
                     " the value of the option brick-log-flush-timeout."},
+    {.key = {"log-async"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-stats"},
+     .description = "If enabled, log messages are queued in per-thread "
+                    "buffers and written to the log file by a separate "
+                    "thread, so that logging never blocks the caller. When "
+                    "messages come faster than they can be written, the "
+                    "excess is dropped and the number dropped is logged."},
+    {.key = {"metrics-socket"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-stats"},
+     .description = "If enabled, the process serves live metrics (fop "
+                    "counts, fop latency histograms, cache and queue "
+                    "counters registered by translators) in the Prometheus "
+                    "text format on the unix socket "
+                    "gmetrics.<pid>.sock in the metrics directory. Reading "
+                    "them takes no locks on the fop path. Latency "
+                    "histograms need latency-measurement to be on."},
     {.key = {"unique-id"},
      .type = GF_OPTION_TYPE_STR,
      .default_value = "/no/such/path",
@@ -0,0 +1,23 @@
+/*
+   Copyright (c) 2024 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+
+#ifndef __QOS_MEM_TYPES_H__
+#define __QOS_MEM_TYPES_H__
+
+#include <glusterfs/mem-types.h>
+
+enum gf_qos_mem_types_ {
+    gf_qos_mt_conf_t = gf_common_mt_end + 1,
+    gf_qos_mt_class_t,
+    gf_qos_mt_rule_t,
+    gf_qos_mt_req_t,
+    gf_qos_mt_end
+};
+#endif
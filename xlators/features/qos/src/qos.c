@@ -0,0 +1,1416 @@
+/*
+  Copyright (c) 2024 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Brick side QoS: the requests are sorted into classes (by client, uid, gid
+ * or namespace), each with an IOPS and a bandwidth token bucket and a
+ * weight. A request whose class has nothing queued and tokens left, in its
+ * buckets and in the brick wide ones, goes down right away; the others wait
+ * for the scheduler thread, which serves the classes by deficit round robin
+ * so that they share the brick in proportion to their weights. */
+
+#include <fnmatch.h>
+
+#include <glusterfs/defaults.h>
+#include <glusterfs/client_t.h>
+#include <glusterfs/hashfn.h>
+#include <glusterfs/statedump.h>
+#include <glusterfs/timespec.h>
+
+#include "qos.h"
+
+enum {
+    QOS_TAKEN,
+    QOS_CLASS_EMPTY,
+    QOS_BRICK_EMPTY,
+};
+
+static char *qos_class_by_names[] = {
+    [QOS_CLASS_BY_CLIENT] = "client",
+    [QOS_CLASS_BY_UID] = "uid",
+    [QOS_CLASS_BY_GID] = "gid",
+    [QOS_CLASS_BY_NAMESPACE] = "namespace",
+};
+
+#define QOS_FOP(name, frame, this, bytes, args...)                             \
+    do {                                                                       \
+        call_stub_t *__stub = NULL;                                            \
+        qos_class_t *__class = NULL;                                           \
+                                                                               \
+        if (qos_admit(this, frame, bytes, &__class)) {                         \
+            STACK_WIND_TAIL(frame, FIRST_CHILD(this),                          \
+                            FIRST_CHILD(this)->fops->name, args);              \
+            break;                                                             \
+        }                                                                      \
+                                                                               \
+        __stub = fop_##name##_stub(frame, default_##name##_resume, args);      \
+        if (qos_enqueue(this, __class, __stub, bytes) < 0) {                   \
+            default_##name##_failure_cbk(frame, ENOMEM);                       \
+            if (__stub != NULL)                                                \
+                call_stub_destroy(__stub);                                     \
+        }                                                                      \
+    } while (0)
+
+static uint64_t
+qos_now(void)
+{
+    struct timespec now;
+
+    timespec_now(&now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static void
+qos_bucket_set(qos_bucket_t *bucket, uint64_t rate, uint64_t now)
+{
+    gf_boolean_t was_limited = (bucket->rate != 0);
+
+    /* a tenth of a second worth of tokens, and room for one request */
+    bucket->rate = rate;
+    bucket->burst = max(rate / 10.0, 1.0);
+    if (!was_limited || bucket->tokens > bucket->burst)
+        bucket->tokens = bucket->burst;
+    bucket->last = now;
+}
+
+static void
+qos_bucket_refill(qos_bucket_t *bucket, uint64_t now)
+{
+    if (!bucket->rate || now <= bucket->last)
+        return;
+
+    bucket->tokens += (double)(now - bucket->last) * bucket->rate / 1e9;
+    if (bucket->tokens > bucket->burst)
+        bucket->tokens = bucket->burst;
+    bucket->last = now;
+}
+
+static gf_boolean_t
+qos_bucket_ready(qos_bucket_t *bucket, uint64_t cost)
+{
+    if (!bucket->rate || !cost)
+        return _gf_true;
+
+    return bucket->tokens >= min((double)cost, bucket->burst);
+}
+
+static void
+qos_bucket_take(qos_bucket_t *bucket, uint64_t cost)
+{
+    if (bucket->rate)
+        bucket->tokens -= cost;
+}
+
+/* Called with conf->lock held */
+static int
+qos_take(qos_conf_t *conf, qos_class_t *class, uint64_t bytes, uint64_t now)
+{
+    if (!conf->limited || conf->draining)
+        return QOS_TAKEN;
+
+    qos_bucket_refill(&conf->brick_iops, now);
+    qos_bucket_refill(&conf->brick_bandwidth, now);
+    if (!qos_bucket_ready(&conf->brick_iops, 1) ||
+        !qos_bucket_ready(&conf->brick_bandwidth, bytes))
+        return QOS_BRICK_EMPTY;
+
+    qos_bucket_refill(&class->iops, now);
+    qos_bucket_refill(&class->bandwidth, now);
+    if (!qos_bucket_ready(&class->iops, 1) ||
+        !qos_bucket_ready(&class->bandwidth, bytes))
+        return QOS_CLASS_EMPTY;
+
+    qos_bucket_take(&conf->brick_iops, 1);
+    qos_bucket_take(&conf->brick_bandwidth, bytes);
+    qos_bucket_take(&class->iops, 1);
+    qos_bucket_take(&class->bandwidth, bytes);
+
+    return QOS_TAKEN;
+}
+
+/* Called with conf->lock held */
+static void
+qos_class_limits(qos_conf_t *conf, qos_class_t *class, uint64_t now)
+{
+    qos_rule_t *rule = NULL;
+
+    class->limits = conf->defaults;
+    list_for_each_entry(rule, &conf->rules, list)
+    {
+        if (fnmatch(rule->pattern, class->name, 0) == 0) {
+            class->limits = rule->limits;
+            break;
+        }
+    }
+
+    qos_bucket_set(&class->iops, class->limits.iops, now);
+    qos_bucket_set(&class->bandwidth, class->limits.bandwidth, now);
+}
+
+static qos_class_t *
+qos_class_new(qos_conf_t *conf, qos_class_by_t by, uint64_t key,
+              const char *name)
+{
+    qos_class_t *class = NULL;
+
+    class = GF_CALLOC(1, sizeof(*class), gf_qos_mt_class_t);
+    if (!class)
+        return NULL;
+
+    class->name = gf_strdup(name);
+    if (!class->name) {
+        GF_FREE(class);
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&class->hash);
+    INIT_LIST_HEAD(&class->active);
+    INIT_LIST_HEAD(&class->queue);
+    class->by = by;
+    class->key = key;
+    qos_class_limits(conf, class, qos_now());
+
+    return class;
+}
+
+/* Called with conf->lock held. Classes are only freed by fini, which lets
+ * frames, clients and io-stats point at them; the classes of another
+ * class-by wait on conf->retired. */
+static qos_class_t *
+qos_class_find(qos_conf_t *conf, qos_class_by_t by, uint64_t key,
+               const char *name)
+{
+    struct list_head *head = &conf->classes[key % QOS_CLASS_BUCKETS];
+    qos_class_t *class = NULL;
+
+    list_for_each_entry(class, head, hash)
+    {
+        if ((class->by == by) && (class->key == key) &&
+            (strcmp(class->name, name) == 0))
+            return class;
+    }
+
+    if (conf->nr_classes >= conf->max_classes)
+        return conf->overflow;
+
+    class = qos_class_new(conf, by, key, name);
+    if (!class)
+        return conf->overflow;
+
+    list_add(&class->hash, head);
+    conf->nr_classes++;
+
+    return class;
+}
+
+/* Called with conf->lock held */
+static qos_class_t *
+qos_classify(xlator_t *this, qos_conf_t *conf, call_frame_t *frame)
+{
+    client_t *client = frame->root->client;
+    qos_class_t *class = NULL;
+    qos_rule_t *rule = NULL;
+    char name[1024] = "internal";
+    const char *recon = NULL;
+    uint64_t key = 0;
+    int len = 0;
+
+    switch (conf->class_by) {
+        case QOS_CLASS_BY_CLIENT:
+            if (!client)
+                break;
+
+            if ((client_ctx_get(client, this, (void **)&class) == 0) &&
+                class &&
+                ((class->by == QOS_CLASS_BY_CLIENT) ||
+                 (class == conf->overflow)))
+                return class;
+
+            /* the same client keeps its class across reconnections */
+            len = strlen(client->client_uid);
+            recon = strstr(client->client_uid, "-RECON_NO:");
+            if (recon)
+                len = recon - client->client_uid;
+            snprintf(name, sizeof(name), "%.*s", len, client->client_uid);
+            key = SuperFastHash(name, strlen(name));
+            class = qos_class_find(conf, QOS_CLASS_BY_CLIENT, key, name);
+            client_ctx_set(client, this, class);
+            return class;
+
+        case QOS_CLASS_BY_UID:
+            key = frame->root->uid;
+            snprintf(name, sizeof(name), "%u", frame->root->uid);
+            break;
+
+        case QOS_CLASS_BY_GID:
+            key = frame->root->gid;
+            snprintf(name, sizeof(name), "%u", frame->root->gid);
+            break;
+
+        case QOS_CLASS_BY_NAMESPACE:
+            if (!frame->root->ns_info.found) {
+                snprintf(name, sizeof(name), "unknown");
+                break;
+            }
+
+            key = frame->root->ns_info.hash;
+            snprintf(name, sizeof(name), "%08" PRIx64, key);
+            list_for_each_entry(rule, &conf->rules, list)
+            {
+                if (rule->ns_hash == key) {
+                    snprintf(name, sizeof(name), "%s", rule->pattern);
+                    break;
+                }
+            }
+            break;
+    }
+
+    return qos_class_find(conf, conf->class_by, key, name);
+}
+
+/* Classifies the request, and lets it through if its class has nothing
+ * queued and tokens are left. Otherwise a place is reserved for it in the
+ * queue of the class, which qos_enqueue() fills. */
+static gf_boolean_t
+qos_admit(xlator_t *this, call_frame_t *frame, uint64_t bytes,
+          qos_class_t **classp)
+{
+    qos_conf_t *conf = this->private;
+    qos_class_t *class = NULL;
+    gf_boolean_t admit = _gf_false;
+
+    /* Nothing is limited: the requests still queued from before drain
+     * through the scheduler, new ones need not wait behind them. The
+     * racy read at worst classifies a request or two more or less. */
+    if (!CMM_LOAD_SHARED(conf->limited)) {
+        *classp = NULL;
+        return _gf_true;
+    }
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        class = qos_classify(this, conf, frame);
+        class->requests++;
+        class->bytes += bytes;
+        frame->root->qos_class = class->name;
+
+        if (!class->queued &&
+            (qos_take(conf, class, bytes, qos_now()) == QOS_TAKEN)) {
+            admit = _gf_true;
+        } else {
+            class->queued++;
+            conf->backlog++;
+        }
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    *classp = class;
+    return admit;
+}
+
+static int
+qos_enqueue(xlator_t *this, qos_class_t *class, call_stub_t *stub,
+            uint64_t bytes)
+{
+    qos_conf_t *conf = this->private;
+    qos_req_t *req = NULL;
+
+    if (stub)
+        req = GF_MALLOC(sizeof(*req), gf_qos_mt_req_t);
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        if (!req) {
+            class->queued--;
+            conf->backlog--;
+            goto unlock;
+        }
+
+        INIT_LIST_HEAD(&req->list);
+        req->stub = stub;
+        req->bytes = bytes;
+        req->queued = qos_now();
+        list_add_tail(&req->list, &class->queue);
+
+        if (list_empty(&class->active)) {
+            list_add_tail(&class->active, &conf->active);
+            pthread_cond_signal(&conf->cond);
+        }
+    }
+unlock:
+    pthread_mutex_unlock(&conf->lock);
+
+    return req ? 0 : -ENOMEM;
+}
+
+/* Starts the next round with the class the brick ran out of tokens on, so
+ * that the classes ahead of it are not always served first */
+static void
+qos_rotate(qos_conf_t *conf, qos_class_t *class)
+{
+    qos_class_t *first = NULL;
+
+    while ((first = list_first_entry(&conf->active, qos_class_t, active)) !=
+           class)
+        list_move_tail(&first->active, &conf->active);
+}
+
+/* Called with conf->lock held. Moves the requests that can go down to
+ * @ready, by deficit round robin over the classes with requests queued. */
+static void
+qos_dispatch(qos_conf_t *conf, struct list_head *ready)
+{
+    qos_class_t *class = NULL;
+    qos_class_t *tmp = NULL;
+    qos_req_t *req = NULL;
+    uint64_t now = qos_now();
+    uint64_t delay = 0;
+    int64_t cost = 0;
+    gf_boolean_t progress = _gf_false;
+    int ret = 0;
+
+    do {
+        progress = _gf_false;
+
+        list_for_each_entry_safe(class, tmp, &conf->active, active)
+        {
+            if (!list_empty(&class->queue)) {
+                req = list_first_entry(&class->queue, qos_req_t, list);
+                if (class->deficit < QOS_OP_COST + (int64_t)req->bytes) {
+                    class->deficit += (int64_t)class->limits.weight *
+                                      QOS_QUANTUM;
+                    progress = _gf_true;
+                }
+            }
+
+            while (!list_empty(&class->queue)) {
+                req = list_first_entry(&class->queue, qos_req_t, list);
+                cost = QOS_OP_COST + req->bytes;
+                if ((class->deficit < cost) && !conf->draining)
+                    break;
+
+                ret = qos_take(conf, class, req->bytes, now);
+                if (ret == QOS_BRICK_EMPTY) {
+                    qos_rotate(conf, class);
+                    return;
+                }
+                if (ret == QOS_CLASS_EMPTY)
+                    break;
+
+                list_move_tail(&req->list, ready);
+                class->deficit -= cost;
+                class->queued--;
+                conf->backlog--;
+
+                delay = now - req->queued;
+                class->delayed++;
+                class->delay_total += delay;
+                if (delay > class->delay_max)
+                    class->delay_max = delay;
+                req->stub->frame->root->qos_delay = delay;
+                progress = _gf_true;
+            }
+
+            if (list_empty(&class->queue)) {
+                class->deficit = 0;
+                list_del_init(&class->active);
+            }
+        }
+    } while (progress);
+}
+
+static void *
+qos_scheduler(void *data)
+{
+    xlator_t *this = data;
+    qos_conf_t *conf = this->private;
+    struct list_head ready;
+    struct timespec tick;
+    qos_req_t *req = NULL;
+    qos_req_t *tmp = NULL;
+
+    THIS = this;
+
+    pthread_mutex_lock(&conf->lock);
+    while (conf->running || !list_empty(&conf->active)) {
+        INIT_LIST_HEAD(&ready);
+        qos_dispatch(conf, &ready);
+
+        if (!list_empty(&ready)) {
+            pthread_mutex_unlock(&conf->lock);
+            list_for_each_entry_safe(req, tmp, &ready, list)
+            {
+                list_del_init(&req->list);
+                call_resume(req->stub);
+                GF_FREE(req);
+            }
+            pthread_mutex_lock(&conf->lock);
+            continue;
+        }
+
+        if (list_empty(&conf->active)) {
+            if (conf->running)
+                pthread_cond_wait(&conf->cond, &conf->lock);
+            continue;
+        }
+
+        /* requests are waiting for tokens */
+        timespec_now_realtime(&tick);
+        tick.tv_nsec += QOS_TICK_NS;
+        if (tick.tv_nsec >= 1000000000) {
+            tick.tv_sec++;
+            tick.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait(&conf->cond, &conf->lock, &tick);
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    return NULL;
+}
+
+static void
+qos_rules_free(struct list_head *rules)
+{
+    qos_rule_t *rule = NULL;
+    qos_rule_t *tmp = NULL;
+
+    list_for_each_entry_safe(rule, tmp, rules, list)
+    {
+        list_del(&rule->list);
+        GF_FREE(rule->pattern);
+        GF_FREE(rule);
+    }
+}
+
+/* class-limits is a comma separated list of
+ * <pattern>=<field>[/<field>...], a field being iops:<n>, bw:<size> or
+ * weight:<n>. What a rule does not set comes from the defaults. */
+static int
+qos_rules_parse(xlator_t *this, const char *str, qos_limits_t *defaults,
+                struct list_head *rules)
+{
+    qos_rule_t *rule = NULL;
+    char *dup = NULL;
+    char *entry = NULL;
+    char *field = NULL;
+    char *value = NULL;
+    char *save = NULL;
+    char *fsave = NULL;
+    char *eq = NULL;
+    int ret = -1;
+
+    dup = gf_strdup(str);
+    if (!dup)
+        goto out;
+
+    for (entry = strtok_r(dup, ",", &save); entry;
+         entry = strtok_r(NULL, ",", &save)) {
+        eq = strrchr(entry, '=');
+        if (!eq) {
+            gf_log(this->name, GF_LOG_ERROR, "no limits in '%s'", entry);
+            goto out;
+        }
+        *eq = '\0';
+        entry = gf_trim(entry);
+        if (!*entry) {
+            gf_log(this->name, GF_LOG_ERROR, "empty class pattern");
+            goto out;
+        }
+
+        rule = GF_CALLOC(1, sizeof(*rule), gf_qos_mt_rule_t);
+        if (!rule)
+            goto out;
+        rule->pattern = gf_strdup(entry);
+        if (!rule->pattern) {
+            GF_FREE(rule);
+            goto out;
+        }
+        rule->ns_hash = SuperFastHash(rule->pattern, strlen(rule->pattern));
+        rule->limits = *defaults;
+        list_add_tail(&rule->list, rules);
+
+        for (field = strtok_r(eq + 1, "/", &fsave); field;
+             field = strtok_r(NULL, "/", &fsave)) {
+            value = strchr(field, ':');
+            if (value)
+                *value++ = '\0';
+            field = gf_trim(field);
+
+            if (!value) {
+                ret = -1;
+            } else if (strcmp(field, "iops") == 0) {
+                ret = gf_string2uint64(value, &rule->limits.iops);
+            } else if (strcmp(field, "bw") == 0) {
+                ret = gf_string2bytesize_uint64(value,
+                                                &rule->limits.bandwidth);
+            } else if (strcmp(field, "weight") == 0) {
+                ret = gf_string2uint32(value, &rule->limits.weight);
+                if (!ret && !rule->limits.weight)
+                    ret = -1;
+            } else {
+                ret = -1;
+            }
+
+            if (ret) {
+                gf_log(this->name, GF_LOG_ERROR,
+                       "invalid limit '%s' for class '%s'", field,
+                       rule->pattern);
+                goto out;
+            }
+        }
+    }
+
+    ret = 0;
+out:
+    GF_FREE(dup);
+    return ret;
+}
+
+static int
+qos_class_by_parse(const char *str, qos_class_by_t *by)
+{
+    int i = 0;
+
+    for (i = 0; i < sizeof(qos_class_by_names) / sizeof(char *); i++) {
+        if (strcmp(str, qos_class_by_names[i]) == 0) {
+            *by = i;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/* Called with conf->lock held. Takes the classes of another kind out of
+ * the table and its count, and brings back those of @by seen before. */
+static void
+qos_classes_switch(qos_conf_t *conf, qos_class_by_t by)
+{
+    qos_class_t *class = NULL;
+    qos_class_t *tmp = NULL;
+    int i = 0;
+
+    for (i = 0; i < QOS_CLASS_BUCKETS; i++) {
+        list_for_each_entry_safe(class, tmp, &conf->classes[i], hash)
+        {
+            if (class->by == by)
+                continue;
+            list_move(&class->hash, &conf->retired);
+            conf->nr_classes--;
+        }
+    }
+
+    list_for_each_entry_safe(class, tmp, &conf->retired, hash)
+    {
+        if (class->by != by)
+            continue;
+        list_move(&class->hash, &conf->classes[class->key % QOS_CLASS_BUCKETS]);
+        conf->nr_classes++;
+    }
+}
+
+/* Called with conf->lock held, applies the options read by init or
+ * reconfigure to the brick and to the classes already seen */
+static int
+qos_configure(xlator_t *this, qos_conf_t *conf, const char *class_by,
+              const char *class_limits, qos_limits_t *brick,
+              qos_limits_t *defaults, uint32_t max_classes)
+{
+    struct list_head rules;
+    qos_class_by_t by = QOS_CLASS_BY_CLIENT;
+    qos_class_t *class = NULL;
+    qos_rule_t *rule = NULL;
+    uint64_t now = qos_now();
+    gf_boolean_t limited = _gf_false;
+    int i = 0;
+
+    INIT_LIST_HEAD(&rules);
+
+    if (qos_class_by_parse(class_by, &by) < 0) {
+        gf_log(this->name, GF_LOG_ERROR, "invalid class-by '%s'", class_by);
+        return -1;
+    }
+
+    if (qos_rules_parse(this, class_limits, defaults, &rules) < 0) {
+        qos_rules_free(&rules);
+        return -1;
+    }
+
+    qos_rules_free(&conf->rules);
+    list_splice_init(&rules, &conf->rules);
+
+    if (conf->class_by != by) {
+        gf_log(this->name, GF_LOG_INFO, "classifying requests by %s",
+               class_by);
+        qos_classes_switch(conf, by);
+    }
+    conf->class_by = by;
+    conf->defaults = *defaults;
+    conf->max_classes = max_classes;
+
+    qos_bucket_set(&conf->brick_iops, brick->iops, now);
+    qos_bucket_set(&conf->brick_bandwidth, brick->bandwidth, now);
+
+    limited = brick->iops || brick->bandwidth || defaults->iops ||
+              defaults->bandwidth;
+    list_for_each_entry(rule, &conf->rules, list)
+    {
+        if (rule->limits.iops || rule->limits.bandwidth)
+            limited = _gf_true;
+    }
+    CMM_STORE_SHARED(conf->limited, limited);
+
+    if (conf->overflow)
+        qos_class_limits(conf, conf->overflow, now);
+    for (i = 0; i < QOS_CLASS_BUCKETS; i++) {
+        list_for_each_entry(class, &conf->classes[i], hash)
+        {
+            qos_class_limits(conf, class, now);
+        }
+    }
+
+    /* the new limits may let waiting requests through */
+    pthread_cond_signal(&conf->cond);
+
+    return 0;
+}
+
+int32_t
+mem_acct_init(xlator_t *this)
+{
+    int ret = -1;
+
+    if (!this)
+        return ret;
+
+    ret = xlator_mem_acct_init(this, gf_qos_mt_end);
+
+    return ret;
+}
+
+int
+reconfigure(xlator_t *this, dict_t *options)
+{
+    qos_conf_t *conf = this->private;
+    qos_limits_t brick = {
+        0,
+    };
+    qos_limits_t defaults = {
+        0,
+    };
+    uint32_t max_classes = 0;
+    char *class_by = NULL;
+    char *class_limits = NULL;
+    int ret = -1;
+
+    GF_OPTION_RECONF("class-by", class_by, options, str, out);
+    GF_OPTION_RECONF("class-limits", class_limits, options, str, out);
+    GF_OPTION_RECONF("brick-iops", brick.iops, options, uint64, out);
+    GF_OPTION_RECONF("brick-bandwidth", brick.bandwidth, options,
+                     size_uint64, out);
+    GF_OPTION_RECONF("default-iops", defaults.iops, options, uint64, out);
+    GF_OPTION_RECONF("default-bandwidth", defaults.bandwidth, options,
+                     size_uint64, out);
+    GF_OPTION_RECONF("default-weight", defaults.weight, options, uint32, out);
+    GF_OPTION_RECONF("max-classes", max_classes, options, uint32, out);
+    GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        ret = qos_configure(this, conf, class_by, class_limits, &brick,
+                            &defaults, max_classes);
+    }
+    pthread_mutex_unlock(&conf->lock);
+out:
+    return ret;
+}
+
+int
+init(xlator_t *this)
+{
+    qos_conf_t *conf = NULL;
+    qos_limits_t brick = {
+        0,
+    };
+    qos_limits_t defaults = {
+        0,
+    };
+    uint32_t max_classes = 0;
+    char *class_by = NULL;
+    char *class_limits = NULL;
+    int ret = -1;
+    int i = 0;
+
+    if (!this->children || this->children->next) {
+        gf_log(this->name, GF_LOG_ERROR,
+               "qos translator requires exactly one child");
+        goto out;
+    }
+
+    conf = GF_CALLOC(1, sizeof(*conf), gf_qos_mt_conf_t);
+    if (!conf)
+        goto out;
+
+    pthread_mutex_init(&conf->lock, NULL);
+    pthread_cond_init(&conf->cond, NULL);
+    INIT_LIST_HEAD(&conf->rules);
+    INIT_LIST_HEAD(&conf->active);
+    INIT_LIST_HEAD(&conf->retired);
+    for (i = 0; i < QOS_CLASS_BUCKETS; i++)
+        INIT_LIST_HEAD(&conf->classes[i]);
+
+    GF_OPTION_INIT("class-by", class_by, str, out);
+    GF_OPTION_INIT("class-limits", class_limits, str, out);
+    GF_OPTION_INIT("brick-iops", brick.iops, uint64, out);
+    GF_OPTION_INIT("brick-bandwidth", brick.bandwidth, size_uint64, out);
+    GF_OPTION_INIT("default-iops", defaults.iops, uint64, out);
+    GF_OPTION_INIT("default-bandwidth", defaults.bandwidth, size_uint64, out);
+    GF_OPTION_INIT("default-weight", defaults.weight, uint32, out);
+    GF_OPTION_INIT("max-classes", max_classes, uint32, out);
+    GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
+
+    ret = qos_configure(this, conf, class_by, class_limits, &brick, &defaults,
+                        max_classes);
+    if (ret)
+        goto out;
+
+    ret = -1;
+    conf->overflow = qos_class_new(conf, conf->class_by, 0,
+                                   QOS_OVERFLOW_CLASS);
+    if (!conf->overflow)
+        goto out;
+
+    this->private = conf;
+    conf->running = _gf_true;
+    ret = gf_thread_create(&conf->scheduler, NULL, qos_scheduler, this,
+                           "qossched");
+    if (ret) {
+        gf_log(this->name, GF_LOG_ERROR, "failed to start the scheduler");
+        this->private = NULL;
+        goto out;
+    }
+
+    ret = 0;
+out:
+    if (ret && conf) {
+        qos_rules_free(&conf->rules);
+        if (conf->overflow) {
+            GF_FREE(conf->overflow->name);
+            GF_FREE(conf->overflow);
+        }
+        pthread_cond_destroy(&conf->cond);
+        pthread_mutex_destroy(&conf->lock);
+        GF_FREE(conf);
+    }
+    return ret;
+}
+
+void
+fini(xlator_t *this)
+{
+    qos_conf_t *conf = this->private;
+    qos_class_t *class = NULL;
+    qos_class_t *tmp = NULL;
+    int i = 0;
+
+    if (!conf)
+        return;
+
+    /* the scheduler lets the requests still queued go before leaving */
+    pthread_mutex_lock(&conf->lock);
+    {
+        conf->running = _gf_false;
+        conf->draining = _gf_true;
+        pthread_cond_signal(&conf->cond);
+    }
+    pthread_mutex_unlock(&conf->lock);
+    pthread_join(conf->scheduler, NULL);
+
+    this->private = NULL;
+
+    for (i = 0; i < QOS_CLASS_BUCKETS; i++) {
+        list_for_each_entry_safe(class, tmp, &conf->classes[i], hash)
+        {
+            list_del(&class->hash);
+            GF_FREE(class->name);
+            GF_FREE(class);
+        }
+    }
+    list_for_each_entry_safe(class, tmp, &conf->retired, hash)
+    {
+        list_del(&class->hash);
+        GF_FREE(class->name);
+        GF_FREE(class);
+    }
+    GF_FREE(conf->overflow->name);
+    GF_FREE(conf->overflow);
+    qos_rules_free(&conf->rules);
+
+    pthread_cond_destroy(&conf->cond);
+    pthread_mutex_destroy(&conf->lock);
+    GF_FREE(conf);
+}
+
+int
+notify(xlator_t *this, int32_t event, void *data, ...)
+{
+    qos_conf_t *conf = this->private;
+    xlator_t *victim = data;
+
+    /* let the requests still waiting go down before the brick does */
+    if ((event == GF_EVENT_PARENT_DOWN) && victim->cleanup_starting && conf) {
+        pthread_mutex_lock(&conf->lock);
+        {
+            conf->draining = _gf_true;
+            pthread_cond_signal(&conf->cond);
+        }
+        pthread_mutex_unlock(&conf->lock);
+    }
+
+    return default_notify(this, event, data);
+}
+
+static void
+qos_class_dump(qos_class_t *class, int index)
+{
+    char key[GF_DUMP_MAX_BUF_LEN];
+
+    gf_proc_dump_build_key(key, "class", "%d.name", index);
+    gf_proc_dump_write(key, "%s", class->name);
+    gf_proc_dump_build_key(key, "class", "%d.weight", index);
+    gf_proc_dump_write(key, "%u", class->limits.weight);
+    gf_proc_dump_build_key(key, "class", "%d.iops", index);
+    gf_proc_dump_write(key, "%" PRIu64, class->limits.iops);
+    gf_proc_dump_build_key(key, "class", "%d.bandwidth", index);
+    gf_proc_dump_write(key, "%" PRIu64, class->limits.bandwidth);
+    gf_proc_dump_build_key(key, "class", "%d.queued", index);
+    gf_proc_dump_write(key, "%u", class->queued);
+    gf_proc_dump_build_key(key, "class", "%d.requests", index);
+    gf_proc_dump_write(key, "%" PRIu64, class->requests);
+    gf_proc_dump_build_key(key, "class", "%d.bytes", index);
+    gf_proc_dump_write(key, "%" PRIu64, class->bytes);
+    gf_proc_dump_build_key(key, "class", "%d.delayed", index);
+    gf_proc_dump_write(key, "%" PRIu64, class->delayed);
+    gf_proc_dump_build_key(key, "class", "%d.delay_total_usec", index);
+    gf_proc_dump_write(key, "%" PRIu64, class->delay_total / 1000);
+    gf_proc_dump_build_key(key, "class", "%d.delay_max_usec", index);
+    gf_proc_dump_write(key, "%" PRIu64, class->delay_max / 1000);
+}
+
+static int
+qos_priv_dump(xlator_t *this)
+{
+    qos_conf_t *conf = this->private;
+    char key_prefix[GF_DUMP_MAX_BUF_LEN];
+    qos_class_t *class = NULL;
+    int index = 0;
+    int i = 0;
+
+    if (!conf)
+        return 0;
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s", this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    if (pthread_mutex_trylock(&conf->lock) != 0)
+        return 0;
+
+    gf_proc_dump_write("class_by", "%s", qos_class_by_names[conf->class_by]);
+    gf_proc_dump_write("brick_iops", "%" PRIu64, conf->brick_iops.rate);
+    gf_proc_dump_write("brick_bandwidth", "%" PRIu64,
+                       conf->brick_bandwidth.rate);
+    gf_proc_dump_write("classes", "%u", conf->nr_classes);
+    gf_proc_dump_write("max_classes", "%u", conf->max_classes);
+    gf_proc_dump_write("backlog", "%" PRIu64, conf->backlog);
+
+    for (i = 0; i < QOS_CLASS_BUCKETS; i++) {
+        list_for_each_entry(class, &conf->classes[i], hash)
+        {
+            qos_class_dump(class, index++);
+        }
+    }
+    qos_class_dump(conf->overflow, index);
+
+    pthread_mutex_unlock(&conf->lock);
+
+    return 0;
+}
+
+static int32_t
+qos_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    QOS_FOP(lookup, frame, this, 0, loc, xdata);
+    return 0;
+}
+
+static int32_t
+qos_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    QOS_FOP(stat, frame, this, 0, loc, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+    QOS_FOP(fstat, frame, this, 0, fd, xdata);
+    return 0;
+}
+
+static int32_t
+qos_access(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t mask,
+           dict_t *xdata)
+{
+    QOS_FOP(access, frame, this, 0, loc, mask, xdata);
+    return 0;
+}
+
+static int32_t
+qos_readlink(call_frame_t *frame, xlator_t *this, loc_t *loc, size_t size,
+             dict_t *xdata)
+{
+    QOS_FOP(readlink, frame, this, 0, loc, size, xdata);
+    return 0;
+}
+
+static int32_t
+qos_mknod(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          dev_t rdev, mode_t umask, dict_t *xdata)
+{
+    QOS_FOP(mknod, frame, this, 0, loc, mode, rdev, umask, xdata);
+    return 0;
+}
+
+static int32_t
+qos_mkdir(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          mode_t umask, dict_t *xdata)
+{
+    QOS_FOP(mkdir, frame, this, 0, loc, mode, umask, xdata);
+    return 0;
+}
+
+static int32_t
+qos_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t xflag,
+           dict_t *xdata)
+{
+    QOS_FOP(unlink, frame, this, 0, loc, xflag, xdata);
+    return 0;
+}
+
+static int32_t
+qos_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
+          dict_t *xdata)
+{
+    QOS_FOP(rmdir, frame, this, 0, loc, flags, xdata);
+    return 0;
+}
+
+static int32_t
+qos_symlink(call_frame_t *frame, xlator_t *this, const char *linkname,
+            loc_t *loc, mode_t umask, dict_t *xdata)
+{
+    QOS_FOP(symlink, frame, this, 0, linkname, loc, umask, xdata);
+    return 0;
+}
+
+static int32_t
+qos_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+           dict_t *xdata)
+{
+    QOS_FOP(rename, frame, this, 0, oldloc, newloc, xdata);
+    return 0;
+}
+
+static int32_t
+qos_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+         dict_t *xdata)
+{
+    QOS_FOP(link, frame, this, 0, oldloc, newloc, xdata);
+    return 0;
+}
+
+static int32_t
+qos_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+             dict_t *xdata)
+{
+    QOS_FOP(truncate, frame, this, 0, loc, offset, xdata);
+    return 0;
+}
+
+static int32_t
+qos_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              dict_t *xdata)
+{
+    QOS_FOP(ftruncate, frame, this, 0, fd, offset, xdata);
+    return 0;
+}
+
+static int32_t
+qos_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+         fd_t *fd, dict_t *xdata)
+{
+    QOS_FOP(open, frame, this, 0, loc, flags, fd, xdata);
+    return 0;
+}
+
+static int32_t
+qos_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+           mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+    QOS_FOP(create, frame, this, 0, loc, flags, mode, umask, fd, xdata);
+    return 0;
+}
+
+static int32_t
+qos_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+          off_t offset, uint32_t flags, dict_t *xdata)
+{
+    QOS_FOP(readv, frame, this, size, fd, size, offset, flags, xdata);
+    return 0;
+}
+
+static int32_t
+qos_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
+           int32_t count, off_t offset, uint32_t flags, struct iobref *iobref,
+           dict_t *xdata)
+{
+    QOS_FOP(writev, frame, this, iov_length(vector, count), fd, vector, count,
+            offset, flags, iobref, xdata);
+    return 0;
+}
+
+static int32_t
+qos_flush(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+    QOS_FOP(flush, frame, this, 0, fd, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t datasync,
+          dict_t *xdata)
+{
+    QOS_FOP(fsync, frame, this, 0, fd, datasync, xdata);
+    return 0;
+}
+
+static int32_t
+qos_opendir(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
+            dict_t *xdata)
+{
+    QOS_FOP(opendir, frame, this, 0, loc, fd, xdata);
+    return 0;
+}
+
+static int32_t
+qos_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+            off_t offset, dict_t *xdata)
+{
+    QOS_FOP(readdir, frame, this, size, fd, size, offset, xdata);
+    return 0;
+}
+
+static int32_t
+qos_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+             off_t offset, dict_t *xdata)
+{
+    QOS_FOP(readdirp, frame, this, size, fd, size, offset, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fsyncdir(call_frame_t *frame, xlator_t *this, fd_t *fd, int datasync,
+             dict_t *xdata)
+{
+    QOS_FOP(fsyncdir, frame, this, 0, fd, datasync, xdata);
+    return 0;
+}
+
+static int32_t
+qos_statfs(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    QOS_FOP(statfs, frame, this, 0, loc, xdata);
+    return 0;
+}
+
+static int32_t
+qos_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
+             int32_t flags, dict_t *xdata)
+{
+    QOS_FOP(setxattr, frame, this, 0, loc, dict, flags, xdata);
+    return 0;
+}
+
+static int32_t
+qos_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, const char *name,
+             dict_t *xdata)
+{
+    QOS_FOP(getxattr, frame, this, 0, loc, name, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fsetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
+              int32_t flags, dict_t *xdata)
+{
+    QOS_FOP(fsetxattr, frame, this, 0, fd, dict, flags, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *name,
+              dict_t *xdata)
+{
+    QOS_FOP(fgetxattr, frame, this, 0, fd, name, xdata);
+    return 0;
+}
+
+static int32_t
+qos_removexattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
+                const char *name, dict_t *xdata)
+{
+    QOS_FOP(removexattr, frame, this, 0, loc, name, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                 const char *name, dict_t *xdata)
+{
+    QOS_FOP(fremovexattr, frame, this, 0, fd, name, xdata);
+    return 0;
+}
+
+static int32_t
+qos_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc, struct iatt *stbuf,
+            int32_t valid, dict_t *xdata)
+{
+    QOS_FOP(setattr, frame, this, 0, loc, stbuf, valid, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iatt *stbuf,
+             int32_t valid, dict_t *xdata)
+{
+    QOS_FOP(fsetattr, frame, this, 0, fd, stbuf, valid, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
+              off_t offset, size_t len, dict_t *xdata)
+{
+    QOS_FOP(fallocate, frame, this, 0, fd, mode, offset, len, xdata);
+    return 0;
+}
+
+static int32_t
+qos_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len, dict_t *xdata)
+{
+    QOS_FOP(discard, frame, this, 0, fd, offset, len, xdata);
+    return 0;
+}
+
+static int32_t
+qos_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             off_t len, dict_t *xdata)
+{
+    QOS_FOP(zerofill, frame, this, 0, fd, offset, len, xdata);
+    return 0;
+}
+
+static int32_t
+qos_seek(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+         gf_seek_what_t what, dict_t *xdata)
+{
+    QOS_FOP(seek, frame, this, 0, fd, offset, what, xdata);
+    return 0;
+}
+
+static int32_t
+qos_rchecksum(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              int32_t len, dict_t *xdata)
+{
+    QOS_FOP(rchecksum, frame, this, 0, fd, offset, len, xdata);
+    return 0;
+}
+
+static int32_t
+qos_xattrop(call_frame_t *frame, xlator_t *this, loc_t *loc,
+            gf_xattrop_flags_t optype, dict_t *xattr, dict_t *xdata)
+{
+    QOS_FOP(xattrop, frame, this, 0, loc, optype, xattr, xdata);
+    return 0;
+}
+
+static int32_t
+qos_fxattrop(call_frame_t *frame, xlator_t *this, fd_t *fd,
+             gf_xattrop_flags_t optype, dict_t *xattr, dict_t *xdata)
+{
+    QOS_FOP(fxattrop, frame, this, 0, fd, optype, xattr, xdata);
+    return 0;
+}
+
+struct xlator_dumpops dumpops = {
+    .priv = qos_priv_dump,
+};
+
+struct xlator_fops fops = {
+    .lookup = qos_lookup,
+    .stat = qos_stat,
+    .fstat = qos_fstat,
+    .access = qos_access,
+    .readlink = qos_readlink,
+    .mknod = qos_mknod,
+    .mkdir = qos_mkdir,
+    .unlink = qos_unlink,
+    .rmdir = qos_rmdir,
+    .symlink = qos_symlink,
+    .rename = qos_rename,
+    .link = qos_link,
+    .truncate = qos_truncate,
+    .ftruncate = qos_ftruncate,
+    .open = qos_open,
+    .create = qos_create,
+    .readv = qos_readv,
+    .writev = qos_writev,
+    .flush = qos_flush,
+    .fsync = qos_fsync,
+    .opendir = qos_opendir,
+    .readdir = qos_readdir,
+    .readdirp = qos_readdirp,
+    .fsyncdir = qos_fsyncdir,
+    .statfs = qos_statfs,
+    .setxattr = qos_setxattr,
+    .getxattr = qos_getxattr,
+    .fsetxattr = qos_fsetxattr,
+    .fgetxattr = qos_fgetxattr,
+    .removexattr = qos_removexattr,
+    .fremovexattr = qos_fremovexattr,
+    .setattr = qos_setattr,
+    .fsetattr = qos_fsetattr,
+    .fallocate = qos_fallocate,
+    .discard = qos_discard,
+    .zerofill = qos_zerofill,
+    .seek = qos_seek,
+    .rchecksum = qos_rchecksum,
+    .xattrop = qos_xattrop,
+    .fxattrop = qos_fxattrop,
+};
+
+struct xlator_cbks cbks;
+
+struct volume_options options[] = {
+    {.key = {"class-by"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"client", "uid", "gid", "namespace"},
+     .default_value = "client",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "What the requests are classified by: the client they "
+                    "come from, their uid or gid, or the namespace (top "
+                    "level directory) they fall in, which needs the "
+                    "namespace translator."},
+    {.key = {"class-limits"},
+     .type = GF_OPTION_TYPE_STR,
+     .default_value = "",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Comma separated list of <pattern>=<limit>[/<limit>...] "
+                    "where a limit is iops:<count>, bw:<size> or "
+                    "weight:<count>. The limits of the first pattern "
+                    "matching the name of a class apply to it, the defaults "
+                    "fill in what it does not set. Clients are named by "
+                    "their client uid, namespaces by their directory."},
+    {.key = {"brick-iops"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Requests per second the brick serves in all, shared by "
+                    "the classes according to their weights. 0 for no "
+                    "limit."},
+    {.key = {"brick-bandwidth"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Bytes per second read and written through the brick in "
+                    "all, shared by the classes according to their weights. "
+                    "0 for no limit."},
+    {.key = {"default-iops"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Requests per second of a class class-limits does not "
+                    "set. 0 for no limit."},
+    {.key = {"default-bandwidth"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Bytes per second of a class class-limits does not set. "
+                    "0 for no limit."},
+    {.key = {"default-weight"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 1000,
+     .default_value = "1",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Share of the brick of a class class-limits does not "
+                    "set, relative to the weights of the other classes."},
+    {.key = {"max-classes"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 16,
+     .max = 65536,
+     .default_value = "1024",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Classes the brick keeps track of, the requests of "
+                    "further ones share the " QOS_OVERFLOW_CLASS " class."},
+    {.key = {"pass-through"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "false",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"qos"},
+     .description = "Enable/Disable the qos translator"},
+    {.key = {NULL}},
+};
+
+xlator_api_t xlator_api = {
+    .init = init,
+    .fini = fini,
+    .notify = notify,
+    .reconfigure = reconfigure,
+    .mem_acct_init = mem_acct_init,
+    .op_version = {GD_OP_VERSION_10_0},
+    .dumpops = &dumpops,
+    .fops = &fops,
+    .cbks = &cbks,
+    .options = options,
+    .identifier = "qos",
+    .category = GF_TECH_PREVIEW,
+};
@@ -0,0 +1,116 @@
+/*
+  Copyright (c) 2024 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __QOS_H__
+#define __QOS_H__
+
+#include <glusterfs/xlator.h>
+#include <glusterfs/call-stub.h>
+#include <glusterfs/list.h>
+
+#include "qos-mem-types.h"
+
+/* Requests of a class are classified by */
+typedef enum {
+    QOS_CLASS_BY_CLIENT,
+    QOS_CLASS_BY_UID,
+    QOS_CLASS_BY_GID,
+    QOS_CLASS_BY_NAMESPACE,
+} qos_class_by_t;
+
+/* Every request costs QOS_OP_COST plus the bytes it moves out of the
+ * deficit of its class, which gets weight * QOS_QUANTUM each round */
+#define QOS_OP_COST 4096
+#define QOS_QUANTUM (64 * 1024)
+
+/* How often the scheduler looks at the buckets while requests wait */
+#define QOS_TICK_NS (5 * 1000 * 1000)
+
+#define QOS_CLASS_BUCKETS 256
+
+/* Class the requests go to once max-classes of them exist */
+#define QOS_OVERFLOW_CLASS "overflow"
+
+typedef struct qos_limits {
+    uint64_t iops;      /* 0 for no limit */
+    uint64_t bandwidth; /* bytes per second, 0 for no limit */
+    uint32_t weight;
+} qos_limits_t;
+
+/* A token bucket refilled from the time elapsed since it was last looked
+ * at, so that a brick can have thousands of them without a thread each.
+ * The bandwidth bucket may go into debt: a request larger than the burst
+ * is let through once the bucket is full and pays for it afterwards. */
+typedef struct qos_bucket {
+    uint64_t rate; /* tokens per second, 0 for no limit */
+    double burst;
+    double tokens;
+    uint64_t last; /* ns */
+} qos_bucket_t;
+
+/* An entry of class-limits */
+typedef struct qos_rule {
+    struct list_head list;
+    char *pattern;
+    uint32_t ns_hash; /* of the pattern, to name the namespace classes */
+    qos_limits_t limits;
+} qos_rule_t;
+
+typedef struct qos_class {
+    struct list_head hash; /* on conf->classes[] or conf->retired */
+    struct list_head active; /* on conf->active while it has requests */
+    struct list_head queue; /* qos_req_t waiting for their turn */
+    qos_class_by_t by;
+    uint64_t key;
+    char *name;
+    qos_limits_t limits;
+    qos_bucket_t iops;
+    qos_bucket_t bandwidth;
+    int64_t deficit;
+    uint32_t queued; /* requests waiting, reserved ones included */
+
+    uint64_t requests;
+    uint64_t bytes;
+    uint64_t delayed;
+    uint64_t delay_total; /* ns */
+    uint64_t delay_max;   /* ns */
+} qos_class_t;
+
+typedef struct qos_req {
+    struct list_head list;
+    call_stub_t *stub;
+    uint64_t bytes;
+    uint64_t queued; /* ns */
+} qos_req_t;
+
+typedef struct qos_conf {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    pthread_t scheduler;
+    gf_boolean_t running;
+    gf_boolean_t draining; /* let everything through, the brick goes down */
+
+    qos_class_by_t class_by;
+    qos_limits_t defaults;
+    qos_bucket_t brick_iops;
+    qos_bucket_t brick_bandwidth;
+    uint32_t max_classes;
+    uint32_t nr_classes;
+    gf_boolean_t limited; /* any bucket has a rate */
+
+    struct list_head rules;
+    struct list_head classes[QOS_CLASS_BUCKETS];
+    struct list_head retired; /* classes of an earlier class-by */
+    struct list_head active; /* the classes of the current DRR round */
+    qos_class_t *overflow;
+    uint64_t backlog; /* requests waiting in all the classes */
+} qos_conf_t;
+
+#endif /* __QOS_H__ */
@@ -23,6 +23,7 @@ frames_file_fill(xlator_t *this, inode_t *file, strfd_t *strfd)
     call_frame_t *frame = NULL;
     int i = 0;
     int j = 1;
+    int l = 0;
 
     if (!this || !file || !strfd)
         return -1;
@@ -31,62 +32,70 @@ frames_file_fill(xlator_t *this, inode_t *file, strfd_t *strfd)
 
     strprintf(strfd, "{ \n\t\"Stack\": [\n");
 
-    LOCK(&pool->lock);
-    {
-        list_for_each_entry(stack, &pool->all_frames, all_frames)
+    for (l = 0; l < GF_CALL_POOL_LISTS; l++) {
+        LOCK(&pool->lists[l].lock);
         {
-            strprintf(strfd, "\t   {\n");
-            strprintf(strfd, "\t\t\"Number\": %d,\n", ++i);
-            strprintf(strfd, "\t\t\"Frame\": [\n");
-            j = 1;
-            list_for_each_entry(frame, &stack->myframes, frames)
+            list_for_each_entry(stack, &pool->lists[l].all_frames,
+                                all_frames)
             {
-                strprintf(strfd, "\t\t   {\n");
-                strprintf(strfd, "\t\t\t\"Number\": %d,\n", j++);
-                strprintf(strfd, "\t\t\t\"Xlator\": \"%s\",\n",
-                          frame->this->name);
-                if (frame->begin.tv_sec)
-                    strprintf(strfd, "\t\t\t\"Creation_time\": %d.%09d,\n",
-                              (int)frame->begin.tv_sec,
-                              (int)frame->begin.tv_nsec);
-                if (frame->parent)
-                    strprintf(strfd, "\t\t\t\"Parent\": \"%s\",\n",
-                              frame->parent->this->name);
-                if (frame->wind_from)
-                    strprintf(strfd, "\t\t\t\"Wind_from\": \"%s\",\n",
-                              frame->wind_from);
-                if (frame->wind_to)
-                    strprintf(strfd, "\t\t\t\"Wind_to\": \"%s\",\n",
-                              frame->wind_to);
-                if (frame->unwind_from)
-                    strprintf(strfd, "\t\t\t\"Unwind_from\": \"%s\",\n",
-                              frame->unwind_from);
-                if (frame->unwind_to)
-                    strprintf(strfd, "\t\t\t\"Unwind_to\": \"%s\",\n",
-                              frame->unwind_to);
-                strprintf(strfd, "\t\t\t\"Complete\": %d\n", frame->complete);
-                if (list_is_last(&frame->frames, &stack->myframes))
-                    strprintf(strfd, "\t\t   }\n");
-                else
-                    strprintf(strfd, "\t\t   },\n");
+                if (i)
+                    strprintf(strfd, ",\n");
+                strprintf(strfd, "\t   {\n");
+                strprintf(strfd, "\t\t\"Number\": %d,\n", ++i);
+                strprintf(strfd, "\t\t\"Frame\": [\n");
+                j = 1;
+                list_for_each_entry(frame, &stack->myframes, frames)
+                {
+                    strprintf(strfd, "\t\t   {\n");
+                    strprintf(strfd, "\t\t\t\"Number\": %d,\n", j++);
+                    strprintf(strfd, "\t\t\t\"Xlator\": \"%s\",\n",
+                              frame->this->name);
+                    if (frame->begin.tv_sec)
+                        strprintf(strfd,
+                                  "\t\t\t\"Creation_time\": %d.%09d,\n",
+                                  (int)frame->begin.tv_sec,
+                                  (int)frame->begin.tv_nsec);
+                    if (frame->parent)
+                        strprintf(strfd, "\t\t\t\"Parent\": \"%s\",\n",
+                                  frame->parent->this->name);
+                    if (frame->wind_from)
+                        strprintf(strfd, "\t\t\t\"Wind_from\": \"%s\",\n",
+                                  frame->wind_from);
+                    if (frame->wind_to)
+                        strprintf(strfd, "\t\t\t\"Wind_to\": \"%s\",\n",
+                                  frame->wind_to);
+                    if (frame->unwind_from)
+                        strprintf(strfd, "\t\t\t\"Unwind_from\": \"%s\",\n",
+                                  frame->unwind_from);
+                    if (frame->unwind_to)
+                        strprintf(strfd, "\t\t\t\"Unwind_to\": \"%s\",\n",
+                                  frame->unwind_to);
+                    strprintf(strfd, "\t\t\t\"Complete\": %d\n",
+                              frame->complete);
+                    if (list_is_last(&frame->frames, &stack->myframes))
+                        strprintf(strfd, "\t\t   }\n");
+                    else
+                        strprintf(strfd, "\t\t   },\n");
+                }
+                strprintf(strfd, "\t\t],\n");
+                strprintf(strfd, "\t\t\"Unique\": %" PRId64 ",\n",
+                          stack->unique);
+                strprintf(strfd, "\t\t\"Type\": \"%s\",\n",
+                          gf_fop_list[stack->op]);
+                strprintf(strfd, "\t\t\"UID\": %d,\n", stack->uid);
+                strprintf(strfd, "\t\t\"GID\": %d,\n", stack->gid);
+                strprintf(strfd, "\t\t\"LK_owner\": \"%s\"\n",
+                          lkowner_utoa(&stack->lk_owner));
+                strprintf(strfd, "\t   }");
             }
-            strprintf(strfd, "\t\t],\n");
-            strprintf(strfd, "\t\t\"Unique\": %" PRId64 ",\n", stack->unique);
-            strprintf(strfd, "\t\t\"Type\": \"%s\",\n", gf_fop_list[stack->op]);
-            strprintf(strfd, "\t\t\"UID\": %d,\n", stack->uid);
-            strprintf(strfd, "\t\t\"GID\": %d,\n", stack->gid);
-            strprintf(strfd, "\t\t\"LK_owner\": \"%s\"\n",
-                      lkowner_utoa(&stack->lk_owner));
-            if (i == (int)pool->cnt)
-                strprintf(strfd, "\t   }\n");
-            else
-                strprintf(strfd, "\t   },\n");
         }
-        strprintf(strfd, "\t],\n");
-        strprintf(strfd, "\t\"Call_Count\": %d\n", (int)pool->cnt);
-        strprintf(strfd, "}");
+        UNLOCK(&pool->lists[l].lock);
     }
-    UNLOCK(&pool->lock);
+    if (i)
+        strprintf(strfd, "\n");
+    strprintf(strfd, "\t],\n");
+    strprintf(strfd, "\t\"Call_Count\": %d\n", i);
+    strprintf(strfd, "}");
 
     return strfd->size;
 }
@@ -2044,6 +2044,33 @@ out:
     return ret;
 }
 
+static int
+brick_graph_add_qos(volgen_graph_t *graph, glusterd_volinfo_t *volinfo,
+                    dict_t *set_dict, glusterd_brickinfo_t *brickinfo)
+{
+    xlator_t *xl = NULL;
+    int ret = -1;
+
+    if (!graph || !volinfo || !set_dict) {
+        gf_smsg(THIS->name, GF_LOG_ERROR, errno, GD_MSG_INVALID_ARGUMENT, NULL);
+        goto out;
+    }
+
+    if (!dict_get_str_boolean(set_dict, "features.qos", 0)) {
+        /* update only if option is enabled */
+        ret = 0;
+        goto out;
+    }
+
+    xl = volgen_graph_add(graph, "features/qos", volinfo->volname);
+    if (!xl)
+        goto out;
+
+    ret = 0;
+out:
+    return ret;
+}
+
 xlator_t *
 add_one_peer(volgen_graph_t *graph, glusterd_brickinfo_t *peer, char *volname,
              uint16_t index)
@@ -2499,6 +2526,7 @@ static volgen_brick_xlator_t server_graph_table[] = {
     {brick_graph_add_io_stats, "io-stats"},
     {brick_graph_add_sdfs, "sdfs"},
     {brick_graph_add_namespace, "namespace"},
+    {brick_graph_add_qos, "qos"},
     {brick_graph_add_cdc, "cdc"},
     {brick_graph_add_quota, "quota"},
     {brick_graph_add_index, "index"},
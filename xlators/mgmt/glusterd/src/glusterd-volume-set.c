@@ -758,6 +758,81 @@ validate_statedump_path(glusterd_volinfo_t *volinfo, dict_t *dict, char *key,
     return ret;
 }
 
+/* Checks the syntax of features.qos-class-limits the way features/qos
+ * parses it: <pattern>=<limit>[/<limit>...][,...] where a limit is
+ * iops:<count>, bw:<size> or weight:<count>, the weight not 0. */
+static int
+validate_qos_class_limits(glusterd_volinfo_t *volinfo, dict_t *dict,
+                          char *key, char *value, char **op_errstr)
+{
+    char *dup = NULL;
+    char *entry = NULL;
+    char *field = NULL;
+    char *limit = NULL;
+    char *save = NULL;
+    char *fsave = NULL;
+    char *eq = NULL;
+    uint64_t num = 0;
+    uint32_t weight = 0;
+    int ret = -1;
+
+    dup = gf_strdup(value);
+    if (!dup)
+        goto out;
+
+    for (entry = strtok_r(dup, ",", &save); entry;
+         entry = strtok_r(NULL, ",", &save)) {
+        eq = strrchr(entry, '=');
+        if (!eq) {
+            gf_asprintf(op_errstr, "%s: no limits in '%s'", key, entry);
+            goto out;
+        }
+        *eq = '\0';
+        entry = gf_trim(entry);
+        if (!*entry) {
+            gf_asprintf(op_errstr, "%s: empty class pattern", key);
+            goto out;
+        }
+
+        for (field = strtok_r(eq + 1, "/", &fsave); field;
+             field = strtok_r(NULL, "/", &fsave)) {
+            limit = strchr(field, ':');
+            if (limit)
+                *limit++ = '\0';
+            field = gf_trim(field);
+
+            if (!limit) {
+                ret = -1;
+            } else if (strcmp(field, "iops") == 0) {
+                ret = gf_string2uint64(limit, &num);
+            } else if (strcmp(field, "bw") == 0) {
+                ret = gf_string2bytesize_uint64(limit, &num);
+            } else if (strcmp(field, "weight") == 0) {
+                ret = gf_string2uint32(limit, &weight);
+                if (!ret && !weight)
+                    ret = -1;
+            } else {
+                ret = -1;
+            }
+
+            if (ret) {
+                gf_asprintf(op_errstr, "%s: invalid limit '%s' for class '%s'",
+                            key, field, entry);
+                goto out;
+            }
+        }
+    }
+
+    ret = 0;
+out:
+    if (ret && *op_errstr)
+        gf_msg(THIS->name, GF_LOG_ERROR, 0, GD_MSG_INVALID_ENTRY, "%s",
+               *op_errstr);
+    GF_FREE(dup);
+
+    return ret;
+}
+
 /* dispatch table for VOLUME SET
  * -----------------------------
  *
@@ -1183,6 +1258,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "debug/io-stats",
      .option = "ios-dnscache-ttl-sec",
      .op_version = 1},
+    {.key = "diagnostics.log-async",
+     .voltype = "debug/io-stats",
+     .option = "log-async",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "diagnostics.metrics-socket",
+     .voltype = "debug/io-stats",
+     .option = "metrics-socket",
+     .op_version = GD_OP_VERSION_10_0},
 
     /* IO-cache xlator options */
     {.key = "performance.cache-max-file-size",
@@ -1212,6 +1295,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "cache-size",
      .op_version = GD_OP_VERSION_8_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.io-cache-page-size",
+     .voltype = "performance/io-cache",
+     .option = "page-size",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "performance.cache-size",
         .voltype = "performance/io-cache",
@@ -1294,6 +1382,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "ctime-invalidation",
      .op_version = GD_OP_VERSION_5_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.quick-read-compress",
+     .voltype = "performance/quick-read",
+     .option = "compress",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.quick-read-admission",
+     .voltype = "performance/quick-read",
+     .option = "admission",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.flush-behind",
      .voltype = "performance/write-behind",
      .option = "flush-behind",
@@ -1374,6 +1472,13 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "read-after-open",
      .op_version = 3,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.anonymous-reads",
+     .voltype = "performance/open-behind",
+     .option = "anonymous-reads",
+     .value = "off",
+     .type = DOC,
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "performance.open-behind-pass-through",
         .voltype = "performance/open-behind",
@@ -1385,6 +1490,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "page-count",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.read-ahead-cache-size",
+     .voltype = "performance/read-ahead",
+     .option = "cache-size",
+     .op_version = GD_OP_VERSION_10_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {
         .key = "performance.read-ahead-pass-through",
         .voltype = "performance/read-ahead",
@@ -1491,6 +1601,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .voltype = "protocol/client",
         .op_version = GD_OP_VERSION_3_7_0,
     },
+    {
+        .key = "client.event-threads-max",
+        .voltype = "protocol/client",
+        .op_version = GD_OP_VERSION_10_0,
+    },
     {.key = "client.tcp-user-timeout",
      .voltype = "protocol/client",
      .option = "transport.tcp-user-timeout",
@@ -1591,6 +1706,12 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "rpc.outstanding-rpc-limit",
      .type = GLOBAL_DOC,
      .op_version = 3},
+    {.key = "server.numa-affinity",
+     .voltype = "protocol/server",
+     .option = "rpc.numa-affinity",
+     .value = "off",
+     .type = DOC,
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "server.ssl",
      .voltype = "protocol/server",
      .value = "off",
@@ -1643,6 +1764,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .voltype = "protocol/server",
         .op_version = GD_OP_VERSION_3_7_0,
     },
+    {
+        .key = "server.event-threads-max",
+        .voltype = "protocol/server",
+        .op_version = GD_OP_VERSION_10_0,
+    },
     {
         .key = "server.tcp-user-timeout",
         .voltype = "protocol/server",
@@ -2234,6 +2360,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "nfs.drc-size",
      .type = GLOBAL_DOC,
      .op_version = 3},
+    {.key = "nfs.drc-client-size",
+     .voltype = "nfs/server",
+     .option = "nfs.drc-client-size",
+     .type = GLOBAL_DOC,
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "nfs.read-size",
      .voltype = "nfs/server",
      .option = "nfs3.read-size",
@@ -2249,6 +2380,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "nfs3.readdir-size",
      .type = GLOBAL_DOC,
      .op_version = 3},
+    {.key = "nfs.write-gather",
+     .voltype = "nfs/server",
+     .option = "nfs3.write-gather",
+     .type = GLOBAL_DOC,
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "nfs.readdir-streams",
+     .voltype = "nfs/server",
+     .option = "nfs3.readdir-streams",
+     .type = GLOBAL_DOC,
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "nfs.rdirplus",
      .voltype = "nfs/server",
      .option = "nfs.rdirplus",
@@ -2396,6 +2537,24 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .voltype = "storage/posix",
         .op_version = GD_OP_VERSION_4_0_0,
     },
+    {
+        .option = "xattr-cache",
+        .key = "storage.xattr-cache",
+        .voltype = "storage/posix",
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .option = "handle-fd-cache-size",
+        .key = "storage.handle-fd-cache-size",
+        .voltype = "storage/posix",
+        .op_version = GD_OP_VERSION_10_0,
+    },
+    {
+        .option = "ctime-writeback-delay-usec",
+        .key = "storage.ctime-writeback-delay-usec",
+        .voltype = "storage/posix",
+        .op_version = GD_OP_VERSION_10_0,
+    },
     {
         .option = "force-create-mode",
         .key = "storage.force-create-mode",
@@ -2834,6 +2993,27 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .flags = VOLOPT_FLAG_CLIENT_OPT,
      .op_version = GD_OP_VERSION_3_9_1,
      .validate_fn = validate_rda_cache_limit},
+    {.key = "performance.rda-dir-cache",
+     .voltype = "performance/readdir-ahead",
+     .option = "rda-dir-cache",
+     .value = "off",
+     .type = DOC,
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "performance.rda-dir-cache-limit",
+     .voltype = "performance/readdir-ahead",
+     .option = "rda-dir-cache-limit",
+     .value = "32MB",
+     .type = DOC,
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "performance.rda-dir-cache-timeout",
+     .voltype = "performance/readdir-ahead",
+     .option = "rda-dir-cache-timeout",
+     .value = "60",
+     .type = DOC,
+     .flags = VOLOPT_FLAG_CLIENT_OPT,
+     .op_version = GD_OP_VERSION_10_0},
     {
         .key = "performance.nl-cache-positive-entry",
         .voltype = "performance/nl-cache",
@@ -3006,6 +3186,46 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .description = "enable/disable dentry serialization xlator in volume",
         .type = NO_DOC,
     },
+    {.key = "features.qos",
+     .voltype = "features/qos",
+     .value = "off",
+     .option = "!features",
+     .op_version = GD_OP_VERSION_10_0,
+     .description = "enable/disable the brick side QoS scheduler, which "
+                    "shares the bricks between classes of requests"},
+    {.key = "features.qos-class-by",
+     .voltype = "features/qos",
+     .option = "class-by",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-class-limits",
+     .voltype = "features/qos",
+     .option = "class-limits",
+     .op_version = GD_OP_VERSION_10_0,
+     .validate_fn = validate_qos_class_limits},
+    {.key = "features.qos-brick-iops",
+     .voltype = "features/qos",
+     .option = "brick-iops",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-brick-bandwidth",
+     .voltype = "features/qos",
+     .option = "brick-bandwidth",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-default-iops",
+     .voltype = "features/qos",
+     .option = "default-iops",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-default-bandwidth",
+     .voltype = "features/qos",
+     .option = "default-bandwidth",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-default-weight",
+     .voltype = "features/qos",
+     .option = "default-weight",
+     .op_version = GD_OP_VERSION_10_0},
+    {.key = "features.qos-max-classes",
+     .voltype = "features/qos",
+     .option = "max-classes",
+     .op_version = GD_OP_VERSION_10_0},
     {.key = "features.cloudsync",
      .voltype = "features/cloudsync",
      .value = "off",
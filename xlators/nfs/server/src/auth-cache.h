@@ -20,10 +20,34 @@
 #include <glusterfs/dict.h>
 #include "nfs3.h"
 
+/* Entries of the cache are looked up by their binary key without taking
+ * the lock, which only serializes the updates. Each slot has a sequence
+ * count that is odd while an update is in progress; readers retry when it
+ * changed under them.
+ */
+#define AUTH_CACHE_SETS 1024 /* must be a power of 2 */
+#define AUTH_CACHE_WAYS 4
+
+struct auth_cache_key {
+    uuid_t exportid;
+    uuid_t mountid;
+    unsigned char addr[16]; /* IPv6, or IPv4-mapped IPv6 address */
+};
+
+struct auth_cache_slot {
+    uint32_t seq;
+    struct auth_cache_key key;
+    time_t timestamp; /* 0 for an empty slot */
+    gf_boolean_t can_write;
+};
+
 struct auth_cache {
-    gf_lock_t lock;     /* locking for the dict (and entries) */
-    dict_t *cache_dict; /* Dict holding fh -> authcache_entry */
-    time_t ttl_sec;     /* TTL of the auth cache in seconds */
+    gf_lock_t lock; /* serializes updates of the slots */
+    struct auth_cache_slot *slots;
+    time_t ttl_sec; /* TTL of the auth cache in seconds */
+
+    gf_atomic_t lookups;
+    gf_atomic_t hits;
 };
 
 /* Initializes the cache */
@@ -33,17 +57,18 @@ auth_cache_init(time_t ttl_sec);
 /* Inserts FH into cache */
 int
 cache_nfs_fh(struct auth_cache *cache, struct nfs3_fh *fh,
-             const char *host_addr, struct export_item *export_item);
+             const struct sockaddr_storage *peer,
+             struct export_item *export_item);
 
 /* Checks if the filehandle cached & writable */
 gf_boolean_t
 is_nfs_fh_cached_and_writeable(struct auth_cache *cache, struct nfs3_fh *fh,
-                               const char *host_addr);
+                               const struct sockaddr_storage *peer);
 
 /* Checks if the filehandle is cached */
 gf_boolean_t
 is_nfs_fh_cached(struct auth_cache *cache, struct nfs3_fh *fh,
-                 const char *host_addr);
+                 const struct sockaddr_storage *peer);
 
 /* Purge the cache */
 void
@@ -69,6 +69,134 @@ _exp_deinit_parsers()
     parser_deinit(options_parser);
 }
 
+/**
+ * _exp_trie_node_init -- Allocate a trie node for a path component
+ *
+ * @name : The path component, not NUL terminated
+ * @len  : Length of the path component
+ *
+ * Not for external use.
+ */
+static struct exp_trie_node *
+_exp_trie_node_init(const char *name, size_t len)
+{
+    struct exp_trie_node *node = NULL;
+
+    node = GF_CALLOC(1, sizeof(*node), gf_common_mt_nfs_exports);
+    if (!node)
+        goto out;
+
+    if (name) {
+        node->name = gf_strndup(name, len);
+        if (!node->name) {
+            GF_FREE(node);
+            node = NULL;
+        }
+    }
+out:
+    return node;
+}
+
+/**
+ * _exp_trie_deinit -- Free a trie node and all its descendants. The export
+ *                     directories are owned by the exports dict.
+ *
+ * Not for external use.
+ */
+static void
+_exp_trie_deinit(struct exp_trie_node *node)
+{
+    struct exp_trie_node *kid = NULL;
+
+    if (!node)
+        return;
+
+    while ((kid = node->kids)) {
+        node->kids = kid->next;
+        _exp_trie_deinit(kid);
+    }
+
+    GF_FREE(node->name);
+    GF_FREE(node);
+}
+
+/**
+ * _exp_trie_next_component -- Find the next component of a path
+ *
+ * @path : Where to start looking, updated to point past the component
+ * @len  : Set to the length of the component
+ *
+ * @return : Pointer to the component, NULL at the end of the path
+ *
+ * Not for external use.
+ */
+static const char *
+_exp_trie_next_component(const char **path, size_t *len)
+{
+    const char *start = *path + strspn(*path, "/");
+
+    if (*start == '\0')
+        return NULL;
+
+    *len = strcspn(start, "/");
+    *path = start + *len;
+
+    return start;
+}
+
+/**
+ * _exp_trie_kid -- Find the child of a trie node for a path component,
+ *                  optionally creating it.
+ *
+ * Not for external use.
+ */
+static struct exp_trie_node *
+_exp_trie_kid(struct exp_trie_node *node, const char *name, size_t len,
+              gf_boolean_t create)
+{
+    struct exp_trie_node *kid = NULL;
+
+    for (kid = node->kids; kid; kid = kid->next) {
+        if ((strncmp(kid->name, name, len) == 0) && (kid->name[len] == '\0'))
+            return kid;
+    }
+
+    if (!create)
+        return NULL;
+
+    kid = _exp_trie_node_init(name, len);
+    if (kid) {
+        kid->next = node->kids;
+        node->kids = kid;
+    }
+
+    return kid;
+}
+
+/**
+ * _exp_trie_insert -- Add an export directory to the trie of the file
+ *
+ * Not for external use.
+ */
+static int
+_exp_trie_insert(struct exports_file *file, struct export_dir *dir)
+{
+    struct exp_trie_node *node = file->trie;
+    const char *path = dir->dir_name;
+    const char *name = NULL;
+    size_t len = 0;
+
+    while ((name = _exp_trie_next_component(&path, &len))) {
+        node = _exp_trie_kid(node, name, len, _gf_true);
+        if (!node)
+            return -1;
+    }
+
+    node->dir = dir;
+
+    return 0;
+}
+
 /**
  * _export_file_init -- Initialize an exports file structure.
  *
@@ -91,7 +219,8 @@ _exports_file_init()
 
     file->exports_dict = dict_new();
     file->exports_map = dict_new();
-    if (!file->exports_dict || !file->exports_map) {
+    file->trie = _exp_trie_node_init(NULL, 0);
+    if (!file->exports_dict || !file->exports_map || !file->trie) {
         gf_msg(GF_EXP, GF_LOG_CRITICAL, ENOMEM, NFS_MSG_NO_MEMORY,
                "Failed to allocate dict!");
         goto free_and_out;
@@ -102,6 +231,9 @@ _exports_file_init()
 free_and_out:
     if (file->exports_dict)
         dict_unref(file->exports_dict);
+    if (file->exports_map)
+        dict_unref(file->exports_map);
+    _exp_trie_deinit(file->trie);
 
     GF_FREE(file);
     file = NULL;
@@ -163,6 +295,7 @@ exp_file_deinit(struct exports_file *expfile)
         dict_unref(expfile->exports_map);
     }
 
+    _exp_trie_deinit(expfile->trie);
     GF_FREE(expfile->filename);
     GF_FREE(expfile);
 out:
@@ -458,6 +591,10 @@ _exp_file_insert(struct exports_file *file, struct export_dir *dir)
     gf_uuid_unparse(export_uuid, export_uuid_str);
 
     dict_set(file->exports_map, export_uuid_str, dirdata);
+
+    if (_exp_trie_insert(file, dir) != 0)
+        gf_msg(GF_EXP, GF_LOG_CRITICAL, ENOMEM, NFS_MSG_NO_MEMORY,
+               "Failed to add %s to the exports trie", dir->dir_name);
 out:
     return;
 }
@@ -1292,7 +1429,8 @@ out:
 
 /**
  * exp_file_get_dir -- Return an export dir given a directory name
- *                     Does a lookup from the dict in the file structure.
+ *                     Walks the trie of the exported directories in the
+ *                     file structure, one path component at a time.
  *
  * @file : Exports file structure to lookup from
  * @dir  : Directory name to lookup
@@ -1304,36 +1442,74 @@ struct export_dir *
 exp_file_get_dir(const struct exports_file *file, const char *dir)
 {
     struct export_dir *lookup_res = NULL;
-    data_t *dict_res = NULL;
-    char *dirdup = NULL;
-    size_t dirlen = 0;
+    struct exp_trie_node *node = NULL;
+    const char *path = dir;
+    const char *name = NULL;
+    size_t len = 0;
 
     GF_VALIDATE_OR_GOTO(GF_EXP, file, out);
     GF_VALIDATE_OR_GOTO(GF_EXP, dir, out);
 
-    dirlen = strlen(dir);
-    if (dirlen <= 0)
+    if (*dir == '\0')
         goto out;
 
-    dirdup = (char *)dir; /* Point at the directory */
+    node = file->trie;
+    while (node && (name = _exp_trie_next_component(&path, &len)))
+        node = _exp_trie_kid(node, name, len, _gf_false);
 
-    /* If directories don't contain a leading slash */
-    if (*dir != '/') {
-        dirdup = alloca(dirlen + 2); /* Leading slash & null byte */
-        snprintf(dirdup, dirlen + 2, "/%s", dir);
-    }
-
-    dict_res = dict_get(file->exports_dict, dirdup);
-    if (!dict_res) {
-        gf_msg_debug(GF_EXP, 0, "%s not found in %s", dirdup, file->filename);
+    if (!node || !node->dir) {
+        gf_msg_debug(GF_EXP, 0, "%s not found in %s", dir, file->filename);
         goto out;
     }
 
-    lookup_res = (struct export_dir *)dict_res->data;
+    lookup_res = node->dir;
 out:
     return lookup_res;
 }
 
+/**
+ * exp_file_get_parent_dirs -- Return the exported directories which are
+ *                             parents of a path, from the top down. The
+ *                             root directory and the path itself are not
+ *                             included.
+ *
+ * @file : Exports file structure to lookup from
+ * @path : Path whose parents to lookup
+ * @dirs : Filled with the export directory structures found
+ * @max  : Number of entries in @dirs
+ *
+ * @return : The number of export directories filled in @dirs
+ */
+int
+exp_file_get_parent_dirs(const struct exports_file *file, const char *path,
+                         struct export_dir **dirs, int max)
+{
+    struct exp_trie_node *node = NULL;
+    const char *name = NULL;
+    size_t len = 0;
+    int count = 0;
+
+    GF_VALIDATE_OR_GOTO(GF_EXP, file, out);
+    GF_VALIDATE_OR_GOTO(GF_EXP, path, out);
+
+    node = file->trie;
+    while ((count < max) &&
+           (name = _exp_trie_next_component(&path, &len))) {
+        /* The last component is the path itself */
+        if (path[strspn(path, "/")] == '\0')
+            break;
+
+        node = _exp_trie_kid(node, name, len, _gf_false);
+        if (!node)
+            break;
+
+        if (node->dir)
+            dirs[count++] = node->dir;
+    }
+out:
+    return count;
+}
+
 /**
  * exp_file_parse -- Parse an exports file into a structure
  *                   that can be looked up through simple
@@ -64,10 +64,19 @@ struct export_dir {
     dict_t *hosts;     /* Dict of hosts */
 };
 
+/* Node of the trie of the exported directories, one per path component */
+struct exp_trie_node {
+    char *name;                 /* Path component */
+    struct export_dir *dir;     /* Export of the path ending here, if any */
+    struct exp_trie_node *kids; /* First child */
+    struct exp_trie_node *next; /* Next sibling */
+};
+
 struct exports_file {
-    char *filename;       /* Filename */
-    dict_t *exports_dict; /* Dict of export_dir_t */
-    dict_t *exports_map;  /* Map of SuperFastHash(<export>) -> expdir */
+    char *filename;              /* Filename */
+    dict_t *exports_dict;        /* Dict of export_dir_t */
+    dict_t *exports_map;         /* Map of SuperFastHash(<export>) -> expdir */
+    struct exp_trie_node *trie;  /* Trie of the exported directories */
 };
 
 void
@@ -80,6 +89,10 @@ exp_file_parse(const char *filepath, struct exports_file **expfile,
 struct export_dir *
 exp_file_get_dir(const struct exports_file *file, const char *dir);
 
+int
+exp_file_get_parent_dirs(const struct exports_file *file, const char *path,
+                         struct export_dir **dirs, int max);
+
 struct export_item *
 exp_dir_get_host(const struct export_dir *expdir, const char *host);
 
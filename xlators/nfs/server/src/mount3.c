@@ -29,10 +29,11 @@
 #include "nfs-messages.h"
 #include <netdb.h>
 #include <glusterfs/syscall.h>
+#include <glusterfs/timespec.h>
+#include <glusterfs/statedump.h>
 #include <errno.h>
 #include <sys/socket.h>
 #include <sys/uio.h>
-#include <libgen.h>
 
 /* This macro will assist in freeing up entire link list
  * of host_auth_spec structure.
@@ -2089,12 +2090,13 @@ out:
  */
 int
 mnt3_check_cached_fh(struct mount3_state *ms, struct nfs3_fh *fh,
-                     const char *host_addr, gf_boolean_t is_write_op)
+                     const struct sockaddr_storage *peer,
+                     gf_boolean_t is_write_op)
 {
     if (!is_write_op)
-        return is_nfs_fh_cached(ms->authcache, fh, host_addr);
+        return is_nfs_fh_cached(ms->authcache, fh, peer);
 
-    return is_nfs_fh_cached_and_writeable(ms->authcache, fh, host_addr);
+    return is_nfs_fh_cached_and_writeable(ms->authcache, fh, peer);
 }
 
 /**
@@ -2128,12 +2130,24 @@ _mnt3_authenticate_req(struct mount3_state *ms, rpcsvc_request_t *req,
     char *pathdup = NULL;
     size_t dlen = 0;
     char *auth_host = NULL;
-    gf_boolean_t fh_cached = _gf_false;
     struct export_item *expitem = NULL;
+    rpc_transport_t *trans = NULL;
 
     GF_VALIDATE_OR_GOTO(GF_MNT, ms, out);
     GF_VALIDATE_OR_GOTO(GF_MNT, req, out);
 
+    /* Check if the filehandle is cached, the lookup is keyed by the
+     * binary address of the peer and needs no formatting of it.
+     */
+    trans = rpcsvc_request_transport(req);
+    if (fh && mnt3_check_cached_fh(ms, fh, &trans->peerinfo.sockaddr,
+                                   is_write_op)) {
+        gf_msg_trace(GF_MNT, 0, "Found cached FH for %s",
+                     trans->peerinfo.identifier);
+        auth_status_code = 0;
+        goto out;
+    }
+
     peer_addr = _mnt3_get_peer_addr(req);
 
     if (!peer_addr)
@@ -2152,14 +2166,6 @@ _mnt3_authenticate_req(struct mount3_state *ms, rpcsvc_request_t *req,
             pathdup[dlen - 1] = '\0';
     }
 
-    /* Check if the filehandle is cached */
-    fh_cached = mnt3_check_cached_fh(ms, fh, host_addr_ip, is_write_op);
-    if (fh_cached) {
-        gf_msg_trace(GF_MNT, 0, "Found cached FH for %s", host_addr_ip);
-        auth_status_code = 0;
-        goto free_and_out;
-    }
-
     /* Check if the IP is authorized */
     auth_status_code = mnt3_auth_host(ms->auth_params, host_addr_ip, fh,
                                       pathdup, is_write_op, &expitem);
@@ -2187,7 +2193,8 @@ _mnt3_authenticate_req(struct mount3_state *ms, rpcsvc_request_t *req,
     if (!authorized_export || !authorized_host) {
         /* Cache the file handle if it was authorized */
         if (fh && auth_status_code == 0)
-            cache_nfs_fh(ms->authcache, fh, host_addr_ip, expitem);
+            cache_nfs_fh(ms->authcache, fh, &trans->peerinfo.sockaddr,
+                         expitem);
 
         goto free_and_out;
     }
@@ -2215,50 +2222,15 @@ out:
     return auth_status_code;
 }
 
-/**
- * gf_resolve_path_parent -- Given a path, returns an allocated string
- *                           containing the parent's path.
- * @path: Path to parse
- * @return: The parent path if found, NULL otherwise
- */
-static char *
-gf_resolve_path_parent(const char *path)
-{
-    char *parent = NULL;
-    char *tmp = NULL;
-    char *pathc = NULL;
-
-    GF_VALIDATE_OR_GOTO(THIS->name, path, out);
-
-    if (0 == strlen(path)) {
-        gf_msg_callingfn(THIS->name, GF_LOG_DEBUG, 0, LG_MSG_INVALID_STRING,
-                         "invalid string for 'path'");
-        goto out;
-    }
-
-    /* dup the parameter, we don't want to modify it */
-    pathc = strdupa(path);
-    if (!pathc) {
-        goto out;
-    }
-
-    /* Get the parent directory */
-    tmp = dirname(pathc);
-    if (strcmp(tmp, "/") == 0)
-        goto out;
-
-    parent = gf_strdup(tmp);
-out:
-    return parent;
-}
-
 /**
  * mnt3_authenticate_request -- Given an RPC request and a path, check if the
  *                              host is authorized to make the request. This
  *                              function calls _mnt3_authenticate_req_path ()
- *                              in a loop for the parent of each path while
- *                              the authentication check for that path is
- *                              failing.
+ *                              in a loop for each exported parent of the
+ *                              path, deepest first, while the authentication
+ *                              check for that path is failing. The exported
+ *                              parents are found in the trie of the exports
+ *                              file.
  *
  * E.g. If the requested path is /patchy/L1, and /patchy is authorized, but
  * /patchy/L1 is not, it follows this code path :
@@ -2283,8 +2255,10 @@ mnt3_authenticate_request(struct mount3_state *ms, rpcsvc_request_t *req,
                           char **authorized_host, gf_boolean_t is_write_op)
 {
     int auth_status_code = -EACCES;
-    char *parent_path = NULL;
-    const char *parent_old = NULL;
+    struct export_dir *parents[GF_MNT3_AUTH_MAX_PARENTS];
+    struct exports_file *expfile = NULL;
+    struct timespec start, end;
+    int count = 0;
 
     GF_VALIDATE_OR_GOTO(GF_MNT, ms, out);
     GF_VALIDATE_OR_GOTO(GF_MNT, req, out);
@@ -2302,33 +2276,38 @@ mnt3_authenticate_request(struct mount3_state *ms, rpcsvc_request_t *req,
         goto out;
     }
 
-    /* First check if the path is allowed */
-    auth_status_code = _mnt3_authenticate_req(
-        ms, req, fh, path, authorized_path, authorized_host, is_write_op);
-
     /* If the filehandle is set, just exit since we have to make only
-     * one call to the function above
+     * one call to the function above. That is the case of every NFS
+     * request, whose cost is accounted for the statedump.
      */
-    if (fh)
+    if (fh) {
+        timespec_now(&start);
+        auth_status_code = _mnt3_authenticate_req(
+            ms, req, fh, path, authorized_path, authorized_host, is_write_op);
+        timespec_now(&end);
+
+        GF_ATOMIC_INC(ms->auth_fh_requests);
+        GF_ATOMIC_ADD(ms->auth_fh_ns, gf_tsdiff(&start, &end));
         goto out;
+    }
 
-    parent_old = path;
-    while (auth_status_code != 0) {
-        /* Get the path's parent */
-        parent_path = gf_resolve_path_parent(parent_old);
-        if (!parent_path) /* Nothing left in the path to resolve */
-            goto out;
-
-        /* Authenticate it */
-        auth_status_code = _mnt3_authenticate_req(ms, req, fh, parent_path,
-                                                  authorized_path,
-                                                  authorized_host, is_write_op);
+    /* First check if the path is allowed */
+    auth_status_code = _mnt3_authenticate_req(
+        ms, req, fh, path, authorized_path, authorized_host, is_write_op);
+    if ((auth_status_code == 0) || !path || !ms->auth_params)
+        goto out;
 
-        parent_old = strdupa(parent_path); /* Copy the parent onto the
-                                            * stack.
-                                            */
+    expfile = ms->auth_params->expfile;
+    if (!expfile)
+        goto out;
 
-        GF_FREE(parent_path); /* Free the allocated parent string */
+    count = exp_file_get_parent_dirs(expfile, path, parents,
+                                     GF_MNT3_AUTH_MAX_PARENTS);
+    while ((auth_status_code != 0) && (count > 0)) {
+        count--;
+        auth_status_code = _mnt3_authenticate_req(
+            ms, req, fh, parents[count]->dir_name, authorized_path,
+            authorized_host, is_write_op);
     }
 
 out:
@@ -3796,10 +3775,45 @@ mnt3_init_state(xlator_t *nfsx)
 
     INIT_LIST_HEAD(&ms->mountlist);
     LOCK_INIT(&ms->mountlock);
+    GF_ATOMIC_INIT(ms->auth_fh_requests, 0);
+    GF_ATOMIC_INIT(ms->auth_fh_ns, 0);
 
     return ms;
 }
 
+int32_t
+mnt3_priv(xlator_t *this)
+{
+    struct nfs_state *nfs = NULL;
+    struct mount3_state *ms = NULL;
+    char key[GF_DUMP_MAX_BUF_LEN];
+    uint64_t requests = 0;
+
+    nfs = (struct nfs_state *)this->private;
+    if (!nfs || !nfs->mstate)
+        return 0;
+
+    ms = nfs->mstate;
+    gf_proc_dump_add_section("nfs.auth");
+
+    requests = GF_ATOMIC_GET(ms->auth_fh_requests);
+    gf_proc_dump_build_key(key, "auth", "fh-requests");
+    gf_proc_dump_write(key, "%" PRIu64, requests);
+    gf_proc_dump_build_key(key, "auth", "fh-resolve-avg-ns");
+    gf_proc_dump_write(key, "%" PRIu64,
+                       requests ? GF_ATOMIC_GET(ms->auth_fh_ns) / requests : 0);
+
+    if (ms->authcache) {
+        gf_proc_dump_build_key(key, "auth", "cache-lookups");
+        gf_proc_dump_write(key, "%" PRIu64,
+                           GF_ATOMIC_GET(ms->authcache->lookups));
+        gf_proc_dump_build_key(key, "auth", "cache-hits");
+        gf_proc_dump_write(key, "%" PRIu64, GF_ATOMIC_GET(ms->authcache->hits));
+    }
+
+    return 0;
+}
+
 int
 mount_init_state(xlator_t *nfsx)
 {
@@ -31,6 +31,9 @@
 #define GF_MOUNTV1_PORT 38466
 #define GF_MNT GF_NFS "-mount"
 
+/* Deepest chain of exported parent directories tried for a mount path */
+#define GF_MNT3_AUTH_MAX_PARENTS 64
+
 extern rpcsvc_program_t *
 mnt3svc_init(xlator_t *nfsx);
 
@@ -63,6 +66,9 @@ mnt3_authenticate_request(struct mount3_state *ms, rpcsvc_request_t *req,
                           const char *path, char **authorized_path,
                           char **authorized_host, gf_boolean_t is_write_op);
 
+int32_t
+mnt3_priv(xlator_t *this);
+
 /* Data structure used to store the list of mounts points currently
  * in use by NFS clients.
  */
@@ -160,6 +166,10 @@ struct mount3_state {
     gf_boolean_t stop_refresh;
 
     struct auth_cache *authcache;
+
+    /* Authentication of the filehandles of NFS requests, for statedump */
+    gf_atomic_t auth_fh_requests;
+    gf_atomic_t auth_fh_ns;
 };
 
 #define gf_mnt3_export_dirs(mst) ((mst)->export_dirs)
@@ -43,6 +43,8 @@ enum gf_nfs_mem_types_ {
     gf_nfs_mt_auth_cache,
     gf_nfs_mt_auth_cache_entry,
     gf_nfs_mt_nlm4_notify,
+    gf_nfs_mt_write_gather,
+    gf_nfs_mt_dirstream,
     gf_nfs_mt_end
 };
 #endif
@@ -1544,14 +1544,22 @@ int32_t
 nfs_forget(xlator_t *this, inode_t *inode)
 {
     uint64_t ctx = 0;
+    uint64_t ctx2 = 0;
     struct nfs_inode_ctx *ictx = NULL;
+    struct nfs3_write_gather *wg = NULL;
 
-    if (inode_ctx_del(inode, this, &ctx))
+    if (inode_ctx_del2(inode, this, &ctx, &ctx2))
         return -1;
 
     ictx = (struct nfs_inode_ctx *)(uintptr_t)ctx;
     GF_FREE(ictx);
 
+    wg = (struct nfs3_write_gather *)(uintptr_t)ctx2;
+    if (wg) {
+        LOCK_DESTROY(&wg->lock);
+        GF_FREE(wg);
+    }
+
     return 0;
 }
 
@@ -1661,6 +1669,18 @@ nfs_priv(xlator_t *this)
         gf_msg_debug(this->name, 0, "Statedump of NLM failed");
         goto out;
     }
+
+    ret = mnt3_priv(this);
+    if (ret) {
+        gf_msg_debug(this->name, 0, "Statedump of MOUNT failed");
+        goto out;
+    }
+
+    ret = nfs3_priv(this);
+    if (ret) {
+        gf_msg_debug(this->name, 0, "Statedump of NFS3 failed");
+        goto out;
+    }
 out:
     return ret;
 }
@@ -1757,6 +1777,26 @@ struct volume_options options[] = {
                     "If the specified value is within the supported range "
                     "but not a multiple of 4096, it is rounded up to the "
                     "nearest multiple of 4096."},
+    {.key = {"nfs3.write-gather"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Coalesce the UNSTABLE writes to a file that arrive "
+                    "while a write to it is in progress into one vectored "
+                    "write, and answer the COMMITs that arrive while an "
+                    "fsync is in progress with a single following fsync. "
+                    "Only one write per file is in progress at a time, "
+                    "which helps many small writes but can slow down "
+                    "clients sending large writes in parallel."},
+    {.key = {"nfs3.readdir-streams"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 65536,
+     .default_value = "128",
+     .description = "Number of directory listings in progress whose "
+                    "position and read ahead entries are kept between "
+                    "READDIR/READDIRPLUS calls, so that a listing is read "
+                    "sequentially instead of seeking at every call. 0 "
+                    "disables it."},
     {.key = {"nfs3.*.volume-access"},
      .type = GF_OPTION_TYPE_STR,
      .value = {"read-only", "read-write"},
@@ -2043,6 +2083,13 @@ struct volume_options options[] = {
      .default_value = "0x20000",
      .description = "Sets the number of non-idempotent "
                     "requests to cache in drc"},
+    {.key = {"nfs.drc-client-size"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 64 * GF_UNIT_KB,
+     .default_value = "4MB",
+     .description = "Sets the memory the drc may hold for the requests "
+                    "of a single client. Its oldest requests are evicted "
+                    "to stay within it."},
     {.key = {"nfs.exports-auth-enable"},
      .type = GF_OPTION_TYPE_BOOL,
      .description = "Set the option to 'on' to enable exports/netgroup "
@@ -29,6 +29,7 @@
 #include "xdr-generic.h"
 #include "nfs-messages.h"
 #include "glfs-internal.h"
+#include <glusterfs/statedump.h>
 
 #include <sys/socket.h>
 #include <sys/uio.h>
@@ -509,6 +510,9 @@ nfs3_solaris_zerolen_fh(struct nfs3_fh *fh, int fhlen)
  */
 typedef ssize_t (*nfs3_serializer)(struct iovec outmsg, void *args);
 
+static void
+nfs3_dirstream_free(struct nfs3_dirstream *ds);
+
 static void
 __nfs3_call_state_wipe(nfs3_call_state_t *cs)
 {
@@ -527,6 +531,8 @@ __nfs3_call_state_wipe(nfs3_call_state_t *cs)
 
     nfs_loc_wipe(&cs->oploc);
     nfs_loc_wipe(&cs->resolvedloc);
+    if (cs->dirstream)
+        nfs3_dirstream_free(cs->dirstream);
     if (cs->iob)
         iobuf_unref(cs->iob);
     if (cs->iobref)
@@ -558,6 +564,7 @@ nfs3_call_state_init(struct nfs3_state *s, rpcsvc_request_t *req, xlator_t *v)
     GF_REF_INIT(cs, __nfs3_call_state_wipe);
     INIT_LIST_HEAD(&cs->entries.list);
     INIT_LIST_HEAD(&cs->openwait_q);
+    INIT_LIST_HEAD(&cs->gather_q);
     cs->operrno = EINVAL;
     cs->req = req;
     cs->vol = v;
@@ -2256,6 +2263,226 @@ __nfs3_write_resume(nfs3_call_state_t *cs)
     return ret;
 }
 
+static struct nfs3_write_gather *
+nfs3_write_gather_get(xlator_t *nfsx, inode_t *inode)
+{
+    struct nfs3_write_gather *wg = NULL;
+    uint64_t raw_ctx = 0;
+
+    LOCK(&inode->lock);
+    {
+        if ((__inode_ctx_get1(inode, nfsx, &raw_ctx) == 0) && raw_ctx) {
+            wg = (struct nfs3_write_gather *)(uintptr_t)raw_ctx;
+            goto unlock;
+        }
+
+        wg = GF_CALLOC(1, sizeof(*wg), gf_nfs_mt_write_gather);
+        if (!wg)
+            goto unlock;
+
+        LOCK_INIT(&wg->lock);
+        INIT_LIST_HEAD(&wg->writes);
+        INIT_LIST_HEAD(&wg->inflight);
+        INIT_LIST_HEAD(&wg->commits);
+        INIT_LIST_HEAD(&wg->syncing);
+
+        raw_ctx = (uint64_t)(uintptr_t)wg;
+        if (__inode_ctx_set1(inode, nfsx, &raw_ctx) != 0) {
+            LOCK_DESTROY(&wg->lock);
+            GF_FREE(wg);
+            wg = NULL;
+        }
+    }
+unlock:
+    UNLOCK(&inode->lock);
+
+    return wg;
+}
+
+/* Writes are only gathered when they are sent with the same credentials. */
+static gf_boolean_t
+nfs3_write_gather_same_user(rpcsvc_request_t *a, rpcsvc_request_t *b)
+{
+    if ((a->uid != b->uid) || (a->gid != b->gid) ||
+        (a->auxgidcount != b->auxgidcount))
+        return _gf_false;
+
+    if (!a->auxgidcount)
+        return _gf_true;
+
+    return (memcmp(a->auxgids, b->auxgids,
+                   a->auxgidcount * sizeof(*a->auxgids)) == 0);
+}
+
+static void
+nfs3_write_gather_send(struct nfs3_write_gather *wg);
+
+static void
+nfs3_write_gather_done(nfs3_call_state_t *lead, int32_t op_ret,
+                       int32_t op_errno, struct iatt *prebuf,
+                       struct iatt *postbuf)
+{
+    struct nfs3_write_gather *wg = NULL;
+    nfs3_call_state_t *cs = NULL;
+    nfs3_call_state_t *tmp = NULL;
+    nfsstat3 stat = NFS3ERR_SERVERFAULT;
+    uint64_t raw_ctx = 0;
+    size_t written = 0;
+    struct list_head done;
+
+    INIT_LIST_HEAD(&done);
+    inode_ctx_get1(lead->resolvedloc.inode, lead->nfsx, &raw_ctx);
+    wg = (struct nfs3_write_gather *)(uintptr_t)raw_ctx;
+
+    LOCK(&wg->lock);
+    {
+        list_splice_init(&wg->inflight, &done);
+    }
+    UNLOCK(&wg->lock);
+
+    /* The queued writes keep the inode, and so wg, alive. */
+    nfs3_write_gather_send(wg);
+
+    if (op_ret >= 0)
+        written = op_ret;
+
+    list_for_each_entry_safe(cs, tmp, &done, gather_q)
+    {
+        list_del_init(&cs->gather_q);
+        if (op_ret == -1) {
+            stat = nfs3_cbk_errno_status(op_ret, op_errno);
+        } else {
+            /* A short write is answered as short writes of the last
+             * requests of the batch.
+             */
+            stat = NFS3_OK;
+            cs->maxcount = min(written, (size_t)cs->datacount);
+            written -= cs->maxcount;
+        }
+
+        nfs3_log_write_res(rpcsvc_request_xid(cs->req), stat, op_errno,
+                           cs->maxcount, cs->writetype,
+                           cs->nfs3state->serverstart, cs->resolvedloc.path);
+        /* every request of the batch gets the wcc of the whole write */
+        nfs3_write_reply(cs->req, stat, cs->maxcount, cs->writetype,
+                         cs->nfs3state->serverstart, prebuf, postbuf);
+        nfs3_call_state_wipe(cs);
+    }
+}
+
+int32_t
+nfs3svc_write_gather_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                         int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                         struct iatt *postbuf, dict_t *xdata)
+{
+    nfs3_write_gather_done(frame->local, op_ret, op_errno, prebuf, postbuf);
+
+    return 0;
+}
+
+/* Sends the queued writes that continue the first one as a single write,
+ * unless a write is already in flight on the inode.
+ */
+static void
+nfs3_write_gather_send(struct nfs3_write_gather *wg)
+{
+    struct iovec vector[GF_NFS3_WRITE_GATHER_IOV];
+    nfs3_call_state_t *lead = NULL;
+    nfs3_call_state_t *cs = NULL;
+    nfs3_call_state_t *tmp = NULL;
+    struct iobref *iobref = NULL;
+    nfs_user_t nfu = {
+        0,
+    };
+    offset3 offset = 0;
+    size_t size = 0;
+    int count = 0;
+    int ret = -ENOMEM;
+
+    LOCK(&wg->lock);
+    {
+        if (!list_empty(&wg->inflight))
+            goto unlock;
+
+        list_for_each_entry_safe(cs, tmp, &wg->writes, gather_q)
+        {
+            if (lead && ((count == GF_NFS3_WRITE_GATHER_IOV) ||
+                         (cs->dataoffset != offset + size) ||
+                         (size + cs->datacount > GF_NFS3_WRITE_GATHER_SIZE) ||
+                         !nfs3_write_gather_same_user(lead->req, cs->req)))
+                break;
+
+            if (!lead) {
+                lead = cs;
+                offset = cs->dataoffset;
+            }
+
+            /* See __nfs3_write_resume() about the payload length. */
+            cs->datavec.iov_len = cs->datacount;
+            vector[count++] = cs->datavec;
+            size += cs->datacount;
+            list_move_tail(&cs->gather_q, &wg->inflight);
+        }
+    }
+unlock:
+    UNLOCK(&wg->lock);
+
+    if (!lead)
+        return;
+
+    GF_ATOMIC_INC(lead->nfs3state->gather_writes);
+    GF_ATOMIC_ADD(lead->nfs3state->gather_requests, count);
+
+    iobref = iobref_new();
+    if (!iobref)
+        goto err;
+
+    list_for_each_entry(cs, &wg->inflight, gather_q)
+    {
+        ret = iobref_merge(iobref, cs->iobref);
+        if (ret < 0)
+            goto err;
+    }
+
+    if (count > 1)
+        gf_msg_trace(GF_NFS3, 0, "gathered %d writes, %zu bytes at %" PRIu64,
+                     count, size, offset);
+
+    nfs_request_user_init(&nfu, lead->req);
+    ret = nfs_write(lead->nfsx, lead->vol, &nfu, lead->fd, iobref, vector,
+                    count, offset, nfs3svc_write_gather_cbk, lead);
+err:
+    if (iobref)
+        iobref_unref(iobref);
+
+    if (ret < 0)
+        nfs3_write_gather_done(lead, -1, -ret, NULL, NULL);
+}
+
+/* UNSTABLE writes are queued on the inode and sent by whoever finds no
+ * write in flight, the ones arriving meanwhile are gathered into the next
+ * write. The replies are sent when the gathered write completes.
+ */
+static int
+nfs3_write_gather(nfs3_call_state_t *cs)
+{
+    struct nfs3_write_gather *wg = NULL;
+
+    wg = nfs3_write_gather_get(cs->nfsx, cs->resolvedloc.inode);
+    if (!wg)
+        return __nfs3_write_resume(cs);
+
+    LOCK(&wg->lock);
+    {
+        list_add_tail(&cs->gather_q, &wg->writes);
+    }
+    UNLOCK(&wg->lock);
+
+    nfs3_write_gather_send(wg);
+
+    return 0;
+}
+
 int
 nfs3_write_resume(void *carg)
 {
@@ -2279,7 +2506,10 @@ nfs3_write_resume(void *carg)
 
     cs->fd = fd; /* Gets unrefd when the call state is wiped. */
 
-    ret = __nfs3_write_resume(cs);
+    if ((cs->writetype == UNSTABLE) && cs->nfs3state->write_gather)
+        ret = nfs3_write_gather(cs);
+    else
+        ret = __nfs3_write_resume(cs);
     if (ret < 0)
         stat = nfs3_errno_to_nfsstat3(-ret);
 nfs3err:
@@ -4162,6 +4392,221 @@ nfs3_readdir_reply(rpcsvc_request_t *req, nfsstat3 stat, struct nfs3_fh *dirfh,
     return 0;
 }
 
+static void
+nfs3_dirstream_free(struct nfs3_dirstream *ds)
+{
+    if (ds->fd)
+        fd_unref(ds->fd);
+    gf_dirent_free(&ds->entries);
+    GF_FREE(ds);
+}
+
+static void
+nfs3_dirstream_free_list(struct list_head *streams)
+{
+    struct nfs3_dirstream *ds = NULL;
+    struct nfs3_dirstream *tmp = NULL;
+
+    list_for_each_entry_safe(ds, tmp, streams, list)
+    {
+        list_del_init(&ds->list);
+        nfs3_dirstream_free(ds);
+    }
+}
+
+static gf_boolean_t
+nfs3_dirstream_same_client(union gf_sock_union *client,
+                           struct sockaddr_storage *peer)
+{
+    union gf_sock_union *addr = (union gf_sock_union *)peer;
+
+    if (client->storage.ss_family != peer->ss_family)
+        return _gf_false;
+
+    switch (peer->ss_family) {
+        case AF_INET:
+            return (client->sin.sin_addr.s_addr == addr->sin.sin_addr.s_addr);
+        case AF_INET6:
+            return !memcmp(&client->sin6.sin6_addr, &addr->sin6.sin6_addr,
+                           sizeof(addr->sin6.sin6_addr));
+        default:
+            return _gf_false;
+    }
+}
+
+/* Takes off the idle list the stream that the call continues, that is the
+ * one of the same client and directory, with the cookie verifier and the
+ * cookie of the call. Otherwise starts a new stream at the cookie of the
+ * call, which covers the first call of a listing as well as the listings
+ * whose stream was dropped.
+ */
+static struct nfs3_dirstream *
+nfs3_dirstream_get(nfs3_call_state_t *cs)
+{
+    struct nfs3_state *nfs3 = cs->nfs3state;
+    struct sockaddr_storage *peer = &cs->req->trans->peerinfo.sockaddr;
+    inode_t *inode = cs->resolvedloc.inode;
+    struct nfs3_dirstream *ds = NULL;
+    struct nfs3_dirstream *tmp = NULL;
+    struct nfs3_dirstream *found = NULL;
+    struct list_head expired;
+    time_t now = gf_time();
+    uint64_t verf = 0;
+
+    INIT_LIST_HEAD(&expired);
+
+    LOCK(&nfs3->dirstreamlock);
+    {
+        list_for_each_entry_safe(ds, tmp, &nfs3->dirstreams, list)
+        {
+            if (now - ds->last_used > GF_NFS3_DIRSTREAM_TIMEOUT) {
+                list_move(&ds->list, &expired);
+                nfs3->dirstreamcount--;
+                continue;
+            }
+
+            if (found || !cs->cookie || ds->verf != cs->cookieverf ||
+                ds->cookie != cs->cookie || gf_uuid_compare(ds->gfid,
+                                                            inode->gfid) ||
+                !nfs3_dirstream_same_client(&ds->client, peer))
+                continue;
+
+            list_del_init(&ds->list);
+            nfs3->dirstreamcount--;
+            found = ds;
+        }
+
+        if (!found)
+            verf = nfs3->serverstart + ++nfs3->dirstreamgen;
+    }
+    UNLOCK(&nfs3->dirstreamlock);
+
+    nfs3_dirstream_free_list(&expired);
+    if (found)
+        return found;
+
+    ds = GF_CALLOC(1, sizeof(*ds), gf_nfs_mt_dirstream);
+    if (!ds)
+        return NULL;
+
+    ds->fd = fd_anonymous(inode);
+    if (!ds->fd) {
+        GF_FREE(ds);
+        return NULL;
+    }
+
+    INIT_LIST_HEAD(&ds->list);
+    INIT_LIST_HEAD(&ds->entries.list);
+    ds->verf = verf;
+    ds->cookie = cs->cookie;
+    gf_uuid_copy(ds->gfid, inode->gfid);
+    memcpy(&ds->client.storage, peer, sizeof(*peer));
+
+    return ds;
+}
+
+/* Puts the stream of the call back on the idle list, unless the listing
+ * reached the end of the directory, dropping the streams left unused the
+ * longest beyond the maximum.
+ */
+static void
+nfs3_dirstream_put(nfs3_call_state_t *cs, gf_boolean_t done)
+{
+    struct nfs3_state *nfs3 = cs->nfs3state;
+    struct nfs3_dirstream *ds = cs->dirstream;
+    struct list_head dropped;
+
+    cs->dirstream = NULL;
+    INIT_LIST_HEAD(&dropped);
+    if (done) {
+        nfs3_dirstream_free(ds);
+        return;
+    }
+
+    ds->last_used = gf_time();
+    LOCK(&nfs3->dirstreamlock);
+    {
+        list_add(&ds->list, &nfs3->dirstreams);
+        nfs3->dirstreamcount++;
+        while (nfs3->dirstreamcount > nfs3->max_dirstreams) {
+            list_move(nfs3->dirstreams.prev, &dropped);
+            nfs3->dirstreamcount--;
+        }
+    }
+    UNLOCK(&nfs3->dirstreamlock);
+
+    nfs3_dirstream_free_list(&dropped);
+}
+
+/* Moves to the call the entries of its stream that fit in the reply, the
+ * way nfs3_fill_readdir3res() and nfs3_fill_readdirp3res() count them.
+ */
+static void
+nfs3_dirstream_take(nfs3_call_state_t *cs)
+{
+    struct nfs3_dirstream *ds = cs->dirstream;
+    gf_dirent_t *entry = NULL;
+    gf_dirent_t *tmp = NULL;
+    count3 filled = NFS3_READDIR_RESOK_SIZE;
+    count3 dirfilled = NFS3_READDIR_RESOK_SIZE;
+    size_t namelen = 0;
+
+    list_for_each_entry_safe(entry, tmp, &ds->entries.list, list)
+    {
+        if (dirfilled >= cs->dircount)
+            break;
+        if (cs->maxcount && (filled >= cs->maxcount))
+            break;
+
+        namelen = strlen(entry->d_name);
+        dirfilled += NFS3_ENTRY3_FIXED_SIZE + namelen;
+        filled += NFS3_ENTRYP3_FIXED_SIZE + nfs3_fh_compute_size() + namelen;
+
+        list_move_tail(&entry->list, &cs->entries.list);
+        ds->cookie = entry->d_off;
+    }
+}
+
+static void
+nfs3_readdir_send(nfs3_call_state_t *cs, nfsstat3 stat, int op_errno,
+                  struct iatt *dirstat, int is_eof)
+{
+    uint64_t cverf = (uintptr_t)cs->fd;
+
+    if (cs->dirstream)
+        cverf = cs->dirstream->verf;
+
+    if (cs->maxcount == 0) {
+        nfs3_log_readdir_res(rpcsvc_request_xid(cs->req), stat, op_errno,
+                             cverf, cs->dircount, is_eof,
+                             cs->resolvedloc.path);
+        nfs3_readdir_reply(cs->req, stat, &cs->parent, cverf, dirstat,
+                           &cs->entries, cs->dircount, is_eof);
+    } else {
+        nfs3_log_readdirp_res(rpcsvc_request_xid(cs->req), stat, op_errno,
+                              cverf, cs->dircount, cs->maxcount, is_eof,
+                              cs->resolvedloc.path);
+        nfs3_readdirp_reply(cs->req, stat, &cs->parent, cverf, dirstat,
+                            &cs->entries, cs->dircount, cs->maxcount, is_eof);
+    }
+
+    if (cs->dirstream)
+        nfs3_dirstream_put(cs, (stat != NFS3_OK) || is_eof);
+
+    nfs3_call_state_wipe(cs);
+}
+
+/* Answers a call from the entries its stream read ahead. */
+static void
+nfs3_readdir_stream_send(nfs3_call_state_t *cs)
+{
+    struct nfs3_dirstream *ds = cs->dirstream;
+
+    nfs3_dirstream_take(cs);
+    nfs3_readdir_send(cs, NFS3_OK, 0, &ds->dirstat,
+                      ds->eof && list_empty(&ds->entries.list));
+}
+
 int32_t
 nfs3svc_readdir_fstat_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                           int32_t op_ret, int32_t op_errno, struct iatt *buf,
@@ -4177,6 +4622,13 @@ nfs3svc_readdir_fstat_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         goto nfs3err;
     }
 
+    if (cs->dirstream) {
+        gf_link_inodes_from_dirent(cs->fd->inode, &cs->dirstream->entries);
+        cs->dirstream->dirstat = *buf;
+        nfs3_readdir_stream_send(cs);
+        return 0;
+    }
+
     /* Check whether we encountered a end of directory stream while
      * readdir'ing.
      */
@@ -4191,25 +4643,7 @@ nfs3svc_readdir_fstat_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     gf_link_inodes_from_dirent(cs->fd->inode, &cs->entries);
 
 nfs3err:
-    if (cs->maxcount == 0) {
-        nfs3_log_readdir_res(rpcsvc_request_xid(cs->req), stat, op_errno,
-                             (uintptr_t)cs->fd, cs->dircount, is_eof,
-                             cs->resolvedloc.path);
-        nfs3_readdir_reply(cs->req, stat, &cs->parent, (uintptr_t)cs->fd, buf,
-                           &cs->entries, cs->dircount, is_eof);
-    } else {
-        nfs3_log_readdirp_res(rpcsvc_request_xid(cs->req), stat, op_errno,
-                              (uintptr_t)cs->fd, cs->dircount, cs->maxcount,
-                              is_eof, cs->resolvedloc.path);
-        nfs3_readdirp_reply(cs->req, stat, &cs->parent, (uintptr_t)cs->fd, buf,
-                            &cs->entries, cs->dircount, cs->maxcount, is_eof);
-    }
-
-    if (is_eof) {
-        /* do nothing */
-    }
-
-    nfs3_call_state_wipe(cs);
+    nfs3_readdir_send(cs, stat, op_errno, buf, is_eof);
     return 0;
 }
 
@@ -4232,7 +4666,15 @@ nfs3svc_readdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     }
 
     cs->operrno = op_errno;
-    list_splice_init(&entries->list, &cs->entries.list);
+    if (cs->dirstream) {
+        list_splice_init(&entries->list, &cs->dirstream->entries.list);
+        if (op_errno == ENOENT) {
+            gf_msg_trace(GF_NFS3, 0, "Reached end-of-directory");
+            cs->dirstream->eof = 1;
+        }
+    } else {
+        list_splice_init(&entries->list, &cs->entries.list);
+    }
     nfs_request_user_init(&nfu, cs->req);
     ret = nfs_fstat(cs->nfsx, cs->vol, &nfu, cs->fd, nfs3svc_readdir_fstat_cbk,
                     cs);
@@ -4272,13 +4714,34 @@ nfs3_readdir_process(nfs3_call_state_t *cs)
     nfs_user_t nfu = {
         0,
     };
+    struct nfs3_dirstream *ds = NULL;
+    size_t size = 0;
+    off_t offset = 0;
 
     if (!cs)
         return ret;
 
+    size = cs->dircount;
+    offset = cs->cookie;
+
+    /* A stream answers from the entries it read ahead, and otherwise reads
+     * several replies worth of them from where the last reply ended.
+     */
+    ds = cs->dirstream;
+    if (ds) {
+        if (!list_empty(&ds->entries.list) || ds->eof) {
+            nfs3_readdir_stream_send(cs);
+            return 0;
+        }
+
+        size = min((uint64_t)cs->dircount * GF_NFS3_DIRSTREAM_BATCH,
+                   cs->nfs3state->readdirsize);
+        offset = ds->cookie;
+    }
+
     nfs_request_user_init(&nfu, cs->req);
-    ret = nfs_readdirp(cs->nfsx, cs->vol, &nfu, cs->fd, cs->dircount,
-                       cs->cookie, nfs3svc_readdir_cbk, cs);
+    ret = nfs_readdirp(cs->nfsx, cs->vol, &nfu, cs->fd, size, offset,
+                       nfs3svc_readdir_cbk, cs);
     return ret;
 }
 
@@ -4352,7 +4815,13 @@ nfs3_readdir_open_resume(void *carg)
 
     cs = (nfs3_call_state_t *)carg;
     nfs3_check_fh_resolve_status(cs, stat, nfs3err);
-    cs->fd = fd_anonymous(cs->resolvedloc.inode);
+    if (cs->nfs3state->max_dirstreams)
+        cs->dirstream = nfs3_dirstream_get(cs);
+
+    if (cs->dirstream)
+        cs->fd = fd_ref(cs->dirstream->fd);
+    else
+        cs->fd = fd_anonymous(cs->resolvedloc.inode);
     if (!cs->fd) {
         gf_msg(GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_ANONYMOUS_FD_FAIL,
                "Fail to create anonymous fd");
@@ -5015,38 +5484,99 @@ nfs3_commit_reply(rpcsvc_request_t *req, nfsstat3 stat, uint64_t wverf,
     return 0;
 }
 
-int32_t
-nfs3svc_commit_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
-                   int32_t op_ret, int32_t op_errno, dict_t *xdata)
+static void
+nfs3_commit_gather_send(struct nfs3_write_gather *wg);
+
+static void
+nfs3_commit_gather_done(nfs3_call_state_t *lead, int32_t op_ret,
+                        int32_t op_errno, struct iatt *prebuf,
+                        struct iatt *postbuf)
 {
-    nfsstat3 stat = NFS3ERR_SERVERFAULT;
+    struct nfs3_write_gather *wg = NULL;
     nfs3_call_state_t *cs = NULL;
-    struct nfs3_state *nfs3 = NULL;
+    nfs3_call_state_t *tmp = NULL;
+    nfsstat3 stat = NFS3ERR_SERVERFAULT;
+    uint64_t raw_ctx = 0;
+    struct list_head done;
 
-    cs = frame->local;
-    if (op_ret == -1) {
+    INIT_LIST_HEAD(&done);
+    inode_ctx_get1(lead->resolvedloc.inode, lead->nfsx, &raw_ctx);
+    wg = (struct nfs3_write_gather *)(uintptr_t)raw_ctx;
+
+    LOCK(&wg->lock);
+    {
+        list_splice_init(&wg->syncing, &done);
+    }
+    UNLOCK(&wg->lock);
+
+    /* COMMITs which arrived during this fsync may cover writes it missed,
+     * they get an fsync of their own.
+     */
+    nfs3_commit_gather_send(wg);
+
+    if (op_ret == -1)
         stat = nfs3_cbk_errno_status(op_ret, op_errno);
-    } else
+    else
         stat = NFS3_OK;
 
-    nfs3 = rpcsvc_request_program_private(cs->req);
-    nfs3_log_commit_res(rpcsvc_request_xid(cs->req), stat, op_errno,
-                        nfs3->serverstart, cs->resolvedloc.path);
-    nfs3_commit_reply(cs->req, stat, nfs3->serverstart, NULL, NULL);
-    nfs3_call_state_wipe(cs);
+    list_for_each_entry_safe(cs, tmp, &done, gather_q)
+    {
+        list_del_init(&cs->gather_q);
+        nfs3_log_commit_res(rpcsvc_request_xid(cs->req), stat, op_errno,
+                            cs->nfs3state->serverstart, cs->resolvedloc.path);
+        nfs3_commit_reply(cs->req, stat, cs->nfs3state->serverstart,
+                          (cs == lead) ? prebuf : NULL, postbuf);
+        nfs3_call_state_wipe(cs);
+    }
+}
+
+int32_t
+nfs3svc_commit_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                   int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                   struct iatt *postbuf, dict_t *xdata)
+{
+    nfs3_commit_gather_done(frame->local, op_ret, op_errno, prebuf, postbuf);
 
     return 0;
 }
 
+/* Sends one fsync for all the queued COMMITs, unless one is in flight. */
+static void
+nfs3_commit_gather_send(struct nfs3_write_gather *wg)
+{
+    nfs3_call_state_t *lead = NULL;
+    nfs_user_t nfu = {
+        0,
+    };
+    int ret = -EFAULT;
+
+    LOCK(&wg->lock);
+    {
+        if (list_empty(&wg->syncing) && !list_empty(&wg->commits)) {
+            list_splice_init(&wg->commits, &wg->syncing);
+            lead = list_first_entry(&wg->syncing, nfs3_call_state_t,
+                                    gather_q);
+        }
+    }
+    UNLOCK(&wg->lock);
+
+    if (!lead)
+        return;
+
+    nfs_request_user_init(&nfu, lead->req);
+    ret = nfs_fsync(lead->nfsx, lead->vol, &nfu, lead->fd, 1,
+                    nfs3svc_commit_cbk, lead);
+    if (ret < 0)
+        nfs3_commit_gather_done(lead, -1, -ret, NULL, NULL);
+}
+
 int
 nfs3_commit_resume(void *carg)
 {
     nfsstat3 stat = NFS3ERR_SERVERFAULT;
     int ret = -EFAULT;
-    nfs_user_t nfu = {
-        0,
-    };
     nfs3_call_state_t *cs = NULL;
+    struct nfs3_write_gather *wg = NULL;
 
     if (!carg)
         return ret;
@@ -5060,10 +5590,24 @@ nfs3_commit_resume(void *carg)
         goto nfs3err;
     }
 
-    nfs_request_user_init(&nfu, cs->req);
-    ret = nfs_flush(cs->nfsx, cs->vol, &nfu, cs->fd, nfs3svc_commit_cbk, cs);
-    if (ret < 0)
+    wg = nfs3_write_gather_get(cs->nfsx, cs->resolvedloc.inode);
+    if (!wg) {
+        ret = -ENOMEM;
         stat = nfs3_errno_to_nfsstat3(-ret);
+        goto nfs3err;
+    }
+
+    /* The COMMIT waits for the fsync in flight, if any, and is answered
+     * along with the others that arrive meanwhile by the next one.
+     */
+    LOCK(&wg->lock);
+    {
+        list_add_tail(&cs->gather_q, &wg->commits);
+    }
+    UNLOCK(&wg->lock);
+
+    nfs3_commit_gather_send(wg);
+    ret = 0;
 
 nfs3err:
     if (ret < 0) {
@@ -5329,6 +5873,46 @@ nfs3_init_options(struct nfs3_state *nfs3, dict_t *options)
         nfs3->readdirsize = size64;
     }
 
+    /* nfs3.write-gather */
+    nfs3->write_gather = _gf_false;
+    if (dict_get(options, "nfs3.write-gather")) {
+        ret = dict_get_str(options, "nfs3.write-gather", &optstr);
+        if (ret < 0) {
+            gf_msg(GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_READ_FAIL,
+                   "Failed to read option: nfs3.write-gather");
+            ret = -1;
+            goto err;
+        }
+
+        ret = gf_string2boolean(optstr, &nfs3->write_gather);
+        if (ret == -1) {
+            gf_msg(GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_FORMAT_FAIL,
+                   "Failed to format option: nfs3.write-gather");
+            ret = -1;
+            goto err;
+        }
+    }
+
+    /* nfs3.readdir-streams */
+    nfs3->max_dirstreams = GF_NFS3_DIRSTREAMS_DEFAULT;
+    if (dict_get(options, "nfs3.readdir-streams")) {
+        ret = dict_get_str(options, "nfs3.readdir-streams", &optstr);
+        if (ret < 0) {
+            gf_msg(GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_READ_FAIL,
+                   "Failed to read option: nfs3.readdir-streams");
+            ret = -1;
+            goto err;
+        }
+
+        ret = gf_string2uint32(optstr, &nfs3->max_dirstreams);
+        if (ret == -1) {
+            gf_msg(GF_NFS3, GF_LOG_ERROR, 0, NFS_MSG_FORMAT_FAIL,
+                   "Failed to format option: nfs3.readdir-streams");
+            ret = -1;
+            goto err;
+        }
+    }
+
     /* We want to use the size of the biggest param for the io buffer size.
      */
     nfs3->iobsize = nfs3->readsize;
@@ -5643,10 +6227,17 @@ nfs3_init_state(xlator_t *nfsx)
         goto free_localpool;
     }
 
-    nfs3->serverstart = (uint64_t)gf_time();
+    /* The write verifier, it has to change whenever the server restarts,
+     * also within the same second.
+     */
+    nfs3->serverstart = ((uint64_t)gf_time() << 32) | (uint32_t)getpid();
     INIT_LIST_HEAD(&nfs3->fdlru);
     LOCK_INIT(&nfs3->fdlrulock);
     nfs3->fdcount = 0;
+    INIT_LIST_HEAD(&nfs3->dirstreams);
+    LOCK_INIT(&nfs3->dirstreamlock);
+    GF_ATOMIC_INIT(nfs3->gather_writes, 0);
+    GF_ATOMIC_INIT(nfs3->gather_requests, 0);
 
     ret = rpcsvc_create_listeners(nfs->rpcsvc, nfsx->options, nfsx->name);
     if (ret == -1) {
@@ -5728,3 +6319,27 @@ nfs3_reconfigure_state(xlator_t *nfsx, dict_t *options)
 out:
     return ret;
 }
+
+int32_t
+nfs3_priv(xlator_t *this)
+{
+    struct nfs_state *nfs = NULL;
+    struct nfs3_state *nfs3 = NULL;
+    char key[GF_DUMP_MAX_BUF_LEN];
+
+    nfs = (struct nfs_state *)this->private;
+    if (!nfs || !nfs->nfs3state)
+        return 0;
+
+    nfs3 = nfs->nfs3state;
+    gf_proc_dump_add_section("nfs.nfs3");
+
+    gf_proc_dump_build_key(key, "write-gather", "enabled");
+    gf_proc_dump_write(key, "%d", nfs3->write_gather);
+    gf_proc_dump_build_key(key, "write-gather", "writes");
+    gf_proc_dump_write(key, "%" PRIu64, GF_ATOMIC_GET(nfs3->gather_writes));
+    gf_proc_dump_build_key(key, "write-gather", "requests");
+    gf_proc_dump_write(key, "%" PRIu64, GF_ATOMIC_GET(nfs3->gather_requests));
+
+    return 0;
+}
@@ -94,6 +94,48 @@
 #define GF_NFS3_VOLACCESS_RO 2
 
 #define GF_NFS3_FDCACHE_SIZE 512
+
+/* Limits of a gathered write, see nfs3.write-gather */
+#define GF_NFS3_WRITE_GATHER_SIZE GF_NFS3_FILE_IO_SIZE_MAX
+#define GF_NFS3_WRITE_GATHER_IOV 64
+
+/* Per inode state of the gathering of UNSTABLE writes and of COMMITs,
+ * stored in the second value of the inode ctx of the NFS xlator. While a
+ * write (or an fsync) is in flight on the inode, the following ones are
+ * queued and sent together once it finishes.
+ */
+struct nfs3_write_gather {
+    gf_lock_t lock;
+    struct list_head writes;   /* UNSTABLE writes waiting to be sent */
+    struct list_head inflight; /* writes part of the write in flight */
+    struct list_head commits;  /* COMMITs waiting for the next fsync */
+    struct list_head syncing;  /* COMMITs answered by the fsync in flight */
+};
+#define GF_NFS3_DIRSTREAMS_DEFAULT 128
+/* Seconds after which an idle directory stream is dropped */
+#define GF_NFS3_DIRSTREAM_TIMEOUT 30
+/* Replies worth of entries a directory stream reads from the volume at once */
+#define GF_NFS3_DIRSTREAM_BATCH 4
+
+/* The cursor of a client listing a directory with READDIR(PLUS). It keeps
+ * the fd, the entries read ahead with their attributes, and the attributes
+ * of the directory between the calls. The next call of the listing finds
+ * it again through the cookie verifier handed out with its entries and the
+ * cookie of the last one.
+ */
+struct nfs3_dirstream {
+    struct list_head list; /* in nfs3_state->dirstreams, latest used first */
+    uint64_t verf;
+    uint64_t cookie; /* d_off of the last entry returned */
+    uuid_t gfid;
+    union gf_sock_union client;
+    fd_t *fd;
+    gf_dirent_t entries; /* read ahead and not returned yet */
+    struct iatt dirstat;
+    time_t last_used;
+    int eof; /* the entries read ahead end the directory */
+};
+
 /* This should probably be moved to a more generic layer so that if needed
  * different versions of NFS protocol can use the same thing.
  */
@@ -143,6 +185,11 @@ typedef struct nfs3_state {
     uint64_t readsize;
     uint64_t writesize;
     uint64_t readdirsize;
+    gf_boolean_t write_gather;
+
+    /* Writes sent by the write gathering, and the requests they carried */
+    gf_atomic_t gather_writes;
+    gf_atomic_t gather_requests;
 
     /* Size of the iobufs used, depends on the sizes of the three params
      * above.
@@ -153,6 +200,13 @@ typedef struct nfs3_state {
     gf_lock_t fdlrulock;
     int fdcount;
     uint32_t occ_logger;
+
+    /* Idle directory streams, see struct nfs3_dirstream */
+    struct list_head dirstreams;
+    gf_lock_t dirstreamlock;
+    uint32_t dirstreamcount;
+    uint32_t max_dirstreams;
+    uint64_t dirstreamgen;
 } nfs3_state_t;
 
 typedef enum nfs3_lookup_type {
@@ -207,6 +261,11 @@ struct nfs3_local {
      */
     struct list_head openwait_q;
 
+    /* The list hook to queue this WRITE or COMMIT on the inode's
+     * struct nfs3_write_gather.
+     */
+    struct list_head gather_q;
+
     /* Per-NFSv3 Op state */
     struct nfs3_fh parent;
     struct nfs3_fh fh;
@@ -238,6 +297,7 @@ struct nfs3_local {
     struct iovec datavec;
     mode_t mode;
     struct iatt attr_in;
+    struct nfs3_dirstream *dirstream;
 
     /* NFSv3 FH resolver state */
     int hardresolved;
@@ -292,4 +352,7 @@ nfs3_reconfigure_state(xlator_t *nfsx, dict_t *options);
 extern uint64_t
 nfs3_request_xlator_deviceid(rpcsvc_request_t *req);
 
+extern int32_t
+nfs3_priv(xlator_t *this);
+
 #endif
@@ -34,7 +34,7 @@ GLFS_MSGID(IO_CACHE, IO_CACHE_MSG_ENFORCEMENT_FAILED,
            IO_CACHE_MSG_ALLOC_MEM_POOL_FAILED, IO_CACHE_MSG_NULL_PAGE_WAIT,
            IO_CACHE_MSG_FRAME_NULL, IO_CACHE_MSG_PAGE_FAULT,
            IO_CACHE_MSG_SERVE_READ_REQUEST, IO_CACHE_MSG_LOCAL_NULL,
-           IO_CACHE_MSG_DEFAULTING_TO_OLD);
+           IO_CACHE_MSG_DEFAULTING_TO_OLD, IO_CACHE_MSG_PAGE_SIZE_TOO_LARGE);
 
 #define IO_CACHE_MSG_NO_MEMORY_STR "out of memory"
 #define IO_CACHE_MSG_ENFORCEMENT_FAILED_STR "inode context is NULL"
@@ -66,4 +66,6 @@ GLFS_MSGID(IO_CACHE, IO_CACHE_MSG_ENFORCEMENT_FAILED,
 #define IO_CACHE_MSG_DEFAULTING_TO_OLD_STR                                     \
     "minimum size of file that can be cached is greater than maximum size. "   \
     "Hence Defaulting to old value"
+#define IO_CACHE_MSG_PAGE_SIZE_TOO_LARGE_STR                                   \
+    "page-size is larger than a shard's share of cache-size"
 #endif /* _IO_CACHE_MESSAGES_H_ */
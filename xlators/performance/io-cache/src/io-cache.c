@@ -115,7 +115,7 @@ ioc_update_pages(call_frame_t *frame, ioc_inode_t *ioc_inode,
                                count, write_offset, page_end - page_offset);
             } else if (trav) {
                 if (!trav->waitq)
-                    ioc_inode->table->cache_used -= __ioc_page_destroy(trav);
+                    __ioc_page_destroy(trav);
             }
 
             if (trav_offset == rounded_offset)
@@ -173,22 +173,12 @@ __ioc_inode_flush(ioc_inode_t *ioc_inode)
 void
 ioc_inode_flush(ioc_inode_t *ioc_inode)
 {
-    int64_t destroy_size = 0;
-
     ioc_inode_lock(ioc_inode);
     {
-        destroy_size = __ioc_inode_flush(ioc_inode);
+        __ioc_inode_flush(ioc_inode);
     }
     ioc_inode_unlock(ioc_inode);
 
-    if (destroy_size) {
-        ioc_table_lock(ioc_inode->table);
-        {
-            ioc_inode->table->cache_used -= destroy_size;
-        }
-        ioc_table_unlock(ioc_inode->table);
-    }
-
     return;
 }
 
@@ -265,13 +255,6 @@ ioc_inode_update(xlator_t *this, inode_t *inode, char *path, struct iatt *iabuf)
         ioc_inode_flush(ioc_inode);
     }
 
-    ioc_table_lock(ioc_inode->table);
-    {
-        list_move_tail(&ioc_inode->inode_lru,
-                       &table->inode_lru[ioc_inode->weight]);
-    }
-    ioc_table_unlock(ioc_inode->table);
-
 out:
     return 0;
 }
@@ -402,7 +385,6 @@ ioc_cache_validate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 {
     ioc_local_t *local = NULL;
     ioc_inode_t *ioc_inode = NULL;
-    size_t destroy_size = 0;
     struct iatt *local_stbuf = NULL;
 
     local = frame->local;
@@ -420,7 +402,7 @@ ioc_cache_validate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
          */
         ioc_inode_lock(ioc_inode);
         {
-            destroy_size = __ioc_inode_flush(ioc_inode);
+            __ioc_inode_flush(ioc_inode);
             if (op_ret >= 0) {
                 ioc_inode->cache.mtime = stbuf->ia_mtime;
                 ioc_inode->cache.mtime_nsec = stbuf->ia_mtime_nsec;
@@ -430,14 +412,6 @@ ioc_cache_validate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         local_stbuf = NULL;
     }
 
-    if (destroy_size) {
-        ioc_table_lock(ioc_inode->table);
-        {
-            ioc_inode->table->cache_used -= destroy_size;
-        }
-        ioc_table_unlock(ioc_inode->table);
-    }
-
     if (op_ret < 0)
         local_stbuf = NULL;
 
@@ -618,13 +592,6 @@ ioc_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
             goto out;
         }
 
-        ioc_table_lock(ioc_inode->table);
-        {
-            list_move_tail(&ioc_inode->inode_lru,
-                           &table->inode_lru[ioc_inode->weight]);
-        }
-        ioc_table_unlock(ioc_inode->table);
-
         ioc_inode_lock(ioc_inode);
         {
             if ((table->min_file_size > ioc_inode->ia_size) ||
@@ -918,23 +885,6 @@ ioc_release(xlator_t *this, fd_t *fd)
     return 0;
 }
 
-int32_t
-ioc_need_prune(ioc_table_t *table)
-{
-    int64_t cache_difference = 0;
-
-    ioc_table_lock(table);
-    {
-        cache_difference = table->cache_used - table->cache_size;
-    }
-    ioc_table_unlock(table);
-
-    if (cache_difference > 0)
-        return 1;
-    else
-        return 0;
-}
-
 /*
  * ioc_dispatch_requests -
  *
@@ -997,6 +947,7 @@ ioc_dispatch_requests(call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
                  */
                 trav = __ioc_page_create(ioc_inode, trav_offset);
                 fault = 1;
+                GF_ATOMIC_INC(table->misses);
                 if (!trav) {
                     gf_smsg(frame->this->name, GF_LOG_CRITICAL, ENOMEM,
                             IO_CACHE_MSG_NO_MEMORY, NULL);
@@ -1019,6 +970,7 @@ ioc_dispatch_requests(call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
                                  "/local_"
                                  "offset=%" PRId64 "",
                                  trav_offset, local_offset);
+                    GF_ATOMIC_INC(table->hits);
                     waitq = __ioc_page_wakeup(trav, trav->op_errno);
                 } else {
                     /* if waitq already exists, fstat
@@ -1052,7 +1004,8 @@ ioc_dispatch_requests(call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
 
         if (fault) {
             fault = 0;
-            /* new page created, increase the table->cache_used */
+            /* new page created, it is charged to its shard once the
+             * data arrives */
             ioc_page_fault(ioc_inode, frame, fd, trav_offset);
         }
 
@@ -1082,10 +1035,6 @@ ioc_dispatch_requests(call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
 out:
     ioc_frame_return(frame);
 
-    if (ioc_need_prune(ioc_inode->table)) {
-        ioc_prune(ioc_inode->table);
-    }
-
     return;
 }
 
@@ -1106,7 +1055,6 @@ ioc_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     uint64_t tmp_ioc_inode = 0;
     ioc_inode_t *ioc_inode = NULL;
     ioc_local_t *local = NULL;
-    uint32_t weight = 0;
     ioc_table_t *table = NULL;
     int32_t op_errno = EINVAL;
 
@@ -1187,15 +1135,6 @@ ioc_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                  "= %" PRId64 " && size = %" GF_PRI_SIZET "",
                  frame, offset, size);
 
-    weight = ioc_inode->weight;
-
-    ioc_table_lock(ioc_inode->table);
-    {
-        list_move_tail(&ioc_inode->inode_lru,
-                       &ioc_inode->table->inode_lru[weight]);
-    }
-    ioc_table_unlock(ioc_inode->table);
-
     ioc_dispatch_requests(frame, ioc_inode, fd, offset, size);
     return 0;
 
@@ -1529,9 +1468,6 @@ ioc_get_priority_list(const char *opt_str, struct list_head *first)
     /* Get the pattern for cache priority.
      * "option priority *.jpg:1,abc*:2" etc
      */
-    /* TODO: inode_lru in table is statically hard-coded to 5,
-     * should be changed to run-time configuration
-     */
     stripe_str = strtok_r(string, ",", &tmp_str);
     while (stripe_str) {
         curr = GF_CALLOC(1, sizeof(struct ioc_priority),
@@ -1600,6 +1536,37 @@ out:
     return max_pri;
 }
 
+static int64_t
+ioc_metric_cache_used(void *data)
+{
+    return ioc_cache_used(data);
+}
+
+static void
+ioc_metrics_register(xlator_t *this, ioc_table_t *table)
+{
+    char labels[256];
+    char name[240];
+
+    gf_metric_label_escape(name, sizeof(name), this->name);
+    snprintf(labels, sizeof(labels), "xlator=\"%s\"", name);
+
+    table->metrics[0] = gf_metric_register_fn(
+        "gluster_iocache_hits_total", labels, "Reads served from io-cache",
+        GF_METRIC_COUNTER, gf_metric_read_atomic, &table->hits);
+    table->metrics[1] = gf_metric_register_fn(
+        "gluster_iocache_misses_total", labels,
+        "Pages io-cache had to fetch", GF_METRIC_COUNTER,
+        gf_metric_read_atomic, &table->misses);
+    table->metrics[2] = gf_metric_register_fn(
+        "gluster_iocache_evictions_total", labels,
+        "Pages evicted by the clock hand", GF_METRIC_COUNTER,
+        gf_metric_read_atomic, &table->evictions);
+    table->metrics[3] = gf_metric_register_fn(
+        "gluster_iocache_bytes", labels, "Bytes cached by io-cache",
+        GF_METRIC_GAUGE, ioc_metric_cache_used, table);
+}
+
 int32_t
 mem_acct_init(xlator_t *this)
 {
@@ -1655,6 +1622,16 @@ out:
     return ret;
 }
 
+/*
+ * Each shard evicts against cache-size / IOC_SHARD_COUNT, so a page
+ * larger than that could never stay cached.
+ */
+static gf_boolean_t
+ioc_page_size_fits(uint64_t page_size, uint64_t cache_size)
+{
+    return (page_size <= (cache_size / IOC_SHARD_COUNT));
+}
+
 int
 reconfigure(xlator_t *this, dict_t *options)
 {
@@ -1662,6 +1639,7 @@ reconfigure(xlator_t *this, dict_t *options)
     ioc_table_t *table = NULL;
     int ret = -1;
     uint64_t cache_size_new = 0;
+    uint32_t index = 0;
     if (!this || !this->private)
         goto out;
 
@@ -1712,12 +1690,28 @@ reconfigure(xlator_t *this, dict_t *options)
                     IO_CACHE_MSG_NOT_RECONFIG_CACHE_SIZE, NULL);
             goto unlock;
         }
+        if (!ioc_page_size_fits(table->page_size, cache_size_new)) {
+            ret = -1;
+            gf_smsg(this->name, GF_LOG_ERROR, 0,
+                    IO_CACHE_MSG_PAGE_SIZE_TOO_LARGE,
+                    "page-size=%" PRIu64, table->page_size,
+                    "cache-size=%" PRIu64, cache_size_new, NULL);
+            gf_smsg(this->name, GF_LOG_ERROR, 0,
+                    IO_CACHE_MSG_NOT_RECONFIG_CACHE_SIZE, NULL);
+            goto unlock;
+        }
         table->cache_size = cache_size_new;
+        for (index = 0; index < IOC_SHARD_COUNT; index++)
+            table->shards[index].size = cache_size_new / IOC_SHARD_COUNT;
 
         ret = 0;
     }
 unlock:
     ioc_table_unlock(table);
+
+    /* the cache may have shrunk */
+    if (!ret)
+        ioc_prune(table);
 out:
     return ret;
 }
@@ -1734,9 +1728,9 @@ init(xlator_t *this)
     dict_t *xl_options = NULL;
     uint32_t index = 0;
     int32_t ret = -1;
-    glusterfs_ctx_t *ctx = NULL;
     data_t *data = 0;
     uint32_t num_pages = 0;
+    uint64_t page_size = 0;
 
     xl_options = this->options;
 
@@ -1758,7 +1752,17 @@ init(xlator_t *this)
     }
 
     table->xl = this;
-    table->page_size = this->ctx->page_size;
+
+    GF_OPTION_INIT("page-size", table->page_size, size_uint64, out);
+    if (!table->page_size) {
+        table->page_size = this->ctx->page_size;
+    } else if ((table->page_size & (table->page_size - 1)) ||
+               (table->page_size < IOC_MIN_PAGE_SIZE)) {
+        gf_smsg(this->name, GF_LOG_ERROR, EINVAL,
+                IO_CACHE_MSG_INVALID_ARGUMENT, "page-size=%" PRIu64,
+                table->page_size, NULL);
+        goto out;
+    }
 
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
 
@@ -1775,6 +1779,27 @@ init(xlator_t *this)
         goto out;
     }
 
+    if (!ioc_page_size_fits(table->page_size, table->cache_size)) {
+        page_size = table->page_size;
+        while ((page_size > IOC_MIN_PAGE_SIZE) &&
+               !ioc_page_size_fits(page_size, table->cache_size))
+            page_size >>= 1;
+
+        if (!ioc_page_size_fits(page_size, table->cache_size)) {
+            gf_smsg(this->name, GF_LOG_ERROR, EINVAL,
+                    IO_CACHE_MSG_PAGE_SIZE_TOO_LARGE,
+                    "page-size=%" PRIu64, table->page_size,
+                    "cache-size=%" PRIu64, table->cache_size, NULL);
+            goto out;
+        }
+
+        gf_smsg(this->name, GF_LOG_WARNING, 0,
+                IO_CACHE_MSG_PAGE_SIZE_TOO_LARGE, "page-size=%" PRIu64,
+                table->page_size, "cache-size=%" PRIu64, table->cache_size,
+                "using=%" PRIu64, page_size, NULL);
+        table->page_size = page_size;
+    }
+
     INIT_LIST_HEAD(&table->priority_list);
     table->max_pri = 1;
     data = dict_get(xl_options, "priority");
@@ -1801,14 +1826,14 @@ init(xlator_t *this)
         goto out;
     }
 
-    table->inode_lru = GF_CALLOC(table->max_pri, sizeof(struct list_head),
-                                 gf_ioc_mt_list_head);
-    if (table->inode_lru == NULL) {
-        goto out;
+    for (index = 0; index < IOC_SHARD_COUNT; index++) {
+        pthread_mutex_init(&table->shards[index].lock, NULL);
+        INIT_LIST_HEAD(&table->shards[index].ring);
+        table->shards[index].size = table->cache_size / IOC_SHARD_COUNT;
     }
-
-    for (index = 0; index < (table->max_pri); index++)
-        INIT_LIST_HEAD(&table->inode_lru[index]);
+    GF_ATOMIC_INIT(table->hits, 0);
+    GF_ATOMIC_INIT(table->misses, 0);
+    GF_ATOMIC_INIT(table->evictions, 0);
 
     this->local_pool = mem_pool_new(ioc_local_t, 64);
     if (!this->local_pool) {
@@ -1831,15 +1856,15 @@ init(xlator_t *this)
         goto out;
     }
 
+    ioc_metrics_register(this, table);
+
     ret = 0;
 
-    ctx = this->ctx;
-    ioc_log2_page_size = log_base2(ctx->page_size);
+    ioc_log2_page_size = log_base2(table->page_size);
 
 out:
     if (ret == -1) {
         if (table != NULL) {
-            GF_FREE(table->inode_lru);
             GF_FREE(table);
         }
     }
@@ -2053,7 +2078,11 @@ ioc_priv_dump(xlator_t *this)
     {
         gf_proc_dump_write("page_size", "%" PRIu64, priv->page_size);
         gf_proc_dump_write("cache_size", "%" PRIu64, priv->cache_size);
-        gf_proc_dump_write("cache_used", "%" PRIu64, priv->cache_used);
+        gf_proc_dump_write("cache_used", "%" PRIu64, ioc_cache_used(priv));
+        gf_proc_dump_write("hits", "%" PRIu64, GF_ATOMIC_GET(priv->hits));
+        gf_proc_dump_write("misses", "%" PRIu64, GF_ATOMIC_GET(priv->misses));
+        gf_proc_dump_write("evictions", "%" PRIu64,
+                           GF_ATOMIC_GET(priv->evictions));
         gf_proc_dump_write("inode_count", "%u", priv->inode_count);
         gf_proc_dump_write("cache_timeout", "%ld", priv->cache_timeout);
         gf_proc_dump_write("min-file-size", "%" PRIu64, priv->min_file_size);
@@ -2091,6 +2120,7 @@ fini(xlator_t *this)
 {
     ioc_table_t *table = NULL;
     struct ioc_priority *curr = NULL, *tmp = NULL;
+    int i = 0;
 
     table = this->private;
 
@@ -2099,6 +2129,9 @@ fini(xlator_t *this)
 
     this->private = NULL;
 
+    for (i = 0; i < IOC_METRICS_MAX; i++)
+        gf_metric_unregister(table->metrics[i]);
+
     if (table->mem_pool != NULL) {
         mem_pool_destroy(table->mem_pool);
         table->mem_pool = NULL;
@@ -2111,15 +2144,14 @@ fini(xlator_t *this)
         GF_FREE(curr);
     }
 
-    /* inode_lru and inodes list can be empty in case fini() is
-     * called soon after init()? Hence commenting the below asserts.
+    /* inodes list can be empty in case fini() is
+     * called soon after init()? Hence commenting the below assert.
      */
-    /*for (i = 0; i < table->max_pri; i++) {
-            GF_ASSERT (list_empty (&table->inode_lru[i]));
-    }
-
+    /*
     GF_ASSERT (list_empty (&table->inodes));
     */
+    for (i = 0; i < IOC_SHARD_COUNT; i++)
+        pthread_mutex_destroy(&table->shards[i].lock);
     pthread_mutex_destroy(&table->table_lock);
     GF_FREE(table);
 
@@ -2205,6 +2237,19 @@ struct volume_options options[] = {
                     "io-cache translator.",
      .op_version = {1},
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"page-size"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .max = IOC_MAX_PAGE_SIZE,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"io-cache"},
+     .description = "Size of the pages io-cache reads and caches, a power "
+                    "of 2 of at least 4KB. 0 uses the page size of the "
+                    "process (128KB by default). Lowered to fit in "
+                    "cache-size/16 if larger. Only read when the "
+                    "translator is initialized."},
     {.key = {"pass-through"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "false",
@@ -17,13 +17,19 @@
 #include <glusterfs/dict.h>
 #include <glusterfs/call-stub.h>
 #include <glusterfs/rbthash.h>
+#include <glusterfs/monitoring.h>
 #include <sys/time.h>
 #include <fnmatch.h>
 #include "io-cache-messages.h"
 
 #define IOC_PAGE_SIZE (1024 * 128) /* 128KB */
+#define IOC_MIN_PAGE_SIZE (4 * 1024)
+#define IOC_MAX_PAGE_SIZE (1024 * 1024)
 #define IOC_CACHE_SIZE (32 * 1024 * 1024)
 #define IOC_PAGE_TABLE_BUCKET_COUNT 1
+#define IOC_SHARD_COUNT 16 /* must be a power of 2 */
+#define IOC_CLOCK_MAX_CREDIT 4
+#define IOC_METRICS_MAX 4
 
 struct ioc_table;
 struct ioc_local;
@@ -98,6 +104,7 @@ struct ioc_local {
  */
 struct ioc_page {
     struct list_head page_lru;
+    struct list_head clock;  /* position in the ring of the page's shard */
     struct ioc_inode *inode; /* inode this page belongs to */
     struct ioc_priority *priority;
     char dirty;
@@ -111,6 +118,9 @@ struct ioc_page {
     pthread_mutex_t page_lock;
     int32_t op_errno;
     char stale;
+    uint8_t credit; /* sweeps of the clock hand this page survives */
+    uint32_t shard;
+    size_t charge; /* bytes accounted to the shard */
 };
 
 struct ioc_cache {
@@ -133,7 +143,6 @@ struct ioc_inode {
                                   * list of inodes, maintained by
                                   * io-cache translator
                                   */
-    struct list_head inode_lru;
     struct ioc_waitq *waitq;
     pthread_mutex_t inode_lock;
     uint32_t weight; /*
@@ -143,15 +152,36 @@ struct ioc_inode {
     inode_t *inode;
 };
 
+/*
+ * ioc_shard - a slice of the page cache
+ *
+ * Pages which hold data are spread over the shards by (gfid, offset). Each
+ * shard keeps its share of cache-size and evicts with a CLOCK sweep over
+ * its ring: a cache hit only sets the page's credit, it does not move the
+ * page anywhere, so readers take no lock beyond the inode lock and
+ * eviction only contends with the readers of one shard.
+ */
+struct ioc_shard {
+    pthread_mutex_t lock;
+    struct list_head ring; /* the clock hand is at the head */
+    uint64_t used;
+    uint64_t size;
+    uint32_t pages;
+    char _pad[64]; /* keeps shards off each other's cache lines */
+};
+
 struct ioc_table {
     uint64_t page_size;
     uint64_t cache_size;
-    uint64_t cache_used;
     uint64_t min_file_size;
     uint64_t max_file_size;
+    struct ioc_shard shards[IOC_SHARD_COUNT];
+    gf_atomic_t hits;
+    gf_atomic_t misses;
+    gf_atomic_t evictions;
+    gf_metric_t *metrics[IOC_METRICS_MAX];
     struct list_head inodes; /* list of inodes cached */
     struct list_head active;
-    struct list_head *inode_lru;
     struct list_head priority_list;
     int32_t readv_count;
     pthread_mutex_t table_lock;
@@ -163,6 +193,7 @@ struct ioc_table {
 };
 
 typedef struct ioc_table ioc_table_t;
+typedef struct ioc_shard ioc_shard_t;
 typedef struct ioc_local ioc_local_t;
 typedef struct ioc_page ioc_page_t;
 typedef struct ioc_inode ioc_inode_t;
@@ -282,10 +313,16 @@ ioc_inode_wakeup(call_frame_t *frame, ioc_inode_t *ioc_inode,
 int8_t
 ioc_cache_still_valid(ioc_inode_t *ioc_inode, struct iatt *stbuf);
 
-int32_t
+gf_boolean_t
+__ioc_page_charge(ioc_page_t *page, size_t size);
+
+void
+ioc_shard_prune(ioc_table_t *table, uint32_t index);
+
+void
 ioc_prune(ioc_table_t *table);
 
-int32_t
-ioc_need_prune(ioc_table_t *table);
+uint64_t
+ioc_cache_used(ioc_table_t *table);
 
 #endif /* __IO_CACHE_H */
@@ -183,11 +183,11 @@ ioc_inode_create(ioc_table_t *table, inode_t *inode, uint32_t weight)
     {
         table->inode_count++;
         list_add(&ioc_inode->inode_list, &table->inodes);
-        list_add_tail(&ioc_inode->inode_lru, &table->inode_lru[weight]);
     }
     ioc_table_unlock(table);
 
-    gf_msg_trace(table->xl->name, 0, "adding to inode_lru[%d]", weight);
+    gf_msg_trace(table->xl->name, 0, "adding inode(%p) with weight %d",
+                 ioc_inode, weight);
 
 out:
     return ioc_inode;
@@ -213,7 +213,6 @@ ioc_inode_destroy(ioc_inode_t *ioc_inode)
     {
         table->inode_count--;
         list_del(&ioc_inode->inode_list);
-        list_del(&ioc_inode->inode_lru);
     }
     ioc_table_unlock(table);
 
@@ -46,11 +46,6 @@ __ioc_page_get(ioc_inode_t *ioc_inode, off_t offset)
     page = rbthash_get(ioc_inode->cache.page_table, &rounded_offset,
                        sizeof(rounded_offset));
 
-    if (page != NULL) {
-        /* push the page to the end of the lru list */
-        list_move_tail(&page->page_lru, &ioc_inode->cache.page_lru);
-    }
-
 out:
     return page;
 }
@@ -74,6 +69,67 @@ out:
     return page;
 }
 
+static uint32_t
+ioc_page_shard(ioc_inode_t *ioc_inode, off_t offset)
+{
+    uint64_t key = 0;
+
+    memcpy(&key, &ioc_inode->inode->gfid[8], sizeof(key));
+    key ^= offset / ioc_inode->table->page_size;
+
+    return (key * 0x9e3779b97f4a7c15ULL) >> 32 & (IOC_SHARD_COUNT - 1);
+}
+
+/*
+ * __ioc_page_charge - account the data of a page to its shard
+ *
+ * @page: page which just got filled
+ * @size: bytes the page holds on to
+ *
+ * assumes the inode of the page is locked. Returns true when the shard went
+ * over its share of the cache, the caller should then run
+ * ioc_shard_prune() once it dropped the inode lock.
+ */
+gf_boolean_t
+__ioc_page_charge(ioc_page_t *page, size_t size)
+{
+    ioc_shard_t *shard = &page->inode->table->shards[page->shard];
+    gf_boolean_t over = _gf_false;
+
+    pthread_mutex_lock(&shard->lock);
+    {
+        if (list_empty(&page->clock)) {
+            list_add_tail(&page->clock, &shard->ring);
+            shard->pages++;
+        } else {
+            shard->used -= page->charge;
+        }
+        page->charge = size;
+        page->credit = min(page->inode->weight, IOC_CLOCK_MAX_CREDIT);
+        shard->used += size;
+        over = (shard->used > shard->size);
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return over;
+}
+
+static void
+__ioc_page_uncharge(ioc_page_t *page)
+{
+    ioc_shard_t *shard = &page->inode->table->shards[page->shard];
+
+    pthread_mutex_lock(&shard->lock);
+    {
+        if (!list_empty(&page->clock)) {
+            list_del_init(&page->clock);
+            shard->used -= page->charge;
+            shard->pages--;
+        }
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
 /*
  * __ioc_page_destroy -
  *
@@ -98,6 +154,7 @@ __ioc_page_destroy(ioc_page_t *page)
         rbthash_remove(page->inode->cache.page_table, &page->offset,
                        sizeof(page->offset));
         list_del(&page->page_lru);
+        __ioc_page_uncharge(page);
 
         gf_msg_trace(page->inode->table->xl->name, 0,
                      "destroying page = %p, offset = %" PRId64
@@ -144,46 +201,64 @@ out:
     return ret;
 }
 
-int32_t
-__ioc_inode_prune(ioc_inode_t *curr, uint64_t *size_pruned,
-                  uint64_t size_to_prune, uint32_t index)
+/*
+ * ioc_shard_prune - bring a shard back under its share of the cache
+ *
+ * @table: ioc_table_t of this translator
+ * @index: shard to prune
+ *
+ * The hand takes a credit away from every page it passes and evicts the
+ * first page which has none left. Pages of an inode somebody is working
+ * on, and pages frames are waiting on, are passed over: the inode lock is
+ * only tried, as the usual order is inode lock before shard lock.
+ */
+void
+ioc_shard_prune(ioc_table_t *table, uint32_t index)
 {
-    ioc_page_t *page = NULL, *next = NULL;
-    int32_t ret = 0;
-    ioc_table_t *table = NULL;
+    ioc_shard_t *shard = &table->shards[index];
+    ioc_inode_t *ioc_inode = NULL;
+    ioc_page_t *page = NULL;
+    uint64_t budget = 0;
 
-    if (curr == NULL) {
-        goto out;
-    }
+    pthread_mutex_lock(&shard->lock);
 
-    table = curr->table;
+    budget = (uint64_t)shard->pages * (IOC_CLOCK_MAX_CREDIT + 1);
+    while ((shard->used > shard->size) && budget--) {
+        page = list_first_entry(&shard->ring, ioc_page_t, clock);
+        list_move_tail(&page->clock, &shard->ring);
 
-    list_for_each_entry_safe(page, next, &curr->cache.page_lru, page_lru)
-    {
-        *size_pruned += page->size;
-        ret = __ioc_page_destroy(page);
+        if (page->credit) {
+            page->credit--;
+            continue;
+        }
 
-        if (ret != -1)
-            table->cache_used -= ret;
+        ioc_inode = page->inode;
+        if (pthread_mutex_trylock(&ioc_inode->inode_lock))
+            continue;
 
-        gf_msg_trace(table->xl->name, 0,
-                     "index = %d && "
-                     "table->cache_used = %" PRIu64
-                     " && table->"
-                     "cache_size = %" PRIu64,
-                     index, table->cache_used, table->cache_size);
+        if (page->waitq || !page->ready) {
+            pthread_mutex_unlock(&ioc_inode->inode_lock);
+            continue;
+        }
 
-        if ((*size_pruned) >= size_to_prune)
-            break;
-    }
+        list_del_init(&page->clock);
+        shard->used -= page->charge;
+        shard->pages--;
+        pthread_mutex_unlock(&shard->lock);
+
+        gf_msg_trace(table->xl->name, 0, "evicting page %p of inode %p", page,
+                     ioc_inode);
+        __ioc_page_destroy(page);
+        GF_ATOMIC_INC(table->evictions);
+        pthread_mutex_unlock(&ioc_inode->inode_lock);
 
-    if (ioc_empty(&curr->cache)) {
-        list_del_init(&curr->inode_lru);
+        pthread_mutex_lock(&shard->lock);
+        budget = (uint64_t)shard->pages * (IOC_CLOCK_MAX_CREDIT + 1);
     }
 
-out:
-    return 0;
+    pthread_mutex_unlock(&shard->lock);
 }
+
 /*
  * ioc_prune - prune the cache. we have a limit to the number of pages we
  *             can have in-memory.
@@ -191,45 +266,30 @@ out:
  * @table: ioc_table_t of this translator
  *
  */
-int32_t
+void
 ioc_prune(ioc_table_t *table)
 {
-    ioc_inode_t *curr = NULL, *next_ioc_inode = NULL;
-    int32_t index = 0;
-    uint64_t size_to_prune = 0;
-    uint64_t size_pruned = 0;
+    uint32_t index = 0;
 
     GF_VALIDATE_OR_GOTO("io-cache", table, out);
 
-    ioc_table_lock(table);
-    {
-        size_to_prune = table->cache_used - table->cache_size;
-        /* take out the least recently used inode */
-        for (index = 0; index < table->max_pri; index++) {
-            list_for_each_entry_safe(curr, next_ioc_inode,
-                                     &table->inode_lru[index], inode_lru)
-            {
-                /* prune page-by-page for this inode, till
-                 * we reach the equilibrium */
-                ioc_inode_lock(curr);
-                {
-                    __ioc_inode_prune(curr, &size_pruned, size_to_prune, index);
-                }
-                ioc_inode_unlock(curr);
+    for (index = 0; index < IOC_SHARD_COUNT; index++)
+        ioc_shard_prune(table, index);
 
-                if (size_pruned >= size_to_prune)
-                    break;
-            } /* list_for_each_entry_safe (curr...) */
+out:
+    return;
+}
 
-            if (size_pruned >= size_to_prune)
-                break;
-        } /* for(index=0;...) */
+uint64_t
+ioc_cache_used(ioc_table_t *table)
+{
+    uint64_t used = 0;
+    uint32_t index = 0;
 
-    } /* ioc_inode_table locked region end */
-    ioc_table_unlock(table);
+    for (index = 0; index < IOC_SHARD_COUNT; index++)
+        used += table->shards[index].used;
 
-out:
-    return 0;
+    return used;
 }
 
 /*
@@ -267,6 +327,8 @@ __ioc_page_create(ioc_inode_t *ioc_inode, off_t offset)
 
     newpage->offset = rounded_offset;
     newpage->inode = ioc_inode;
+    newpage->shard = ioc_page_shard(ioc_inode, rounded_offset);
+    INIT_LIST_HEAD(&newpage->clock);
     pthread_mutex_init(&newpage->page_lock, NULL);
 
     rbthash_insert(ioc_inode->cache.page_table, newpage, &rounded_offset,
@@ -407,10 +469,10 @@ ioc_fault_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ioc_inode_t *ioc_inode = NULL;
     ioc_table_t *table = NULL;
     ioc_page_t *page = NULL;
-    int32_t destroy_size = 0;
     size_t page_size = 0;
     ioc_waitq_t *waitq = NULL;
-    size_t iobref_page_size = 0;
+    uint32_t shard = 0;
+    gf_boolean_t need_prune = _gf_false;
     char zero_filled = 0;
 
     GF_ASSERT(frame);
@@ -435,7 +497,7 @@ ioc_fault_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
                          "cache for inode(%p) is invalid. flushing "
                          "all pages",
                          ioc_inode);
-            destroy_size = __ioc_inode_flush(ioc_inode);
+            __ioc_inode_flush(ioc_inode);
         }
 
         if ((op_ret >= 0) && !zero_filled) {
@@ -498,7 +560,9 @@ ioc_fault_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
                 page->size = page_size;
                 page->op_errno = op_errno;
 
-                iobref_page_size = iobref_size(page->iobref);
+                shard = page->shard;
+                need_prune = __ioc_page_charge(page,
+                                               iobref_size(page->iobref));
 
                 if (page->waitq) {
                     /* wake up all the frames waiting on
@@ -514,25 +578,8 @@ unlock:
 
     ioc_waitq_return(waitq);
 
-    if (iobref_page_size) {
-        ioc_table_lock(table);
-        {
-            table->cache_used += iobref_page_size;
-        }
-        ioc_table_unlock(table);
-    }
-
-    if (destroy_size) {
-        ioc_table_lock(table);
-        {
-            table->cache_used -= destroy_size;
-        }
-        ioc_table_unlock(table);
-    }
-
-    if (ioc_need_prune(ioc_inode->table)) {
-        ioc_prune(ioc_inode->table);
-    }
+    if (need_prune)
+        ioc_shard_prune(table, shard);
 
     gf_msg_trace(frame->this->name, 0, "fault frame %p returned", frame);
     pthread_mutex_destroy(&local->local_lock);
@@ -669,8 +716,9 @@ __ioc_frame_fill(ioc_page_t *page, call_frame_t *frame, off_t offset,
                  "&& page->size = %" GF_PRI_SIZET " && wait_count = %d",
                  frame, offset, size, page->size, local->wait_count);
 
-    /* immediately move this page to the end of the page_lru list */
-    list_move_tail(&page->page_lru, &ioc_inode->cache.page_lru);
+    /* referenced again, let the page survive the next sweeps of the clock
+     * hand */
+    page->credit = min(ioc_inode->weight, IOC_CLOCK_MAX_CREDIT);
     /* fill local->pending_size bytes from local->pending_offset */
     if (local->op_ret != -1) {
         local->op_errno = op_errno;
@@ -960,8 +1008,6 @@ __ioc_page_error(ioc_page_t *page, int32_t op_ret, int32_t op_errno)
 {
     ioc_waitq_t *waitq = NULL, *trav = NULL;
     call_frame_t *frame = NULL;
-    int64_t ret = 0;
-    ioc_table_t *table = NULL;
     ioc_local_t *local = NULL;
 
     GF_VALIDATE_OR_GOTO("io-cache", page, out);
@@ -986,12 +1032,7 @@ __ioc_page_error(ioc_page_t *page, int32_t op_ret, int32_t op_errno)
         ioc_local_unlock(local);
     }
 
-    table = page->inode->table;
-    ret = __ioc_page_destroy(page);
-
-    if (ret != -1) {
-        table->cache_used -= ret;
-    }
+    __ioc_page_destroy(page);
 
 out:
     return waitq;
@@ -152,6 +152,26 @@ __iot_enqueue(iot_conf_t *conf, call_stub_t *stub, int pri)
     fop_data->queue_sizes++;
 }
 
+/* In NUMA mode (ctx->numa) the workers are bound to the nodes of the host
+ * in turn, so that they are spread over them and the memory they allocate
+ * stays local; *bound is the node the worker is bound to, -1 for none. */
+static void
+iot_worker_numa(iot_conf_t *conf, int node, int *bound)
+{
+    int want = conf->this->ctx->numa ? node : -1;
+    int ret = 0;
+
+    if (want == *bound)
+        return;
+
+    ret = gf_numa_bind_thread(want);
+    if (ret != 0)
+        gf_log(conf->this->name, GF_LOG_WARNING,
+               "failed to bind worker to NUMA node %d (%s)", want,
+               strerror(-ret));
+    *bound = want;
+}
+
 static void *
 iot_worker(void *data)
 {
@@ -161,13 +181,27 @@ iot_worker(void *data)
     struct timespec sleep_till;
     int ret = 0;
     int pri = -1;
+    int nodes = gf_numa_node_count();
+    int node = -1;
+    int bound = -1;
     gf_boolean_t bye = _gf_false;
 
     conf = data;
     this = conf->this;
     THIS = this;
 
+    if (nodes > 1) {
+        pthread_mutex_lock(&conf->mutex);
+        {
+            node = conf->numa_next % nodes;
+            conf->numa_next = node + 1;
+        }
+        pthread_mutex_unlock(&conf->mutex);
+    }
+
     for (;;) {
+        iot_worker_numa(conf, node, &bound);
+
         pthread_mutex_lock(&conf->mutex);
         {
             if (pri != -1) {
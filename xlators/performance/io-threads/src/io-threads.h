@@ -70,6 +70,7 @@ struct iot_conf {
     xlator_t *this;
     int32_t watchdog_secs;
     gf_boolean_t cleanup_disconnected_reqs;
+    int32_t numa_next; /* node of the next worker, see iot_worker_numa() */
 };
 
 typedef struct iot_conf iot_conf_t;
@@ -24,6 +24,16 @@
  *       that it's not a read, causes the open request to be sent to the
  *       bricks, and all future operations will be executed synchronously,
  *       including opens (it's reset once all fd's are closed).
+ *
+ *       With anonymous-reads enabled, every open (except truncating ones) is
+ *       kept behind on its own fd, not only the first one of the inode.
+ *       Reads, fstat, seek and fgetxattr on such an fd are sent through an
+ *       anonymous fd and flush is answered locally, so a file that is only
+ *       read never sends an open, flush or release to the bricks. Any other
+ *       fd operation (writes, locks, ...) sends the real open of that fd
+ *       first. Inode operations that need the file to remain open (unlink,
+ *       rename, setattr, ...) send the real opens of all the fds of the
+ *       inode and wait for them.
  */
 
 typedef struct ob_conf {
@@ -40,6 +50,12 @@ typedef struct ob_conf {
                                            first and then send readv i.e
                                            similar to what writev does
                                         */
+    gf_boolean_t anonymous_reads;  /* keep every open behind and read through
+                                      anonymous fds until a fop needs the
+                                      real fd */
+    gf_atomic_t anon_opens;        /* opens kept behind per fd */
+    gf_atomic_t anon_fops;         /* fops sent through anonymous fds */
+    gf_atomic_t anon_fallbacks;    /* opens finally sent to the bricks */
 } ob_conf_t;
 
 /* A negative state represents an errno value negated. In this case the
@@ -91,8 +107,33 @@ typedef struct ob_inode {
     /* This flag is set as soon as we know that the open will be
      * sent to the bricks, even before the stub is ready. */
     bool triggered;
+
+    /* fd's opened in anonymous-reads mode whose real open has not
+     * completed yet (ob_anon_fd_t). */
+    struct list_head anon_fds;
+
+    /* Inode fops waiting for the real opens of anon_fds in flight. */
+    struct list_head anon_waiters;
+
+    /* Number of real opens of anon_fds currently in flight. */
+    int32_t anon_inflight;
 } ob_inode_t;
 
+/* An fd whose open is kept behind in anonymous-reads mode. */
+typedef struct ob_anon_fd {
+    /* Link into ob_inode->anon_fds. */
+    struct list_head list;
+
+    /* Fops waiting for the real open of this fd. */
+    struct list_head resume_fops;
+
+    /* The fd. Only used to find this object, no reference is kept. */
+    fd_t *fd;
+
+    /* The delayed open. It's NULL once the open has been sent. */
+    call_stub_t *open;
+} ob_anon_fd_t;
+
 /* Dummy pointer used temporarily while the actual open stub is being created */
 #define OB_OPEN_PREPARING ((call_stub_t *)-1)
 
@@ -124,7 +165,7 @@ typedef struct ob_inode {
         ob_inode_t *__ob_inode;                                                \
         fd_t *__first_fd;                                                      \
         ob_state_t __ob_state = ob_open_and_resume_fd(                         \
-            _xl, _fd, 0, true, _trigger, &__ob_inode, &__first_fd);            \
+            _xl, _fd, 0, true, _trigger, _trigger, &__ob_inode, &__first_fd);  \
         switch (__ob_state) {                                                  \
             case OB_STATE_OPEN_PENDING:                                        \
                 if (!(_trigger)) {                                             \
@@ -141,12 +182,35 @@ typedef struct ob_inode {
         }                                                                      \
     } while (0)
 
+/* Like OB_POST_FD but for fops that can be served on an anonymous fd. _args
+ * don't include the fd. */
+#define OB_POST_FD_READ(_fop, _xl, _frame, _fd, _trigger, _args...)            \
+    do {                                                                       \
+        ob_inode_t *__ob_inode;                                                \
+        fd_t *__first_fd;                                                      \
+        ob_state_t __ob_state = ob_open_and_resume_fd(                         \
+            _xl, _fd, 0, true, _trigger, false, &__ob_inode, &__first_fd);     \
+        switch (__ob_state) {                                                  \
+            case OB_STATE_OPEN_PENDING: {                                      \
+                fd_t *__ob_fd = ob_anonymous_fd(_xl, _fd);                     \
+                if (__ob_fd != NULL) {                                         \
+                    default_##_fop(_frame, _xl, __ob_fd, ##_args);             \
+                    fd_unref(__ob_fd);                                         \
+                } else {                                                       \
+                    default_##_fop##_failure_cbk(_frame, ENOMEM);              \
+                }                                                              \
+                break;                                                         \
+            }                                                                  \
+                OB_POST_COMMON(_fop, _xl, _frame, __first_fd, _fd, ##_args);   \
+        }                                                                      \
+    } while (0)
+
 #define OB_POST_FLUSH(_xl, _frame, _fd, _args...)                              \
     do {                                                                       \
         ob_inode_t *__ob_inode;                                                \
         fd_t *__first_fd;                                                      \
         ob_state_t __ob_state = ob_open_and_resume_fd(                         \
-            _xl, _fd, 0, true, false, &__ob_inode, &__first_fd);               \
+            _xl, _fd, 0, true, false, false, &__ob_inode, &__first_fd);        \
         switch (__ob_state) {                                                  \
             case OB_STATE_OPEN_PENDING:                                        \
                 default_flush_cbk(_frame, NULL, _xl, 0, 0, NULL);              \
@@ -160,7 +224,8 @@ typedef struct ob_inode {
         ob_inode_t *__ob_inode;                                                \
         fd_t *__first_fd;                                                      \
         ob_state_t __ob_state = ob_open_and_resume_inode(                      \
-            _xl, _inode, NULL, 0, true, _trigger, &__ob_inode, &__first_fd);   \
+            _xl, _inode, NULL, 0, true, _trigger, _trigger, &__ob_inode,       \
+            &__first_fd);                                                      \
         switch (__ob_state) {                                                  \
             case OB_STATE_OPEN_PENDING:                                        \
                 OB_POST_COMMON(_fop, _xl, _frame, __first_fd, ##_args);        \
@@ -181,6 +246,8 @@ ob_inode_get_locked(xlator_t *this, inode_t *inode)
     if (ob_inode != NULL) {
         ob_inode->inode = inode;
         INIT_LIST_HEAD(&ob_inode->resume_fops);
+        INIT_LIST_HEAD(&ob_inode->anon_fds);
+        INIT_LIST_HEAD(&ob_inode->anon_waiters);
 
         value = (uint64_t)(uintptr_t)ob_inode;
         if (__inode_ctx_set(inode, this, &value) < 0) {
@@ -192,14 +259,77 @@ ob_inode_get_locked(xlator_t *this, inode_t *inode)
     return ob_inode;
 }
 
+static void
+ob_resume_pending(struct list_head *list)
+{
+    call_stub_t *stub;
+
+    while (!list_empty(list)) {
+        stub = list_first_entry(list, call_stub_t, list);
+        list_del_init(&stub->list);
+
+        call_resume(stub);
+    }
+}
+
+static ob_anon_fd_t *
+ob_anon_fd_find_locked(ob_inode_t *ob_inode, fd_t *fd)
+{
+    ob_anon_fd_t *ob_fd;
+
+    list_for_each_entry(ob_fd, &ob_inode->anon_fds, list)
+    {
+        if (ob_fd->fd == fd) {
+            return ob_fd;
+        }
+    }
+
+    return NULL;
+}
+
+/* Takes the delayed open of an anonymous-reads fd so that it can be sent.
+ * Returns NULL if it has already been sent. */
+static call_stub_t *
+ob_anon_fd_trigger_locked(xlator_t *xl, ob_inode_t *ob_inode,
+                          ob_anon_fd_t *ob_fd)
+{
+    ob_conf_t *conf = xl->private;
+    call_stub_t *open_stub;
+
+    open_stub = ob_fd->open;
+    if (open_stub != NULL) {
+        ob_fd->open = NULL;
+        ob_inode->anon_inflight++;
+        GF_ATOMIC_INC(conf->anon_fallbacks);
+    }
+
+    return open_stub;
+}
+
+static fd_t *
+ob_anonymous_fd(xlator_t *xl, fd_t *fd)
+{
+    ob_conf_t *conf = xl->private;
+    fd_t *anon_fd;
+
+    anon_fd = fd_anonymous_with_flags(fd->inode, fd->flags);
+    if (anon_fd != NULL) {
+        GF_ATOMIC_INC(conf->anon_fops);
+    }
+
+    return anon_fd;
+}
+
 static ob_state_t
 ob_open_and_resume_inode(xlator_t *xl, inode_t *inode, fd_t *fd,
                          int32_t open_count, bool synchronous, bool trigger,
-                         ob_inode_t **pob_inode, fd_t **pfd)
+                         bool anon_trigger, ob_inode_t **pob_inode, fd_t **pfd)
 {
     ob_conf_t *conf;
     ob_inode_t *ob_inode;
+    ob_anon_fd_t *ob_fd;
     call_stub_t *open_stub;
+    struct list_head list;
 
     if (inode == NULL) {
         return OB_STATE_READY;
@@ -221,6 +351,48 @@ ob_open_and_resume_inode(xlator_t *xl, inode_t *inode, fd_t *fd,
 
         ob_inode->open_count += open_count;
 
+        /* An fd opened in anonymous-reads mode. Its open is only sent when
+         * the current request really needs it. */
+        ob_fd = (fd != NULL) ? ob_anon_fd_find_locked(ob_inode, fd) : NULL;
+        if (ob_fd != NULL) {
+            *pfd = fd;
+            if (!anon_trigger && (ob_fd->open != NULL)) {
+                UNLOCK(&inode->lock);
+
+                return OB_STATE_OPEN_PENDING;
+            }
+
+            open_stub = ob_anon_fd_trigger_locked(xl, ob_inode, ob_fd);
+
+            UNLOCK(&inode->lock);
+
+            if (open_stub != NULL) {
+                call_resume(open_stub);
+            }
+
+            return OB_STATE_OPEN_TRIGGERED;
+        }
+
+        /* Requests on the inode need all the files opened in anonymous-reads
+         * mode to be really open (e.g. so that an unlinked file can still be
+         * read). */
+        if ((fd == NULL) && trigger && !list_empty(&ob_inode->anon_fds)) {
+            INIT_LIST_HEAD(&list);
+            list_for_each_entry(ob_fd, &ob_inode->anon_fds, list)
+            {
+                open_stub = ob_anon_fd_trigger_locked(xl, ob_inode, ob_fd);
+                if (open_stub != NULL) {
+                    list_add_tail(&open_stub->list, &list);
+                }
+            }
+
+            UNLOCK(&inode->lock);
+
+            ob_resume_pending(&list);
+
+            return OB_STATE_OPEN_TRIGGERED;
+        }
+
         /* If first_fd is not NULL, it means that there's a previous open not
          * yet completed. */
         if (ob_inode->first_fd != NULL) {
@@ -283,8 +455,8 @@ ob_open_and_resume_inode(xlator_t *xl, inode_t *inode, fd_t *fd,
 
 static ob_state_t
 ob_open_and_resume_fd(xlator_t *xl, fd_t *fd, int32_t open_count,
-                      bool synchronous, bool trigger, ob_inode_t **pob_inode,
-                      fd_t **pfd)
+                      bool synchronous, bool trigger, bool anon_trigger,
+                      ob_inode_t **pob_inode, fd_t **pfd)
 {
     uint64_t err;
 
@@ -293,7 +465,7 @@ ob_open_and_resume_fd(xlator_t *xl, fd_t *fd, int32_t open_count,
     }
 
     return ob_open_and_resume_inode(xl, fd->inode, fd, open_count, synchronous,
-                                    trigger, pob_inode, pfd);
+                                    trigger, anon_trigger, pob_inode, pfd);
 }
 
 static ob_state_t
@@ -306,20 +478,35 @@ ob_open_behind(xlator_t *xl, fd_t *fd, int32_t flags, ob_inode_t **pob_inode,
      *       we also execute this open synchronously ? */
     synchronous = (flags & O_TRUNC) != 0;
 
-    return ob_open_and_resume_fd(xl, fd, 1, synchronous, true, pob_inode, pfd);
+    return ob_open_and_resume_fd(xl, fd, 1, synchronous, true, true, pob_inode,
+                                 pfd);
 }
 
 static int32_t
 ob_stub_dispatch(xlator_t *xl, ob_inode_t *ob_inode, fd_t *fd,
                  call_stub_t *stub)
 {
+    ob_anon_fd_t *ob_fd;
+
     LOCK(&ob_inode->inode->lock);
     {
         /* We only queue a stub if the open has not been completed or
-         * cancelled. */
-        if (ob_inode->first_fd == fd) {
+         * cancelled. A NULL fd means that the stub waits for the opens of
+         * the anonymous-reads fd's. */
+        if (fd == NULL) {
+            if (ob_inode->anon_inflight > 0) {
+                list_add_tail(&stub->list, &ob_inode->anon_waiters);
+                stub = NULL;
+            }
+        } else if (ob_inode->first_fd == fd) {
             list_add_tail(&stub->list, &ob_inode->resume_fops);
             stub = NULL;
+        } else {
+            ob_fd = ob_anon_fd_find_locked(ob_inode, fd);
+            if (ob_fd != NULL) {
+                list_add_tail(&stub->list, &ob_fd->resume_fops);
+                stub = NULL;
+            }
         }
     }
     UNLOCK(&ob_inode->inode->lock);
@@ -371,19 +558,6 @@ ob_open_dispatch(xlator_t *xl, ob_inode_t *ob_inode, fd_t *fd,
     return 0;
 }
 
-static void
-ob_resume_pending(struct list_head *list)
-{
-    call_stub_t *stub;
-
-    while (!list_empty(list)) {
-        stub = list_first_entry(list, call_stub_t, list);
-        list_del_init(&stub->list);
-
-        call_resume(stub);
-    }
-}
-
 static void
 ob_open_completed(xlator_t *xl, ob_inode_t *ob_inode, fd_t *fd, int32_t op_ret,
                   int32_t op_errno)
@@ -440,16 +614,154 @@ ob_open_resume(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
     return 0;
 }
 
+static void
+ob_anon_open_completed(xlator_t *xl, ob_inode_t *ob_inode, fd_t *fd,
+                       int32_t op_ret, int32_t op_errno)
+{
+    struct list_head list;
+    ob_anon_fd_t *ob_fd;
+
+    INIT_LIST_HEAD(&list);
+
+    if (op_ret < 0) {
+        fd_ctx_set(fd, xl, op_errno <= 0 ? EIO : op_errno);
+    }
+
+    LOCK(&ob_inode->inode->lock);
+    {
+        /* From now on the fd is handled as any other fd (or fails with the
+         * error stored in its context). */
+        ob_fd = ob_anon_fd_find_locked(ob_inode, fd);
+        if (ob_fd != NULL) {
+            list_del_init(&ob_fd->list);
+            list_splice_init(&ob_fd->resume_fops, &list);
+        }
+
+        ob_inode->anon_inflight--;
+        if (ob_inode->anon_inflight == 0) {
+            list_append_init(&ob_inode->anon_waiters, &list);
+        }
+    }
+    UNLOCK(&ob_inode->inode->lock);
+
+    GF_FREE(ob_fd);
+
+    ob_resume_pending(&list);
+}
+
+static int32_t
+ob_anon_open_cbk(call_frame_t *frame, void *cookie, xlator_t *xl,
+                 int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
+{
+    ob_inode_t *ob_inode;
+
+    ob_inode = frame->local;
+    frame->local = NULL;
+
+    ob_anon_open_completed(xl, ob_inode, cookie, op_ret, op_errno);
+
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+static int32_t
+ob_anon_open_resume(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
+                    fd_t *fd, dict_t *xdata)
+{
+    STACK_WIND_COOKIE(frame, ob_anon_open_cbk, fd, FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->open, loc, flags, fd, xdata);
+
+    return 0;
+}
+
+static void
+ob_anon_open_destroy(call_stub_t *stub)
+{
+    stub->frame->local = NULL;
+    STACK_DESTROY(stub->frame->root);
+    call_stub_destroy(stub);
+}
+
+/* Keeps the open behind on this fd until a fop needs it. Returns false if
+ * the open needs to be processed as usual. */
+static bool
+ob_anon_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
+             fd_t *fd, dict_t *xdata)
+{
+    ob_conf_t *conf = this->private;
+    ob_inode_t *ob_inode = NULL;
+    ob_anon_fd_t *ob_fd;
+    call_frame_t *open_frame;
+    call_stub_t *stub = NULL;
+
+    ob_fd = GF_CALLOC(1, sizeof(*ob_fd), gf_ob_mt_anon_fd_t);
+    if (ob_fd == NULL) {
+        return false;
+    }
+    INIT_LIST_HEAD(&ob_fd->list);
+    INIT_LIST_HEAD(&ob_fd->resume_fops);
+    ob_fd->fd = fd;
+
+    /* A new frame is needed because the current one will be destroyed as
+     * soon as the open is answered. */
+    open_frame = copy_frame(frame);
+    if (open_frame != NULL) {
+        stub = fop_open_stub(open_frame, ob_anon_open_resume, loc, flags, fd,
+                             xdata);
+        if (stub == NULL) {
+            STACK_DESTROY(open_frame->root);
+        }
+    }
+    if (stub == NULL) {
+        GF_FREE(ob_fd);
+        return false;
+    }
+    ob_fd->open = stub;
+
+    LOCK(&fd->inode->lock);
+    {
+        ob_inode = ob_inode_get_locked(this, fd->inode);
+        if (ob_inode != NULL) {
+            /* The fd is accounted as any other open fd so that ob_fdclose()
+             * and later opens see it. */
+            open_frame->local = ob_inode;
+            ob_inode->open_count++;
+            list_add_tail(&ob_fd->list, &ob_inode->anon_fds);
+        }
+    }
+    UNLOCK(&fd->inode->lock);
+
+    if (ob_inode == NULL) {
+        ob_anon_open_destroy(stub);
+        GF_FREE(ob_fd);
+        return false;
+    }
+
+    GF_ATOMIC_INC(conf->anon_opens);
+
+    default_open_cbk(frame, NULL, this, 0, 0, fd, xdata);
+
+    return true;
+}
+
 static int32_t
 ob_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags, fd_t *fd,
         dict_t *xdata)
 {
+    ob_conf_t *conf = this->private;
     ob_inode_t *ob_inode = NULL;
     call_frame_t *open_frame;
     call_stub_t *stub;
     fd_t *first_fd;
     ob_state_t state;
 
+    /* Truncating opens have side effects and are always sent. */
+    if (conf->anonymous_reads && ((flags & O_TRUNC) == 0) &&
+        ob_anon_open(frame, this, loc, flags, fd, xdata)) {
+        return 0;
+    }
+
     state = ob_open_behind(this, fd, flags, &ob_inode, &first_fd);
     if (state == OB_STATE_READY) {
         /* There's no pending open, but there are other file descriptors opened
@@ -524,7 +836,7 @@ ob_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
     ob_state_t state;
 
     /* Create requests are never delayed. We always send them synchronously. */
-    state = ob_open_and_resume_fd(this, fd, 1, true, true, &ob_inode,
+    state = ob_open_and_resume_fd(this, fd, 1, true, true, true, &ob_inode,
                                   &first_fd);
     if (state == OB_STATE_READY) {
         /* There's no pending open, but there are other file descriptors opened
@@ -571,7 +883,8 @@ ob_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     ob_conf_t *conf = this->private;
     bool trigger = conf->read_after_open || !conf->use_anonymous_fd;
 
-    OB_POST_FD(readv, this, frame, fd, trigger, fd, size, offset, flags, xdata);
+    OB_POST_FD_READ(readv, this, frame, fd, trigger, size, offset, flags,
+                    xdata);
 
     return 0;
 }
@@ -593,7 +906,7 @@ ob_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
     ob_conf_t *conf = this->private;
     bool trigger = !conf->use_anonymous_fd;
 
-    OB_POST_FD(fstat, this, frame, fd, trigger, fd, xdata);
+    OB_POST_FD_READ(fstat, this, frame, fd, trigger, xdata);
 
     return 0;
 }
@@ -605,7 +918,7 @@ ob_seek(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     ob_conf_t *conf = this->private;
     bool trigger = !conf->use_anonymous_fd;
 
-    OB_POST_FD(seek, this, frame, fd, trigger, fd, offset, what, xdata);
+    OB_POST_FD_READ(seek, this, frame, fd, trigger, offset, what, xdata);
 
     return 0;
 }
@@ -657,7 +970,7 @@ static int32_t
 ob_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *name,
              dict_t *xdata)
 {
-    OB_POST_FD(fgetxattr, this, frame, fd, true, fd, name, xdata);
+    OB_POST_FD_READ(fgetxattr, this, frame, fd, true, name, xdata);
 
     return 0;
 }
@@ -785,10 +1098,14 @@ ob_fdclose(xlator_t *this, fd_t *fd)
 {
     struct list_head list;
     ob_inode_t *ob_inode;
+    ob_anon_fd_t *ob_fd;
     call_stub_t *stub;
+    call_stub_t *anon_stub;
 
     INIT_LIST_HEAD(&list);
     stub = NULL;
+    anon_stub = NULL;
+    ob_fd = NULL;
 
     LOCK(&fd->inode->lock);
     {
@@ -796,6 +1113,20 @@ ob_fdclose(xlator_t *this, fd_t *fd)
         if (ob_inode != NULL) {
             ob_inode->open_count--;
 
+            /* An anonymous-reads fd that has never been opened is simply
+             * forgotten. If its open is in flight, it will be completed and
+             * released as usual. */
+            ob_fd = ob_anon_fd_find_locked(ob_inode, fd);
+            if ((ob_fd != NULL) && (ob_fd->open != NULL)) {
+                GF_ASSERT(list_empty(&ob_fd->resume_fops));
+
+                list_del_init(&ob_fd->list);
+                anon_stub = ob_fd->open;
+                ob_fd->open = NULL;
+            } else {
+                ob_fd = NULL;
+            }
+
             /* If this fd is the same as ob_inode->first_fd, it means that
              * the initial open has not fully completed. We'll try to cancel
              * it. */
@@ -835,6 +1166,11 @@ ob_fdclose(xlator_t *this, fd_t *fd)
         ob_open_destroy(stub, fd);
     }
 
+    if (anon_stub != NULL) {
+        ob_anon_open_destroy(anon_stub);
+        GF_FREE(ob_fd);
+    }
+
     ob_resume_pending(&list);
 }
 
@@ -872,6 +1208,16 @@ ob_priv_dump(xlator_t *this)
 
     gf_proc_dump_write("lazy_open", "%d", conf->lazy_open);
 
+    gf_proc_dump_write("anonymous_reads", "%d", conf->anonymous_reads);
+
+    gf_proc_dump_write("anon_opens", "%" PRId64,
+                       GF_ATOMIC_GET(conf->anon_opens));
+
+    gf_proc_dump_write("anon_fops", "%" PRId64, GF_ATOMIC_GET(conf->anon_fops));
+
+    gf_proc_dump_write("anon_fallbacks", "%" PRId64,
+                       GF_ATOMIC_GET(conf->anon_fallbacks));
+
     return 0;
 }
 
@@ -935,6 +1281,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("read-after-open", conf->read_after_open, options, bool,
                      out);
 
+    GF_OPTION_RECONF("anonymous-reads", conf->anonymous_reads, options, bool,
+                     out);
+
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
     ret = 0;
 out:
@@ -969,8 +1318,14 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("read-after-open", conf->read_after_open, bool, err);
 
+    GF_OPTION_INIT("anonymous-reads", conf->anonymous_reads, bool, err);
+
     GF_OPTION_INIT("pass-through", this->pass_through, bool, err);
 
+    GF_ATOMIC_INIT(conf->anon_opens, 0);
+    GF_ATOMIC_INIT(conf->anon_fops, 0);
+    GF_ATOMIC_INIT(conf->anon_fallbacks, 0);
+
     this->private = conf;
 
     return 0;
@@ -1073,6 +1428,20 @@ struct volume_options options[] = {
         .tags = {},
         /* option_validation_fn validate_fn; */
     },
+    {
+        .key = {"anonymous-reads"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .description = "Keep every open behind, not only the first one of a "
+                       "file, and send reads, fstat, seek and fgetxattr "
+                       "through anonymous fds. A file that is only read is "
+                       "never opened, flushed or released on the bricks. "
+                       "Writes, locks and other fd operations send the "
+                       "real open first. Truncating opens are always sent.",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+        .tags = {"open-behind"},
+    },
     {.key = {"pass-through"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "false",
@@ -9,6 +9,7 @@
 */
 
 #include <math.h>
+#include <zlib.h>
 #include "quick-read.h"
 #include <glusterfs/statedump.h>
 #include "quick-read-messages.h"
@@ -53,7 +54,7 @@ __qr_get_generation(xlator_t *this, qr_inode_t *qr_inode)
     qr_inode_table_t *table = NULL;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode->table;
 
     gen = GF_ATOMIC_INC(priv->generation);
     if (gen == 0) {
@@ -77,11 +78,11 @@ qr_get_generation(xlator_t *this, inode_t *inode)
     qr_private_t *priv = NULL;
 
     priv = this->private;
-    table = &priv->table;
 
     qr_inode = qr_inode_ctx_get(this, inode);
 
     if (qr_inode) {
+        table = qr_inode->table;
         LOCK(&table->lock);
         {
             gen = __qr_get_generation(this, qr_inode);
@@ -173,11 +174,24 @@ out:
     return qr_inode;
 }
 
+static uint64_t
+qr_gfid_key(uuid_t gfid)
+{
+    uint64_t key = 0;
+
+    memcpy(&key, &gfid[8], sizeof(key));
+
+    return key * 0x9e3779b97f4a7c15ULL;
+}
+
 qr_inode_t *
-qr_inode_new(xlator_t *this, inode_t *inode)
+qr_inode_new(xlator_t *this, uuid_t gfid)
 {
+    qr_private_t *priv = NULL;
     qr_inode_t *qr_inode = NULL;
 
+    priv = this->private;
+
     qr_inode = GF_CALLOC(1, sizeof(*qr_inode), gf_qr_mt_qr_inode_t);
     if (!qr_inode)
         return NULL;
@@ -185,18 +199,17 @@ qr_inode_new(xlator_t *this, inode_t *inode)
     INIT_LIST_HEAD(&qr_inode->lru);
 
     qr_inode->priority = 0; /* initial priority */
+    qr_inode->key = qr_gfid_key(gfid);
+    qr_inode->table = &priv->table[qr_inode->key >> 60 & (QR_SHARD_COUNT - 1)];
 
     return qr_inode;
 }
 
 qr_inode_t *
-qr_inode_ctx_get_or_new(xlator_t *this, inode_t *inode)
+qr_inode_ctx_get_or_new(xlator_t *this, inode_t *inode, uuid_t gfid)
 {
     qr_inode_t *qr_inode = NULL;
     int ret = -1;
-    qr_private_t *priv = NULL;
-
-    priv = this->private;
 
     LOCK(&inode->lock);
     {
@@ -204,13 +217,13 @@ qr_inode_ctx_get_or_new(xlator_t *this, inode_t *inode)
         if (qr_inode)
             goto unlock;
 
-        qr_inode = qr_inode_new(this, inode);
+        qr_inode = qr_inode_new(this, gfid);
         if (!qr_inode)
             goto unlock;
 
         ret = __qr_inode_ctx_set(this, inode, qr_inode);
         if (ret) {
-            __qr_inode_prune(this, &priv->table, qr_inode, 0);
+            __qr_inode_prune(this, qr_inode->table, qr_inode, 0);
             GF_FREE(qr_inode);
             qr_inode = NULL;
         }
@@ -236,6 +249,38 @@ qr_get_priority(qr_conf_t *conf, const char *path)
     return priority;
 }
 
+static qr_content_t *
+qr_content_new(size_t size)
+{
+    qr_content_t *content = NULL;
+
+    content = GF_MALLOC(sizeof(*content) + size, gf_qr_mt_content_t);
+    if (!content)
+        return NULL;
+
+    GF_ATOMIC_INIT(content->ref, 1);
+
+    return content;
+}
+
+static qr_content_t *
+qr_content_ref(qr_content_t *content)
+{
+    GF_ATOMIC_INC(content->ref);
+
+    return content;
+}
+
+static void
+qr_content_unref(qr_content_t *content)
+{
+    if (!content)
+        return;
+
+    if (GF_ATOMIC_DEC(content->ref) == 0)
+        GF_FREE(content);
+}
+
 void
 __qr_inode_register(xlator_t *this, qr_inode_table_t *table,
                     qr_inode_t *qr_inode)
@@ -249,10 +294,11 @@ __qr_inode_register(xlator_t *this, qr_inode_table_t *table,
     if (!priv)
         return;
 
-    if (list_empty(&qr_inode->lru))
+    if (list_empty(&qr_inode->lru)) {
         /* first time addition of this qr_inode into table */
-        table->cache_used += qr_inode->size;
-    else
+        table->cache_used += qr_inode->stored;
+        table->saved += qr_inode->size - qr_inode->stored;
+    } else
         list_del_init(&qr_inode->lru);
 
     list_add_tail(&qr_inode->lru, &table->lru[qr_inode->priority]);
@@ -276,7 +322,7 @@ qr_inode_set_priority(xlator_t *this, inode_t *inode, const char *path)
         return;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode->table;
     conf = &priv->conf;
 
     if (path)
@@ -302,12 +348,14 @@ __qr_inode_prune_data(xlator_t *this, qr_inode_table_t *table,
 
     priv = this->private;
 
-    GF_FREE(qr_inode->data);
+    qr_content_unref(qr_inode->data);
     qr_inode->data = NULL;
 
     if (!list_empty(&qr_inode->lru)) {
-        table->cache_used -= qr_inode->size;
+        table->cache_used -= qr_inode->stored;
+        table->saved -= qr_inode->size - qr_inode->stored;
         qr_inode->size = 0;
+        qr_inode->stored = 0;
 
         list_del_init(&qr_inode->lru);
 
@@ -331,7 +379,6 @@ __qr_inode_prune(xlator_t *this, qr_inode_table_t *table, qr_inode_t *qr_inode,
 void
 qr_inode_prune(xlator_t *this, inode_t *inode, uint64_t gen)
 {
-    qr_private_t *priv = NULL;
     qr_inode_table_t *table = NULL;
     qr_inode_t *qr_inode = NULL;
 
@@ -339,8 +386,7 @@ qr_inode_prune(xlator_t *this, inode_t *inode, uint64_t gen)
     if (!qr_inode)
         return;
 
-    priv = this->private;
-    table = &priv->table;
+    table = qr_inode->table;
 
     LOCK(&table->lock);
     {
@@ -349,7 +395,110 @@ qr_inode_prune(xlator_t *this, inode_t *inode, uint64_t gen)
     UNLOCK(&table->lock);
 }
 
-/* To be called with priv->table.lock held */
+static uint64_t
+qr_shard_size(qr_conf_t *conf)
+{
+    return conf->cache_size / QR_SHARD_COUNT;
+}
+
+/*
+ * Each shard evicts against cache-size / QR_SHARD_COUNT, so a file
+ * larger than that could never stay cached.
+ */
+static gf_boolean_t
+qr_max_file_size_fits(uint64_t max_file_size, uint64_t cache_size)
+{
+    return (max_file_size <= (cache_size / QR_SHARD_COUNT));
+}
+
+static uint32_t
+qr_sketch_index(uint64_t key, int row)
+{
+    static const uint64_t seeds[QR_SKETCH_DEPTH] = {
+        0xc2b2ae3d27d4eb4fULL,
+        0x165667b19e3779f9ULL,
+        0xd6e8feb86659fd93ULL,
+        0xff51afd7ed558ccdULL,
+    };
+
+    return ((key * seeds[row]) >> 32) & (QR_SKETCH_WIDTH - 1);
+}
+
+/*
+ * Count an access to the file with @key in the frequency sketch of its
+ * shard.  All counters are halved every QR_SKETCH_WIDTH * 8 accesses so
+ * that files which stopped being hot lose their weight.  To be called
+ * with table->lock held.
+ */
+static void
+__qr_sketch_add(qr_inode_table_t *table, uint64_t key)
+{
+    int row = 0;
+    int i = 0;
+    uint8_t *counter = NULL;
+
+    for (row = 0; row < QR_SKETCH_DEPTH; row++) {
+        counter = &table->sketch[row][qr_sketch_index(key, row)];
+        if (*counter < QR_SKETCH_MAX)
+            (*counter)++;
+    }
+
+    if (++table->sketch_adds < QR_SKETCH_WIDTH * 8)
+        return;
+
+    for (row = 0; row < QR_SKETCH_DEPTH; row++)
+        for (i = 0; i < QR_SKETCH_WIDTH; i++)
+            table->sketch[row][i] >>= 1;
+
+    table->sketch_adds = 0;
+}
+
+static uint8_t
+__qr_sketch_estimate(qr_inode_table_t *table, uint64_t key)
+{
+    uint8_t estimate = QR_SKETCH_MAX;
+    int row = 0;
+
+    for (row = 0; row < QR_SKETCH_DEPTH; row++)
+        estimate = min(estimate, table->sketch[row][qr_sketch_index(key, row)]);
+
+    return estimate;
+}
+
+/*
+ * TinyLFU admission: content which would push the shard over its size
+ * is only taken in when the file has been accessed more often than the
+ * file it would evict first.  This keeps one-off scans from flushing the
+ * hot set.  To be called with table->lock held.
+ */
+static gf_boolean_t
+__qr_content_admit(qr_conf_t *conf, qr_inode_table_t *table,
+                   qr_inode_t *qr_inode, size_t stored)
+{
+    qr_inode_t *victim = NULL;
+    int index = 0;
+
+    if (!conf->admission)
+        return _gf_true;
+
+    if (table->cache_used + stored <= qr_shard_size(conf))
+        return _gf_true;
+
+    for (index = 0; index < conf->max_pri; index++) {
+        if (!list_empty(&table->lru[index])) {
+            victim = list_first_entry(&table->lru[index], qr_inode_t, lru);
+            break;
+        }
+    }
+
+    if (!victim)
+        return _gf_true;
+
+    return (__qr_sketch_estimate(table, qr_inode->key) >
+            __qr_sketch_estimate(table, victim->key));
+}
+
+/* To be called with table->lock held */
 void
 __qr_cache_prune(xlator_t *this, qr_inode_table_t *table, qr_conf_t *conf)
 {
@@ -361,74 +510,152 @@ __qr_cache_prune(xlator_t *this, qr_inode_table_t *table, qr_conf_t *conf)
         list_for_each_entry_safe(curr, next, &table->lru[index], lru)
         {
             __qr_inode_prune(this, table, curr, 0);
-            if (table->cache_used < conf->cache_size)
+            if (table->cache_used < qr_shard_size(conf))
                 return;
         }
     }
 }
 
 void
-qr_cache_prune(xlator_t *this)
+qr_cache_prune(xlator_t *this, qr_inode_table_t *table)
 {
     qr_private_t *priv = NULL;
     qr_conf_t *conf = NULL;
-    qr_inode_table_t *table = NULL;
 
     priv = this->private;
-    table = &priv->table;
     conf = &priv->conf;
 
     LOCK(&table->lock);
     {
-        if (table->cache_used > conf->cache_size)
+        if (table->cache_used > qr_shard_size(conf))
             __qr_cache_prune(this, table, conf);
     }
     UNLOCK(&table->lock);
 }
 
-void *
+static uint64_t
+qr_cache_used(qr_private_t *priv)
+{
+    uint64_t used = 0;
+    int i = 0;
+
+    for (i = 0; i < QR_SHARD_COUNT; i++)
+        used += priv->table[i].cache_used;
+
+    return used;
+}
+
+/*
+ * Compress @data with zlib at its fastest level.  Returns the buffer to
+ * keep, and its length in @stored: the compressed copy when it saves at
+ * least an eighth of the size, @data itself otherwise.
+ */
+static qr_content_t *
+qr_content_compress(qr_content_t *data, size_t size, size_t *stored)
+{
+    qr_content_t *out = NULL;
+    qr_content_t *shrunk = NULL;
+    uLongf len = 0;
+
+    *stored = size;
+
+    len = compressBound(size);
+    out = qr_content_new(len);
+    if (!out)
+        return data;
+
+    if ((compress2((Bytef *)out->data, &len, (Bytef *)data->data, size,
+                   Z_BEST_SPEED) != Z_OK) ||
+        (len + (size >> 3) > size)) {
+        qr_content_unref(out);
+        return data;
+    }
+
+    shrunk = GF_REALLOC(out, sizeof(*out) + len);
+    if (shrunk)
+        out = shrunk;
+
+    qr_content_unref(data);
+    *stored = len;
+
+    return out;
+}
+
+qr_content_t *
 qr_content_extract(dict_t *xdata)
 {
     data_t *data = NULL;
-    void *content = NULL;
+    qr_content_t *content = NULL;
     int ret = 0;
 
     ret = dict_get_with_ref(xdata, GF_CONTENT_KEY, &data);
     if (ret < 0 || !data)
         return NULL;
 
-    content = GF_MALLOC(data->len, gf_qr_mt_content_t);
+    content = qr_content_new(data->len);
     if (!content)
         goto out;
 
-    memcpy(content, data->data, data->len);
+    memcpy(content->data, data->data, data->len);
 
 out:
     data_unref(data);
     return content;
 }
 
+/* To be called with table->lock held */
+static gf_boolean_t
+__qr_content_stale(qr_inode_t *qr_inode, uint32_t rollover, uint64_t gen)
+{
+    /* allow for rollover of frame->root->unique */
+    if ((rollover != qr_inode->gen_rollover) ||
+        (gen && qr_inode->gen && (qr_inode->gen >= gen)))
+        return _gf_true;
+
+    return ((qr_inode->data == NULL) && (qr_inode->invalidation_time >= gen));
+}
+
 void
-qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
+qr_content_update(xlator_t *this, qr_inode_t *qr_inode, qr_content_t *data,
                   struct iatt *buf, uint64_t gen)
 {
     qr_private_t *priv = NULL;
     qr_inode_table_t *table = NULL;
     uint32_t rollover = 0;
+    size_t stored = 0;
 
     rollover = gen >> 32;
     gen = gen & 0xffffffff;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode->table;
 
+    /* Admission is decided on the uncompressed size, an upper bound of
+     * what is stored, so that content which would be thrown away is not
+     * compressed first. */
+    stored = buf->ia_size;
     LOCK(&table->lock);
     {
-        if ((rollover != qr_inode->gen_rollover) ||
-            (gen && qr_inode->gen && (qr_inode->gen >= gen)))
+        __qr_sketch_add(table, qr_inode->key);
+
+        if (__qr_content_stale(qr_inode, rollover, gen))
+            goto unlock;
+
+        if ((qr_inode->data == NULL) &&
+            !__qr_content_admit(&priv->conf, table, qr_inode, stored)) {
+            GF_ATOMIC_INC(priv->qr_counter.admission_rejects);
             goto unlock;
+        }
+    }
+    UNLOCK(&table->lock);
+
+    if (priv->conf.compress)
+        data = qr_content_compress(data, buf->ia_size, &stored);
 
-        if ((qr_inode->data == NULL) && (qr_inode->invalidation_time >= gen))
+    LOCK(&table->lock);
+    {
+        /* the content may have been invalidated while compressing */
+        if (__qr_content_stale(qr_inode, rollover, gen))
             goto unlock;
 
         __qr_inode_prune(this, table, qr_inode, gen);
@@ -436,6 +663,7 @@ qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
         qr_inode->data = data;
         data = NULL;
         qr_inode->size = buf->ia_size;
+        qr_inode->stored = stored;
 
         qr_inode->ia_mtime = buf->ia_mtime;
         qr_inode->ia_mtime_nsec = buf->ia_mtime_nsec;
@@ -450,10 +678,9 @@ qr_content_update(xlator_t *this, qr_inode_t *qr_inode, void *data,
 unlock:
     UNLOCK(&table->lock);
 
-    if (data)
-        GF_FREE(data);
+    qr_content_unref(data);
 
-    qr_cache_prune(this);
+    qr_cache_prune(this, table);
 }
 
 gf_boolean_t
@@ -498,15 +725,12 @@ __qr_content_refresh(xlator_t *this, qr_inode_t *qr_inode, struct iatt *buf,
     gen = gen & 0xffffffff;
 
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode->table;
     conf = &priv->conf;
 
-    /* allow for rollover of frame->root->unique */
-    if ((rollover != qr_inode->gen_rollover) ||
-        (gen && qr_inode->gen && (qr_inode->gen >= gen)))
-        goto done;
+    __qr_sketch_add(table, qr_inode->key);
 
-    if ((qr_inode->data == NULL) && (qr_inode->invalidation_time >= gen))
+    if (__qr_content_stale(qr_inode, rollover, gen))
         goto done;
 
     qr_inode->gen = gen;
@@ -527,11 +751,9 @@ void
 qr_content_refresh(xlator_t *this, qr_inode_t *qr_inode, struct iatt *buf,
                    uint64_t gen)
 {
-    qr_private_t *priv = NULL;
     qr_inode_table_t *table = NULL;
 
-    priv = this->private;
-    table = &priv->table;
+    table = qr_inode->table;
 
     LOCK(&table->lock);
     {
@@ -563,7 +785,7 @@ qr_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
               int32_t op_errno, inode_t *inode_ret, struct iatt *buf,
               dict_t *xdata, struct iatt *postparent)
 {
-    void *content = NULL;
+    qr_content_t *content = NULL;
     qr_inode_t *qr_inode = NULL;
     inode_t *inode = NULL;
     qr_local_t *local = NULL;
@@ -585,10 +807,10 @@ qr_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
 
     if (content) {
         /* new content came along, always replace old content */
-        qr_inode = qr_inode_ctx_get_or_new(this, inode);
+        qr_inode = qr_inode_ctx_get_or_new(this, inode, buf->ia_gfid);
         if (!qr_inode) {
             /* no harm done */
-            GF_FREE(content);
+            qr_content_unref(content);
             goto out;
         }
 
@@ -705,6 +927,7 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
     xlator_t *this = NULL;
     qr_private_t *priv = NULL;
     qr_inode_table_t *table = NULL;
+    qr_content_t *content = NULL;
     int op_ret = -1;
     struct iobuf *iobuf = NULL;
     struct iobref *iobref = NULL;
@@ -714,13 +937,19 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
     struct iatt buf = {
         0,
     };
+    char *base = NULL;
+    size_t file_size = 0;
+    size_t stored = 0;
+    uLongf len = 0;
 
     this = frame->this;
     priv = this->private;
-    table = &priv->table;
+    table = qr_inode->table;
 
     LOCK(&table->lock);
     {
+        __qr_sketch_add(table, qr_inode->key);
+
         if (!qr_inode->data)
             goto unlock;
 
@@ -732,21 +961,11 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
 
         op_ret = min(size, (qr_inode->size - offset));
 
-        iobuf = iobuf_get2(this->ctx->iobuf_pool, op_ret);
-        if (!iobuf) {
-            op_ret = -1;
-            goto unlock;
-        }
-
-        iobref = iobref_new();
-        if (!iobref) {
-            op_ret = -1;
-            goto unlock;
-        }
-
-        iobref_add(iobref, iobuf);
-
-        memcpy(iobuf->ptr, qr_inode->data + offset, op_ret);
+        /* the copy or inflate happens below, off the lock; the ref keeps
+         * the content alive if it gets pruned or replaced meanwhile */
+        content = qr_content_ref(qr_inode->data);
+        file_size = qr_inode->size;
+        stored = qr_inode->stored;
 
         buf = qr_inode->buf;
 
@@ -756,8 +975,46 @@ qr_readv_cached(call_frame_t *frame, qr_inode_t *qr_inode, size_t size,
 unlock:
     UNLOCK(&table->lock);
 
+    if (op_ret < 0)
+        goto out;
+
+    /* compressed content is inflated whole, then served in place */
+    if (stored != file_size)
+        iobuf = iobuf_get2(this->ctx->iobuf_pool, file_size);
+    else
+        iobuf = iobuf_get2(this->ctx->iobuf_pool, op_ret);
+    if (!iobuf) {
+        op_ret = -1;
+        goto out;
+    }
+
+    iobref = iobref_new();
+    if (!iobref) {
+        op_ret = -1;
+        goto out;
+    }
+
+    iobref_add(iobref, iobuf);
+
+    if (stored != file_size) {
+        len = file_size;
+        if ((uncompress((Bytef *)iobuf->ptr, &len, (Bytef *)content->data,
+                        stored) != Z_OK) ||
+            (len != file_size)) {
+            op_ret = -1;
+            goto out;
+        }
+        base = (char *)iobuf->ptr + offset;
+    } else {
+        memcpy(iobuf->ptr, content->data + offset, op_ret);
+        base = iobuf->ptr;
+    }
+
+out:
+    qr_content_unref(content);
+
     if (op_ret >= 0) {
-        iov.iov_base = iobuf->ptr;
+        iov.iov_base = base;
         iov.iov_len = op_ret;
 
         GF_ATOMIC_INC(priv->qr_counter.cache_hit);
@@ -1044,8 +1301,12 @@ qr_priv_dump(xlator_t *this)
     qr_inode_table_t *table = NULL;
     uint32_t file_count = 0;
     uint32_t i = 0;
+    uint32_t j = 0;
     qr_inode_t *curr = NULL;
     uint64_t total_size = 0;
+    uint64_t saved = 0;
+    uint64_t hits = 0;
+    uint64_t lookups = 0;
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
 
     if (!this) {
@@ -1057,37 +1318,48 @@ qr_priv_dump(xlator_t *this)
     if (!conf)
         return -1;
 
-    table = &priv->table;
-
     gf_proc_dump_build_key(key_prefix, "xlator.performance.quick-read", "priv");
 
     gf_proc_dump_add_section("%s", key_prefix);
 
     gf_proc_dump_write("max_file_size", "%" PRIu64, conf->max_file_size);
     gf_proc_dump_write("cache_timeout", "%ld", conf->cache_timeout);
+    gf_proc_dump_write("compress", "%s", conf->compress ? "on" : "off");
+    gf_proc_dump_write("admission", "%s", conf->admission ? "on" : "off");
 
-    if (!table) {
-        goto out;
-    } else {
-        for (i = 0; i < conf->max_pri; i++) {
-            list_for_each_entry(curr, &table->lru[i], lru)
-            {
-                file_count++;
-                total_size += curr->size;
+    for (j = 0; j < QR_SHARD_COUNT; j++) {
+        table = &priv->table[j];
+
+        LOCK(&table->lock);
+        {
+            for (i = 0; i < conf->max_pri; i++) {
+                list_for_each_entry(curr, &table->lru[i], lru)
+                {
+                    file_count++;
+                    total_size += curr->stored;
+                }
             }
+            saved += table->saved;
         }
+        UNLOCK(&table->lock);
     }
 
+    hits = GF_ATOMIC_GET(priv->qr_counter.cache_hit);
+    lookups = hits + GF_ATOMIC_GET(priv->qr_counter.cache_miss);
+
     gf_proc_dump_write("total_files_cached", "%d", file_count);
     gf_proc_dump_write("total_cache_used", "%" PRIu64, total_size);
-    gf_proc_dump_write("cache-hit", "%" GF_PRI_ATOMIC,
-                       GF_ATOMIC_GET(priv->qr_counter.cache_hit));
+    gf_proc_dump_write("bytes-saved", "%" PRIu64, saved);
+    gf_proc_dump_write("cache-hit", "%" PRIu64, hits);
     gf_proc_dump_write("cache-miss", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(priv->qr_counter.cache_miss));
+    gf_proc_dump_write("cache-hit-ratio", "%.2f",
+                       lookups ? (double)hits * 100 / lookups : 0.0);
     gf_proc_dump_write("cache-invalidations", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(priv->qr_counter.file_data_invals));
+    gf_proc_dump_write("admission-rejects", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(priv->qr_counter.admission_rejects));
 
-out:
     return 0;
 }
 
@@ -1095,15 +1367,13 @@ static int32_t
 qr_dump_metrics(xlator_t *this, int fd)
 {
     qr_private_t *priv = NULL;
-    qr_inode_table_t *table = NULL;
 
     priv = this->private;
-    table = &priv->table;
 
     dprintf(fd, "%s.total_files_cached %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(priv->qr_counter.files_cached));
     dprintf(fd, "%s.total_cache_used %" PRId64 "\n", this->name,
-            table->cache_used);
+            qr_cache_used(priv));
     dprintf(fd, "%s.cache-hit %" PRId64 "\n", this->name,
             GF_ATOMIC_GET(priv->qr_counter.cache_hit));
     dprintf(fd, "%s.cache-miss %" PRId64 "\n", this->name,
@@ -1197,6 +1467,10 @@ qr_reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("ctime-invalidation", conf->ctime_invalidation, options,
                      bool, out);
 
+    GF_OPTION_RECONF("compress", conf->compress, options, bool, out);
+
+    GF_OPTION_RECONF("admission", conf->admission, options, bool, out);
+
     GF_OPTION_RECONF("cache-size", cache_size_new, options, size_uint64, out);
     if (!check_cache_size_ok(this, cache_size_new)) {
         ret = -1;
@@ -1204,6 +1478,14 @@ qr_reconfigure(xlator_t *this, dict_t *options)
                "Not reconfiguring cache-size");
         goto out;
     }
+    if (!qr_max_file_size_fits(conf->max_file_size, cache_size_new)) {
+        ret = -1;
+        gf_msg(this->name, GF_LOG_ERROR, EINVAL, QUICK_READ_MSG_INVALID_CONFIG,
+               "Not reconfiguring cache-size: max-file-size %" PRIu64
+               " is larger than a shard's share of cache-size %" PRIu64,
+               conf->max_file_size, cache_size_new);
+        goto out;
+    }
     conf->cache_size = cache_size_new;
 
     ret = 0;
@@ -1311,7 +1593,7 @@ out:
 int32_t
 qr_init(xlator_t *this)
 {
-    int32_t ret = -1, i = 0;
+    int32_t ret = -1, i = 0, j = 0;
     qr_private_t *priv = NULL;
     qr_conf_t *conf = NULL;
 
@@ -1335,7 +1617,8 @@ qr_init(xlator_t *this)
         goto out;
     }
 
-    LOCK_INIT(&priv->table.lock);
+    for (i = 0; i < QR_SHARD_COUNT; i++)
+        LOCK_INIT(&priv->table[i].lock);
     LOCK_INIT(&priv->lock);
     conf = &priv->conf;
 
@@ -1352,8 +1635,21 @@ qr_init(xlator_t *this)
         goto out;
     }
 
+    if (!qr_max_file_size_fits(conf->max_file_size, conf->cache_size)) {
+        gf_msg(this->name, GF_LOG_WARNING, 0, QUICK_READ_MSG_INVALID_CONFIG,
+               "max-file-size %" PRIu64 " is larger than a shard's share of "
+               "cache-size %" PRIu64 ", using %" PRIu64,
+               conf->max_file_size, conf->cache_size,
+               conf->cache_size / QR_SHARD_COUNT);
+        conf->max_file_size = conf->cache_size / QR_SHARD_COUNT;
+    }
+
     GF_OPTION_INIT("ctime-invalidation", conf->ctime_invalidation, bool, out);
 
+    GF_OPTION_INIT("compress", conf->compress, bool, out);
+
+    GF_OPTION_INIT("admission", conf->admission, bool, out);
+
     INIT_LIST_HEAD(&conf->priority_list);
     conf->max_pri = 1;
     if (dict_get(this->options, "priority")) {
@@ -1368,15 +1664,18 @@ qr_init(xlator_t *this)
         conf->max_pri++;
     }
 
-    priv->table.lru = GF_CALLOC(conf->max_pri, sizeof(*priv->table.lru),
-                                gf_common_mt_list_head);
-    if (priv->table.lru == NULL) {
-        ret = -1;
-        goto out;
-    }
+    for (i = 0; i < QR_SHARD_COUNT; i++) {
+        priv->table[i].lru = GF_CALLOC(conf->max_pri,
+                                       sizeof(*priv->table[i].lru),
+                                       gf_common_mt_list_head);
+        if (priv->table[i].lru == NULL) {
+            ret = -1;
+            goto out;
+        }
 
-    for (i = 0; i < conf->max_pri; i++) {
-        INIT_LIST_HEAD(&priv->table.lru[i]);
+        for (j = 0; j < conf->max_pri; j++) {
+            INIT_LIST_HEAD(&priv->table[i].lru[j]);
+        }
     }
 
     ret = 0;
@@ -1386,6 +1685,10 @@ qr_init(xlator_t *this)
     this->private = priv;
 out:
     if ((ret == -1) && priv) {
+        for (i = 0; i < QR_SHARD_COUNT; i++) {
+            GF_FREE(priv->table[i].lru);
+            LOCK_DESTROY(&priv->table[i].lock);
+        }
         GF_FREE(priv);
     }
 
@@ -1396,21 +1699,26 @@ void
 qr_inode_table_destroy(qr_private_t *priv)
 {
     int i = 0;
+    int j = 0;
     qr_conf_t *conf = NULL;
 
     conf = &priv->conf;
 
-    for (i = 0; i < conf->max_pri; i++) {
-        /* There is a known leak of inodes, hence until
-         * that is fixed, log the assert as warning.
-        GF_ASSERT (list_empty (&priv->table.lru[i]));*/
-        if (!list_empty(&priv->table.lru[i])) {
-            gf_msg("quick-read", GF_LOG_INFO, 0, QUICK_READ_MSG_LRU_NOT_EMPTY,
-                   "quick read inode table lru not empty");
+    for (j = 0; j < QR_SHARD_COUNT; j++) {
+        for (i = 0; i < conf->max_pri; i++) {
+            /* There is a known leak of inodes, hence until
+             * that is fixed, log the assert as warning.
+            GF_ASSERT (list_empty (&priv->table[j].lru[i]));*/
+            if (!list_empty(&priv->table[j].lru[i])) {
+                gf_msg("quick-read", GF_LOG_INFO, 0,
+                       QUICK_READ_MSG_LRU_NOT_EMPTY,
+                       "quick read inode table lru not empty");
+            }
         }
-    }
 
-    LOCK_DESTROY(&priv->table.lock);
+        GF_FREE(priv->table[j].lru);
+        LOCK_DESTROY(&priv->table[j].lock);
+    }
 
     return;
 }
@@ -1571,7 +1879,8 @@ struct volume_options qr_options[] = {
      .default_value = "128MB",
      .op_version = {1},
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
-     .description = "Size of small file read cache."},
+     .description = "Size of small file read cache. It is split evenly "
+                    "between the shards of the cache."},
     {
         .key = {"cache-timeout"},
         .type = GF_OPTION_TYPE_INT,
@@ -1617,6 +1926,30 @@ struct volume_options qr_options[] = {
                        "changes to file data. So, use this only when mtime "
                        "is not reliable",
     },
+    {
+        .key = {"compress"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .tags = {"quick-read"},
+        .description = "Keep cached file contents zlib compressed, trading "
+                       "CPU on every cached read for more files in the same "
+                       "cache-size. Contents which do not shrink by at least "
+                       "an eighth are kept as they are.",
+    },
+    {
+        .key = {"admission"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .op_version = {GD_OP_VERSION_10_0},
+        .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+        .tags = {"quick-read"},
+        .description = "When the cache is full, only cache a new file if it "
+                       "has been accessed more often than the file it would "
+                       "evict, so that one-off scans do not flush frequently "
+                       "read files.",
+    },
     {.key = {NULL}}};
 
 xlator_api_t xlator_api = {
@@ -25,9 +25,30 @@
 #include <fnmatch.h>
 #include "quick-read-mem-types.h"
 
+/* The cache is split in shards, each with its own lock, LRU lists and
+ * an equal part of cache-size. Must be a power of 2. */
+#define QR_SHARD_COUNT 16
+
+/* Dimensions of the per-shard access frequency sketch used for admission.
+ * QR_SKETCH_WIDTH must be a power of 2. */
+#define QR_SKETCH_DEPTH 4
+#define QR_SKETCH_WIDTH 1024
+#define QR_SKETCH_MAX 15
+
+struct qr_inode_table;
+
+/* Cached file content, plain or compressed. Readers hold a ref while they
+ * copy or inflate it outside the table lock. */
+struct qr_content {
+    gf_atomic_t ref;
+    char data[];
+};
+typedef struct qr_content qr_content_t;
+
 struct qr_inode {
-    void *data;
-    size_t size;
+    qr_content_t *data;
+    size_t size;   /* size of the file */
+    size_t stored; /* bytes held in data, less than size if compressed */
     int priority;
     uint64_t ia_mtime;
     uint32_t ia_mtime_nsec;
@@ -39,6 +60,8 @@ struct qr_inode {
     struct list_head lru;
     uint64_t gen;
     time_t invalidation_time;
+    uint64_t key; /* gfid hash, picks the shard and sketch counters */
+    struct qr_inode_table *table;
 };
 typedef struct qr_inode qr_inode_t;
 
@@ -56,14 +79,20 @@ struct qr_conf {
     int max_pri;
     gf_boolean_t qr_invalidation;
     gf_boolean_t ctime_invalidation;
+    gf_boolean_t compress;
+    gf_boolean_t admission;
     struct list_head priority_list;
 };
 typedef struct qr_conf qr_conf_t;
 
+/* One shard of the cache. */
 struct qr_inode_table {
-    uint64_t cache_used;
-    struct list_head *lru;
     gf_lock_t lock;
+    uint64_t cache_used; /* bytes held, after compression */
+    uint64_t saved;      /* bytes compression saved */
+    struct list_head *lru;
+    uint32_t sketch_adds;
+    uint8_t sketch[QR_SKETCH_DEPTH][QR_SKETCH_WIDTH];
 };
 typedef struct qr_inode_table qr_inode_table_t;
 
@@ -72,11 +101,12 @@ struct qr_statistics {
     gf_atomic_t cache_miss;
     gf_atomic_t file_data_invals; /* No. of invalidates received from upcall */
     gf_atomic_t files_cached;
+    gf_atomic_t admission_rejects;
 };
 
 struct qr_private {
     qr_conf_t conf;
-    qr_inode_table_t table;
+    qr_inode_table_t table[QR_SHARD_COUNT];
     time_t last_child_down;
     gf_lock_t lock;
     struct qr_statistics qr_counter;
@@ -15,22 +15,30 @@
 #include <assert.h>
 #include "read-ahead-messages.h"
 
+int
+ra_page_cmp(const void *a, const void *b, void *param)
+{
+    const ra_page_t *pa = a;
+    const ra_page_t *pb = b;
+
+    if (pa->offset < pb->offset)
+        return -1;
+
+    return (pa->offset > pb->offset);
+}
+
 ra_page_t *
 ra_page_get(ra_file_t *file, off_t offset)
 {
     ra_page_t *page = NULL;
-    off_t rounded_offset = 0;
+    ra_page_t key = {
+        0,
+    };
 
     GF_VALIDATE_OR_GOTO("read-ahead", file, out);
 
-    page = file->pages.next;
-    rounded_offset = gf_floor(offset, file->page_size);
-
-    while (page != &file->pages && page->offset < rounded_offset)
-        page = page->next;
-
-    if (page == &file->pages || page->offset != rounded_offset)
-        page = NULL;
+    key.offset = gf_floor(offset, file->page_size);
+    page = rb_find(file->page_tree, &key);
 
 out:
     return page;
@@ -40,33 +48,44 @@ ra_page_t *
 ra_page_create(ra_file_t *file, off_t offset)
 {
     ra_page_t *page = NULL;
-    off_t rounded_offset = 0;
+    ra_page_t *next = NULL;
     ra_page_t *newpage = NULL;
+    struct rb_traverser trav;
 
     GF_VALIDATE_OR_GOTO("read-ahead", file, out);
 
-    page = file->pages.next;
-    rounded_offset = gf_floor(offset, file->page_size);
-
-    while (page != &file->pages && page->offset < rounded_offset)
-        page = page->next;
+    page = ra_page_get(file, offset);
+    if (page)
+        goto out;
 
-    if (page == &file->pages || page->offset != rounded_offset) {
-        newpage = GF_CALLOC(1, sizeof(*newpage), gf_ra_mt_ra_page_t);
-        if (!newpage) {
-            goto out;
-        }
+    newpage = GF_CALLOC(1, sizeof(*newpage), gf_ra_mt_ra_page_t);
+    if (!newpage) {
+        goto out;
+    }
 
-        newpage->offset = rounded_offset;
-        newpage->prev = page->prev;
-        newpage->next = page;
-        newpage->file = file;
-        page->prev->next = newpage;
-        page->prev = newpage;
+    newpage->offset = gf_floor(offset, file->page_size);
+    newpage->file = file;
+    newpage->stream = -1;
 
-        page = newpage;
+    if (rb_t_insert(&trav, file->page_tree, newpage) != newpage) {
+        GF_FREE(newpage);
+        goto out;
     }
 
+    /* keep the list in offset order: link in front of the successor */
+    next = rb_t_next(&trav);
+    if (!next)
+        next = &file->pages;
+
+    newpage->prev = next->prev;
+    newpage->next = next;
+    next->prev->next = newpage;
+    next->prev = newpage;
+
+    GF_ATOMIC_ADD(file->conf->cache_used, file->page_size);
+
+    page = newpage;
+
 out:
     return page;
 }
@@ -516,11 +535,22 @@ out:
 void
 ra_page_purge(ra_page_t *page)
 {
+    ra_file_t *file = NULL;
+
     GF_VALIDATE_OR_GOTO("read-ahead", page, out);
 
+    file = page->file;
+
+    /* prefetched, never asked for: the stream read too far ahead */
+    if (page->dirty && page->stream >= 0)
+        file->streams[page->stream].wasted++;
+
+    rb_delete(file->page_tree, page);
     page->prev->next = page->next;
     page->next->prev = page->prev;
 
+    GF_ATOMIC_SUB(file->conf->cache_used, file->page_size);
+
     if (page->iobref) {
         iobref_unref(page->iobref);
     }
@@ -596,6 +626,9 @@ ra_file_destroy(ra_file_t *file)
         trav = file->pages.next;
     }
 
+    if (file->page_tree)
+        rb_destroy(file->page_tree, NULL);
+
     pthread_mutex_destroy(&file->file_lock);
     GF_FREE(file);
 
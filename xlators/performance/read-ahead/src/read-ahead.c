@@ -25,7 +25,7 @@
 #include "read-ahead-messages.h"
 
 static void
-read_ahead(call_frame_t *frame, ra_file_t *file);
+read_ahead(call_frame_t *frame, ra_file_t *file, int idx);
 
 int
 ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
@@ -51,12 +51,19 @@ ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
         goto unwind;
     }
 
+    file->page_tree = rb_create(ra_page_cmp, NULL, NULL);
+    if (!file->page_tree) {
+        GF_FREE(file);
+        op_ret = -1;
+        op_errno = ENOMEM;
+        goto unwind;
+    }
+
     /* If O_DIRECT open, we disable caching on it */
 
     if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
         file->disabled = 1;
 
-    file->offset = (unsigned long long)0;
     file->conf = conf;
     file->pages.next = &file->pages;
     file->pages.prev = &file->pages;
@@ -73,14 +80,9 @@ ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ra_conf_unlock(conf);
 
     file->fd = fd;
-    file->page_count = conf->page_count;
     file->page_size = conf->page_size;
     pthread_mutex_init(&file->file_lock, NULL);
 
-    if (!file->disabled) {
-        file->page_count = 1;
-    }
-
     ret = fd_ctx_set(fd, this, (uint64_t)(long)file);
     if (ret == -1) {
         gf_msg(frame->this->name, GF_LOG_WARNING, 0, READ_AHEAD_MSG_NO_MEMORY,
@@ -125,12 +127,19 @@ ra_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
         goto unwind;
     }
 
+    file->page_tree = rb_create(ra_page_cmp, NULL, NULL);
+    if (!file->page_tree) {
+        GF_FREE(file);
+        op_ret = -1;
+        op_errno = ENOMEM;
+        goto unwind;
+    }
+
     /* If O_DIRECT open, we disable caching on it */
 
     if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
         file->disabled = 1;
 
-    file->offset = (unsigned long long)0;
     // file->size = fd->inode->buf.ia_size;
     file->conf = conf;
     file->pages.next = &file->pages;
@@ -148,7 +157,6 @@ ra_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ra_conf_unlock(conf);
 
     file->fd = fd;
-    file->page_count = conf->page_count;
     file->page_size = conf->page_size;
     pthread_mutex_init(&file->file_lock, NULL);
 
@@ -230,6 +238,146 @@ flush_region(call_frame_t *frame, ra_file_t *file, off_t offset, off_t size,
     ra_file_unlock(file);
 }
 
+/* free the pages of stream @idx below @end, called with the file lock held */
+static void
+__ra_stream_purge(ra_file_t *file, int idx, off_t end)
+{
+    ra_page_t *trav = NULL;
+    ra_page_t *next = NULL;
+
+    trav = file->pages.next;
+    while (trav != &file->pages && trav->offset < end) {
+        next = trav->next;
+        if (trav->stream == idx) {
+            if (!trav->waitq) {
+                ra_page_purge(trav);
+            } else {
+                trav->stale = 1;
+                trav->stream = -1;
+            }
+        }
+        trav = next;
+    }
+}
+
+/*
+ * Find the stream a read continues, either sequentially or at the
+ * stride seen so far, and advance it.  A read that continues nothing
+ * may confirm a stride for a stream seen only once; otherwise it starts
+ * a new stream in a free or the least recently used slot.  Called with
+ * the file lock held.
+ */
+static int
+__ra_stream_get(ra_file_t *file, off_t offset, size_t size)
+{
+    ra_stream_t *stream = NULL;
+    off_t delta = 0;
+    int candidate = -1;
+    int victim = 0;
+    int i = 0;
+
+    file->reads++;
+
+    for (i = 0; i < RA_MAX_STREAMS; i++) {
+        stream = &file->streams[i];
+        if (!stream->used)
+            continue;
+
+        if (offset == stream->offset + stream->size) {
+            stream->stride = stream->size;
+            goto found;
+        }
+
+        if (stream->run && (offset == stream->offset + stream->stride))
+            goto found;
+
+        delta = offset - stream->offset;
+        if (!stream->run && (candidate < 0) && (delta > 0) &&
+            (delta <= RA_MAX_STRIDE_PAGES * file->page_size))
+            candidate = i;
+    }
+
+    if (candidate >= 0) {
+        i = candidate;
+        stream = &file->streams[i];
+        stream->stride = offset - stream->offset;
+        goto found;
+    }
+
+    for (i = 0; i < RA_MAX_STREAMS; i++) {
+        if (!file->streams[i].used) {
+            victim = i;
+            break;
+        }
+        if (file->streams[i].used < file->streams[victim].used)
+            victim = i;
+    }
+
+    stream = &file->streams[victim];
+    if (stream->used)
+        __ra_stream_purge(file, victim, file->pages.prev->offset + 1);
+
+    memset(stream, 0, sizeof(*stream));
+    stream->offset = offset;
+    stream->size = size;
+    stream->used = file->reads;
+
+    /* files are mostly read from the start, take that as sequential */
+    if (offset == 0) {
+        stream->stride = size;
+        stream->run = 1;
+        stream->window = 1;
+    }
+
+    return victim;
+
+found:
+    stream->run++;
+    if (!stream->window)
+        stream->window = 1;
+    stream->offset = offset;
+    stream->size = size;
+    stream->used = file->reads;
+
+    return i;
+}
+
+/*
+ * Resize the window from what the last read found: halve it when
+ * prefetched pages went unread, double it when the reader had to wait
+ * for pages still in transit and grow it by a page on plain hits.
+ */
+static void
+__ra_stream_adapt(ra_conf_t *conf, ra_stream_t *stream, ra_local_t *local)
+{
+    stream->hits += local->hits;
+    stream->waits += local->waits;
+
+    if (stream->wasted) {
+        stream->window = max(stream->window / 2, 1);
+        stream->wasted = 0;
+    } else if (local->waits) {
+        stream->window = min(stream->window * 2, conf->page_count);
+    } else if (local->hits) {
+        stream->window = min(stream->window + 1, conf->page_count);
+    }
+}
+
+static void
+ra_file_reset_streams(ra_file_t *file)
+{
+    int i = 0;
+
+    ra_file_lock(file);
+    {
+        for (i = 0; i < RA_MAX_STREAMS; i++) {
+            file->streams[i].window = 1;
+            file->streams[i].wasted = 0;
+        }
+    }
+    ra_file_unlock(file);
+}
+
 int
 ra_release(xlator_t *this, fd_t *fd)
 {
@@ -249,74 +397,106 @@ out:
     return 0;
 }
 
-void
-read_ahead(call_frame_t *frame, ra_file_t *file)
+/*
+ * Prefetch the pages in [start, end) of stream @idx that are not cached
+ * yet.  Returns -1 once the cache budget or memory runs out.
+ */
+static int
+ra_prefetch(call_frame_t *frame, ra_file_t *file, int idx, off_t start,
+            off_t end)
 {
-    off_t ra_offset = 0;
-    size_t ra_size = 0;
-    off_t trav_offset = 0;
+    ra_conf_t *conf = NULL;
     ra_page_t *trav = NULL;
-    off_t cap = 0;
+    off_t trav_offset = 0;
     char fault = 0;
+    int ret = 0;
 
-    GF_VALIDATE_OR_GOTO("read-ahead", frame, out);
-    GF_VALIDATE_OR_GOTO(frame->this->name, file, out);
-
-    if (!file->page_count) {
-        goto out;
-    }
-
-    ra_size = file->page_size * file->page_count;
-    ra_offset = gf_floor(file->offset, file->page_size);
-    cap = file->size ? file->size : file->offset + ra_size;
-
-    while (ra_offset < min(file->offset + ra_size, cap)) {
-        ra_file_lock(file);
-        {
-            trav = ra_page_get(file, ra_offset);
-        }
-        ra_file_unlock(file);
-
-        if (!trav)
-            break;
-
-        ra_offset += file->page_size;
-    }
-
-    if (trav) {
-        /* comfortable enough */
-        goto out;
-    }
-
-    trav_offset = ra_offset;
-
-    cap = file->size ? file->size : ra_offset + ra_size;
+    conf = file->conf;
 
-    while (trav_offset < min(ra_offset + ra_size, cap)) {
+    for (trav_offset = gf_floor(start, file->page_size); trav_offset < end;
+         trav_offset += file->page_size) {
         fault = 0;
         ra_file_lock(file);
         {
             trav = ra_page_get(file, trav_offset);
             if (!trav) {
-                fault = 1;
+                if (GF_ATOMIC_GET(conf->cache_used) + file->page_size >
+                    conf->cache_size) {
+                    GF_ATOMIC_INC(conf->budget_skips);
+                    ret = -1;
+                    goto unlock;
+                }
+
                 trav = ra_page_create(file, trav_offset);
-                if (trav)
-                    trav->dirty = 1;
+                if (!trav) {
+                    /* OUT OF MEMORY */
+                    ret = -1;
+                    goto unlock;
+                }
+
+                trav->dirty = 1;
+                trav->stream = idx;
+                fault = 1;
             }
         }
+    unlock:
         ra_file_unlock(file);
 
-        if (!trav) {
-            /* OUT OF MEMORY */
+        if (ret)
             break;
-        }
 
         if (fault) {
             gf_msg_trace(frame->this->name, 0, "RA at offset=%" PRId64,
                          trav_offset);
             ra_page_fault(file, frame, trav_offset);
         }
-        trav_offset += file->page_size;
+    }
+
+    return ret;
+}
+
+static void
+read_ahead(call_frame_t *frame, ra_file_t *file, int idx)
+{
+    ra_stream_t stream;
+    off_t start = 0;
+    off_t end = 0;
+    off_t eof = 0;
+    uint32_t i = 0;
+
+    GF_VALIDATE_OR_GOTO("read-ahead", frame, out);
+    GF_VALIDATE_OR_GOTO(frame->this->name, file, out);
+
+    ra_file_lock(file);
+    {
+        stream = file->streams[idx];
+        eof = file->stbuf.ia_size;
+    }
+    ra_file_unlock(file);
+
+    if (!stream.run || !stream.window) {
+        goto out;
+    }
+
+    if (stream.stride <= (off_t)(stream.size + file->page_size)) {
+        /* sequential, or gaps too small to skip a page */
+        start = stream.offset + stream.size;
+        end = start + stream.window * file->page_size;
+        if (eof && end > eof)
+            end = eof;
+
+        ra_prefetch(frame, file, idx, start, end);
+        goto out;
+    }
+
+    for (i = 1; i <= stream.window; i++) {
+        start = stream.offset + i * stream.stride;
+        end = start + stream.size;
+        if (eof && end > eof)
+            end = eof;
+
+        if ((start >= end) || ra_prefetch(frame, file, idx, start, end))
+            break;
     }
 
 out:
@@ -335,7 +515,7 @@ ra_need_atime_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 static void
-dispatch_requests(call_frame_t *frame, ra_file_t *file)
+dispatch_requests(call_frame_t *frame, ra_file_t *file, int idx)
 {
     ra_local_t *local = NULL;
     ra_conf_t *conf = NULL;
@@ -374,7 +554,15 @@ dispatch_requests(call_frame_t *frame, ra_file_t *file)
                 fault = 1;
                 need_atime_update = 0;
             }
+
+            if (trav->dirty) {
+                if (trav->ready)
+                    local->hits++;
+                else
+                    local->waits++;
+            }
             trav->dirty = 0;
+            trav->stream = idx;
 
             if (trav->ready) {
                 gf_msg_trace(frame->this->name, 0, "HIT at offset=%" PRId64 ".",
@@ -444,7 +632,7 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     ra_local_t *local = NULL;
     ra_conf_t *conf = NULL;
     int op_errno = EINVAL;
-    char expected_offset = 1;
+    int idx = 0;
     uint64_t tmp_file = 0;
 
     GF_ASSERT(frame);
@@ -464,29 +652,14 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         goto disabled;
     }
 
-    if (file->offset != offset) {
-        gf_msg_trace(this->name, 0,
-                     "unexpected offset (%" PRId64 " != %" PRId64
-                     ") "
-                     "resetting",
-                     file->offset, offset);
-
-        expected_offset = file->expected = file->page_count = 0;
-    } else {
-        gf_msg_trace(this->name, 0,
-                     "expected offset (%" PRId64 ") when page_count=%d", offset,
-                     file->page_count);
-
-        if (file->expected < (file->page_size * conf->page_count)) {
-            file->expected += size;
-            file->page_count = min((file->expected / file->page_size),
-                                   conf->page_count);
-        }
+    ra_file_lock(file);
+    {
+        idx = __ra_stream_get(file, offset, size);
     }
+    ra_file_unlock(file);
 
-    if (!expected_offset) {
-        flush_region(frame, file, 0, file->pages.prev->offset + 1, 0);
-    }
+    gf_msg_trace(this->name, 0, "read at offset=%" PRId64 " in stream %d",
+                 offset, idx);
 
     local = mem_get0(this->local_pool);
     if (!local) {
@@ -506,13 +679,16 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
     frame->local = local;
 
-    dispatch_requests(frame, file);
+    dispatch_requests(frame, file, idx);
 
-    flush_region(frame, file, 0, gf_floor(offset, file->page_size), 0);
-
-    read_ahead(frame, file);
+    ra_file_lock(file);
+    {
+        __ra_stream_adapt(conf, &file->streams[idx], local);
+        __ra_stream_purge(file, idx, gf_floor(offset, file->page_size));
+    }
+    ra_file_unlock(file);
 
-    file->offset = offset + size;
+    read_ahead(frame, file, idx);
 
     ra_frame_return(frame);
 
@@ -640,8 +816,8 @@ ra_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
 
             flush_region(frame, file, 0, file->pages.prev->offset + 1, 1);
 
-            /* reset the read-ahead counters too */
-            file->expected = file->page_count = 0;
+            /* restart the read-ahead windows too */
+            ra_file_reset_streams(file);
         }
     }
     UNLOCK(&inode->lock);
@@ -766,12 +942,16 @@ ra_fdctx_dump(xlator_t *this, fd_t *fd)
 {
     ra_file_t *file = NULL;
     ra_page_t *page = NULL;
+    ra_stream_t *stream = NULL;
     int32_t ret = 0, i = 0;
     uint64_t tmp_file = 0;
     char *path = NULL;
     char key_prefix[GF_DUMP_MAX_BUF_LEN] = {
         0,
     };
+    char key[GF_DUMP_MAX_BUF_LEN] = {
+        0,
+    };
 
     fd_ctx_get(fd, this, &tmp_file);
     file = (ra_file_t *)(long)tmp_file;
@@ -802,11 +982,21 @@ ra_fdctx_dump(xlator_t *this, fd_t *fd)
 
     gf_proc_dump_write("page-size", "%" PRId64, file->page_size);
 
-    gf_proc_dump_write("page-count", "%u", file->page_count);
-
-    gf_proc_dump_write("next-expected-offset-for-sequential-reads", "%" PRId64,
-                       file->offset);
+    for (i = 0; i < RA_MAX_STREAMS; i++) {
+        stream = &file->streams[i];
+        if (!stream->used)
+            continue;
+
+        snprintf(key, sizeof(key), "stream[%d]", i);
+        gf_proc_dump_write(key,
+                           "offset=%" PRId64 ", stride=%" PRId64
+                           ", window=%u, run=%u, hits=%" PRIu64
+                           ", waits=%" PRIu64,
+                           stream->offset, stream->stride, stream->window,
+                           stream->run, stream->hits, stream->waits);
+    }
 
+    i = 0;
     for (page = file->pages.next; page != &file->pages; page = page->next) {
         gf_proc_dump_write("page", "%d: %p", i++, (void *)page);
         ra_page_dump(page);
@@ -1042,6 +1232,11 @@ ra_priv_dump(xlator_t *this)
     {
         gf_proc_dump_write("page_size", "%" PRIu64, conf->page_size);
         gf_proc_dump_write("page_count", "%d", conf->page_count);
+        gf_proc_dump_write("cache_size", "%" PRIu64, conf->cache_size);
+        gf_proc_dump_write("cache_used", "%" PRIu64,
+                           GF_ATOMIC_GET(conf->cache_used));
+        gf_proc_dump_write("budget_skips", "%" PRIu64,
+                           GF_ATOMIC_GET(conf->budget_skips));
         gf_proc_dump_write("force_atime_update", "%d",
                            conf->force_atime_update);
     }
@@ -1092,6 +1287,9 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("page-size", conf->page_size, options, size_uint64, out);
 
+    GF_OPTION_RECONF("cache-size", conf->cache_size, options, size_uint64,
+                     out);
+
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
 
     ret = 0;
@@ -1131,6 +1329,8 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("page-count", conf->page_count, uint32, out);
 
+    GF_OPTION_INIT("cache-size", conf->cache_size, size_uint64, out);
+
     GF_OPTION_INIT("force-atime-update", conf->force_atime_update, bool, out);
 
     GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
@@ -1138,6 +1338,9 @@ init(xlator_t *this)
     conf->files.next = &conf->files;
     conf->files.prev = &conf->files;
 
+    GF_ATOMIC_INIT(conf->cache_used, 0);
+    GF_ATOMIC_INIT(conf->budget_skips, 0);
+
     pthread_mutex_init(&conf->conf_lock, NULL);
 
     this->local_pool = mem_pool_new(ra_local_t, 64);
@@ -1236,7 +1439,8 @@ struct volume_options options[] = {
      .default_value = "4",
      .op_version = {1},
      .tags = {"read-ahead"},
-     .description = "Number of pages that will be pre-fetched"},
+     .description = "Largest number of pages (or reads, for strided "
+                    "access) a stream will pre-fetch"},
     {.key = {"page-size"},
      .type = GF_OPTION_TYPE_SIZET,
      .min = 4096,
@@ -1246,6 +1450,17 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
      .tags = {"read-ahead"},
      .description = "Page size with which read-ahead performs server I/O"},
+    {.key = {"cache-size"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = GF_UNIT_MB,
+     .max = 32 * GF_UNIT_GB,
+     .default_value = "64MB",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"read-ahead"},
+     .description = "Memory all open files together may hold in read-ahead "
+                    "pages. Pre-fetching stops while the limit is reached; "
+                    "pages a reader asked for are always fetched."},
     {.key = {"pass-through"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "false",
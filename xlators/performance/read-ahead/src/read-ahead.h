@@ -15,6 +15,13 @@
 #include <glusterfs/dict.h>
 #include <glusterfs/xlator.h>
 #include "read-ahead-mem-types.h"
+#include "rb.h"
+
+/* Independent access streams tracked per fd. */
+#define RA_MAX_STREAMS 4
+
+/* Reads further apart than this many pages are not taken as a stride. */
+#define RA_MAX_STRIDE_PAGES 64
 
 struct ra_conf;
 struct ra_local;
@@ -44,6 +51,8 @@ struct ra_local {
     size_t size;
     int32_t op_ret;
     int32_t op_errno;
+    int32_t hits;  /* pages found ready in the read-ahead cache */
+    int32_t waits; /* pages prefetched but still in transit */
     off_t pending_offset;
     size_t pending_size;
     fd_t *fd;
@@ -65,6 +74,27 @@ struct ra_page {
     struct ra_waitq *waitq;
     struct iobref *iobref;
     char stale;
+    int8_t stream; /* index of the stream the page was read for */
+};
+
+/*
+ * A stream is a run of reads on the fd at a fixed distance from each
+ * other: sequential reads when the distance equals the read size, a
+ * strided pattern otherwise.  Each stream has its own window, which
+ * grows while prefetched pages are consumed (faster when readers catch
+ * up with pages still in transit) and is halved when prefetched pages
+ * are thrown away unread.
+ */
+struct ra_stream {
+    off_t offset;    /* offset of the last read */
+    size_t size;     /* size of the last read */
+    off_t stride;    /* distance between the last two reads */
+    uint64_t used;   /* file->reads at last use, 0 if slot is free */
+    uint32_t run;    /* reads that confirmed the pattern */
+    uint32_t window; /* reads or pages to prefetch */
+    uint32_t wasted; /* prefetched pages purged unread */
+    uint64_t hits;
+    uint64_t waits;
 };
 
 struct ra_file {
@@ -73,20 +103,22 @@ struct ra_file {
     struct ra_conf *conf;
     fd_t *fd;
     int disabled;
-    size_t expected;
-    struct ra_page pages;
-    off_t offset;
-    size_t size;
+    struct ra_page pages;           /* ordered by offset */
+    struct rb_table *page_tree;     /* index of pages by offset */
+    struct ra_stream streams[RA_MAX_STREAMS];
+    uint64_t reads;
     int32_t refcount;
     pthread_mutex_t file_lock;
     struct iatt stbuf;
     uint64_t page_size;
-    uint32_t page_count;
 };
 
 struct ra_conf {
     uint64_t page_size;
     uint32_t page_count;
+    uint64_t cache_size; /* bytes all files together may hold in pages */
+    gf_atomic_t cache_used;
+    gf_atomic_t budget_skips;
     void *cache_block;
     struct ra_file files;
     gf_boolean_t force_atime_update;
@@ -98,6 +130,7 @@ typedef struct ra_local ra_local_t;
 typedef struct ra_page ra_page_t;
 typedef struct ra_file ra_file_t;
 typedef struct ra_waitq ra_waitq_t;
+typedef struct ra_stream ra_stream_t;
 typedef struct ra_fill ra_fill_t;
 
 ra_page_t *
@@ -106,6 +139,9 @@ ra_page_get(ra_file_t *file, off_t offset);
 ra_page_t *
 ra_page_create(ra_file_t *file, off_t offset);
 
+int
+ra_page_cmp(const void *a, const void *b, void *param);
+
 void
 ra_page_fault(ra_file_t *file, call_frame_t *frame, off_t offset);
 void
@@ -18,6 +18,7 @@ enum gf_rda_mem_types_ {
     gf_rda_mt_rda_fd_ctx,
     gf_rda_mt_rda_priv,
     gf_rda_mt_inode_ctx_t,
+    gf_rda_mt_dir_listing,
     gf_rda_mt_end
 };
 
@@ -26,6 +26,8 @@
 #include <math.h>
 #include <glusterfs/glusterfs.h>
 #include <glusterfs/call-stub.h>
+#include <glusterfs/statedump.h>
+#include <glusterfs/upcall-utils.h>
 #include "readdir-ahead.h"
 #include "readdir-ahead-mem-types.h"
 #include "readdir-ahead-messages.h"
@@ -41,6 +43,8 @@ rda_local_wipe(struct rda_local *local)
         dict_unref(local->xattrs);
     if (local->inode)
         inode_unref(local->inode);
+    if (local->newparent)
+        inode_unref(local->newparent);
 }
 
 /*
@@ -177,6 +181,362 @@ rda_inode_ctx_update_iatts(inode_t *inode, xlator_t *this,
     return ret;
 }
 
+static void
+rda_inode_ctx_get_iatt(inode_t *inode, xlator_t *this, struct iatt *attr)
+{
+    rda_inode_ctx_t *ctx_p = NULL;
+
+    LOCK(&inode->lock);
+    {
+        ctx_p = __rda_inode_ctx_get(inode, this);
+        if (ctx_p) {
+            *attr = ctx_p->statbuf;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (ctx_p == NULL)
+        memset(attr, 0, sizeof(struct iatt));
+}
+
+/*
+ * Directory listing cache. A preload that starts at offset 0 and reaches eod
+ * without being bypassed holds the complete listing of the directory. A copy
+ * of it is hung off the directory inode ctx so that later opendirs are served
+ * without going to the bricks. Every change to the directory, seen either
+ * through an entry fop or an upcall, bumps dir_gen and drops the listing; a
+ * preload that overlapped such a change is not installed.
+ *
+ * Upcalls only reach a client that looked at the directory within the
+ * cache-invalidation-timeout of the bricks, so a listing is not served for
+ * longer than rda-dir-cache-timeout after it was installed. The entries keep
+ * no inodes, which would otherwise be pinned past the lru-limit of the inode
+ * table for as long as the listing is cached.
+ *
+ * Lock order is inode->lock, then priv->lock. The directory inode lock is
+ * never taken with an fd ctx lock held.
+ */
+static struct rda_dir_listing *
+rda_dir_listing_new(void)
+{
+    struct rda_dir_listing *listing = NULL;
+
+    listing = GF_CALLOC(1, sizeof(*listing), gf_rda_mt_dir_listing);
+    if (!listing)
+        return NULL;
+
+    INIT_LIST_HEAD(&listing->entries.list);
+    INIT_LIST_HEAD(&listing->lru);
+    GF_ATOMIC_INIT(listing->refcount, 1);
+
+    return listing;
+}
+
+static void
+rda_dir_listing_unref(struct rda_dir_listing *listing)
+{
+    if (!listing)
+        return;
+
+    if (GF_ATOMIC_DEC(listing->refcount) != 0)
+        return;
+
+    gf_dirent_free(&listing->entries);
+    if (listing->inode)
+        inode_unref(listing->inode);
+    GF_FREE(listing);
+}
+
+static int
+rda_dir_gen_get(xlator_t *this, inode_t *inode, uint64_t *gen)
+{
+    rda_inode_ctx_t *ctx_p = NULL;
+
+    LOCK(&inode->lock);
+    {
+        ctx_p = __rda_inode_ctx_get(inode, this);
+        if (ctx_p)
+            *gen = GF_ATOMIC_GET(ctx_p->dir_gen);
+    }
+    UNLOCK(&inode->lock);
+
+    return ctx_p ? 0 : -1;
+}
+
+/*
+ * Take a reference on the cached listing of a directory, if there is one
+ * that has not expired yet.
+ */
+static struct rda_dir_listing *
+rda_dir_listing_get(xlator_t *this, inode_t *inode)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_dir_listing *listing = NULL;
+    struct rda_dir_listing *expired = NULL;
+    rda_inode_ctx_t *ctx_p = NULL;
+    uint64_t ctx_uint = 0;
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get1(inode, this, &ctx_uint) == 0) {
+            ctx_p = (rda_inode_ctx_t *)(uintptr_t)ctx_uint;
+            listing = ctx_p->listing;
+        }
+
+        if (listing &&
+            (gf_time() - listing->installed) >= priv->dir_cache_timeout) {
+            expired = listing;
+            listing = NULL;
+            ctx_p->listing = NULL;
+        }
+
+        if (listing || expired) {
+            if (listing)
+                GF_ATOMIC_INC(listing->refcount);
+
+            LOCK(&priv->lock);
+            {
+                if (expired && !expired->evicted) {
+                    list_del_init(&expired->lru);
+                    priv->dir_cache_size -= expired->size;
+                    expired->evicted = _gf_true;
+                } else if (listing && !listing->evicted) {
+                    list_move(&listing->lru, &priv->dir_lru);
+                }
+            }
+            UNLOCK(&priv->lock);
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    rda_dir_listing_unref(expired);
+
+    if (listing)
+        GF_ATOMIC_INC(priv->dir_cache_hits);
+    else
+        GF_ATOMIC_INC(priv->dir_cache_misses);
+
+    return listing;
+}
+
+/*
+ * Drop listings from the cold end of the lru until the cache fits in its
+ * budget. With the cache disabled everything goes.
+ */
+static void
+rda_dir_cache_prune(xlator_t *this)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_dir_listing *victim = NULL;
+    rda_inode_ctx_t *ctx_p = NULL;
+    uint64_t ctx_uint = 0;
+    uint64_t limit = 0;
+    gf_boolean_t drop = _gf_false;
+
+    limit = priv->dir_cache ? priv->dir_cache_limit : 0;
+
+    for (;;) {
+        victim = NULL;
+
+        LOCK(&priv->lock);
+        {
+            if (priv->dir_cache_size > limit &&
+                !list_empty(&priv->dir_lru)) {
+                victim = list_entry(priv->dir_lru.prev, struct rda_dir_listing,
+                                    lru);
+                list_del_init(&victim->lru);
+                priv->dir_cache_size -= victim->size;
+                victim->evicted = _gf_true;
+                GF_ATOMIC_INC(victim->refcount);
+            }
+        }
+        UNLOCK(&priv->lock);
+
+        if (!victim)
+            break;
+
+        drop = _gf_false;
+        LOCK(&victim->inode->lock);
+        {
+            if (__inode_ctx_get1(victim->inode, this, &ctx_uint) == 0) {
+                ctx_p = (rda_inode_ctx_t *)(uintptr_t)ctx_uint;
+                if (ctx_p->listing == victim) {
+                    ctx_p->listing = NULL;
+                    drop = _gf_true;
+                }
+            }
+        }
+        UNLOCK(&victim->inode->lock);
+
+        if (drop)
+            rda_dir_listing_unref(victim);
+        rda_dir_listing_unref(victim);
+    }
+}
+
+/*
+ * Hand a complete listing over to the directory inode ctx. The caller's
+ * reference is consumed.
+ */
+static void
+rda_dir_listing_install(xlator_t *this, inode_t *inode,
+                        struct rda_dir_listing *listing, uint64_t gen)
+{
+    struct rda_priv *priv = this->private;
+    rda_inode_ctx_t *ctx_p = NULL;
+    gf_boolean_t installed = _gf_false;
+
+    listing->inode = inode_ref(inode);
+    listing->installed = gf_time();
+
+    LOCK(&inode->lock);
+    {
+        ctx_p = __rda_inode_ctx_get(inode, this);
+        if (ctx_p && !ctx_p->listing && priv->dir_cache &&
+            listing->size <= priv->dir_cache_limit &&
+            GF_ATOMIC_GET(ctx_p->dir_gen) == gen) {
+            ctx_p->listing = listing;
+
+            LOCK(&priv->lock);
+            {
+                list_add(&listing->lru, &priv->dir_lru);
+                priv->dir_cache_size += listing->size;
+            }
+            UNLOCK(&priv->lock);
+
+            installed = _gf_true;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (installed)
+        rda_dir_cache_prune(this);
+    else
+        rda_dir_listing_unref(listing);
+}
+
+/*
+ * The contents of a directory changed: drop its cached listing and make sure
+ * a preload racing with the change is not installed.
+ */
+static void
+rda_dir_invalidate(xlator_t *this, inode_t *inode)
+{
+    struct rda_priv *priv = this->private;
+    struct rda_dir_listing *listing = NULL;
+    rda_inode_ctx_t *ctx_p = NULL;
+    uint64_t ctx_uint = 0;
+
+    if (!inode)
+        return;
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get1(inode, this, &ctx_uint) == 0) {
+            ctx_p = (rda_inode_ctx_t *)(uintptr_t)ctx_uint;
+            GF_ATOMIC_INC(ctx_p->dir_gen);
+            listing = ctx_p->listing;
+            ctx_p->listing = NULL;
+        }
+
+        if (listing) {
+            LOCK(&priv->lock);
+            {
+                if (!listing->evicted) {
+                    list_del_init(&listing->lru);
+                    priv->dir_cache_size -= listing->size;
+                    listing->evicted = _gf_true;
+                }
+            }
+            UNLOCK(&priv->lock);
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (listing) {
+        GF_ATOMIC_INC(priv->dir_cache_invalidations);
+        rda_dir_listing_unref(listing);
+    }
+}
+
+static void
+rda_dir_invalidate_gfid(xlator_t *this, inode_table_t *itable, uuid_t gfid)
+{
+    inode_t *inode = NULL;
+
+    if (gf_uuid_is_null(gfid))
+        return;
+
+    inode = inode_find(itable, gfid);
+    if (!inode)
+        return;
+
+    rda_dir_invalidate(this, inode);
+    inode_unref(inode);
+}
+
+/*
+ * Serve a request from the cached listing attached to the fd. ctx must be
+ * locked. Entries whose inode is still in the table get it along with the
+ * attributes kept in its ctx; the others go up without an inode and are
+ * looked up again by whoever needs them.
+ */
+static int32_t
+__rda_serve_listing(xlator_t *this, struct rda_fd_ctx *ctx, size_t request_size,
+                    off_t off, gf_dirent_t *entries, int *op_errno)
+{
+    struct rda_dir_listing *listing = ctx->listing;
+    gf_dirent_t *dirent = NULL;
+    gf_dirent_t *copy = NULL;
+    size_t dirent_size, size = 0;
+    int32_t count = 0;
+    struct iatt tmp_stat = {
+        0,
+    };
+
+    if (!off) {
+        ctx->listing_pos = &listing->entries;
+        ctx->listing_off = 0;
+    }
+
+    for (dirent = list_entry(ctx->listing_pos->list.next, gf_dirent_t, list);
+         &dirent->list != &listing->entries.list;
+         dirent = list_entry(dirent->list.next, gf_dirent_t, list)) {
+        dirent_size = gf_dirent_size(dirent->d_name);
+        if (size + dirent_size > request_size)
+            break;
+
+        copy = entry_copy(dirent);
+        if (!copy)
+            break;
+
+        if (!((strcmp(copy->d_name, ".") == 0) ||
+              (strcmp(copy->d_name, "..") == 0)))
+            copy->inode = inode_find(listing->inode->table,
+                                     copy->d_stat.ia_gfid);
+
+        if (copy->inode) {
+            rda_inode_ctx_get_iatt(copy->inode, this, &tmp_stat);
+            if (gf_uuid_is_null(tmp_stat.ia_gfid)) {
+                inode_unref(copy->inode);
+                copy->inode = NULL;
+            } else {
+                copy->d_stat = tmp_stat;
+            }
+        }
+
+        size += dirent_size;
+        list_add_tail(&copy->list, &entries->list);
+        ctx->listing_pos = dirent;
+        ctx->listing_off = dirent->d_off;
+        count++;
+    }
+
+    *op_errno = count ? 0 : listing->op_errno;
+
+    return count;
+}
+
 /*
  * Reset the tracking state of the context.
  */
@@ -200,6 +560,14 @@ rda_reset_ctx(xlator_t *this, struct rda_fd_ctx *ctx)
         dict_unref(ctx->xattrs);
         ctx->xattrs = NULL;
     }
+
+    rda_dir_listing_unref(ctx->listing);
+    ctx->listing = NULL;
+    ctx->listing_pos = NULL;
+    ctx->listing_off = 0;
+
+    rda_dir_listing_unref(ctx->build);
+    ctx->build = NULL;
 }
 
 static void
@@ -274,24 +642,6 @@ rda_can_serve_readdirp(struct rda_fd_ctx *ctx, size_t request_size)
     return _gf_false;
 }
 
-static void
-rda_inode_ctx_get_iatt(inode_t *inode, xlator_t *this, struct iatt *attr)
-{
-    rda_inode_ctx_t *ctx_p = NULL;
-
-    LOCK(&inode->lock);
-    {
-        ctx_p = __rda_inode_ctx_get(inode, this);
-        if (ctx_p) {
-            *attr = ctx_p->statbuf;
-        }
-    }
-    UNLOCK(&inode->lock);
-
-    if (ctx_p == NULL)
-        memset(attr, 0, sizeof(struct iatt));
-}
-
 /*
  * Serve a request from the fd dentry list based on the size of the request
  * buffer. ctx must be locked.
@@ -376,6 +726,9 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     int ret = 0;
     int op_errno = 0;
     gf_boolean_t serve = _gf_false;
+    struct rda_priv *priv = this->private;
+    struct rda_dir_listing *listing = NULL;
+    struct rda_dir_listing *stale = NULL;
 
     ctx = get_rda_fd_ctx(fd, this);
     if (!ctx)
@@ -384,15 +737,50 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     if (ctx->state & RDA_FD_BYPASS)
         goto bypass;
 
+    /*
+     * A rewind on an fd whose preload is exhausted may be served from the
+     * listing cached since.
+     */
+    if (!off && priv->dir_cache && !ctx->listing &&
+        (ctx->state & RDA_FD_EOD) && (ctx->cur_size == 0))
+        listing = rda_dir_listing_get(this, fd->inode);
+
     INIT_LIST_HEAD(&entries.list);
     LOCK(&ctx->lock);
 
     /* recheck now that we have the lock */
     if (ctx->state & RDA_FD_BYPASS) {
         UNLOCK(&ctx->lock);
+        rda_dir_listing_unref(listing);
         goto bypass;
     }
 
+    if (listing && !ctx->listing && !ctx->stub &&
+        (ctx->state & RDA_FD_EOD) && (ctx->cur_size == 0)) {
+        rda_reset_ctx(this, ctx);
+        ctx->listing = listing;
+        ctx->listing_pos = &listing->entries;
+        listing = NULL;
+    }
+
+    if (ctx->listing) {
+        if (off && off != ctx->listing_off) {
+            /* a seek within the cached listing, get out of the way */
+            stale = ctx->listing;
+            ctx->listing = NULL;
+            ctx->listing_pos = NULL;
+            ctx->state |= RDA_FD_BYPASS;
+            UNLOCK(&ctx->lock);
+            rda_dir_listing_unref(stale);
+            rda_dir_listing_unref(listing);
+            goto bypass;
+        }
+
+        ret = __rda_serve_listing(this, ctx, size, off, &entries, &op_errno);
+        serve = _gf_true;
+        goto unlock;
+    }
+
     /*
      * If a new read comes in at offset 0 and the buffer has been
      * completed, reset the context and kickstart the filler again.
@@ -448,7 +836,9 @@ rda_readdirp(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         }
     }
 
+unlock:
     UNLOCK(&ctx->lock);
+    rda_dir_listing_unref(listing);
 
     if (serve) {
         STACK_UNWIND_STRICT(readdirp, frame, ret, op_errno, &entries, xdata);
@@ -491,6 +881,10 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     };
     uint64_t generation = 0;
     call_frame_t *fill_frame = NULL;
+    gf_dirent_t *copy = NULL;
+    struct rda_dir_listing *build = NULL;
+    struct rda_dir_listing *stale = NULL;
+    uint64_t build_gen = 0;
 
     INIT_LIST_HEAD(&serve_entries.list);
     LOCK(&ctx->lock);
@@ -537,6 +931,24 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 
             dirent_size = gf_dirent_size(dirent->d_name);
 
+            if (ctx->build) {
+                copy = entry_copy(dirent);
+                if (copy) {
+                    if (copy->inode) {
+                        inode_unref(copy->inode);
+                        copy->inode = NULL;
+                    }
+                    list_add_tail(&copy->list, &ctx->build->entries.list);
+                    ctx->build->size += dirent_size;
+                }
+
+                /* not cacheable, stop copying */
+                if (!copy || ctx->build->size > priv->dir_cache_limit) {
+                    stale = ctx->build;
+                    ctx->build = NULL;
+                }
+            }
+
             ctx->cur_size += dirent_size;
 
             GF_ATOMIC_ADD(priv->rda_cache_size, dirent_size);
@@ -560,6 +972,14 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         ctx->state &= ~RDA_FD_RUNNING;
         ctx->state |= RDA_FD_EOD;
         ctx->op_errno = op_errno;
+
+        /* the copy taken from offset 0 is now a complete listing */
+        if (ctx->build) {
+            build = ctx->build;
+            build->op_errno = op_errno;
+            build_gen = ctx->build_gen;
+            ctx->build = NULL;
+        }
     } else if (op_ret == -1) {
         /* kill the preload and pend the error */
         ctx->state &= ~RDA_FD_RUNNING;
@@ -580,6 +1000,12 @@ rda_fill_fd_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     }
 
 out:
+    if (ctx->build && (ctx->state & (RDA_FD_BYPASS | RDA_FD_ERROR))) {
+        rda_dir_listing_unref(stale);
+        stale = ctx->build;
+        ctx->build = NULL;
+    }
+
     /*
      * If we have been marked for bypass and have no pending stub, clear the
      * run state so we stop preloading the context with entries.
@@ -609,6 +1035,10 @@ out:
         op_errno = 0;
 
     UNLOCK(&ctx->lock);
+    rda_dir_listing_unref(stale);
+    if (build)
+        rda_dir_listing_install(this, local->fd->inode, build, build_gen);
+
     if (fill_frame) {
         rda_local_wipe(fill_frame->local);
         STACK_DESTROY(fill_frame->root);
@@ -639,11 +1069,18 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
     struct rda_fd_ctx *ctx;
     off_t offset;
     struct rda_priv *priv = this->private;
+    struct rda_dir_listing *build = NULL;
+    uint64_t build_gen = 0;
 
     ctx = get_rda_fd_ctx(fd, this);
     if (!ctx)
         goto err;
 
+    /* a preload from offset 0 is copied to populate the listing cache */
+    if (priv->dir_cache && (ctx->state & RDA_FD_NEW) &&
+        (rda_dir_gen_get(this, fd->inode, &build_gen) == 0))
+        build = rda_dir_listing_new();
+
     LOCK(&ctx->lock);
 
     if (ctx->state & RDA_FD_NEW) {
@@ -651,6 +1088,12 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
         ctx->state |= RDA_FD_RUNNING;
         if (priv->rda_low_wmark)
             ctx->state |= RDA_FD_PLUGGED;
+
+        if (build && !ctx->build) {
+            ctx->build = build;
+            ctx->build_gen = build_gen;
+            build = NULL;
+        }
     }
 
     offset = ctx->next_offset;
@@ -687,6 +1130,7 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
     GF_ATOMIC_INC(ctx->prefetching);
 
     UNLOCK(&ctx->lock);
+    rda_dir_listing_unref(build);
 
     STACK_WIND(nframe, rda_fill_fd_cbk, FIRST_CHILD(this),
                FIRST_CHILD(this)->fops->readdirp, fd, priv->rda_req_size,
@@ -695,6 +1139,7 @@ rda_fill_fd(call_frame_t *frame, xlator_t *this, fd_t *fd)
     return 0;
 
 err:
+    rda_dir_listing_unref(build);
     if (nframe) {
         rda_local_wipe(nframe->local);
         FRAME_DESTROY(nframe, frame->root->ctx->measure_latency);
@@ -707,8 +1152,35 @@ static int32_t
 rda_opendir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
                 int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
 {
-    if (!op_ret)
-        rda_fill_fd(frame, this, fd);
+    struct rda_priv *priv = this->private;
+    struct rda_dir_listing *listing = NULL;
+    struct rda_fd_ctx *ctx = NULL;
+
+    if (op_ret)
+        goto unwind;
+
+    if (priv->dir_cache)
+        listing = rda_dir_listing_get(this, fd->inode);
+
+    /* a cached listing makes the preload unnecessary */
+    if (listing) {
+        ctx = get_rda_fd_ctx(fd, this);
+        if (ctx) {
+            LOCK(&ctx->lock);
+            {
+                ctx->listing = listing;
+                ctx->listing_pos = &listing->entries;
+                ctx->listing_off = 0;
+            }
+            UNLOCK(&ctx->lock);
+            goto unwind;
+        }
+        rda_dir_listing_unref(listing);
+    }
+
+    rda_fill_fd(frame, this, fd);
+
+unwind:
 
     RDA_STACK_UNWIND(opendir, frame, op_ret, op_errno, fd, xdata);
     return 0;
@@ -959,6 +1431,7 @@ rda_setxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     rda_mark_inode_dirty(this, local->inode);
     rda_inode_ctx_update_iatts(local->inode, this, NULL, NULL,
                                local->generation);
+    rda_dir_invalidate(this, local->inode);
 unwind:
     RDA_STACK_UNWIND(setxattr, frame, op_ret, op_errno, xdata);
     return 0;
@@ -986,6 +1459,7 @@ rda_fsetxattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     rda_mark_inode_dirty(this, local->inode);
     rda_inode_ctx_update_iatts(local->inode, this, NULL, NULL,
                                local->generation);
+    rda_dir_invalidate(this, local->inode);
 unwind:
     RDA_STACK_UNWIND(fsetxattr, frame, op_ret, op_errno, xdata);
     return 0;
@@ -1017,6 +1491,7 @@ rda_setattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     rda_mark_inode_dirty(this, local->inode);
     rda_inode_ctx_update_iatts(local->inode, this, statpost, &postbuf_out,
                                local->generation);
+    rda_dir_invalidate(this, local->inode);
 
 unwind:
     RDA_STACK_UNWIND(setattr, frame, op_ret, op_errno, statpre, &postbuf_out,
@@ -1050,6 +1525,7 @@ rda_fsetattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     rda_mark_inode_dirty(this, local->inode);
     rda_inode_ctx_update_iatts(local->inode, this, statpost, &postbuf_out,
                                local->generation);
+    rda_dir_invalidate(this, local->inode);
 
 unwind:
     RDA_STACK_UNWIND(fsetattr, frame, op_ret, op_errno, statpre, &postbuf_out,
@@ -1079,6 +1555,7 @@ rda_removexattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     rda_mark_inode_dirty(this, local->inode);
     rda_inode_ctx_update_iatts(local->inode, this, NULL, NULL,
                                local->generation);
+    rda_dir_invalidate(this, local->inode);
 unwind:
     RDA_STACK_UNWIND(removexattr, frame, op_ret, op_errno, xdata);
     return 0;
@@ -1106,6 +1583,7 @@ rda_fremovexattr_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     rda_mark_inode_dirty(this, local->inode);
     rda_inode_ctx_update_iatts(local->inode, this, NULL, NULL,
                                local->generation);
+    rda_dir_invalidate(this, local->inode);
 unwind:
     RDA_STACK_UNWIND(fremovexattr, frame, op_ret, op_errno, xdata);
     return 0;
@@ -1120,6 +1598,183 @@ rda_fremovexattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
     return 0;
 }
 
+static int32_t
+rda_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+    rda_dir_invalidate(this, ((struct rda_local *)frame->local)->inode);
+
+    RDA_STACK_UNWIND(create, frame, op_ret, op_errno, fd, inode, buf,
+                     preparent, postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+           mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(create, frame, this, loc->parent, NULL, xdata,
+                               loc, flags, mode, umask, fd);
+    return 0;
+}
+
+static int32_t
+rda_mknod_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+    rda_dir_invalidate(this, ((struct rda_local *)frame->local)->inode);
+
+    RDA_STACK_UNWIND(mknod, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_mknod(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          dev_t rdev, mode_t umask, dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(mknod, frame, this, loc->parent, NULL, xdata,
+                               loc, mode, rdev, umask);
+    return 0;
+}
+
+static int32_t
+rda_mkdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, inode_t *inode,
+              struct iatt *buf, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+    rda_dir_invalidate(this, ((struct rda_local *)frame->local)->inode);
+
+    RDA_STACK_UNWIND(mkdir, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_mkdir(call_frame_t *frame, xlator_t *this, loc_t *loc, mode_t mode,
+          mode_t umask, dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(mkdir, frame, this, loc->parent, NULL, xdata,
+                               loc, mode, umask);
+    return 0;
+}
+
+static int32_t
+rda_symlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, inode_t *inode,
+                struct iatt *buf, struct iatt *preparent,
+                struct iatt *postparent, dict_t *xdata)
+{
+    rda_dir_invalidate(this, ((struct rda_local *)frame->local)->inode);
+
+    RDA_STACK_UNWIND(symlink, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_symlink(call_frame_t *frame, xlator_t *this, const char *linkpath,
+            loc_t *loc, mode_t umask, dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(symlink, frame, this, loc->parent, NULL, xdata,
+                               linkpath, loc, umask);
+    return 0;
+}
+
+static int32_t
+rda_link_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
+             int32_t op_errno, inode_t *inode, struct iatt *buf,
+             struct iatt *preparent, struct iatt *postparent, dict_t *xdata)
+{
+    rda_dir_invalidate(this, ((struct rda_local *)frame->local)->newparent);
+
+    RDA_STACK_UNWIND(link, frame, op_ret, op_errno, inode, buf, preparent,
+                     postparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_link(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+         dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(link, frame, this, NULL, newloc->parent, xdata,
+                               oldloc, newloc);
+    return 0;
+}
+
+static int32_t
+rda_unlink_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+    rda_dir_invalidate(this, ((struct rda_local *)frame->local)->inode);
+
+    RDA_STACK_UNWIND(unlink, frame, op_ret, op_errno, preparent, postparent,
+                     xdata);
+    return 0;
+}
+
+static int32_t
+rda_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflags,
+           dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(unlink, frame, this, loc->parent, NULL, xdata,
+                               loc, xflags);
+    return 0;
+}
+
+static int32_t
+rda_rmdir_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *preparent,
+              struct iatt *postparent, dict_t *xdata)
+{
+    rda_dir_invalidate(this, ((struct rda_local *)frame->local)->inode);
+
+    RDA_STACK_UNWIND(rmdir, frame, op_ret, op_errno, preparent, postparent,
+                     xdata);
+    return 0;
+}
+
+static int32_t
+rda_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
+          dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(rmdir, frame, this, loc->parent, NULL, xdata,
+                               loc, flags);
+    return 0;
+}
+
+static int32_t
+rda_rename_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *buf,
+               struct iatt *preoldparent, struct iatt *postoldparent,
+               struct iatt *prenewparent, struct iatt *postnewparent,
+               dict_t *xdata)
+{
+    struct rda_local *local = frame->local;
+
+    rda_dir_invalidate(this, local->inode);
+    rda_dir_invalidate(this, local->newparent);
+
+    RDA_STACK_UNWIND(rename, frame, op_ret, op_errno, buf, preoldparent,
+                     postoldparent, prenewparent, postnewparent, xdata);
+    return 0;
+}
+
+static int32_t
+rda_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
+           dict_t *xdata)
+{
+    RDA_ENTRY_MODIFICATION_FOP(rename, frame, this, oldloc->parent,
+                               newloc->parent, xdata, oldloc, newloc);
+    return 0;
+}
+
 static int32_t
 rda_releasedir(xlator_t *this, fd_t *fd)
 {
@@ -1153,6 +1808,7 @@ rda_forget(xlator_t *this, inode_t *inode)
     uint64_t ctx_uint = 0;
     rda_inode_ctx_t *ctx = NULL;
 
+    /* a cached listing holds a ref on its directory, so none is left here */
     inode_ctx_del1(inode, this, &ctx_uint);
     if (!ctx_uint)
         return 0;
@@ -1164,6 +1820,97 @@ rda_forget(xlator_t *this, inode_t *inode)
     return 0;
 }
 
+/*
+ * Another client changed something we may have cached. The directory named
+ * by the upcall and, for entry changes, its parents lose their listings; the
+ * stat kept for the inode is no longer trusted.
+ */
+static int
+rda_invalidate(xlator_t *this, void *data)
+{
+    struct gf_upcall *up_data = data;
+    struct gf_upcall_cache_invalidation *up_ci = NULL;
+    inode_table_t *itable = NULL;
+    inode_t *inode = NULL;
+
+    if (up_data->event_type != GF_UPCALL_CACHE_INVALIDATION)
+        return 0;
+
+    up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
+    itable = ((xlator_t *)this->graph->top)->itable;
+
+    inode = inode_find(itable, up_data->gfid);
+    if (inode) {
+        rda_dir_invalidate(this, inode);
+        rda_inode_ctx_update_iatts(inode, this, NULL, NULL, 0);
+        inode_unref(inode);
+    }
+
+    if (up_ci->flags &
+        (UP_PARENT_DENTRY_FLAGS | UP_RENAME_FLAGS | UP_NLINK | UP_FORGET)) {
+        rda_dir_invalidate_gfid(this, itable, up_ci->p_stat.ia_gfid);
+        if (up_ci->flags & UP_RENAME_FLAGS)
+            rda_dir_invalidate_gfid(this, itable, up_ci->oldp_stat.ia_gfid);
+    }
+
+    return 0;
+}
+
+int
+rda_notify(xlator_t *this, int event, void *data, ...)
+{
+    int ret = 0;
+    struct rda_priv *priv = this->private;
+
+    if (event == GF_EVENT_UPCALL && priv->dir_cache)
+        ret = rda_invalidate(this, data);
+
+    if (default_notify(this, event, data) != 0)
+        ret = -1;
+
+    return ret;
+}
+
+static int
+rda_priv_dump(xlator_t *this)
+{
+    struct rda_priv *priv = this->private;
+    uint64_t dir_cache_size = 0;
+    char key_prefix[GF_DUMP_MAX_BUF_LEN] = {
+        0,
+    };
+
+    if (!priv)
+        return 0;
+
+    LOCK(&priv->lock);
+    {
+        dir_cache_size = priv->dir_cache_size;
+    }
+    UNLOCK(&priv->lock);
+
+    gf_proc_dump_build_key(key_prefix, "xlator.performance.readdir-ahead",
+                           "priv");
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    gf_proc_dump_write("rda_cache_size", "%" PRId64,
+                       GF_ATOMIC_GET(priv->rda_cache_size));
+    gf_proc_dump_write("rda_cache_limit", "%" PRIu64, priv->rda_cache_limit);
+    gf_proc_dump_write("dir_cache", "%s", priv->dir_cache ? "on" : "off");
+    gf_proc_dump_write("dir_cache_size", "%" PRIu64, dir_cache_size);
+    gf_proc_dump_write("dir_cache_limit", "%" PRIu64, priv->dir_cache_limit);
+    gf_proc_dump_write("dir_cache_timeout", "%" PRIu32,
+                       priv->dir_cache_timeout);
+    gf_proc_dump_write("dir_cache_hits", "%" PRId64,
+                       GF_ATOMIC_GET(priv->dir_cache_hits));
+    gf_proc_dump_write("dir_cache_misses", "%" PRId64,
+                       GF_ATOMIC_GET(priv->dir_cache_misses));
+    gf_proc_dump_write("dir_cache_invalidations", "%" PRId64,
+                       GF_ATOMIC_GET(priv->dir_cache_invalidations));
+
+    return 0;
+}
+
 int32_t
 mem_acct_init(xlator_t *this)
 {
@@ -1199,6 +1946,13 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("parallel-readdir", priv->parallel_readdir, options, bool,
                      err);
     GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, err);
+    GF_OPTION_RECONF("rda-dir-cache", priv->dir_cache, options, bool, err);
+    GF_OPTION_RECONF("rda-dir-cache-limit", priv->dir_cache_limit, options,
+                     size_uint64, err);
+    GF_OPTION_RECONF("rda-dir-cache-timeout", priv->dir_cache_timeout, options,
+                     uint32, err);
+
+    rda_dir_cache_prune(this);
 
     return 0;
 err:
@@ -1232,6 +1986,11 @@ init(xlator_t *this)
     this->private = priv;
 
     GF_ATOMIC_INIT(priv->rda_cache_size, 0);
+    LOCK_INIT(&priv->lock);
+    INIT_LIST_HEAD(&priv->dir_lru);
+    GF_ATOMIC_INIT(priv->dir_cache_hits, 0);
+    GF_ATOMIC_INIT(priv->dir_cache_misses, 0);
+    GF_ATOMIC_INIT(priv->dir_cache_invalidations, 0);
 
     this->local_pool = mem_pool_new(struct rda_local, 32);
     if (!this->local_pool)
@@ -1243,6 +2002,11 @@ init(xlator_t *this)
     GF_OPTION_INIT("rda-cache-limit", priv->rda_cache_limit, size_uint64, err);
     GF_OPTION_INIT("parallel-readdir", priv->parallel_readdir, bool, err);
     GF_OPTION_INIT("pass-through", this->pass_through, bool, err);
+    GF_OPTION_INIT("rda-dir-cache", priv->dir_cache, bool, err);
+    GF_OPTION_INIT("rda-dir-cache-limit", priv->dir_cache_limit, size_uint64,
+                   err);
+    GF_OPTION_INIT("rda-dir-cache-timeout", priv->dir_cache_timeout, uint32,
+                   err);
 
     return 0;
 
@@ -1258,8 +2022,17 @@ err:
 void
 fini(xlator_t *this)
 {
+    struct rda_priv *priv = NULL;
+
     GF_VALIDATE_OR_GOTO("readdir-ahead", this, out);
 
+    priv = this->private;
+    if (priv) {
+        priv->dir_cache = _gf_false;
+        rda_dir_cache_prune(this);
+        LOCK_DESTROY(&priv->lock);
+    }
+
     GF_FREE(this->private);
 
 out:
@@ -1286,6 +2059,15 @@ struct xlator_fops fops = {
     .fsetattr = rda_fsetattr,
     .removexattr = rda_removexattr,
     .fremovexattr = rda_fremovexattr,
+    /* entry write, drops the cached listing of the parent */
+    .create = rda_create,
+    .mknod = rda_mknod,
+    .mkdir = rda_mkdir,
+    .symlink = rda_symlink,
+    .link = rda_link,
+    .unlink = rda_unlink,
+    .rmdir = rda_rmdir,
+    .rename = rda_rename,
 };
 
 struct xlator_cbks cbks = {
@@ -1293,6 +2075,10 @@ struct xlator_cbks cbks = {
     .forget = rda_forget,
 };
 
+struct xlator_dumpops dumpops = {
+    .priv = rda_priv_dump,
+};
+
 struct volume_options options[] = {
     {
         .key = {"readdir-ahead"},
@@ -1356,6 +2142,41 @@ struct volume_options options[] = {
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
      .tags = {"readdir-ahead"},
      .description = "Enable/Disable readdir ahead translator"},
+    {.key = {"rda-dir-cache"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"readdir-ahead"},
+     .description = "Keep complete directory listings cached after the "
+                    "directory is closed and serve later listings of the "
+                    "same directory from it. Changes made through this "
+                    "client drop the cached listing; enable "
+                    "features.cache-invalidation so that changes made by "
+                    "other clients do too."},
+    {.key = {"rda-dir-cache-limit"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .max = INFINITY,
+     .default_value = "32MB",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"readdir-ahead"},
+     .description = "maximum memory used by the cached directory listings. "
+                    "Least recently listed directories are dropped first; "
+                    "a directory bigger than this is never cached."},
+    {.key = {"rda-dir-cache-timeout"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 600,
+     .default_value = "60",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"readdir-ahead"},
+     .description = "seconds a cached directory listing is served for. "
+                    "Keep it at or below features.cache-invalidation-timeout, "
+                    "the bricks stop sending invalidations for a directory "
+                    "this client has not looked at for that long."},
     {.key = {NULL}},
 };
 
@@ -1363,10 +2184,12 @@ xlator_api_t xlator_api = {
     .init = init,
     .fini = fini,
     .reconfigure = reconfigure,
+    .notify = rda_notify,
     .mem_acct_init = mem_acct_init,
     .op_version = {1}, /* Present from the initial version */
     .fops = &fops,
     .cbks = &cbks,
+    .dumpops = &dumpops,
     .options = options,
     .identifier = "readdir-ahead",
     .category = GF_MAINTAINED,
@@ -42,6 +42,22 @@
                    FIRST_CHILD(this)->fops->name, args, __xdata);              \
     } while (0)
 
+#define RDA_ENTRY_MODIFICATION_FOP(name, frame, this, __parent,                \
+                                   __newparent, __xdata, args...)              \
+    do {                                                                       \
+        struct rda_local *__local = NULL;                                      \
+                                                                               \
+        __local = mem_get0(this->local_pool);                                  \
+        if (__parent)                                                          \
+            __local->inode = inode_ref(__parent);                              \
+        if (__newparent)                                                       \
+            __local->newparent = inode_ref(__newparent);                       \
+                                                                               \
+        frame->local = __local;                                                \
+        STACK_WIND(frame, rda_##name##_cbk, FIRST_CHILD(this),                 \
+                   FIRST_CHILD(this)->fops->name, args, __xdata);              \
+    } while (0)
+
 #define RDA_STACK_UNWIND(fop, frame, params...)                                \
     do {                                                                       \
         struct rda_local *__local = NULL;                                      \
@@ -56,6 +72,23 @@
         }                                                                      \
     } while (0)
 
+/*
+ * A complete listing of a directory kept across opendir/releasedir. The
+ * directory inode ctx holds one reference, every fd reading from it holds
+ * another. The entries hold no inodes, they are looked up by gfid when
+ * served.
+ */
+struct rda_dir_listing {
+    gf_dirent_t entries;
+    size_t size;          /* sum of gf_dirent_size() of the entries */
+    int op_errno;         /* returned with the empty reply at eod */
+    gf_atomic_t refcount;
+    struct list_head lru; /* in priv->dir_lru while cached */
+    inode_t *inode;       /* directory the listing belongs to */
+    gf_boolean_t evicted; /* dropped from the lru, not to be re-added */
+    time_t installed;     /* expires dir_cache_timeout seconds later */
+};
+
 struct rda_fd_ctx {
     off_t cur_offset;  /* current head of the ctx */
     size_t cur_size;   /* current size of the preload */
@@ -69,6 +102,11 @@ struct rda_fd_ctx {
     dict_t *writes_during_prefetch;
     gf_atomic_t prefetching;
     gf_dirent_t entries;
+    struct rda_dir_listing *listing; /* cached listing being served */
+    gf_dirent_t *listing_pos;        /* next entry to serve from listing */
+    off_t listing_off;               /* offset expected for listing_pos */
+    struct rda_dir_listing *build;   /* copy of a preload from offset 0 */
+    uint64_t build_gen;              /* dir_gen when build started */
 };
 
 struct rda_local {
@@ -76,6 +114,7 @@ struct rda_local {
     fd_t *fd;
     dict_t *xattrs; /* md-cache keys to be sent in readdirp() */
     inode_t *inode;
+    inode_t *newparent; /* destination directory of rename/link */
     off_t offset;
     uint64_t generation;
     int32_t skip_dir;
@@ -88,11 +127,22 @@ struct rda_priv {
     uint64_t rda_cache_limit;
     gf_atomic_t rda_cache_size;
     gf_boolean_t parallel_readdir;
+    gf_boolean_t dir_cache;
+    uint64_t dir_cache_limit;
+    uint32_t dir_cache_timeout;
+    gf_lock_t lock; /* protects dir_lru and dir_cache_size */
+    struct list_head dir_lru;
+    uint64_t dir_cache_size;
+    gf_atomic_t dir_cache_hits;
+    gf_atomic_t dir_cache_misses;
+    gf_atomic_t dir_cache_invalidations;
 };
 
 typedef struct rda_inode_ctx {
     struct iatt statbuf;
     gf_atomic_t generation;
+    gf_atomic_t dir_gen; /* bumped whenever the directory contents change */
+    struct rda_dir_listing *listing;
 } rda_inode_ctx_t;
 
 #endif /* __READDIR_AHEAD_H */
@@ -205,7 +205,7 @@ client_submit_request(xlator_t *this, void *req, call_frame_t *frame,
     }
 
     if (req && xdrproc) {
-        xdr_size = xdr_sizeof(xdrproc, req);
+        xdr_size = xdr_sizeof_generic(xdrproc, req);
         iobuf = iobuf_get2(this->ctx->iobuf_pool, xdr_size);
         if (!iobuf) {
             goto out;
@@ -2536,14 +2536,18 @@ out:
 
 static int
 client_check_event_threads(xlator_t *this, clnt_conf_t *conf, int32_t old,
-                           int32_t new)
+                           int32_t new, int32_t new_max)
 {
-    if (old == new)
+    if ((old == new) && (conf->event_threads_max == new_max))
         return 0;
 
     conf->event_threads = new;
-    return gf_event_reconfigure_threads(this->ctx->event_pool,
-                                        conf->event_threads);
+    conf->event_threads_max = new_max;
+    /* autoscaled between the two when event-threads-max is above
+     * event-threads */
+    return gf_event_autoscale_set(this->ctx->event_pool, conf->event_threads,
+                                  max(conf->event_threads_max,
+                                      conf->event_threads));
 }
 
 int
@@ -2557,6 +2561,7 @@ reconfigure(xlator_t *this, dict_t *options)
     char *old_remote_host = NULL;
     char *new_remote_host = NULL;
     int32_t new_nthread = 0;
+    int32_t new_nthread_max = 0;
     struct rpc_clnt_config rpc_config = {
         0,
     };
@@ -2570,8 +2575,10 @@ reconfigure(xlator_t *this, dict_t *options)
                      out);
 
     GF_OPTION_RECONF("event-threads", new_nthread, options, int32, out);
+    GF_OPTION_RECONF("event-threads-max", new_nthread_max, options, int32,
+                     out);
     ret = client_check_event_threads(this, conf, conf->event_threads,
-                                     new_nthread);
+                                     new_nthread, new_nthread_max);
     if (ret)
         goto out;
 
@@ -2626,6 +2633,7 @@ int
 init(xlator_t *this)
 {
     int ret = -1;
+    int32_t nthread_max = 0;
     clnt_conf_t *conf = NULL;
 
     if (this->children) {
@@ -2651,8 +2659,9 @@ init(xlator_t *this)
 
     /* Set event threads to the configured default */
     GF_OPTION_INIT("event-threads", conf->event_threads, int32, out);
+    GF_OPTION_INIT("event-threads-max", nthread_max, int32, out);
     ret = client_check_event_threads(this, conf, STARTING_EVENT_THREADS,
-                                     conf->event_threads);
+                                     conf->event_threads, nthread_max);
     if (ret)
         goto out;
 
@@ -2985,6 +2994,16 @@ struct volume_options options[] = {
                     "faster, depending on available processing power.",
      .op_version = {GD_OP_VERSION_3_7_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_RANGE},
+    {.key = {"event-threads-max"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = CLIENT_MAX_EVENT_THREADS,
+     .default_value = "0",
+     .description = "When above event-threads, the number of event threads "
+                    "follows the measured load between event-threads and "
+                    "this value. 0 keeps event-threads threads.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_RANGE},
 
     /* This option is required for running code-coverage tests with
        old protocol */
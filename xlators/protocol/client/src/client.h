@@ -126,6 +126,7 @@ typedef struct clnt_conf {
 
     int event_threads; /* # of event threads
                         * configured */
+    int event_threads_max; /* up to which they are autoscaled */
 
     gf_boolean_t destroy; /* if enabled implies fini was called
                            * on @this xlator instance */
@@ -43,7 +43,7 @@ gfs_serialize_reply(rpcsvc_request_t *req, void *arg, struct iovec *outmsg,
      * be serialized.
      */
     if (arg && xdrproc) {
-        xdr_size = xdr_sizeof(xdrproc, arg);
+        xdr_size = xdr_sizeof_generic(xdrproc, arg);
         iob = iobuf_get2(req->svc->ctx->iobuf_pool, xdr_size);
         if (!iob) {
             gf_msg_callingfn(THIS->name, GF_LOG_ERROR, ENOMEM, PS_MSG_NO_MEMORY,
@@ -592,7 +592,7 @@ glusterfs_ctx_pool_destroy(glusterfs_ctx_t *ctx)
             mem_pool_destroy(pool->frame_mem_pool);
         if (pool->stack_mem_pool)
             mem_pool_destroy(pool->stack_mem_pool);
-        LOCK_DESTROY(&pool->lock);
+        call_pool_fini(pool);
         GF_FREE(pool);
     }
 
@@ -760,19 +760,21 @@ _copy_auth_opt(dict_t *unused, char *key, data_t *value, void *xl_dict)
 }
 
 int
-server_check_event_threads(xlator_t *this, server_conf_t *conf, int32_t new)
+server_check_event_threads(xlator_t *this, server_conf_t *conf, int32_t new,
+                           int32_t new_max)
 {
     struct event_pool *pool = this->ctx->event_pool;
     int target;
+    int target_max;
 
     target = new + pool->auto_thread_count;
+    target_max = max(new_max, new) + pool->auto_thread_count;
     conf->event_threads = new;
+    conf->event_threads_max = new_max;
 
-    if (target == pool->eventthreadcount) {
-        return 0;
-    }
-
-    return gf_event_reconfigure_threads(pool, target);
+    /* autoscaled between the two when event-threads-max is above
+     * event-threads */
+    return gf_event_autoscale_set(pool, target, target_max);
 }
 
 int
@@ -789,6 +791,7 @@ server_reconfigure(xlator_t *this, dict_t *options)
     int ret = 0;
     char *statedump_path = NULL;
     int32_t new_nthread = 0;
+    int32_t new_nthread_max = 0;
     char *auth_path = NULL;
     char *xprt_path = NULL;
     xlator_t *oldTHIS;
@@ -981,6 +984,12 @@ do_rpc:
         goto out;
     }
 
+    ret = rpcsvc_set_numa_affinity(rpc_conf, options);
+    if (ret < 0) {
+        gf_smsg(this->name, GF_LOG_ERROR, 0, PS_MSG_RECONFIGURE_FAILED, NULL);
+        goto out;
+    }
+
     list_for_each_entry(listeners, &(rpc_conf->listeners), list)
     {
         if (listeners->trans != NULL) {
@@ -1000,7 +1009,9 @@ do_rpc:
      */
 
     GF_OPTION_RECONF("event-threads", new_nthread, options, int32, out);
-    ret = server_check_event_threads(this, conf, new_nthread);
+    GF_OPTION_RECONF("event-threads-max", new_nthread_max, options, int32,
+                     out);
+    ret = server_check_event_threads(this, conf, new_nthread, new_nthread_max);
     if (ret)
         goto out;
 
@@ -1136,7 +1147,9 @@ server_init(xlator_t *this)
 
     /* Set event threads to the configured default */
     GF_OPTION_INIT("event-threads", conf->event_threads, int32, err);
-    ret = server_check_event_threads(this, conf, conf->event_threads);
+    GF_OPTION_INIT("event-threads-max", conf->event_threads_max, int32, err);
+    ret = server_check_event_threads(this, conf, conf->event_threads,
+                                     conf->event_threads_max);
     if (ret)
         goto err;
 
@@ -1894,6 +1907,19 @@ struct volume_options server_options[] = {
                     "potentially run out of memory)",
      .op_version = {1},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_GLOBAL},
+    {.key = {"rpc.numa-affinity"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Run the brick NUMA aware: the event threads are bound "
+                    "to the NUMA nodes and the connections shared out "
+                    "between them, each request handler thread is bound to "
+                    "the node of the event thread that feeds it, and large "
+                    "buffers are taken from memory of the node using them, "
+                    "so that requests are read, executed and replied to on "
+                    "one node. Applies to handler threads started and "
+                    "connections made after the change.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"manage-gids"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -1916,6 +1942,16 @@ struct volume_options server_options[] = {
                     "faster, depending on available processing power.",
      .op_version = {GD_OP_VERSION_3_7_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_RANGE},
+    {.key = {"event-threads-max"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = SERVER_MAX_EVENT_THREADS,
+     .default_value = "0",
+     .description = "When above event-threads, the number of event threads "
+                    "follows the measured load between event-threads and "
+                    "this value. 0 keeps event-threads threads.",
+     .op_version = {GD_OP_VERSION_10_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_RANGE},
     {.key = {"dynamic-auth"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
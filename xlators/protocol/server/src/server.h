@@ -67,6 +67,7 @@ struct server_conf {
     struct _child_status *child_status;
     int event_threads; /* # of event threads
                         * configured */
+    int event_threads_max; /* up to which they are autoscaled */
     gf_boolean_t strict_auth_enabled;
     pthread_mutex_t mutex;
 
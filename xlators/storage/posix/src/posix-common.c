@@ -48,6 +48,7 @@
 #include "posix-messages.h"
 #include <glusterfs/events.h>
 #include "posix-gfid-path.h"
+#include "posix-metadata.h"
 #include <glusterfs/compat-uuid.h>
 #include "timer-wheel.h"
 
@@ -117,6 +118,27 @@ posix_priv(xlator_t *this)
     gf_proc_dump_write("max_read", "%" PRId64, GF_ATOMIC_GET(priv->read_value));
     gf_proc_dump_write("max_write", "%" PRId64,
                        GF_ATOMIC_GET(priv->write_value));
+    gf_proc_dump_write("xattr_cache", "%s", priv->xattr_cache ? "on" : "off");
+    gf_proc_dump_write("xattr_cache_hits", "%" PRId64,
+                       GF_ATOMIC_GET(priv->xattr_cache_hits));
+    gf_proc_dump_write("xattr_cache_misses", "%" PRId64,
+                       GF_ATOMIC_GET(priv->xattr_cache_misses));
+    gf_proc_dump_write("xattr_fill_syscalls", "%" PRId64,
+                       GF_ATOMIC_GET(priv->xattr_syscalls));
+    gf_proc_dump_write("handle_fd_cache_size", "%" PRIu32,
+                       priv->handle_fd_cache_size);
+    gf_proc_dump_write("handle_fds", "%" PRId64,
+                       GF_ATOMIC_GET(priv->handle_fds));
+    gf_proc_dump_write("handle_fd_hits", "%" PRId64,
+                       GF_ATOMIC_GET(priv->handle_fd_hits));
+    gf_proc_dump_write("handle_readlinks", "%" PRId64,
+                       GF_ATOMIC_GET(priv->handle_readlinks));
+    gf_proc_dump_write("ctime_writeback_delay_usec", "%" PRIu32,
+                       priv->mdata_writeback_delay_usec);
+    gf_proc_dump_write("mdata_deferred", "%" PRId64,
+                       GF_ATOMIC_GET(priv->mdata_deferred));
+    gf_proc_dump_write("mdata_writebacks", "%" PRId64,
+                       GF_ATOMIC_GET(priv->mdata_writebacks));
 
     return 0;
 }
@@ -487,6 +509,16 @@ posix_reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("ctime", priv->ctime, options, bool, out);
 
+    GF_OPTION_RECONF("ctime-writeback-delay-usec",
+                     priv->mdata_writeback_delay_usec, options, uint32, out);
+    if (posix_mdata_flusher_start(this))
+        goto out;
+
+    GF_OPTION_RECONF("xattr-cache", priv->xattr_cache, options, bool, out);
+
+    GF_OPTION_RECONF("handle-fd-cache-size", priv->handle_fd_cache_size,
+                     options, uint32, out);
+
     ret = 0;
 out:
     return ret;
@@ -625,6 +657,53 @@ out:
     return ret;
 }
 
+/**
+ * posix_metrics_register - expose the posix counters through the live
+ * metrics registry. They are read straight from the atomics kept for
+ * statedump, so this costs nothing on the fop path. A failure here only
+ * loses the metrics.
+ */
+static void
+posix_metrics_register(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    char labels[PATH_MAX + 16];
+    char path[PATH_MAX];
+    int i = 0;
+    struct {
+        const char *name;
+        const char *help;
+        gf_metric_type_t type;
+        gf_atomic_t *value;
+    } table[POSIX_METRICS_MAX] = {
+        {"gluster_posix_xattr_cache_hits_total",
+         "Lookups served from the posix xattr cache", GF_METRIC_COUNTER,
+         &priv->xattr_cache_hits},
+        {"gluster_posix_xattr_cache_misses_total",
+         "Lookups that had to read xattrs from disk", GF_METRIC_COUNTER,
+         &priv->xattr_cache_misses},
+        {"gluster_posix_handle_fds", "Cached O_PATH directory fds",
+         GF_METRIC_GAUGE, &priv->handle_fds},
+        {"gluster_posix_handle_fd_hits_total",
+         "Handles resolved through a cached directory fd", GF_METRIC_COUNTER,
+         &priv->handle_fd_hits},
+        {"gluster_posix_mdata_deferred_total",
+         "Parent directory time updates deferred", GF_METRIC_COUNTER,
+         &priv->mdata_deferred},
+        {"gluster_posix_mdata_writebacks_total",
+         "Deferred time updates written back", GF_METRIC_COUNTER,
+         &priv->mdata_writebacks},
+    };
+
+    gf_metric_label_escape(path, sizeof(path), priv->base_path);
+    snprintf(labels, sizeof(labels), "brick=\"%s\"", path);
+
+    for (i = 0; i < POSIX_METRICS_MAX; i++)
+        priv->metrics[i] = gf_metric_register_fn(
+            table[i].name, labels, table[i].help, table[i].type,
+            gf_metric_read_atomic, table[i].value);
+}
+
 /**
  * init -
  */
@@ -842,7 +921,8 @@ posix_init(xlator_t *this)
         ret = -1;
         goto out;
     } else {
-        /* First time volume, set the GFID */
+        /* First time volume, set the GFID. No inode, and so no cached
+         * xattrs, exist before init. */
         size = sys_lsetxattr(dir_data->data, "trusted.gfid", rootgfid, 16,
                              XATTR_CREATE);
         if (size == -1) {
@@ -898,6 +978,14 @@ posix_init(xlator_t *this)
     LOCK_INIT(&_private->lock);
     GF_ATOMIC_INIT(_private->read_value, 0);
     GF_ATOMIC_INIT(_private->write_value, 0);
+    GF_ATOMIC_INIT(_private->xattr_cache_hits, 0);
+    GF_ATOMIC_INIT(_private->xattr_cache_misses, 0);
+    GF_ATOMIC_INIT(_private->xattr_syscalls, 0);
+    GF_ATOMIC_INIT(_private->handle_fds, 0);
+    GF_ATOMIC_INIT(_private->handle_fd_hits, 0);
+    GF_ATOMIC_INIT(_private->handle_readlinks, 0);
+    GF_ATOMIC_INIT(_private->mdata_deferred, 0);
+    GF_ATOMIC_INIT(_private->mdata_writebacks, 0);
 
     _private->export_statfs = 1;
     tmp_data = dict_get(this->options, "export-statfs-size");
@@ -1167,6 +1255,10 @@ posix_init(xlator_t *this)
         goto out;
     }
 
+    pthread_mutex_init(&_private->mdata_mutex, NULL);
+    pthread_cond_init(&_private->mdata_cond, NULL);
+    INIT_LIST_HEAD(&_private->mdata_dirty);
+
     GF_OPTION_INIT("batch-fsync-mode", batch_fsync_mode_str, str, out);
 
     if (set_batch_fsync_mode(_private, batch_fsync_mode_str) != 0) {
@@ -1231,6 +1323,19 @@ posix_init(xlator_t *this)
 
     GF_OPTION_INIT("ctime", _private->ctime, bool, out);
 
+    GF_OPTION_INIT("ctime-writeback-delay-usec",
+                   _private->mdata_writeback_delay_usec, uint32, out);
+    ret = posix_mdata_flusher_start(this);
+    if (ret)
+        goto out;
+
+    GF_OPTION_INIT("xattr-cache", _private->xattr_cache, bool, out);
+
+    GF_OPTION_INIT("handle-fd-cache-size", _private->handle_fd_cache_size,
+                   uint32, out);
+
+    posix_metrics_register(this);
+
 out:
     if (ret) {
         if (_private) {
@@ -1282,6 +1387,14 @@ posix_fini(xlator_t *this)
     }
     UNLOCK(&priv->lock);
 
+    /* before the handle dirs are closed, the flusher needs them */
+    posix_mdata_flusher_stop(this);
+
+    for (i = 0; i < POSIX_METRICS_MAX; i++) {
+        gf_metric_unregister(priv->metrics[i]);
+        priv->metrics[i] = NULL;
+    }
+
     if (priv->dirfd >= 0) {
         sys_close(priv->dirfd);
         priv->dirfd = -1;
@@ -1351,6 +1464,8 @@ posix_fini(xlator_t *this)
     LOCK_DESTROY(&priv->lock);
     pthread_mutex_destroy(&priv->fsync_mutex);
     pthread_cond_destroy(&priv->fsync_cond);
+    pthread_mutex_destroy(&priv->mdata_mutex);
+    pthread_cond_destroy(&priv->mdata_cond);
     pthread_mutex_destroy(&priv->janitor_mutex);
     pthread_cond_destroy(&priv->janitor_cond);
     GF_FREE(priv->trash_path);
@@ -1589,5 +1704,44 @@ struct volume_options posix_options[] = {
          "are stored in xattr to keep it consistent across replica and "
          "distribute set. The time attributes stored at the backend are "
          "not considered "},
+    {.key = {"xattr-cache"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .op_version = {GD_OP_VERSION_10_0},
+     .tags = {"posix"},
+     .description =
+         "When enabled, xattrs read from the backend to answer lookup and "
+         "readdirp xattr requests are cached in the inode context, and "
+         "served from there until the inode's xattrs are modified. This "
+         "saves listxattr/getxattr calls on every lookup of the inode."},
+    {.key = {"ctime-writeback-delay-usec"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .validate = GF_OPT_VALIDATE_MIN,
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .op_version = {GD_OP_VERSION_10_0},
+     .tags = {"posix"},
+     .description =
+         "When ctime is enabled, ctime/mtime updates of a parent directory "
+         "caused by entry operations are kept in memory and written to the "
+         "mdata xattr after this many usecs, in one write for all the "
+         "updates received meanwhile. If the brick crashes, the directory "
+         "times can go back by up to this delay. 0 writes every update "
+         "through."},
+    {.key = {"handle-fd-cache-size"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .default_value = "0",
+     .validate = GF_OPT_VALIDATE_MIN,
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .op_version = {GD_OP_VERSION_10_0},
+     .tags = {"posix"},
+     .description =
+         "Maximum number of directory fds (O_PATH) kept open by the brick "
+         "to resolve gfid handles. With a cached fd, entries under a "
+         "directory are reached without expanding the chain of "
+         ".glusterfs symlinks up to the brick root. 0 disables the cache."},
     {.key = {NULL}},
 };
@@ -304,10 +304,12 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
         cs_obj_status = dict_get_sizen(xdata, GF_CS_OBJECT_STATUS);
         cs_obj_repair = dict_get_sizen(xdata, GF_CS_OBJECT_REPAIR);
 
-        if (cs_obj_status || cs_obj_repair)
+        if (cs_obj_status || cs_obj_repair) {
             posix_cs_maintenance(this, NULL, loc, NULL, &buf, real_path,
                                  cs_obj_status, cs_obj_repair, &xattr,
                                  _gf_true);
+            posix_xattr_cache_invalidate(this, loc->inode);
+        }
 
         if (dict_get_sizen(xdata, GF_CLEAN_WRITE_PROTECTION)) {
             ret = sys_lremovexattr(real_path, GF_PROTECT_FROM_EXTERNAL_WRITES);
@@ -315,6 +317,7 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
                 gf_msg(this->name, GF_LOG_ERROR, P_MSG_XATTR_NOT_REMOVED, errno,
                        "removexattr failed. key %s path %s",
                        GF_PROTECT_FROM_EXTERNAL_WRITES, loc->path);
+            posix_xattr_cache_invalidate(this, loc->inode);
         }
 
         if (cs_obj_status)
@@ -340,6 +343,7 @@ posix_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
             }
         unlock:
             pthread_mutex_unlock(&ctx->pgfid_lock);
+            posix_xattr_cache_invalidate(this, loc->inode);
         }
     }
 
@@ -1455,6 +1459,7 @@ posix_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
         }
     unlock:
         pthread_mutex_unlock(&ctx->pgfid_lock);
+        posix_xattr_cache_invalidate(this, loc->inode);
 
         if (op_ret < 0) {
             gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_XATTR_FAILED,
@@ -1470,6 +1475,7 @@ posix_unlink(call_frame_t *frame, xlator_t *this, loc_t *loc, int xflag,
     if (priv->gfid2path && (stbuf.ia_nlink > 1)) {
         op_ret = posix_remove_gfid2path_xattr(this, real_path, loc->pargfid,
                                               loc->name);
+        posix_xattr_cache_invalidate(this, loc->inode);
         if (op_ret < 0) {
             /* Allow unlink if pgfid xattr is not set. */
             if (errno != ENOATTR)
@@ -1643,6 +1649,7 @@ posix_rmdir(call_frame_t *frame, xlator_t *this, loc_t *loc, int flags,
     op_errno = errno;
 
     if (op_ret == 0) {
+        posix_handle_fd_stale(this, loc->inode);
         if (posix_symlinks_match(this, loc, stbuf.ia_gfid))
             posix_handle_unset(this, stbuf.ia_gfid, NULL);
     }
@@ -1880,6 +1887,7 @@ posix_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
     char newdirid[64];
     uuid_t victim = {0};
     int was_dir = 0;
+    inode_t *victim_inode = NULL;
     int nlink = 0;
     char *pgfid_xattr_key = NULL;
     int32_t nlink_samepgfid = 0;
@@ -2069,6 +2077,7 @@ unlock:
         locked = _gf_false;
     }
     pthread_mutex_unlock(&ctx_old->pgfid_lock);
+    posix_xattr_cache_invalidate(this, oldloc->inode);
 
     if (op_ret < 0) {
         gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_XATTR_FAILED,
@@ -2078,8 +2087,14 @@ unlock:
         goto out;
     }
 
-    if (was_dir)
+    if (was_dir) {
+        victim_inode = inode_find(oldloc->inode->table, victim);
+        if (victim_inode) {
+            posix_handle_fd_stale(this, victim_inode);
+            inode_unref(victim_inode);
+        }
         posix_handle_unset(this, victim, NULL);
+    }
 
     if (was_present && !was_dir && nlink == 1)
         posix_handle_unset(this, victim, NULL);
@@ -2272,6 +2287,7 @@ real_op:
         }
     unlock:
         pthread_mutex_unlock(&ctx->pgfid_lock);
+        posix_xattr_cache_invalidate(this, newloc->inode);
 
         if (op_ret < 0) {
             gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_XATTR_FAILED,
@@ -2286,6 +2302,7 @@ real_op:
         if (stbuf.ia_nlink <= MAX_GFID2PATH_LINK_SUP) {
             op_ret = posix_set_gfid2path_xattr(this, real_newpath,
                                                newloc->pargfid, newloc->name);
+            posix_xattr_cache_invalidate(this, newloc->inode);
             if (op_ret) {
                 op_errno = errno;
                 goto out;
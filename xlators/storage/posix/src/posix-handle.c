@@ -347,6 +347,7 @@ posix_handle_pump(xlator_t *this, char *buf, int len, int maxlen,
     dirfd = priv->arrdfd[index];
 
     /* is a directory's symlink-handle */
+    GF_ATOMIC_INC(priv->handle_readlinks);
     ret = readlinkat(dirfd, tmpstr, linkname, 512);
     if (ret == -1) {
         gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_READLINK_FAILED,
@@ -467,6 +468,162 @@ out:
     return len + 1;
 }
 
+/*
+  Directory handles are symlink chains, and posix_handle_path() has to
+  readlink() each of them up to the brick root. Once a directory has been
+  resolved, an O_PATH fd of it is kept in the inode ctx, and its path is
+  read back with a single readlink() of /proc/self/fd/<fd>, which the kernel
+  answers from the dentry without walking any chain. The path is the real
+  one under the brick, so that it can be logged, compared or stored like
+  the one of posix_handle_path(). The fd is closed only at forget.
+
+  Returns the length of the path + 1 as posix_handle_path() does, or 0 if
+  no fd is cached for the directory.
+*/
+
+int
+posix_handle_fd_path(xlator_t *this, inode_t *inode, uuid_t gfid,
+                     const char *basename, char *buf, size_t size)
+{
+    struct posix_private *priv = this->private;
+    posix_inode_ctx_t *ctx = NULL;
+    uint64_t ctx_uint = 0;
+    char fd_path[32] = {
+        0,
+    };
+    int dir_fd = -1;
+    ssize_t len = 0;
+    int ret = 0;
+
+    if (!priv->handle_fd_cache_size || !inode ||
+        gf_uuid_compare(inode->gfid, gfid) || __is_root_gfid(gfid))
+        return 0;
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get(inode, this, &ctx_uint) == 0) {
+            ctx = (posix_inode_ctx_t *)(uintptr_t)ctx_uint;
+            if (!ctx->dir_fd_stale)
+                dir_fd = ctx->dir_fd;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+    if (dir_fd < 0)
+        return 0;
+
+    snprintf(fd_path, sizeof(fd_path), "/proc/self/fd/%d", dir_fd);
+    len = sys_readlink(fd_path, buf, size - 1);
+    if (len <= 0 || len >= size - 1 || buf[0] != '/')
+        return 0;
+    buf[len] = '\0';
+
+    /* removed behind our back */
+    if (len > SLEN(" (deleted)") &&
+        !strcmp(buf + len - SLEN(" (deleted)"), " (deleted)"))
+        return 0;
+
+    if (basename) {
+        ret = snprintf(buf + len, size - len, "/%s", basename);
+        if (ret < 0 || ret >= size - len)
+            return 0;
+        len += ret;
+    }
+
+    GF_ATOMIC_INC(priv->handle_fd_hits);
+
+    return len + 1;
+}
+
+void
+posix_handle_fd_cache(xlator_t *this, inode_t *inode, uuid_t gfid,
+                      const char *dir_path, struct iatt *buf)
+{
+#ifdef O_PATH
+    struct posix_private *priv = this->private;
+    posix_inode_ctx_t *ctx = NULL;
+    struct stat stbuf = {
+        0,
+    };
+    int fd = -1;
+    gf_boolean_t cached = _gf_false;
+
+    if (!priv->handle_fd_cache_size || !inode || !dir_path ||
+        gf_uuid_compare(inode->gfid, gfid) || __is_root_gfid(gfid))
+        return;
+
+    if ((buf ? buf->ia_type : inode->ia_type) != IA_IFDIR)
+        return;
+
+    /* reserve the slot up front, so that racing resolutions cannot take
+     * the cache past its size */
+    if (GF_ATOMIC_INC(priv->handle_fds) > priv->handle_fd_cache_size) {
+        GF_ATOMIC_DEC(priv->handle_fds);
+        return;
+    }
+
+    fd = open(dir_path, O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0)
+        goto out;
+
+    if (sys_fstat(fd, &stbuf) || (stbuf.st_ino == priv->handledir_st_ino &&
+                                  stbuf.st_dev == priv->handledir_st_dev))
+        goto out;
+
+    LOCK(&inode->lock);
+    {
+        ctx = __posix_inode_ctx_get(inode, this);
+        if (ctx && ctx->dir_fd < 0 && !ctx->dir_fd_stale) {
+            ctx->dir_fd = fd;
+            fd = -1;
+            cached = _gf_true;
+        }
+    }
+    UNLOCK(&inode->lock);
+
+out:
+    if (!cached)
+        GF_ATOMIC_DEC(priv->handle_fds);
+    if (fd >= 0)
+        sys_close(fd);
+#endif
+}
+
+/* Called once the directory is gone from the backend. The fd itself is
+ * left open until forget, as paths built from it may still be in use. */
+void
+posix_handle_fd_stale(xlator_t *this, inode_t *inode)
+{
+    posix_inode_ctx_t *ctx = NULL;
+    uint64_t ctx_uint = 0;
+
+    if (!inode)
+        return;
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get(inode, this, &ctx_uint) == 0) {
+            ctx = (posix_inode_ctx_t *)(uintptr_t)ctx_uint;
+            ctx->dir_fd_stale = _gf_true;
+        }
+    }
+    UNLOCK(&inode->lock);
+}
+
+void
+posix_handle_fd_release(xlator_t *this, posix_inode_ctx_t *ctx)
+{
+    struct posix_private *priv = this->private;
+
+    if (ctx->dir_fd < 0)
+        return;
+
+    sys_close(ctx->dir_fd);
+    ctx->dir_fd = -1;
+    if (priv)
+        GF_ATOMIC_DEC(priv->handle_fds);
+}
+
 int
 posix_handle_gfid_path(xlator_t *this, uuid_t gfid, char *buf, size_t buflen)
 {
@@ -176,6 +176,15 @@
                                  _gf_false, _gf_true);                         \
             break;                                                             \
         }                                                                      \
+        parp = alloca(PATH_MAX);                                               \
+        if (posix_handle_fd_path(this, loc->parent, loc->pargfid, NULL, parp,  \
+                                 PATH_MAX) > 0) {                              \
+            entp = alloca(PATH_MAX);                                           \
+            snprintf(entp, PATH_MAX, "%s/%s", parp, loc->name);                \
+            op_ret = posix_pstat(this, loc->inode, NULL, entp, ent_p,          \
+                                 _gf_false, _gf_true);                         \
+            break;                                                             \
+        }                                                                      \
         errno = 0;                                                             \
         op_ret = posix_istat(this, loc->inode, loc->pargfid, loc->name, ent_p, \
                              _gf_true);                                        \
@@ -188,6 +197,9 @@
                        "Failed to create entry handle "                        \
                        "for path %s",                                          \
                        loc->path);                                             \
+            } else {                                                           \
+                posix_handle_fd_cache(this, loc->parent, loc->pargfid, parp,   \
+                                      NULL);                                   \
             }                                                                  \
             break;                                                             \
         }                                                                      \
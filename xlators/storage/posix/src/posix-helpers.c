@@ -207,9 +207,252 @@ posix_xattr_ignorable(char *key)
     return gf_get_index_by_elem(posix_ignore_xattrs, key) >= 0;
 }
 
+void
+posix_xattr_cache_destroy(posix_xattr_cache_t *cache)
+{
+    if (!cache)
+        return;
+
+    if (cache->values)
+        dict_unref(cache->values);
+    GF_FREE(cache->list);
+    GF_FREE(cache);
+}
+
+static posix_xattr_cache_t *
+__posix_xattr_cache_detach(xlator_t *this, inode_t *inode)
+{
+    posix_inode_ctx_t *ctx = NULL;
+    posix_xattr_cache_t *cache = NULL;
+    uint64_t ctx_uint = 0;
+
+    if ((__inode_ctx_get(inode, this, &ctx_uint) == 0) && ctx_uint) {
+        ctx = (posix_inode_ctx_t *)(uintptr_t)ctx_uint;
+        ctx->xattr_gen++;
+        cache = ctx->xattr_cache;
+        ctx->xattr_cache = NULL;
+    }
+
+    return cache;
+}
+
+/* Must be called after the backend xattrs of @inode have been modified, so
+ * that a concurrent posix_xattr_fill() which read the old values before the
+ * modification cannot publish them (see xattr_gen). */
+void
+__posix_xattr_cache_invalidate(xlator_t *this, inode_t *inode)
+{
+    posix_xattr_cache_destroy(__posix_xattr_cache_detach(this, inode));
+}
+
+void
+posix_xattr_cache_invalidate(xlator_t *this, inode_t *inode)
+{
+    posix_xattr_cache_t *cache = NULL;
+
+    if (!inode)
+        return;
+
+    LOCK(&inode->lock);
+    {
+        cache = __posix_xattr_cache_detach(this, inode);
+    }
+    UNLOCK(&inode->lock);
+
+    posix_xattr_cache_destroy(cache);
+}
+
+/* Attach the xattr cache of filler->inode to @filler, (re)creating it if it
+ * is missing or stale w.r.t. the backend inode. Returns _gf_true if the
+ * listxattr() result was served from the cache. */
+static gf_boolean_t
+posix_xattr_cache_fetch(posix_xattr_filler_t *filler)
+{
+    struct posix_private *priv = filler->this->private;
+    inode_t *inode = filler->inode;
+    posix_inode_ctx_t *ctx = NULL;
+    posix_xattr_cache_t *cache = NULL;
+    posix_xattr_cache_t *stale = NULL;
+    gf_boolean_t list_cached = _gf_false;
+    struct stat lstatbuf = {
+        0,
+    };
+    int ret = -1;
+
+    if (filler->real_path)
+        ret = sys_lstat(filler->real_path, &lstatbuf);
+    else
+        ret = sys_fstat(filler->fdnum, &lstatbuf);
+    if (ret)
+        return _gf_false;
+
+    LOCK(&inode->lock);
+    {
+        ctx = __posix_inode_ctx_get(inode, filler->this);
+        if (!ctx)
+            goto unlock;
+
+        cache = ctx->xattr_cache;
+        if (cache && ((cache->ino != lstatbuf.st_ino) ||
+                      (cache->ctime.tv_sec != lstatbuf.st_ctime) ||
+                      (cache->ctime.tv_nsec != ST_CTIM_NSEC(&lstatbuf)))) {
+            stale = cache;
+            cache = NULL;
+            ctx->xattr_cache = NULL;
+            ctx->xattr_gen++;
+        }
+
+        if (cache) {
+            if (cache->list_size > 0)
+                filler->list = gf_memdup(cache->list, cache->list_size);
+            if (cache->list_size == 0 || filler->list) {
+                filler->list_size = cache->list_size;
+                filler->listed = _gf_true;
+                list_cached = _gf_true;
+            }
+        } else {
+            cache = GF_CALLOC(1, sizeof(*cache), gf_posix_mt_xattr_cache_t);
+            if (!cache)
+                goto unlock;
+            cache->values = dict_new();
+            if (!cache->values) {
+                GF_FREE(cache);
+                goto unlock;
+            }
+            cache->list_size = -1;
+            cache->ino = lstatbuf.st_ino;
+            cache->ctime.tv_sec = lstatbuf.st_ctime;
+            cache->ctime.tv_nsec = ST_CTIM_NSEC(&lstatbuf);
+            ctx->xattr_cache = cache;
+        }
+
+        filler->cache = dict_ref(cache->values);
+        filler->cache_gen = ctx->xattr_gen;
+    }
+unlock:
+    UNLOCK(&inode->lock);
+
+    posix_xattr_cache_destroy(stale);
+
+    if (list_cached)
+        GF_ATOMIC_INC(priv->xattr_cache_hits);
+    else
+        GF_ATOMIC_INC(priv->xattr_cache_misses);
+
+    return list_cached;
+}
+
+/* Returns the cache of filler->inode if it still is the one @filler was
+ * attached to. Must be called with inode->lock held. */
+static posix_xattr_cache_t *
+__posix_xattr_cache_get_current(posix_xattr_filler_t *filler)
+{
+    posix_inode_ctx_t *ctx = NULL;
+    uint64_t ctx_uint = 0;
+
+    if ((__inode_ctx_get(filler->inode, filler->this, &ctx_uint) != 0) ||
+        !ctx_uint)
+        return NULL;
+
+    ctx = (posix_inode_ctx_t *)(uintptr_t)ctx_uint;
+    if ((ctx->xattr_gen != filler->cache_gen) || !ctx->xattr_cache)
+        return NULL;
+
+    return ctx->xattr_cache;
+}
+
+static void
+posix_xattr_cache_set_list(posix_xattr_filler_t *filler)
+{
+    posix_xattr_cache_t *cache = NULL;
+    char *list = NULL;
+
+    if (filler->list_size > 0) {
+        list = gf_memdup(filler->list, filler->list_size);
+        if (!list)
+            return;
+    }
+
+    LOCK(&filler->inode->lock);
+    {
+        cache = __posix_xattr_cache_get_current(filler);
+        if (cache && (cache->list_size < 0)) {
+            cache->list = list;
+            cache->list_size = filler->list_size;
+            list = NULL;
+        }
+    }
+    UNLOCK(&filler->inode->lock);
+
+    GF_FREE(list);
+}
+
+static void
+posix_xattr_cache_set(posix_xattr_filler_t *filler, char *key,
+                      const char *value, ssize_t size)
+{
+    char *copy = NULL;
+
+    copy = GF_MALLOC(size + 1, gf_posix_mt_char);
+    if (!copy)
+        return;
+    memcpy(copy, value, size);
+    copy[size] = '\0';
+
+    LOCK(&filler->inode->lock);
+    {
+        if (__posix_xattr_cache_get_current(filler) &&
+            (dict_set_bin(filler->cache, key, copy, size) == 0))
+            copy = NULL;
+    }
+    UNLOCK(&filler->inode->lock);
+
+    GF_FREE(copy);
+}
+
+static int
+posix_xattr_cache_get(posix_xattr_filler_t *filler, char *key)
+{
+    data_t *data = NULL;
+    char *value = NULL;
+    int ret = -1;
+
+    data = dict_get(filler->cache, key);
+    if (!data)
+        goto out;
+
+    value = GF_MALLOC(data->len + 1, gf_posix_mt_char);
+    if (!value)
+        goto out;
+    memcpy(value, data->data, data->len);
+    value[data->len] = '\0';
+
+    ret = dict_set_bin(filler->xattr, key, value, data->len);
+    if (ret < 0)
+        GF_FREE(value);
+out:
+    return ret;
+}
+
+/* Whether @key is one of the names listxattr() gave for the inode */
+static gf_boolean_t
+posix_xattr_listed(posix_xattr_filler_t *filler, const char *key)
+{
+    size_t offset = 0;
+
+    while (offset < filler->list_size) {
+        if (strcmp(filler->list + offset, key) == 0)
+            return _gf_true;
+        offset += strlen(filler->list + offset) + 1;
+    }
+
+    return _gf_false;
+}
+
 static int
 _posix_xattr_get_set_from_backend(posix_xattr_filler_t *filler, char *key)
 {
+    struct posix_private *priv = filler->this->private;
     ssize_t xattr_size = 256; /* guesstimated initial size of xattr */
     int ret = -1;
     char *value = NULL;
@@ -218,6 +461,21 @@ _posix_xattr_get_set_from_backend(posix_xattr_filler_t *filler, char *key)
         goto out;
     }
 
+    if (filler->cache && (posix_xattr_cache_get(filler, key) == 0)) {
+        ret = 0;
+        goto out;
+    }
+
+    /* The inode was just listed, or its list is cached: a key missing from
+     * it is not there. system.* may hold attributes which are not listed. */
+    if (filler->listed && strncmp(key, "system.", SLEN("system.")) &&
+        !posix_xattr_listed(filler, key)) {
+        errno = ENODATA;
+        goto out;
+    }
+
+    GF_ATOMIC_INC(priv->xattr_syscalls);
+
     /* Most of the gluster internal xattrs don't exceed 256 bytes. So try
      * getxattr with ~256 bytes. If it gives ERANGE then go the old way
      * of getxattr with NULL buf to find the length and then getxattr with
@@ -284,6 +542,8 @@ _posix_xattr_get_set_from_backend(posix_xattr_filler_t *filler, char *key)
     }
 
     value[xattr_size] = '\0';
+    if (filler->cache)
+        posix_xattr_cache_set(filler, key, value, xattr_size);
     ret = dict_set_bin(filler->xattr, key, value, xattr_size);
 
     if (ret < 0) {
@@ -316,6 +576,13 @@ _posix_get_marker_all_contributions(posix_xattr_filler_t *filler)
                            0,
                        };
 
+    /* posix_xattr_fill() has already listed the xattrs, don't do it again */
+    if (filler->list) {
+        list = filler->list;
+        size = filler->list_size;
+        goto walk;
+    }
+
     if (filler->real_path)
         size = sys_llistxattr(filler->real_path, NULL, 0);
     else
@@ -358,6 +625,7 @@ _posix_get_marker_all_contributions(posix_xattr_filler_t *filler)
         goto out;
     }
 
+walk:
     remaining_size = size;
     list_offset = 0;
 
@@ -373,7 +641,8 @@ _posix_get_marker_all_contributions(posix_xattr_filler_t *filler)
     ret = 0;
 
 out:
-    GF_FREE(list);
+    if (list != filler->list)
+        GF_FREE(list);
     return ret;
 }
 
@@ -859,34 +1128,71 @@ out:
     return ret;
 }
 
-static void
+static ssize_t
 _get_list_xattr(posix_xattr_filler_t *filler)
 {
-    ssize_t size = 0;
+    struct posix_private *priv = NULL;
+    char buf[XATTR_KEY_BUF_SIZE];
+    char *list = buf;
+    ssize_t size = -1;
 
     if ((!filler) || ((!filler->real_path) && (filler->fdnum < 0)))
         goto out;
 
+    priv = filler->this->private;
+
+    /* The names of all xattrs of an inode almost always fit in a page, so
+     * list them in one go and only probe the size on ERANGE. */
+    GF_ATOMIC_INC(priv->xattr_syscalls);
     if (filler->real_path)
-        size = sys_llistxattr(filler->real_path, NULL, 0);
+        size = sys_llistxattr(filler->real_path, buf, sizeof(buf));
     else
-        size = sys_flistxattr(filler->fdnum, NULL, 0);
+        size = sys_flistxattr(filler->fdnum, buf, sizeof(buf));
 
-    if (size <= 0)
-        goto out;
+    if ((size == -1) && (errno == ERANGE)) {
+        GF_ATOMIC_INC(priv->xattr_syscalls);
+        if (filler->real_path)
+            size = sys_llistxattr(filler->real_path, NULL, 0);
+        else
+            size = sys_flistxattr(filler->fdnum, NULL, 0);
+        if (size <= 0)
+            goto out;
 
-    filler->list = GF_CALLOC(1, size, gf_posix_mt_char);
-    if (!filler->list)
+        list = GF_CALLOC(1, size, gf_posix_mt_char);
+        if (!list) {
+            size = -1;
+            goto out;
+        }
+
+        GF_ATOMIC_INC(priv->xattr_syscalls);
+        if (filler->real_path)
+            size = sys_llistxattr(filler->real_path, list, size);
+        else
+            size = sys_flistxattr(filler->fdnum, list, size);
+    }
+
+    if (size == 0)
+        filler->listed = _gf_true;
+    if (size <= 0)
         goto out;
 
-    if (filler->real_path)
-        size = sys_llistxattr(filler->real_path, filler->list, size);
-    else
-        size = sys_flistxattr(filler->fdnum, filler->list, size);
+    if (list == buf) {
+        filler->list = gf_memdup(buf, size);
+        if (!filler->list) {
+            size = -1;
+            goto out;
+        }
+    } else {
+        filler->list = list;
+        list = buf;
+    }
 
     filler->list_size = size;
+    filler->listed = _gf_true;
 out:
-    return;
+    if (list != buf)
+        GF_FREE(list);
+    return size;
 }
 
 static void
@@ -930,11 +1236,14 @@ dict_t *
 posix_xattr_fill(xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
                  int fdnum, dict_t *xattr_req, struct iatt *buf)
 {
+    struct posix_private *priv = this->private;
     dict_t *xattr = NULL;
     posix_xattr_filler_t filler = {
         0,
     };
     gf_boolean_t list = _gf_false;
+    gf_boolean_t list_cached = _gf_false;
+    ssize_t size = 0;
 
     if (dict_get_sizen(xattr_req, "list-xattr")) {
         dict_del_sizen(xattr_req, "list-xattr");
@@ -954,11 +1263,24 @@ posix_xattr_fill(xlator_t *this, const char *real_path, loc_t *loc, fd_t *fd,
     filler.fd = fd;
     filler.fdnum = fdnum;
 
-    _get_list_xattr(&filler);
+    if (priv->xattr_cache) {
+        filler.inode = _get_filler_inode(&filler);
+        if (filler.inode)
+            list_cached = posix_xattr_cache_fetch(&filler);
+    }
+
+    if (!list_cached) {
+        size = _get_list_xattr(&filler);
+        if (filler.cache && (size >= 0))
+            posix_xattr_cache_set_list(&filler);
+    }
+
     dict_foreach(xattr_req, _posix_xattr_get_set, &filler);
     if (list)
         _handle_list_xattr(&filler);
 
+    if (filler.cache)
+        dict_unref(filler.cache);
     GF_FREE(filler.list);
 out:
     return xattr;
@@ -1045,6 +1367,8 @@ posix_gfid_set(xlator_t *this, const char *path, loc_t *loc, dict_t *xattr_req,
                "setting GFID on %s failed ", path);
         goto out;
     }
+    if (loc)
+        posix_xattr_cache_invalidate(this, loc->inode);
     gf_uuid_copy(uuid_curr, uuid_req);
 
 verify_handle:
@@ -2812,6 +3136,7 @@ __posix_inode_ctx_get(inode_t *inode, xlator_t *this)
     pthread_mutex_init(&ctx_p->xattrop_lock, NULL);
     pthread_mutex_init(&ctx_p->write_atomic_lock, NULL);
     pthread_mutex_init(&ctx_p->pgfid_lock, NULL);
+    ctx_p->dir_fd = -1;
 
     ctx_uint = (uint64_t)(uintptr_t)ctx_p;
     ret = __inode_ctx_set(inode, this, &ctx_uint);
@@ -2984,6 +3309,7 @@ posix_check_internal_writes(xlator_t *this, inode_t *fd_inode, int sysfd,
                        "setxattr failed key %s",
                        GF_PROTECT_FROM_EXTERNAL_WRITES);
             }
+            __posix_xattr_cache_invalidate(this, fd_inode);
         } else {  // GF_AVOID_OVERWRITE was found, otherwise we would not be
                   // here
             ret = sys_fgetxattr(sysfd, GF_PROTECT_FROM_EXTERNAL_WRITES, NULL,
@@ -3391,6 +3717,7 @@ posix_cs_maintenance(xlator_t *this, fd_t *fd, loc_t *loc, int *pfd,
 
             if (state == GF_CS_REPAIR) {
                 state = posix_cs_heal_state(this, NULL, pfd, buf);
+                __posix_xattr_cache_invalidate(this, fd->inode);
 
                 if (state == GF_CS_ERROR) {
                     gf_msg(this->name, GF_LOG_ERROR, 0, 0,
@@ -3442,6 +3769,7 @@ posix_cs_maintenance(xlator_t *this, fd_t *fd, loc_t *loc, int *pfd,
 
             if (state == GF_CS_REPAIR) {
                 state = posix_cs_heal_state(this, realpath, NULL, buf);
+                __posix_xattr_cache_invalidate(this, loc->inode);
 
                 if (state == GF_CS_ERROR) {
                     gf_msg(this->name, GF_LOG_ERROR, 0, 0,
@@ -473,6 +473,10 @@ posix_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
     op_ret = 0;
 
 out:
+    /* chown drops security.capability, chmod rewrites the ACL mask */
+    if (loc && (valid & (GF_SET_ATTR_UID | GF_SET_ATTR_GID | GF_SET_ATTR_MODE)))
+        posix_xattr_cache_invalidate(this, loc->inode);
+
     SET_TO_OLD_FS_ID();
 
     STACK_UNWIND_STRICT(setattr, frame, op_ret, op_errno, &statpre, &statpost,
@@ -703,6 +707,9 @@ posix_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd,
     op_ret = 0;
 
 out:
+    if (fd && (valid & (GF_SET_ATTR_UID | GF_SET_ATTR_GID | GF_SET_ATTR_MODE)))
+        posix_xattr_cache_invalidate(this, fd->inode);
+
     SET_TO_OLD_FS_ID();
 
     STACK_UNWIND_STRICT(fsetattr, frame, op_ret, op_errno, &statpre, &statpost,
@@ -3198,6 +3205,9 @@ posix_setxattr(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *dict,
     }
 
 out:
+    if (priv)
+        posix_xattr_cache_invalidate(this, loc->inode);
+
     SET_TO_OLD_FS_ID();
 
     STACK_UNWIND_STRICT(setxattr, frame, op_ret, op_errno, xattr);
@@ -3691,6 +3701,10 @@ posix_getxattr(call_frame_t *frame, xlator_t *this, loc_t *loc,
         goto out;
     }
 
+    /* the mdata xattr on disk may lag behind the inode ctx */
+    if (!name || !strcmp(name, GF_XATTR_MDATA_KEY))
+        posix_mdata_flush_inode(this, loc->inode);
+
     dict = dict_new();
     if (!dict) {
         op_errno = ENOMEM;
@@ -4200,6 +4214,9 @@ posix_fgetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, const char *name,
 
     _fd = pfd->fd;
 
+    if (!name || !strcmp(name, GF_XATTR_MDATA_KEY))
+        posix_mdata_flush_inode(this, fd->inode);
+
     /* Get the total size */
     dict = dict_new();
     if (!dict) {
@@ -4568,6 +4585,9 @@ posix_fsetxattr(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *dict,
     ret = posix_set_iatt_in_dict(xattr, &preop, &postop);
 
 out:
+    if (priv)
+        posix_xattr_cache_invalidate(this, fd->inode);
+
     SET_TO_OLD_FS_ID();
 
     STACK_UNWIND_STRICT(fsetxattr, frame, op_ret, op_errno, xattr);
@@ -4774,6 +4794,7 @@ posix_common_removexattr(call_frame_t *frame, loc_t *loc, fd_t *fd,
 
     op_ret = 0;
 out:
+    posix_xattr_cache_invalidate(this, inode);
     SET_TO_OLD_FS_ID();
     return op_ret;
 }
@@ -4840,6 +4861,8 @@ posix_fsyncdir(call_frame_t *frame, xlator_t *this, fd_t *fd, int datasync,
         goto out;
     }
 
+    posix_mdata_flush_inode(this, fd->inode);
+
     op_ret = 0;
 
 out:
@@ -5234,6 +5257,7 @@ do_xattrop(call_frame_t *frame, xlator_t *this, loc_t *loc, fd_t *fd,
 
     op_ret = dict_foreach(xattr, _posix_handle_xattr_keyvalue_pair, &filler);
     op_errno = filler.op_errno;
+    posix_xattr_cache_invalidate(this, inode);
     if (op_ret < 0)
         goto out;
 
@@ -6170,6 +6194,8 @@ posix_forget(xlator_t *this, inode_t *inode)
     pthread_mutex_destroy(&ctx->xattrop_lock);
     pthread_mutex_destroy(&ctx->write_atomic_lock);
     pthread_mutex_destroy(&ctx->pgfid_lock);
+    posix_xattr_cache_destroy(ctx->xattr_cache);
+    posix_handle_fd_release(this, ctx);
     GF_FREE(ctx);
 
     return ret;
@@ -74,6 +74,13 @@
                                  iatt_p, _gf_false, _gf_true);                 \
             break;                                                             \
         }                                                                      \
+        rpath = alloca(PATH_MAX);                                              \
+        if (posix_handle_fd_path(this, (loc)->inode, (loc)->gfid, NULL, rpath, \
+                                 PATH_MAX) > 0) {                              \
+            op_ret = posix_pstat(this, (loc)->inode, (loc)->gfid, rpath,       \
+                                 iatt_p, _gf_false, _gf_true);                 \
+            break;                                                             \
+        }                                                                      \
         errno = 0;                                                             \
         op_ret = posix_istat(this, loc->inode, loc->gfid, NULL, iatt_p,        \
                              _gf_true);                                        \
@@ -86,6 +93,9 @@
                        "Failed to create inode handle "                        \
                        "for path %s",                                          \
                        (loc)->path);                                           \
+            } else if (op_ret == 0) {                                          \
+                posix_handle_fd_cache(this, (loc)->inode, (loc)->gfid, rpath,  \
+                                      iatt_p);                                 \
             }                                                                  \
             break;                                                             \
         } /* __ret == -1 && errno == ELOOP */                                  \
@@ -101,6 +111,17 @@ int
 posix_handle_path(xlator_t *this, uuid_t gfid, const char *basename, char *buf,
                   size_t len);
 
+int
+posix_handle_fd_path(xlator_t *this, inode_t *inode, uuid_t gfid,
+                     const char *basename, char *buf, size_t size);
+
+void
+posix_handle_fd_cache(xlator_t *this, inode_t *inode, uuid_t gfid,
+                      const char *dir_path, struct iatt *buf);
+
+void
+posix_handle_fd_stale(xlator_t *this, inode_t *inode);
+
 int
 posix_make_ancestryfromgfid(xlator_t *this, char *path, int pathsize,
                             gf_dirent_t *head, int type, uuid_t gfid,
@@ -184,7 +184,8 @@ out:
     return op_ret;
 }
 
-/* posix_store_mdata_xattr stores the posix_mdata_t on disk */
+/* posix_store_mdata_xattr stores the posix_mdata_t on disk. It is called
+ * with inode->lock held. */
 static int
 posix_store_mdata_xattr(xlator_t *this, const char *real_path_arg, int fd,
                         inode_t *inode, posix_mdata_t *metadata)
@@ -235,6 +236,9 @@ posix_store_mdata_xattr(xlator_t *this, const char *real_path_arg, int fd,
         posix_dump_buffer(this, real_path, GF_XATTR_MDATA_KEY, value, 0);
     }
 #endif
+    __posix_xattr_cache_invalidate(this, inode);
+    if (op_ret == 0)
+        metadata->dirty = 0;
 out:
     if (op_ret < 0) {
         gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_XATTR_FAILED,
@@ -245,6 +249,222 @@ out:
     return op_ret;
 }
 
+/* With storage.ctime-writeback-delay-usec set, ctime/mtime updates of a
+ * parent directory done by entry fops (create, mkdir, unlink, rename...) only
+ * change the mdata in the inode ctx, which stays authoritative for every
+ * stat served by this brick. The directory is queued once, and the flusher
+ * thread writes its latest mdata after the delay, so a burst of creates in
+ * one directory costs a single xattr write instead of one per entry.
+ *
+ * The queued write is done synchronously on fsyncdir, on getxattr of the
+ * mdata xattr (self-heal and rebalance read it from the backend) and at
+ * fini. If the brick process dies before the flusher ran, the directory
+ * keeps the times it had on disk, i.e. its ctime/mtime go back by at most
+ * the delay. Times of the entries themselves are always written through.
+ *
+ * Called with inode->lock held. */
+static void
+__posix_mdata_defer(xlator_t *this, inode_t *inode, posix_mdata_t *mdata)
+{
+    struct posix_private *priv = this->private;
+
+    mdata->dirty = 1;
+    GF_ATOMIC_INC(priv->mdata_deferred);
+
+    if (mdata->queued)
+        return;
+
+    mdata->queued = 1;
+    mdata->inode = inode_ref(inode);
+
+    pthread_mutex_lock(&priv->mdata_mutex);
+    {
+        list_add_tail(&mdata->dirty_list, &priv->mdata_dirty);
+        pthread_cond_signal(&priv->mdata_cond);
+    }
+    pthread_mutex_unlock(&priv->mdata_mutex);
+}
+
+/* Writes the mdata of a queued directory if it is still dirty. A directory
+ * removed in the meantime has no handle anymore and is skipped. The mdata
+ * stays dirty if the write fails, so that it is tried again. Returns -1 in
+ * that case. Called with inode->lock held. */
+static int
+__posix_mdata_writeback(xlator_t *this, inode_t *inode, posix_mdata_t *mdata)
+{
+    struct posix_private *priv = this->private;
+    posix_mdata_disk_t disk_metadata;
+    char *real_path = NULL;
+    int ret = 0;
+
+    if (!mdata->dirty)
+        return 0;
+
+    MAKE_HANDLE_PATH(real_path, this, inode->gfid, NULL);
+    if (!real_path) {
+        mdata->dirty = 0;
+        return 0;
+    }
+
+    posix_mdata_to_disk(&disk_metadata, mdata);
+    ret = sys_lsetxattr(real_path, GF_XATTR_MDATA_KEY, (void *)&disk_metadata,
+                        sizeof(posix_mdata_disk_t), 0);
+    if (ret == 0) {
+        mdata->dirty = 0;
+        GF_ATOMIC_INC(priv->mdata_writebacks);
+        __posix_xattr_cache_invalidate(this, inode);
+    } else if (errno == ENOENT || errno == ESTALE) {
+        mdata->dirty = 0;
+        ret = 0;
+    } else {
+        gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_STOREMDATA_FAILED,
+               "file: %s: gfid: %s key:%s ", real_path, uuid_utoa(inode->gfid),
+               GF_XATTR_MDATA_KEY);
+    }
+
+    return ret;
+}
+
+/* posix_mdata_flush_inode writes the mdata of inode if an update of it is
+ * still waiting for the flusher. The inode stays queued, the flusher drops
+ * it without writing again, or retries if this write failed. */
+void
+posix_mdata_flush_inode(xlator_t *this, inode_t *inode)
+{
+    uint64_t ctx = 0;
+    posix_mdata_t *mdata = NULL;
+
+    if (!inode)
+        return;
+
+    LOCK(&inode->lock);
+    {
+        if (__inode_ctx_get1(inode, this, &ctx) == 0 && ctx) {
+            mdata = (posix_mdata_t *)(uintptr_t)ctx;
+            __posix_mdata_writeback(this, inode, mdata);
+        }
+    }
+    UNLOCK(&inode->lock);
+}
+
+/* Writes every directory of head. One whose write failed goes back to the
+ * dirty list for the next round, unless the flusher is stopping. */
+static void
+posix_mdata_flush_list(xlator_t *this, struct list_head *head,
+                       gf_boolean_t stop)
+{
+    struct posix_private *priv = this->private;
+    posix_mdata_t *mdata = NULL;
+    posix_mdata_t *tmp = NULL;
+    inode_t *inode = NULL;
+    int ret = 0;
+
+    list_for_each_entry_safe(mdata, tmp, head, dirty_list)
+    {
+        inode = mdata->inode;
+
+        LOCK(&inode->lock);
+        {
+            list_del_init(&mdata->dirty_list);
+            ret = __posix_mdata_writeback(this, inode, mdata);
+            if (ret == 0 || stop) {
+                mdata->queued = 0;
+                mdata->inode = NULL;
+            } else {
+                pthread_mutex_lock(&priv->mdata_mutex);
+                {
+                    list_add_tail(&mdata->dirty_list, &priv->mdata_dirty);
+                }
+                pthread_mutex_unlock(&priv->mdata_mutex);
+            }
+        }
+        UNLOCK(&inode->lock);
+
+        /* may free mdata through forget */
+        if (ret == 0 || stop)
+            inode_unref(inode);
+    }
+}
+
+void *
+posix_mdata_flusher(void *d)
+{
+    xlator_t *this = d;
+    struct posix_private *priv = this->private;
+    struct list_head list;
+    gf_boolean_t stop = _gf_false;
+
+    while (!stop) {
+        INIT_LIST_HEAD(&list);
+
+        pthread_mutex_lock(&priv->mdata_mutex);
+        {
+            while (list_empty(&priv->mdata_dirty) && !priv->mdata_flusher_stop)
+                pthread_cond_wait(&priv->mdata_cond, &priv->mdata_mutex);
+            stop = priv->mdata_flusher_stop;
+        }
+        pthread_mutex_unlock(&priv->mdata_mutex);
+
+        /* let more updates of the same directories pile up */
+        if (!stop)
+            gf_nanosleep(priv->mdata_writeback_delay_usec * GF_US_IN_NS);
+
+        pthread_mutex_lock(&priv->mdata_mutex);
+        {
+            list_splice_init(&priv->mdata_dirty, &list);
+        }
+        pthread_mutex_unlock(&priv->mdata_mutex);
+
+        posix_mdata_flush_list(this, &list, stop);
+    }
+
+    return NULL;
+}
+
+/* Starts the flusher the first time a nonzero write-back delay is set. With
+ * the delay at 0 every update is written through and no thread is needed.
+ * Called from init and reconfigure, which do not run concurrently. */
+int
+posix_mdata_flusher_start(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    int ret = 0;
+
+    if (!priv->mdata_writeback_delay_usec || priv->mdata_flusher)
+        return 0;
+
+    ret = gf_thread_create(&priv->mdata_flusher, NULL, posix_mdata_flusher,
+                           this, "posixmdw");
+    if (ret) {
+        priv->mdata_flusher = 0;
+        gf_msg(this->name, GF_LOG_ERROR, errno,
+               P_MSG_FSYNCER_THREAD_CREATE_FAILED,
+               "mdata flusher thread creation failed");
+    }
+
+    return ret;
+}
+
+/* Stops the flusher once everything queued is on disk. */
+void
+posix_mdata_flusher_stop(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+
+    if (!priv->mdata_flusher)
+        return;
+
+    pthread_mutex_lock(&priv->mdata_mutex);
+    {
+        priv->mdata_flusher_stop = _gf_true;
+        pthread_cond_signal(&priv->mdata_cond);
+    }
+    pthread_mutex_unlock(&priv->mdata_mutex);
+
+    pthread_join(priv->mdata_flusher, NULL);
+    priv->mdata_flusher = 0;
+}
+
 /* _posix_get_mdata_xattr gets posix_mdata_t from inode context. If it fails
  * to get it from inode context, gets it from disk. This is with out inode lock.
  */
@@ -467,8 +687,9 @@ posix_set_mdata_xattr(xlator_t *this, const char *real_path, int fd,
                       inode_t *inode, struct timespec *time,
                       struct timespec *u_atime, struct timespec *u_mtime,
                       struct iatt *stbuf, posix_mdata_flag_t *flag,
-                      gf_boolean_t update_utime)
+                      gf_boolean_t update_utime, gf_boolean_t defer)
 {
+    struct posix_private *priv = this->private;
     uint64_t ctx;
     posix_mdata_t *mdata = NULL;
     int ret = -1;
@@ -599,6 +820,12 @@ posix_set_mdata_xattr(xlator_t *this, const char *real_path, int fd,
          * We should evaluate the performance, and based on that we can
          * decide on asynchronous updation.
          */
+        if (defer && priv->mdata_writeback_delay_usec &&
+            priv->mdata_flusher && inode->ia_type == IA_IFDIR) {
+            __posix_mdata_defer(this, inode, mdata);
+            ret = 0;
+            goto unlock;
+        }
         ret = posix_store_mdata_xattr(this, real_path, fd, inode, mdata);
         if (ret) {
             gf_msg(this->name, GF_LOG_ERROR, errno, P_MSG_STOREMDATA_FAILED,
@@ -679,7 +906,7 @@ posix_update_utime_in_mdata(xlator_t *this, const char *real_path, int fd,
         if (flag.mtime || flag.atime) {
             ret = posix_set_mdata_xattr(this, real_path, -1, inode, ctime,
                                         &tv_atime, &tv_mtime, NULL, &flag,
-                                        _gf_true);
+                                        _gf_true, _gf_false);
             if (ret) {
                 gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_SETMDATA_FAILED,
                        "posix set mdata atime failed on file:"
@@ -722,7 +949,7 @@ posix_update_ctime_in_mdata(xlator_t *this, const char *real_path, int fd,
         flag.ctime = 1;
 
         ret = posix_set_mdata_xattr(this, real_path, -1, inode, &tv_ctime, NULL,
-                                    NULL, NULL, &flag, _gf_true);
+                                    NULL, NULL, &flag, _gf_true, _gf_false);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_SETMDATA_FAILED,
                    "posix set mdata atime failed on file:"
@@ -788,7 +1015,7 @@ posix_set_ctime(call_frame_t *frame, xlator_t *this, const char *real_path,
         }
         ret = posix_set_mdata_xattr(this, real_path, fd, inode,
                                     &frame->root->ctime, NULL, NULL, stbuf,
-                                    &flag, _gf_false);
+                                    &flag, _gf_false, _gf_false);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_SETMDATA_FAILED,
                    "posix set mdata failed on file: %s gfid:%s", real_path,
@@ -819,7 +1046,7 @@ posix_set_parent_ctime(call_frame_t *frame, xlator_t *this,
         }
         ret = posix_set_mdata_xattr(this, real_path, fd, inode,
                                     &frame->root->ctime, NULL, NULL, stbuf,
-                                    &flag, _gf_false);
+                                    &flag, _gf_false, _gf_true);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_SETMDATA_FAILED,
                    "posix set mdata failed on file: %s gfid:%s", real_path,
@@ -881,7 +1108,7 @@ posix_set_ctime_cfr(call_frame_t *frame, xlator_t *this,
 
         ret = posix_set_mdata_xattr(this, real_path_out, fd_out, inode_out,
                                     &frame->root->ctime, NULL, NULL, stbuf_out,
-                                    &flag_dup, _gf_false);
+                                    &flag_dup, _gf_false, _gf_false);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_SETMDATA_FAILED,
                    "posix set mdata failed on file: %s gfid:%s", real_path_out,
@@ -900,7 +1127,7 @@ posix_set_ctime_cfr(call_frame_t *frame, xlator_t *this,
 
         ret = posix_set_mdata_xattr(this, real_path_in, fd_out, inode_out,
                                     &frame->root->ctime, NULL, NULL, stbuf_out,
-                                    &flag_dup, _gf_false);
+                                    &flag_dup, _gf_false, _gf_false);
         if (ret) {
             gf_msg(this->name, GF_LOG_WARNING, errno, P_MSG_SETMDATA_FAILED,
                    "posix set mdata failed on file: %s gfid:%s", real_path_in,
@@ -22,8 +22,14 @@ typedef struct {
     struct timespec atime;
     /* version of structure, bumped up if any new member is added */
     uint8_t version;
+    /* Write-back state, see __posix_mdata_defer(). Both are protected by
+     * inode->lock. */
+    uint8_t dirty;  /* newer than the xattr on disk */
+    uint8_t queued; /* on priv->mdata_dirty, holds a ref on inode */
 
-    char _pad[7]; /* manual padding */
+    char _pad[5]; /* manual padding */
+    struct list_head dirty_list;
+    inode_t *inode;
 } posix_mdata_t;
 
 typedef struct {
@@ -67,5 +73,13 @@ posix_set_mdata_xattr_legacy_files(xlator_t *this, inode_t *inode,
                                    int *op_errno);
 void
 posix_mdata_iatt_from_disk(struct mdata_iatt *out, posix_mdata_disk_t *in);
+void
+posix_mdata_flush_inode(xlator_t *this, inode_t *inode);
+void *
+posix_mdata_flusher(void *d);
+int
+posix_mdata_flusher_start(xlator_t *this);
+void
+posix_mdata_flusher_stop(xlator_t *this);
 
 #endif /* _POSIX_METADATA_H */
@@ -32,6 +32,7 @@
 #include <glusterfs/compat.h>
 #include "posix-mem-types.h"
 #include <glusterfs/call-stub.h>
+#include <glusterfs/monitoring.h>
 
 #ifdef HAVE_LIBAIO
 #include <libaio.h>
@@ -53,6 +54,8 @@
 
 #define DHT_LINKTO "trusted.glusterfs.dht.linkto"
 
+#define POSIX_METRICS_MAX 6
+
 #define POSIX_GFID_HANDLE_SIZE(base_path_len)                                  \
     (base_path_len + SLEN("/") + SLEN(GF_HIDDEN_PATH) + SLEN("/") +            \
      SLEN("00/") + SLEN("00/") + SLEN(UUID0_STR) + 1) /* '\0' */;
@@ -171,6 +174,17 @@ struct posix_private {
     gf_atomic_t read_value;  /* Total read, from init */
     gf_atomic_t write_value; /* Total write, from init */
 
+    /* xattr cache counters, reported in statedump */
+    gf_atomic_t xattr_cache_hits;
+    gf_atomic_t xattr_cache_misses;
+    gf_atomic_t xattr_syscalls; /* list/getxattr calls made by xattr fill */
+
+    /* O_PATH directory fds kept in inode ctx, see posix_handle_fd_path() */
+    gf_atomic_t handle_fds;       /* currently open */
+    gf_atomic_t handle_fd_hits;   /* resolutions served from a cached fd */
+    gf_atomic_t handle_readlinks; /* symlink handles expanded */
+    uint32_t handle_fd_cache_size;
+
     /* janitor task which cleans up /.trash (created by replicate) */
     struct gf_tw_timer_list *janitor;
 
@@ -195,6 +209,16 @@ struct posix_private {
     struct list_head fsyncs;
     pthread_mutex_t fsync_mutex;
     pthread_cond_t fsync_cond;
+    /* directories whose mdata is written back lazily */
+    pthread_t mdata_flusher;
+    struct list_head mdata_dirty;
+    pthread_mutex_t mdata_mutex;
+    pthread_cond_t mdata_cond;
+    gf_atomic_t mdata_deferred;   /* parent updates kept in memory only */
+    gf_atomic_t mdata_writebacks; /* xattr writes done by the flusher */
+    gf_boolean_t mdata_flusher_stop;
+    /* live metrics, see posix_metrics_register() */
+    gf_metric_t *metrics[POSIX_METRICS_MAX];
     pthread_mutex_t janitor_mutex;
     pthread_cond_t janitor_cond;
     pthread_cond_t fd_cond;
@@ -210,6 +234,7 @@ struct posix_private {
     } batch_fsync_mode;
 
     uint32_t batch_fsync_delay_usec;
+    uint32_t mdata_writeback_delay_usec;
     char gfid2path_sep[8];
 
     /* seconds to sleep between health checks */
@@ -251,6 +276,8 @@ struct posix_private {
 
     gf_boolean_t fips_mode_rchecksum;
     gf_boolean_t ctime;
+    /* cache xattrs fetched for lookup/readdirp xdata in the inode ctx */
+    gf_boolean_t xattr_cache;
     gf_boolean_t janitor_task_stop;
 
     gf_boolean_t disk_unit_percent;
@@ -311,16 +338,35 @@ typedef struct {
     int flags;
     char *list;
     size_t list_size;
+    dict_t *cache;      /* xattr cache values, see posix_xattr_cache_t */
+    uint64_t cache_gen; /* ctx->xattr_gen the cache was taken at */
     int32_t op_errno;
-
-    char _pad[4]; /* manual padding */
+    gf_boolean_t listed; /* list holds every xattr name of the inode */
 } posix_xattr_filler_t;
 
+/* Per-inode cache of the backend xattrs that posix_xattr_fill() reads to
+ * answer lookup/readdirp xdata requests. It is dropped by every posix fop
+ * that modifies xattrs of the inode (see posix_xattr_cache_invalidate()),
+ * and re-validated against the backend ctime, which the kernel bumps on
+ * any xattr change, to catch modifications that bypass posix. Keys missing
+ * from the cached list are answered ENODATA without asking the backend. */
+typedef struct {
+    dict_t *values;        /* key -> value of xattrs read from the backend */
+    char *list;            /* raw listxattr() output */
+    ssize_t list_size;     /* -1 until listxattr() result is cached */
+    struct timespec ctime; /* backend ctime at the time of caching */
+    ino_t ino;
+} posix_xattr_cache_t;
+
 typedef struct {
     uint64_t unlink_flag;
     pthread_mutex_t xattrop_lock;
     pthread_mutex_t write_atomic_lock;
     pthread_mutex_t pgfid_lock;
+    posix_xattr_cache_t *xattr_cache;
+    uint64_t xattr_gen; /* bumped on every invalidation of xattr_cache */
+    int dir_fd;         /* O_PATH fd of the directory, -1 if not open */
+    gf_boolean_t dir_fd_stale; /* directory removed, don't resolve via fd */
 } posix_inode_ctx_t;
 
 #define POSIX_BASE_PATH(this)                                                  \
@@ -362,6 +408,9 @@ int
 __posix_inode_ctx_get_all(inode_t *inode, xlator_t *this,
                           posix_inode_ctx_t **ctx);
 
+posix_inode_ctx_t *
+__posix_inode_ctx_get(inode_t *inode, xlator_t *this);
+
 int
 posix_gfid_set(xlator_t *this, const char *path, loc_t *loc, dict_t *xattr_req,
                pid_t pid, int *op_errno);
@@ -379,6 +428,18 @@ posix_pstat(xlator_t *this, inode_t *inode, uuid_t gfid, const char *real_path,
 dict_t *
 posix_xattr_fill(xlator_t *this, const char *path, loc_t *loc, fd_t *fd,
                  int fdnum, dict_t *xattr, struct iatt *buf);
+
+void
+__posix_xattr_cache_invalidate(xlator_t *this, inode_t *inode);
+
+void
+posix_xattr_cache_invalidate(xlator_t *this, inode_t *inode);
+
+void
+posix_xattr_cache_destroy(posix_xattr_cache_t *cache);
+
+void
+posix_handle_fd_release(xlator_t *this, posix_inode_ctx_t *ctx);
 int
 posix_handle_pair(xlator_t *this, loc_t *loc, const char *real_path, char *key,
                   data_t *value, int flags, struct iatt *stbuf);